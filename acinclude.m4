@@ -13,7 +13,7 @@ AC_ARG_ENABLE(drivers,
 	[                    icp_a106,imon,imonlcd,IOWarrior,irman,irtrans,]
 	[                    joy,jw002,lb216,lcdm001,lcterm,linux_input,lirc,lis,MD8800,mdm166a,]
 	[                    ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,]
-	[                    Olimex_MOD_LCD1x9,picolcd,pyramid,rawserial,]
+	[                    Olimex_MOD_LCD1x9,picolcd,pyramid,rawserial,record,]
 	[                    sdeclcd,sed1330,sed1520,serialPOS,serialVFD,]
 	[                    shuttleVFD,sli,stv5730,SureElec,svga,t6963,text,]
 	[                    tyan,ula200,vlsys_m428,xosd,yard2LCD]
@@ -23,7 +23,7 @@ AC_ARG_ENABLE(drivers,
 	drivers="$enableval",
 	drivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,glk,lb216,lcdm001,MtxOrb,pyramid,text])
 
-allDrivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,ea65,EyeboxOne,futaba,g15,glcd,glcdlib,glk,hd44780,i2500vfd,icp_a106,imon,imonlcd,IOWarrior,irman,irtrans,joy,jw002,lb216,lcdm001,lcterm,linux_input,lirc,lis,MD8800,mdm166a,ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,Olimex_MOD_LCD1x9,picolcd,pyramid,sdeclcd,sed1330,sed1520,serialPOS,serialVFD,shuttleVFD,sli,stv5730,SureElec,svga,t6963,text,tyan,ula200,vlsys_m428,xosd,rawserial,yard2LCD]
+allDrivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,ea65,EyeboxOne,futaba,g15,glcd,glcdlib,glk,hd44780,i2500vfd,icp_a106,imon,imonlcd,IOWarrior,irman,irtrans,joy,jw002,lb216,lcdm001,lcterm,linux_input,lirc,lis,MD8800,mdm166a,ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,Olimex_MOD_LCD1x9,picolcd,pyramid,record,sdeclcd,sed1330,sed1520,serialPOS,serialVFD,shuttleVFD,sli,stv5730,SureElec,svga,t6963,text,tyan,ula200,vlsys_m428,xosd,rawserial,yard2LCD]
 if test "$debug" = yes; then
 	allDrivers=["${allDrivers},debug"]
 fi
@@ -187,7 +187,7 @@ dnl				else
 		glcd)
 			GLCD_DRIVERS=""
 			if test "$ac_cv_port_have_lpt" = yes ; then
-				GLCD_DRIVERS="$GLCD_DRIVERS glcd-glcd-t6963.o t6963_low.o"
+				GLCD_DRIVERS="$GLCD_DRIVERS glcd-glcd-t6963.o t6963_low.o lpt-io.o"
 			fi
 			if test "$enable_libpng" = yes ; then
 				GLCD_DRIVERS="$GLCD_DRIVERS glcd-glcd-png.o"
@@ -233,7 +233,7 @@ dnl			else
 			actdrivers=["$actdrivers glk"]
 			;;
 		hd44780)
-			HD44780_DRIVERS="hd44780-hd44780-serial.o hd44780-hd44780-lis2.o hd44780-hd44780-usblcd.o"
+			HD44780_DRIVERS="hd44780-hd44780-serial.o hd44780-hd44780-lis2.o hd44780-hd44780-usblcd.o hd44780-hd44780-sim.o"
 			AC_CHECK_LIB(ugpio, main,[
 				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-ugpio.o"
 				LIBUGPIO="-lugpio"
@@ -248,13 +248,13 @@ dnl			else
 					[AC_MSG_WARN([Could not find libgpiod, not building hd44780-gpiod driver])])],
 				[AC_MSG_WARN([pkg-config not (fully) installed; hd44780-gpiod driver may not be built])])
 			if test "$ac_cv_port_have_lpt" = yes ; then
-				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-4bit.o hd44780-hd44780-ext8bit.o hd44780-hd44780-winamp.o hd44780-hd44780-serialLpt.o hd44780-hd44780-lcm162.o"
+				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-4bit.o hd44780-hd44780-ext8bit.o hd44780-hd44780-winamp.o hd44780-hd44780-serialLpt.o hd44780-hd44780-lcm162.o hd44780-hd44780-lpt.o hd44780-lpt-io.o"
 			fi
 			if test "$enable_libusb" = yes ; then
 				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-bwct-usb.o hd44780-hd44780-uss720.o hd44780-hd44780-usbtiny.o hd44780-hd44780-usb4all.o"
 			fi
 			if test "$enable_libusb_1_0" = yes ; then
-				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-lcd2usb.o"
+				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-lcd2usb.o hd44780-usb-io.o"
 			fi
 			if test "$enable_libftdi" = yes ; then
 				HD44780_DRIVERS="$HD44780_DRIVERS hd44780-hd44780-ftdi.o"
@@ -452,6 +452,10 @@ dnl			else
 			DRIVERS="$DRIVERS rawserial${SO}"
 			actdrivers=["$actdrivers rawserial"]
 			;;
+		record)
+			DRIVERS="$DRIVERS record${SO}"
+			actdrivers=["$actdrivers record"]
+			;;
 		picolcd)
 			if test "$enable_libusb_1_0" = yes ; then
 				DRIVERS="$DRIVERS picolcd${SO}"
@@ -11,6 +11,10 @@
  *               2006-2008, Peter Marschall
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
@@ -20,7 +24,13 @@
 #include <signal.h>
 #include <time.h>
 #include <sys/wait.h>
+#include <sys/time.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef HAVE_SYS_SIGNALFD_H
+# include <sys/signalfd.h>
+#endif
 
 #include "getopt.h"
 
@@ -28,6 +38,7 @@
 #include "shared/report.h"
 #include "shared/configfile.h"
 #include "shared/sockets.h"
+#include "shared/defines.h"
 
 #include "menu.h"
 
@@ -42,6 +53,11 @@
 #define DEFAULT_CONFIGFILE	SYSCONFDIR "/lcdexec.conf"
 #define DEFAULT_PIDFILE		PIDFILEDIR "/lcdexec.pid"
 
+/** Interval of the keep-alive messages to LCDd [ms] */
+#define KEEPALIVE_INTERVAL	3000
+/** Number of bytes of a command's output that are kept */
+#define OUTPUT_TAIL_SIZE	512
+
 
 /** information about a process started by lcdexec */
 typedef struct ProcInfo {
@@ -53,6 +69,12 @@ typedef struct ProcInfo {
 	int status;		/**< exit status of the process */
 	int feedback;		/**< what info to show to the user */
 	int shown;		/**< tell if the info has been shown to the user */
+	int out_fd;		/**< read end of the command's stdout; or -1 */
+	char tail[OUTPUT_TAIL_SIZE];	/**< last bytes of the command's output */
+	int tail_len;		/**< number of bytes in \c tail */
+	int dirty;		/**< output changed since the screen was updated */
+	int screen;		/**< output screen has been created */
+	long last_update;	/**< time of the last screen update [ms] */
 } ProcInfo;
 
 
@@ -87,6 +109,7 @@ char *pidfile = NULL;
 int pidfile_written = FALSE;
 char *displayname = NULL;
 char *default_shell = NULL;
+int output_interval = 500;	/**< minimal time between output updates [ms] */
 
 /* Other global variables */
 MenuEntry *main_menu = NULL;	/**< pointer to the main menu */
@@ -96,19 +119,28 @@ int lcd_wid = 0;		/**< LCD display width reported by the server */
 int lcd_hgt = 0;		/**< LCD display height reported by the server */
 
 int sock = -1;			/**< socket to connect to server */
+int sigchld_fd = -1;		/**< readable when a child has terminated */
+sigset_t orig_sigmask;		/**< signal mask to restore for children */
+#ifndef HAVE_SYS_SIGNALFD_H
+int sigchld_pipe[2];		/**< self-pipe written by the SIGCHLD handler */
+#endif
 
 int Quit = 0;			/**< indicate end of main loop */
 
 
 /* Function prototypes */
 static void exit_program(int val);
-static void sigchld_handler(int signal);
+static int setup_sigchld(void);
+static void reap_children(void);
+static long now_ms(void);
 static int process_command_line(int argc, char **argv);
 static int process_configfile(char * configfile);
 static int connect_and_setup(void);
 static int process_response(char *str);
 static int exec_command(MenuEntry *cmd);
 static int show_procinfo_msg(ProcInfo *p);
+static void read_output(ProcInfo *p);
+static void show_output(ProcInfo *p);
 static int main_loop(void);
 
 
@@ -168,11 +200,11 @@ int main(int argc, char **argv)
 	sigaction(SIGPIPE, &sa, NULL);	// write to closed socket
 	sigaction(SIGKILL, &sa, NULL);	// kill -9 [cannot be trapped; but ...]
 
-	/* setup signal handler for children to avoid zombies */
-	sigemptyset(&sa.sa_mask);
-	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
-	sa.sa_handler = sigchld_handler;
-	sigaction(SIGCHLD, &sa, NULL);
+	/* get notified of terminated children in the main loop */
+	if (setup_sigchld() < 0) {
+		report(RPT_CRIT, "Could not set up SIGCHLD handling");
+		exit_program(EXIT_FAILURE);
+	}
 
 	main_loop();
 
@@ -194,14 +226,73 @@ static void exit_program(int val)
 }
 
 
-/* the grim reaper ;-) */
+#ifndef HAVE_SYS_SIGNALFD_H
+/* wake up the main loop when a child has terminated */
 static void sigchld_handler(int signal)
 {
+	int saved_errno = errno;
+
+	if (write(sigchld_pipe[1], "", 1) < 0)
+		; /* the pipe is full: the main loop will wake up anyway */
+	errno = saved_errno;
+}
+#endif
+
+
+/** Set up sigchld_fd, which becomes readable when a child has terminated.
+ * With signalfd() SIGCHLD is blocked and read as data; elsewhere a signal
+ * handler writes to a pipe.
+ * \return  0 on success, -1 on error.
+ */
+static int setup_sigchld(void)
+{
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+
+#ifdef HAVE_SYS_SIGNALFD_H
+	if (sigprocmask(SIG_BLOCK, &mask, &orig_sigmask) < 0)
+		return -1;
+	sigchld_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sigchld_fd < 0)
+		return -1;
+#else
+	{
+		struct sigaction sa;
+
+		sigprocmask(SIG_BLOCK, NULL, &orig_sigmask);
+		if (pipe(sigchld_pipe) < 0)
+			return -1;
+		fcntl(sigchld_pipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(sigchld_pipe[1], F_SETFL, O_NONBLOCK);
+		fcntl(sigchld_pipe[0], F_SETFD, FD_CLOEXEC);
+		fcntl(sigchld_pipe[1], F_SETFD, FD_CLOEXEC);
+		sigchld_fd = sigchld_pipe[0];
+
+		sigemptyset(&sa.sa_mask);
+		sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+		sa.sa_handler = sigchld_handler;
+		sigaction(SIGCHLD, &sa, NULL);
+	}
+#endif
+	return 0;
+}
+
+
+/* the grim reaper ;-) */
+static void reap_children(void)
+{
+	char buf[128];
 	pid_t pid;
 	int status;
 
-	/* wait for the child that was signalled as finished */
-	if ((pid = wait(&status)) != -1) {
+	/* consume the notification(s) */
+	while (read(sigchld_fd, buf, sizeof(buf)) > 0)
+		;
+
+	/* several children may have terminated for one notification */
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
 		ProcInfo *p;
 
 		/* fill the procinfo structure with the necessary information */
@@ -209,12 +300,31 @@ static void sigchld_handler(int signal)
 			if (p->pid == pid) {
 				p->status = status;
 				p->endtime = time(NULL);
+
+				/* take the rest of its output */
+				if (p->out_fd >= 0) {
+					read_output(p);
+					if (p->out_fd >= 0) {
+						close(p->out_fd);
+						p->out_fd = -1;
+					}
+				}
 			}
 		}
 	}
 }
 
 
+/** Current time in milliseconds */
+static long now_ms(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+
 static int process_command_line(int argc, char **argv)
 {
 	int c;
@@ -319,6 +429,10 @@ static int process_configfile(char *configfile)
 	if ((tmp = config_get_string(progname, "DisplayName", 0, NULL)) != NULL)
 		displayname = strdup(tmp);
 
+	output_interval = config_get_int(progname, "OutputInterval", 0, 500);
+	if (output_interval < 0)
+		output_interval = 500;
+
 	/* try to find a shell that understands the -c COMMAND syntax */
 	if ((tmp = config_get_string(progname, "Shell", 0, NULL)) != NULL)
 		default_shell = strdup(tmp);
@@ -522,6 +636,7 @@ static int exec_command(MenuEntry *cmd)
 		char *envp[cmd->numChildren+1];
 		MenuEntry *arg;
 		int i;
+		int out_pipe[2] = { -1, -1 };
 
 		/* set argument vector */
 		argv[0] = default_shell;
@@ -575,9 +690,26 @@ static int exec_command(MenuEntry *cmd)
 
 		debug(RPT_DEBUG, "Executing '%s' via Shell %s", command, default_shell);
 
+		/* capture the output of commands that give feedback */
+		if (cmd->data.exec.feedback) {
+			if (pipe(out_pipe) < 0) {
+				report(RPT_WARNING, "Could not create pipe: %s", strerror(errno));
+				out_pipe[0] = out_pipe[1] = -1;
+			}
+			else {
+				fcntl(out_pipe[0], F_SETFL, O_NONBLOCK);
+				fcntl(out_pipe[0], F_SETFD, FD_CLOEXEC);
+			}
+		}
+
 		switch (pid = fork()) {
 		  case 0:
 			/* We're the child: execute the command */
+			sigprocmask(SIG_SETMASK, &orig_sigmask, NULL);
+			if (out_pipe[1] >= 0) {
+				dup2(out_pipe[1], STDOUT_FILENO);
+				close(out_pipe[1]);
+			}
 			execve(argv[0], (char **) argv, envp);
 			exit(EXIT_SUCCESS);
 			break;
@@ -589,21 +721,29 @@ static int exec_command(MenuEntry *cmd)
 				p->pid = pid;
 				p->starttime = time(NULL);
 				p->feedback = cmd->data.exec.feedback;
-				/* prepend it to existing queue atomically */
+				p->out_fd = out_pipe[0];
+				/* prepend it to existing queue */
 				p->next = proc_queue;
 				proc_queue = p;
 			}
+			else if (out_pipe[0] >= 0) {
+				close(out_pipe[0]);
+			}
         		break;
 		  case -1:
 			report(RPT_ERR, "Could not fork");
-			return -1;
+			if (out_pipe[0] >= 0)
+				close(out_pipe[0]);
+			break;
 		}
+		if (out_pipe[1] >= 0)
+			close(out_pipe[1]);
 
 		/* free envp's contents */
 		for (i = 0; envp[i] != NULL; i++)
 			free(envp[i]);
 
-		return 0;
+		return (pid == -1) ? -1 : 0;
 	}
 	return -1;
 }
@@ -617,6 +757,9 @@ static int show_procinfo_msg(ProcInfo *p)
 			if ((p->shown) || (!p->feedback))
 				return 1;
 
+			/* the summary replaces the output screen */
+			if (p->screen)
+				sock_printf(sock, "screen_del [%u]\n", p->pid);
 			sock_printf(sock, "screen_add [%u]\n", p->pid);
 			sock_printf(sock, "screen_set [%u] -name {lcdexec [%u]}"
 					  " -priority alert -timeout %d"
@@ -680,57 +823,190 @@ static int show_procinfo_msg(ProcInfo *p)
 }
 
 
+/** Read what a command has written and keep the last bytes of it.
+ * \param p  The command's ProcInfo.
+ */
+static void read_output(ProcInfo *p)
+{
+	char buf[1024];
+	int n;
+
+	while ((n = read(p->out_fd, buf, sizeof(buf))) > 0) {
+		if (n >= OUTPUT_TAIL_SIZE) {
+			memcpy(p->tail, buf + n - OUTPUT_TAIL_SIZE, OUTPUT_TAIL_SIZE);
+			p->tail_len = OUTPUT_TAIL_SIZE;
+		}
+		else {
+			if (p->tail_len + n > OUTPUT_TAIL_SIZE) {
+				int drop = p->tail_len + n - OUTPUT_TAIL_SIZE;
+
+				memmove(p->tail, p->tail + drop, p->tail_len - drop);
+				p->tail_len -= drop;
+			}
+			memcpy(p->tail + p->tail_len, buf, n);
+			p->tail_len += n;
+		}
+		p->dirty = 1;
+	}
+	if ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EINTR))) {
+		/* EOF: the command closed its stdout */
+		close(p->out_fd);
+		p->out_fd = -1;
+	}
+}
+
+
+/** Show the last lines of a running command's output on its screen.
+ * \param p  The command's ProcInfo.
+ */
+static void show_output(ProcInfo *p)
+{
+	int lines = (lcd_hgt > 2) ? lcd_hgt - 1 : 1;
+	int first_row = (lcd_hgt >= 2) ? 2 : 1;
+	/* commands for each row, the title and the (escaped) output itself */
+	char out[lines * 128 + 2 * OUTPUT_TAIL_SIZE + strlen(p->cmd->displayname) + 512];
+	char *o = out;
+	int end = p->tail_len;
+	int line;
+
+	if ((lcd_wid <= 0) || (lcd_hgt <= 0))
+		return;
+
+	if (!p->screen) {
+		o += sprintf(o, "screen_add [%u]\n", p->pid);
+		o += sprintf(o, "screen_set [%u] -name {lcdexec [%u]}"
+				" -priority foreground -heartbeat off\n",
+				p->pid, p->pid);
+		if (lcd_hgt > 2) {
+			o += sprintf(o, "widget_add [%u] t title\n", p->pid);
+			o += sprintf(o, "widget_set [%u] t {%s}\n", p->pid, p->cmd->displayname);
+		}
+		else if (lcd_hgt == 2) {
+			o += sprintf(o, "widget_add [%u] t string\n", p->pid);
+			o += sprintf(o, "widget_set [%u] t 1 1 {%s}\n", p->pid, p->cmd->displayname);
+		}
+		for (line = 0; line < lines; line++)
+			o += sprintf(o, "widget_add [%u] o%d scroller\n", p->pid, line);
+		p->screen = 1;
+	}
+
+	/* a line that has been terminated is complete, not the start of an empty one */
+	if ((end > 0) && ((p->tail[end-1] == '\n') || (p->tail[end-1] == '\r')))
+		end--;
+
+	/* fill the rows bottom up with the last lines of the output */
+	for (line = lines - 1; line >= 0; line--) {
+		int start = end;
+		int i;
+
+		while ((start > 0) && (p->tail[start-1] != '\n') && (p->tail[start-1] != '\r'))
+			start--;
+
+		o += sprintf(o, "widget_set [%u] o%d 1 %d %d %d m 2 \"", p->pid, line,
+				first_row + line, lcd_wid, first_row + line);
+		for (i = start; i < end; i++) {
+			char ch = p->tail[i];
+
+			if ((unsigned char) ch < 32)
+				continue;
+			if ((ch == '\\') || (ch == '"'))
+				*o++ = '\\';
+			*o++ = ch;
+		}
+		*o++ = '"';
+		*o++ = '\n';
+
+		end = (start > 0) ? start - 1 : 0;
+	}
+
+	sock_send(sock, out, o - out);
+	p->dirty = 0;
+	p->last_update = now_ms();
+}
+
+
 static int main_loop(void)
 {
 	int num_bytes;
 	char buf[100];
-	int keepalive_delay = 0;
-	int status_delay = 0;
-
-	/* Continuously check if we get a menu event... */
-	while (!Quit && ((num_bytes = sock_recv_string(sock, buf, sizeof(buf)-1)) >= 0)) {
-		if (num_bytes == 0) {
-			ProcInfo *p;
-
-			/* wait for 1/10th of a second */
-			usleep(100000);
-
-			/* send an empty line every 3 seconds to make sure the server still exists */
-			if (keepalive_delay++ >= 30) {
-				keepalive_delay = 0;
-				if (sock_send_string(sock, "\n") < 0) {
-					break; /* Out of while loop */
-				}
-			}
+	long next_keepalive = now_ms() + KEEPALIVE_INTERVAL;
+	int server_ready = 0;
+
+	/* Wait for menu events, command output and terminated commands */
+	while (!Quit) {
+		struct pollfd fds[2 + FD_SETSIZE];
+		ProcInfo *p, **pp;
+		int received = 0;
+		int nfds, timeout;
+		long now;
+
+		while ((num_bytes = sock_recv_string(sock, buf, sizeof(buf)-1)) > 0) {
+			process_response(buf);
+			received++;
+		}
+		/* readable but nothing to read means the server has gone */
+		if ((num_bytes < 0) || (server_ready && (received == 0)))
+			break;
 
-			/* check for a screen to show and procinfo deletion every second */
-			if (status_delay++ >= 10) {
-				status_delay = 0;
+		now = now_ms();
 
-				/* delete the ProcInfo from the queue */
-				for (p = proc_queue; p != NULL; p = p->next) {
-					ProcInfo *pn = p->next;
+		/* send an empty line every 3 seconds to make sure the server still exists */
+		if (now >= next_keepalive) {
+			next_keepalive = now + KEEPALIVE_INTERVAL;
+			if (sock_send_string(sock, "\n") < 0) {
+				break; /* Out of while loop */
+			}
+		}
 
-					if ((pn != NULL) && (pn->shown)) {
-						p->next = pn->next;
-						free(pn);
-					}
-				}
-				/* deleting queue head is special */
-				if ((proc_queue != NULL) && (proc_queue->shown)) {
-					p = proc_queue;
-					proc_queue = proc_queue->next;
+		fds[0].fd = sock;
+		fds[0].events = POLLIN;
+		fds[1].fd = sigchld_fd;
+		fds[1].events = POLLIN;
+		nfds = 2;
+		timeout = next_keepalive - now;
+
+		for (pp = &proc_queue; (p = *pp) != NULL; ) {
+			/* show finished processes & forget them */
+			if (p->endtime > 0) {
+				p->shown |= show_procinfo_msg(p);
+				if (p->shown) {
+					*pp = p->next;
 					free(p);
+					continue;
 				}
+			}
+			/* update output screens, but not more often than configured */
+			else if (p->dirty) {
+				long due = p->last_update + output_interval;
+
+				if (now >= due)
+					show_output(p);
+				else
+					timeout = min(timeout, due - now);
+			}
+			if ((p->out_fd >= 0) && (nfds < sizeof(fds)/sizeof(fds[0]))) {
+				fds[nfds].fd = p->out_fd;
+				fds[nfds].events = POLLIN;
+				nfds++;
+			}
+			pp = &p->next;
+		}
 
-				/* look for a process to display, display it & mark it as shown */
-				for (p = proc_queue; p != NULL; p = p->next) {
-					p->shown |= show_procinfo_msg(p);
-				}
+		if (poll(fds, nfds, max(timeout, 0)) < 0) {
+			if (errno != EINTR) {
+				report(RPT_ERR, "poll failed: %s", strerror(errno));
+				break;
 			}
+			continue;
 		}
-		else {
-			process_response(buf);
+		server_ready = (fds[0].revents & (POLLIN | POLLHUP)) ? 1 : 0;
+
+		if (fds[1].revents & POLLIN)
+			reap_children();
+
+		for (p = proc_queue; p != NULL; p = p->next) {
+			if (p->out_fd >= 0)
+				read_output(p);
 		}
 	}
 
@@ -0,0 +1,833 @@
+/** \file clients/lcdreplay/lcdreplay.c
+ * Main file for \c lcdreplay, which replays client sessions and checks the
+ * frames LCDd shows.
+ *
+ * A session is a text file with one protocol command per line, optionally
+ * preceded by the number of milliseconds to wait before sending it. Lines
+ * starting with \c # are comments. While the session is replayed, LCDd
+ * records its frames with the \c record driver; \c lcdreplay cuts the
+ * frames shown during the session out of that recording and compares them
+ * with the frames of an earlier run, or saves them as the reference.
+ *
+ * Recordings can also be printed and compared directly.
+ */
+
+/* This file is part of lcdreplay, an LCDproc client.
+ *
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "getopt.h"
+
+#include "shared/report.h"
+#include "shared/sockets.h"
+#include "shared/defines.h"
+#include "shared/lcdrec.h"
+
+
+/** A recording loaded into memory */
+typedef struct Recording {
+	const char *name;	/**< file name for messages */
+	unsigned char *data;	/**< file contents */
+	size_t size;		/**< number of bytes in \c data */
+	size_t pos;		/**< read position */
+} Recording;
+
+/** The display as described by a recording */
+typedef struct RecState {
+	int width, height;	/**< display size in characters */
+	int cellheight;		/**< pixel rows of a custom character */
+	int cellwidth;		/**< pixel columns of a custom character */
+	unsigned char *chars;	/**< contents of the cells */
+	int cursor_x, cursor_y, cursor_state;
+	int backlight;		/**< backlight state, -1 if unknown */
+	unsigned char cc[LCDREC_NUM_CCS][256];	/**< custom characters */
+	unsigned int cc_changed;	/**< custom characters set by the last frame */
+	unsigned long time;	/**< time of the frame since session start [ms] */
+	unsigned long frame;	/**< number of the frame in the session */
+} RecState;
+
+/** Result of reading a record */
+enum {
+	REC_ERROR = -1,		/**< the recording is damaged */
+	REC_END = 0,		/**< no (complete) record left */
+	REC_FRAME,		/**< a frame has been applied to the state */
+	REC_SESSION		/**< a new session starts, the state was reset */
+};
+
+
+char * help_text =
+"lcdreplay - replay LCDproc client sessions and check the frames LCDd shows\n"
+"\n"
+"This program is released under the terms of the GNU General Public License.\n"
+"\n"
+"Usage: lcdreplay [<options>] <session>\n"
+"       lcdreplay -d <recording>\n"
+"       lcdreplay -c <expected> <recording>\n"
+"  where <options> are:\n"
+"    -a <address>        DNS name or IP address of the LCDd server [localhost]\n"
+"    -p <port>           port of the LCDd server [13666]\n"
+"    -o <file>           recording the record driver of LCDd writes\n"
+"    -e <file>           compare the frames of the session with this recording\n"
+"    -x <file>           save the frames of the session to this recording\n"
+"    -w <ms>             time to wait after the last command [1000]\n"
+"    -d                  print the frames of a recording\n"
+"    -c                  compare two recordings\n"
+"    -r <level>          Set reporting level (0-5) [2: errors and warnings]\n"
+"    -h                  Show this help\n";
+
+char *progname = "lcdreplay";
+
+char *address = "localhost";
+int port = 13666;
+char *live_file = NULL;		/**< recording written by LCDd (-o) */
+char *expect_file = NULL;	/**< reference recording (-e) */
+char *save_file = NULL;		/**< where to save the session's frames (-x) */
+int wait_after = 1000;		/**< wait after the last command [ms] */
+enum { MODE_REPLAY, MODE_DUMP, MODE_COMPARE } mode = MODE_REPLAY;
+int report_level = RPT_WARNING;
+
+
+/* Function prototypes */
+static int process_command_line(int argc, char **argv);
+static long now_ms(void);
+static int load_recording(const char *name, Recording *rec, size_t limit);
+static int read_record(Recording *rec, RecState *st);
+static void print_frame(FILE *f, RecState *st);
+static int dump_recording(const char *name);
+static int compare_recordings(Recording *expected, Recording *actual);
+static int cut_recording(Recording *rec, size_t start, size_t end, Recording *part);
+static int save_recording(const char *name, Recording *rec);
+static int replay_session(const char *session);
+
+
+int main(int argc, char **argv)
+{
+	int args;
+	Recording expected, actual;
+
+	if (process_command_line(argc, argv) < 0) {
+		fprintf(stderr, "%s", help_text);
+		exit(EXIT_FAILURE);
+	}
+	set_reporting(progname, report_level, RPT_DEST_STDERR);
+	args = argc - optind;
+
+	switch (mode) {
+	  case MODE_DUMP:
+		if (args != 1)
+			break;
+		return (dump_recording(argv[optind]) < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+	  case MODE_COMPARE:
+		if (args != 2)
+			break;
+		if ((load_recording(argv[optind], &expected, 0) < 0)
+		    || (load_recording(argv[optind + 1], &actual, 0) < 0))
+			return EXIT_FAILURE;
+		return (compare_recordings(&expected, &actual) != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+	  case MODE_REPLAY:
+		if (args != 1)
+			break;
+		if (((expect_file != NULL) || (save_file != NULL)) && (live_file == NULL)) {
+			report(RPT_ERR, "-e and -x need the recording of LCDd (-o)");
+			return EXIT_FAILURE;
+		}
+		return (replay_session(argv[optind]) != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	fprintf(stderr, "%s", help_text);
+	return EXIT_FAILURE;
+}
+
+
+static int process_command_line(int argc, char **argv)
+{
+	int c;
+	int error = 0;
+
+	/* No error output from getopt */
+	opterr = 0;
+
+	while ((c = getopt(argc, argv, "a:p:o:e:x:w:dcr:h")) > 0) {
+		char *end;
+		int temp_int;
+
+		switch(c) {
+		  case 'a':
+			address = strdup(optarg);
+			break;
+		  case 'p':
+			temp_int = strtol(optarg, &end, 0);
+			if ((*optarg != '\0') && (*end == '\0') &&
+			    (temp_int > 0) && (temp_int <= 0xFFFF)) {
+				port = temp_int;
+			} else {
+				report(RPT_ERR, "Illegal port value %s", optarg);
+				error = -1;
+			}
+			break;
+		  case 'o':
+			live_file = strdup(optarg);
+			break;
+		  case 'e':
+			expect_file = strdup(optarg);
+			break;
+		  case 'x':
+			save_file = strdup(optarg);
+			break;
+		  case 'w':
+			temp_int = strtol(optarg, &end, 0);
+			if ((*optarg != '\0') && (*end == '\0') && (temp_int >= 0)) {
+				wait_after = temp_int;
+			} else {
+				report(RPT_ERR, "Illegal wait time %s", optarg);
+				error = -1;
+			}
+			break;
+		  case 'd':
+			mode = MODE_DUMP;
+			break;
+		  case 'c':
+			mode = MODE_COMPARE;
+			break;
+		  case 'r':
+			temp_int = strtol(optarg, &end, 0);
+			if ((*optarg != '\0') && (*end == '\0') && (temp_int >= 0)) {
+				report_level = temp_int;
+			} else {
+				report(RPT_ERR, "Illegal report level value %s", optarg);
+				error = -1;
+			}
+			break;
+		  case 'h':
+			fprintf(stderr, "%s", help_text);
+			exit(EXIT_SUCCESS);
+			/* NOTREACHED */
+		  case ':':
+			report(RPT_ERR, "Missing option argument for %c", optopt);
+			error = -1;
+			break;
+		  case '?':
+		  default:
+			report(RPT_ERR, "Unknown option: %c", optopt);
+			error = -1;
+			break;
+		}
+	}
+	return error;
+}
+
+
+static long now_ms(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+
+/**
+ * Read a recording into memory.
+ * \param name   File name.
+ * \param rec    Recording to fill in.
+ * \param limit  Number of bytes to read at most, or 0 for all.
+ * \return       0 on success, -1 on error.
+ */
+static int load_recording(const char *name, Recording *rec, size_t limit)
+{
+	FILE *f;
+	struct stat st;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->name = name;
+
+	f = fopen(name, "rb");
+	if ((f == NULL) || (fstat(fileno(f), &st) < 0)) {
+		report(RPT_ERR, "Cannot open %s: %s", name, strerror(errno));
+		if (f != NULL)
+			fclose(f);
+		return -1;
+	}
+	rec->size = st.st_size;
+	if ((limit > 0) && (limit < rec->size))
+		rec->size = limit;
+
+	rec->data = malloc(rec->size + 1);
+	if ((rec->data == NULL) || (fread(rec->data, 1, rec->size, f) != rec->size)) {
+		report(RPT_ERR, "Cannot read %s", name);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	return 0;
+}
+
+
+/** Get a varint from the recording; returns -1 if it is incomplete */
+static long get_varint(Recording *rec)
+{
+	unsigned long value = 0;
+	int shift = 0;
+
+	while (rec->pos < rec->size) {
+		unsigned char b = rec->data[rec->pos++];
+
+		value |= (unsigned long) (b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return value;
+		shift += 7;
+		if (shift > 28)
+			return -1;
+	}
+	return -1;
+}
+
+
+/** Check that \c n more bytes are available */
+#define HAVE_BYTES(rec, n)	((rec)->pos + (n) <= (rec)->size)
+
+
+/**
+ * Read the next record and apply it to the display state.
+ * A frame that is cut off at the end of the file (LCDd may be writing it)
+ * counts as the end of the recording.
+ * \param rec  Recording.
+ * \param st   Display state; it has to be zeroed before the first call.
+ * \return     One of the REC_* values.
+ */
+static int read_record(Recording *rec, RecState *st)
+{
+	size_t start = rec->pos;
+	unsigned char *p;
+	int flags;
+	long delay;
+
+	if (rec->pos >= rec->size)
+		return REC_END;
+	p = rec->data + rec->pos;
+
+	if (p[0] != LCDREC_FRAME) {
+		if (!HAVE_BYTES(rec, LCDREC_HEADER_SIZE))
+			return REC_END;
+		if ((memcmp(p, LCDREC_MAGIC, LCDREC_MAGIC_LEN) != 0)
+		    || (p[LCDREC_MAGIC_LEN] != LCDREC_VERSION)) {
+			report(RPT_ERR, "%s: not a recording or unknown version at offset %lu",
+			       rec->name, (unsigned long) rec->pos);
+			return REC_ERROR;
+		}
+		free(st->chars);
+		memset(st, 0, sizeof(*st));
+		st->width = (p[LCDREC_MAGIC_LEN + 1] != 0) ? p[LCDREC_MAGIC_LEN + 1] : 256;
+		st->height = (p[LCDREC_MAGIC_LEN + 2] != 0) ? p[LCDREC_MAGIC_LEN + 2] : 256;
+		st->cellwidth = p[LCDREC_MAGIC_LEN + 3];
+		st->cellheight = p[LCDREC_MAGIC_LEN + 4];
+		st->backlight = -1;
+		st->chars = malloc(st->width * st->height);
+		if (st->chars == NULL) {
+			report(RPT_ERR, "malloc failure");
+			return REC_ERROR;
+		}
+		memset(st->chars, ' ', st->width * st->height);
+		rec->pos += LCDREC_HEADER_SIZE;
+		return REC_SESSION;
+	}
+
+	if (st->chars == NULL) {
+		report(RPT_ERR, "%s: frame without session header", rec->name);
+		return REC_ERROR;
+	}
+
+	rec->pos++;
+	delay = get_varint(rec);
+	if ((delay < 0) || !HAVE_BYTES(rec, 1))
+		goto incomplete;
+	flags = rec->data[rec->pos++];
+	st->cc_changed = 0;
+
+	if (flags & LCDREC_F_CHARS) {
+		long runs = get_varint(rec);
+		long cell = 0;
+
+		if (runs < 0)
+			goto incomplete;
+		while (runs-- > 0) {
+			long skip = get_varint(rec);
+			long len = get_varint(rec);
+
+			if ((skip < 0) || (len < 0) || !HAVE_BYTES(rec, len))
+				goto incomplete;
+			cell += skip;
+			if (cell + len > st->width * st->height) {
+				report(RPT_ERR, "%s: cells out of range at offset %lu",
+				       rec->name, (unsigned long) start);
+				return REC_ERROR;
+			}
+			memcpy(st->chars + cell, rec->data + rec->pos, len);
+			rec->pos += len;
+			cell += len;
+		}
+	}
+	if (flags & LCDREC_F_CURSOR) {
+		long x = get_varint(rec);
+		long y = get_varint(rec);
+
+		if ((x < 0) || (y < 0) || !HAVE_BYTES(rec, 1))
+			goto incomplete;
+		st->cursor_x = x;
+		st->cursor_y = y;
+		st->cursor_state = rec->data[rec->pos++];
+	}
+	if (flags & LCDREC_F_BACKLIGHT) {
+		if (!HAVE_BYTES(rec, 1))
+			goto incomplete;
+		st->backlight = rec->data[rec->pos++];
+	}
+	if (flags & LCDREC_F_CUSTOM) {
+		int count;
+
+		if (!HAVE_BYTES(rec, 1))
+			goto incomplete;
+		count = rec->data[rec->pos++];
+		while (count-- > 0) {
+			int n;
+
+			if (!HAVE_BYTES(rec, 1 + st->cellheight))
+				goto incomplete;
+			n = rec->data[rec->pos++];
+			if (n >= LCDREC_NUM_CCS) {
+				report(RPT_ERR, "%s: bad custom character at offset %lu",
+				       rec->name, (unsigned long) start);
+				return REC_ERROR;
+			}
+			memcpy(st->cc[n], rec->data + rec->pos, st->cellheight);
+			rec->pos += st->cellheight;
+			st->cc_changed |= 1 << n;
+		}
+	}
+
+	st->time += delay;
+	st->frame++;
+	return REC_FRAME;
+
+incomplete:
+	rec->pos = start;
+	return REC_END;
+}
+
+
+/**
+ * Print the display contents like the text driver does.
+ * Custom characters are shown by their number.
+ */
+static void print_frame(FILE *f, RecState *st)
+{
+	int x, y, i;
+
+	fprintf(f, "frame %lu at %lu ms\n+", st->frame, st->time);
+	for (x = 0; x < st->width; x++)
+		fputc('-', f);
+	fprintf(f, "+\n");
+	for (y = 0; y < st->height; y++) {
+		fputc('|', f);
+		for (x = 0; x < st->width; x++) {
+			unsigned char c = st->chars[y * st->width + x];
+
+			if (c < LCDREC_NUM_CCS)
+				c = '0' + c;
+			else if ((c < 0x20) || (c >= 0x7F))
+				c = '.';
+			fputc(c, f);
+		}
+		fprintf(f, "|\n");
+	}
+	fputc('+', f);
+	for (x = 0; x < st->width; x++)
+		fputc('-', f);
+	fprintf(f, "+\n");
+
+	if (st->cursor_state != 0)
+		fprintf(f, "cursor %d,%d type %d\n", st->cursor_x, st->cursor_y, st->cursor_state);
+	if (st->backlight >= 0)
+		fprintf(f, "backlight %s\n", (st->backlight) ? "on" : "off");
+	for (i = 0; i < LCDREC_NUM_CCS; i++) {
+		if (st->cc_changed & (1 << i)) {
+			fprintf(f, "char %d:", i);
+			for (y = 0; y < st->cellheight; y++)
+				fprintf(f, " %02x", st->cc[i][y]);
+			fprintf(f, "\n");
+		}
+	}
+}
+
+
+static int dump_recording(const char *name)
+{
+	Recording rec;
+	RecState st;
+	int res;
+
+	if (load_recording(name, &rec, 0) < 0)
+		return -1;
+
+	memset(&st, 0, sizeof(st));
+	while ((res = read_record(&rec, &st)) > 0) {
+		if (res == REC_SESSION)
+			printf("session %dx%d, cells %dx%d\n",
+			       st.width, st.height, st.cellwidth, st.cellheight);
+		else
+			print_frame(stdout, &st);
+	}
+	printf("%lu bytes\n", (unsigned long) rec.size);
+
+	free(st.chars);
+	free(rec.data);
+	return res;
+}
+
+
+/**
+ * Check whether two frames look the same. Timing is not compared, and the
+ * custom characters only as far as they are on the display.
+ */
+static int same_frame(RecState *a, RecState *b)
+{
+	int size = a->width * a->height;
+	unsigned int used = 0;
+	int i;
+
+	if ((a->width != b->width) || (a->height != b->height)
+	    || (a->cellheight != b->cellheight)
+	    || (memcmp(a->chars, b->chars, size) != 0)
+	    || (a->cursor_state != b->cursor_state)
+	    || (a->backlight != b->backlight))
+		return 0;
+	if ((a->cursor_state != 0)
+	    && ((a->cursor_x != b->cursor_x) || (a->cursor_y != b->cursor_y)))
+		return 0;
+
+	for (i = 0; i < size; i++) {
+		if (a->chars[i] < LCDREC_NUM_CCS)
+			used |= 1 << a->chars[i];
+	}
+	for (i = 0; i < LCDREC_NUM_CCS; i++) {
+		if ((used & (1 << i)) && (memcmp(a->cc[i], b->cc[i], a->cellheight) != 0))
+			return 0;
+	}
+	return 1;
+}
+
+
+/**
+ * Compare the frames of two recordings, ignoring their timing.
+ * Both recordings are read from their current position on.
+ * \return  0 if they show the same, 1 if not, -1 on error.
+ */
+static int compare_recordings(Recording *expected, Recording *actual)
+{
+	RecState a, b;
+	int ra, rb;
+	int result = 1;
+
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+
+	do {
+		/* Session headers only matter for the frames that follow */
+		while ((ra = read_record(expected, &a)) == REC_SESSION)
+			;
+		while ((rb = read_record(actual, &b)) == REC_SESSION)
+			;
+	} while ((ra == REC_FRAME) && (rb == REC_FRAME) && same_frame(&a, &b));
+
+	if ((ra == REC_ERROR) || (rb == REC_ERROR)) {
+		result = -1;
+	}
+	else if ((ra == REC_END) && (rb == REC_END)) {
+		printf("%lu frames match (%lu ms expected, %lu ms now)\n",
+		       a.frame, a.time, b.time);
+		result = 0;
+	}
+	else if (ra == REC_END) {
+		printf("%s has more frames than %s:\n", actual->name, expected->name);
+		print_frame(stdout, &b);
+	}
+	else if (rb == REC_END) {
+		printf("%s ends before frame %lu of %s:\n", actual->name, a.frame, expected->name);
+		print_frame(stdout, &a);
+	}
+	else {
+		printf("Frames differ; expected (%s):\n", expected->name);
+		print_frame(stdout, &a);
+		printf("but got (%s):\n", actual->name);
+		print_frame(stdout, &b);
+	}
+
+	free(a.chars);
+	free(b.chars);
+	return result;
+}
+
+
+/** Append a varint to a buffer; returns the new write position */
+static unsigned char *put_varint(unsigned char *out, unsigned long value)
+{
+	while (value >= 0x80) {
+		*out++ = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	*out++ = value;
+	return out;
+}
+
+
+/**
+ * Cut the frames from offset \c start to \c end out of a recording. The
+ * result is a recording of its own: its first frame holds the complete
+ * display state after the first of these frames, the frames after it are
+ * copied as they are. What was shown before \c start does not matter.
+ * \param rec    Recording to take the frames from.
+ * \param start  Offset of the first frame.
+ * \param end    Offset after the last frame.
+ * \param part   Recording to fill in.
+ * \return       0 on success, -1 on error.
+ */
+static int cut_recording(Recording *rec, size_t start, size_t end, Recording *part)
+{
+	RecState st;
+	unsigned char *out;
+	int size, i, res;
+
+	/* Get the state after the first frame at or behind start */
+	memset(&st, 0, sizeof(st));
+	rec->pos = 0;
+	rec->size = end;
+	while ((res = read_record(rec, &st)) > 0) {
+		if ((res == REC_FRAME) && (rec->pos > start))
+			break;
+	}
+	if (res != REC_FRAME) {
+		free(st.chars);
+		report(RPT_ERR, "%s: no frames recorded during the session", rec->name);
+		return -1;
+	}
+	start = rec->pos;
+
+	size = st.width * st.height;
+	memset(part, 0, sizeof(*part));
+	part->name = rec->name;
+	part->data = malloc(LCDREC_HEADER_SIZE + 32 + size
+			    + LCDREC_NUM_CCS * (1 + st.cellheight) + (end - start));
+	if (part->data == NULL) {
+		report(RPT_ERR, "malloc failure");
+		free(st.chars);
+		return -1;
+	}
+
+	out = part->data;
+	memcpy(out, LCDREC_MAGIC, LCDREC_MAGIC_LEN);
+	out += LCDREC_MAGIC_LEN;
+	*out++ = LCDREC_VERSION;
+	*out++ = st.width & 0xFF;
+	*out++ = st.height & 0xFF;
+	*out++ = st.cellwidth;
+	*out++ = st.cellheight;
+
+	*out++ = LCDREC_FRAME;
+	*out++ = 0;
+	*out++ = LCDREC_F_CHARS | LCDREC_F_CURSOR | LCDREC_F_CUSTOM
+		| ((st.backlight >= 0) ? LCDREC_F_BACKLIGHT : 0);
+	out = put_varint(out, 1);
+	out = put_varint(out, 0);
+	out = put_varint(out, size);
+	memcpy(out, st.chars, size);
+	out += size;
+	out = put_varint(out, st.cursor_x);
+	out = put_varint(out, st.cursor_y);
+	*out++ = st.cursor_state;
+	if (st.backlight >= 0)
+		*out++ = st.backlight;
+	*out++ = LCDREC_NUM_CCS;
+	for (i = 0; i < LCDREC_NUM_CCS; i++) {
+		*out++ = i;
+		memcpy(out, st.cc[i], st.cellheight);
+		out += st.cellheight;
+	}
+
+	memcpy(out, rec->data + start, end - start);
+	out += end - start;
+	part->size = out - part->data;
+
+	free(st.chars);
+	return 0;
+}
+
+
+/** Write a recording to a file; returns 0 on success, -1 on error */
+static int save_recording(const char *name, Recording *rec)
+{
+	FILE *f;
+	int res = 0;
+
+	f = fopen(name, "wb");
+	if (f == NULL) {
+		report(RPT_ERR, "Cannot write %s: %s", name, strerror(errno));
+		return -1;
+	}
+	if (fwrite(rec->data, rec->size, 1, f) != 1)
+		res = -1;
+	if ((fclose(f) != 0) || (res < 0)) {
+		report(RPT_ERR, "Cannot write %s: %s", name, strerror(errno));
+		res = -1;
+	}
+	return res;
+}
+
+
+/** Get the size of the recording LCDd is writing */
+static size_t live_size(void)
+{
+	struct stat st;
+
+	if ((live_file == NULL) || (stat(live_file, &st) < 0))
+		return 0;
+	return st.st_size;
+}
+
+
+/**
+ * Read and log what LCDd sends until the given time.
+ * \return  0 if the time is reached, -1 if the connection is lost.
+ */
+static int wait_until(int sock, long until, int lineno)
+{
+	char buf[1024];
+	struct pollfd pfd;
+	long now;
+
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+
+	while ((now = now_ms()) < until) {
+		int len;
+
+		if (poll(&pfd, 1, until - now) <= 0)
+			continue;
+		while ((len = sock_recv_string(sock, buf, sizeof(buf) - 1)) > 0) {
+			buf[strcspn(buf, "\n")] = '\0';
+			if (strncmp(buf, "huh?", 4) == 0)
+				report(RPT_WARNING, "line %d: %s", lineno, buf);
+			else
+				report(RPT_DEBUG, "received: %s", buf);
+		}
+		if ((len < 0) || (pfd.revents & (POLLHUP | POLLERR))) {
+			report(RPT_ERR, "Connection to LCDd lost");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+/**
+ * Send the commands of a session file to LCDd, then check or save the
+ * frames LCDd recorded meanwhile.
+ * \return  0 on success, 1 if the frames differ, -1 on error.
+ */
+static int replay_session(const char *session)
+{
+	FILE *f;
+	char line[8192];
+	int lineno = 0;
+	int sock;
+	size_t start, end;
+	long next;
+	int result = 0;
+
+	f = fopen(session, "r");
+	if (f == NULL) {
+		report(RPT_ERR, "Cannot open %s: %s", session, strerror(errno));
+		return -1;
+	}
+
+	start = live_size();
+
+	sock = sock_connect(address, port);
+	if (sock < 0) {
+		report(RPT_ERR, "Cannot connect to %s:%d", address, port);
+		fclose(f);
+		return -1;
+	}
+
+	next = now_ms();
+	while (fgets(line, sizeof(line) - 1, f) != NULL) {
+		char *cmd;
+		long delay;
+
+		lineno++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if ((line[0] == '#') || (line[strspn(line, " \t")] == '\0'))
+			continue;
+
+		delay = strtol(line, &cmd, 10);
+		if (cmd == line)
+			delay = 0;
+		cmd += strspn(cmd, " \t");
+
+		next += delay;
+		if (wait_until(sock, next, lineno) < 0) {
+			result = -1;
+			break;
+		}
+		/* LCDd expects complete lines in one piece */
+		memmove(line, cmd, strlen(cmd) + 1);
+		strcat(line, "\n");
+		if (sock_send_string(sock, line) < 0) {
+			report(RPT_ERR, "Connection to LCDd lost");
+			result = -1;
+			break;
+		}
+	}
+	fclose(f);
+
+	if ((result == 0) && (wait_until(sock, now_ms() + wait_after, lineno) < 0))
+		result = -1;
+	end = live_size();
+	sock_close(sock);
+
+	if ((result == 0) && (live_file != NULL)) {
+		Recording live, frames, expected;
+
+		if ((load_recording(live_file, &live, end) < 0)
+		    || (cut_recording(&live, start, end, &frames) < 0))
+			return -1;
+		free(live.data);
+
+		if (save_file != NULL)
+			result = save_recording(save_file, &frames);
+
+		if ((result == 0) && (expect_file != NULL)) {
+			if (load_recording(expect_file, &expected, 0) < 0)
+				return -1;
+			result = compare_recordings(&expected, &frames);
+			free(expected.data);
+		}
+		free(frames.data);
+	}
+	return result;
+}
@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 
 #include "lcd_link.h"
 #include "vc_link.h"
@@ -27,9 +28,11 @@
 #include "shared/report.h"
 #include "shared/str.h"
 #include "shared/sockets.h"
+#include "shared/rawscreen.h"
 
 char *address = UNSET_STR;
 int port = UNSET_INT;
+char *unix_socket = NULL;
 short autoscroll = 1;
 
 int sock;
@@ -38,6 +41,9 @@ short scroll_x = 0, scroll_y = 0;
 short lcd_cursor_x, lcd_cursor_y;
 short lcd_width = 0, lcd_height = 0;
 char *lcd_buf = NULL;
+static char *out_buf = NULL;	/**< Commands of one update pass */
+RawScreenHeader *raw = NULL;	/**< Shared cells, if LCDd gave us a raw screen */
+size_t raw_size = 0;
 
 short last_vc_cursor_y = 0;
 short last_vc_cursor_x = 0;
@@ -45,6 +51,8 @@ short last_lcd_cursor_x = 0;
 short last_lcd_cursor_y = 0;
 
 static int read_connect_string(void);
+static int request_raw_screen(void);
+static int update_raw_screen(void);
 static int split(char *str, char delim, char *parts[], int maxparts);
 
 
@@ -55,12 +63,23 @@ int setup_connection(void)
 	int e = 0;
 	short line;
 
-	report(RPT_INFO, "Connecting to %s:%d", address, port);
+	if ((unix_socket != NULL) && (unix_socket[0] != '\0')) {
+		report(RPT_INFO, "Connecting to %s", unix_socket);
 
-	sock = sock_connect(address, port);
-	if (sock < 0) {
-		report(RPT_ERR, "Connecting to %s:%d failed", address, port);
-		return -1;
+		sock = sock_connect_unix(unix_socket);
+		if (sock < 0) {
+			report(RPT_ERR, "Connecting to %s failed", unix_socket);
+			return -1;
+		}
+	}
+	else {
+		report(RPT_INFO, "Connecting to %s:%d", address, port);
+
+		sock = sock_connect(address, port);
+		if (sock < 0) {
+			report(RPT_ERR, "Connecting to %s:%d failed", address, port);
+			return -1;
+		}
 	}
 	/* Create our menu */
 	sock_send_string(sock, "hello\n");
@@ -73,10 +92,18 @@ int setup_connection(void)
 
 	/* Create screen */
 	CHAIN(e, sock_send_string(sock, "screen_add console\n"));
-	for (line = 0; line < lcd_height; line++) {
-		snprintf(buf, sizeof(buf)-1, "widget_add console line%d string\n", line);
-		buf[sizeof(buf)-1] = 0;
-		CHAIN(e, sock_send_string(sock, buf));
+
+	/* On a local connection write the cells directly, if LCDd lets us */
+	if ((e >= 0) && (unix_socket != NULL) && (unix_socket[0] != '\0')) {
+		if (request_raw_screen() < 0)
+			report(RPT_WARNING, "No raw screen available, using widgets");
+	}
+	if (raw == NULL) {
+		for (line = 0; line < lcd_height; line++) {
+			snprintf(buf, sizeof(buf)-1, "widget_add console line%d string\n", line);
+			buf[sizeof(buf)-1] = 0;
+			CHAIN(e, sock_send_string(sock, buf));
+		}
 	}
 	/* Add menu items */
 	CHAIN(e, sock_send_string(sock, "menu_add_item \"\" autoscroll checkbox \"Auto scroll\"\n"));
@@ -100,6 +127,10 @@ int setup_connection(void)
 
 int teardown_connection(void)
 {
+	if (raw != NULL) {
+		munmap(raw, raw_size);
+		raw = NULL;
+	}
 	sock_close(sock);
 
 	return 0;
@@ -150,6 +181,71 @@ static int read_connect_string(void)
 }
 
 
+/**
+ * Ask LCDd for a shared memory raw screen for the console screen and map it.
+ * Responses to earlier commands that arrive in the meantime are handled
+ * as usual.
+ * \return  0 on success, -1 if no raw screen could be set up.
+ */
+static int request_raw_screen(void)
+{
+	char buf[200];
+	char *argv[5];
+	int argc;
+	int len;
+	int fd = -1;
+	short timeout = 50; /* Give the server 5 secs to respond */
+
+	if (sock_send_string(sock, "screen_raw console\n") < 0)
+		return -1;
+
+	while (timeout > 0) {
+		len = sock_recv_string_fd(sock, buf, sizeof(buf), &fd);
+		if (len < 0)
+			return -1;
+		if (len == 0) {
+			usleep(100000);
+			timeout--;
+			continue;
+		}
+		if (fd >= 0)
+			break;
+		if (strncmp(buf, "huh?", 4) == 0) {
+			report(RPT_WARNING, "Server said: \"%s\"", buf);
+			return -1;
+		}
+		process_response(buf);
+	}
+	if (fd < 0)
+		return -1;
+
+	argc = split(buf, ' ', argv, 5);
+	if ((argc < 4) || (strcmp(argv[0], "rawscreen") != 0)) {
+		report(RPT_ERR, "Received invalid rawscreen response");
+		close(fd);
+		return -1;
+	}
+
+	raw_size = RAWSCREEN_SIZE(atoi(argv[2]), atoi(argv[3]));
+	raw = mmap(NULL, raw_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (raw == MAP_FAILED) {
+		report(RPT_ERR, "Could not map raw screen: %s", strerror(errno));
+		raw = NULL;
+		return -1;
+	}
+	if ((raw->magic != RAWSCREEN_MAGIC) || (raw->version != RAWSCREEN_VERSION)
+	    || (RAWSCREEN_SIZE(raw->width, raw->height) > raw_size)) {
+		report(RPT_ERR, "Raw screen has an unknown layout");
+		munmap(raw, raw_size);
+		raw = NULL;
+		return -1;
+	}
+	report(RPT_INFO, "Using raw screen of %dx%d", raw->width, raw->height);
+	return 0;
+}
+
+
 /**
  * Splits a string into parts, to which pointers will be returned in &parts.
  * The return value is the number of parts.
@@ -268,11 +364,8 @@ int process_response(char *str)
 
 int update_display(void)
 {
-	//int bytes_read;
 	short line;
-	int e = 0;
-	char buf[80];
-	char *str_buf;
+	char *a;
 	short num_lines;
 	num_lines = min(lcd_height, vc_height);
 
@@ -282,6 +375,14 @@ int update_display(void)
 	if (!lcd_buf) {
 		/* Not yet allocated */
 		lcd_buf = malloc(lcd_width * lcd_height);
+		/* Room for the cursor command and all lines fully escaped */
+		out_buf = malloc(80 + lcd_height * (80 + 2 * lcd_width));
+		if ((lcd_buf == NULL) || (out_buf == NULL)) {
+			report(RPT_ERR, "malloc failure: %s", strerror(errno));
+			free(lcd_buf);
+			lcd_buf = NULL;
+			return -1;
+		}
 		memset(lcd_buf, ' ', lcd_width * lcd_height);
 	}
 
@@ -302,6 +403,14 @@ int update_display(void)
 	}
 	lcd_cursor_x = vc_cursor_x - scroll_x + 1;
 	lcd_cursor_y = vc_cursor_y - scroll_y + 1;
+
+	/* The raw screen takes cells and cursor without any commands */
+	if (raw != NULL)
+		return update_raw_screen();
+
+	/* All commands of this pass are collected and sent at once */
+	a = out_buf;
+
 	if (lcd_cursor_x != last_lcd_cursor_x || lcd_cursor_y != last_lcd_cursor_y) {
 		last_lcd_cursor_x = lcd_cursor_x;
 		last_lcd_cursor_y = lcd_cursor_y;
@@ -309,17 +418,14 @@ int update_display(void)
 		/* New scroll positions, send the cursor command */
 		if (lcd_cursor_x < 1 || lcd_cursor_x > lcd_width
 		|| lcd_cursor_y < 1 || lcd_cursor_y > lcd_height) {
-			snprintf(buf, sizeof(buf)-1, "screen_set console -cursor off\n");
+			a += snprintf(a, 80, "screen_set console -cursor off\n");
 		} else {
-			snprintf(buf, sizeof(buf)-1, "screen_set console -cursor on -cursor_x %d -cursor_y %d\n",
+			a += snprintf(a, 80, "screen_set console -cursor on -cursor_x %d -cursor_y %d\n",
 					lcd_cursor_x, lcd_cursor_y);
 		}
-		buf[sizeof(buf)-1] = 0;
-		CHAIN(e, sock_send_string(sock, buf));
 	}
 
-	/* Send all (changed) lines */
-	str_buf = malloc(80 + 2 * lcd_width);
+	/* Add all (changed) lines */
 	for (line = 0; line < num_lines; line++) {
 
 		char *vc_p;
@@ -335,13 +441,11 @@ int update_display(void)
 		/* Has the line data changed ? */
 		if (memcmp(vc_p, lcd_p, line_width) != 0) {
 			/* Yes, so send it */
-			char *a;
 			short pos;
 
 			/* Format/escape the data */
-			snprintf(str_buf, 80, "widget_set console line%d 1 %d \"", line, line+1);
+			a += snprintf(a, 80, "widget_set console line%d 1 %d \"", line, line+1);
 
-			a = str_buf + strlen(str_buf); /* start just after the " */
 			for (pos = 0; pos < line_width; pos++) {
 				if (vc_p[pos] == '\\' || vc_p[pos] == '\"') {
 					*a++ = '\\'; /* add escape char */
@@ -354,17 +458,17 @@ int update_display(void)
 			}
 			*a++ = '\"'; /* end string */
 			*a++ = '\n'; /* newline */
-			*a = 0; /* terminate */
-			CHAIN(e, sock_send_string(sock, str_buf));
 
 			/* And store the new data */
 			memcpy(lcd_p, vc_p, line_width);
 
 		}
 	}
-	free(str_buf);
 
-	if (e < 0) {
+	if (a == out_buf)
+		return 0;
+
+	if (sock_send(sock, out_buf, a - out_buf) < 0) {
 		report(RPT_ERR, "Error while sending data to LCDd");
 		return -1;
 	}
@@ -373,6 +477,61 @@ int update_display(void)
 }
 
 
+/**
+ * Copy the visible part of the console into the shared raw screen.
+ * Lines are compared against the shared cells directly, and the sequence
+ * counter is only bumped if something changed.
+ * \return  0 on success.
+ */
+static int update_raw_screen(void)
+{
+	char *cells = rawscreen_cells(raw);
+	short num_lines = min(min(lcd_height, vc_height), raw->height);
+	short line_width = min(min(lcd_width, vc_width), raw->width);
+	short cursor;
+	short line;
+	int updating = 0;
+
+	if (lcd_cursor_x < 1 || lcd_cursor_x > lcd_width
+	|| lcd_cursor_y < 1 || lcd_cursor_y > lcd_height)
+		cursor = 0;	/* CURSOR_OFF */
+	else
+		cursor = 1;	/* CURSOR_DEFAULT_ON */
+
+	if ((raw->cursor != cursor) || (raw->cursor_x != lcd_cursor_x)
+	    || (raw->cursor_y != lcd_cursor_y)) {
+		rawscreen_begin_update(raw);
+		updating = 1;
+		raw->cursor = cursor;
+		raw->cursor_x = lcd_cursor_x;
+		raw->cursor_y = lcd_cursor_y;
+	}
+
+	for (line = 0; line < num_lines; line++) {
+		char *vc_p = vc_buf + vc_width * (scroll_y + line) + scroll_x;
+		char *raw_p = cells + raw->width * line;
+		short pos;
+
+		for (pos = 0; pos < line_width; pos++) {
+			char ch = ((signed char) vc_p[pos] >= 32) ? vc_p[pos] : '?';
+
+			if (raw_p[pos] == ch)
+				continue;
+			if (!updating) {
+				rawscreen_begin_update(raw);
+				updating = 1;
+			}
+			raw_p[pos] = ch;
+		}
+	}
+
+	if (updating)
+		rawscreen_end_update(raw);
+
+	return 0;
+}
+
+
 int send_nop(void)
 {
 	return sock_send_string(sock, "\n");
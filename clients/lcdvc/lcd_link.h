@@ -3,6 +3,8 @@
 
 extern char *address;
 extern int port;
+extern char *unix_socket;
+extern int sock;
 
 int setup_connection(void);
 int teardown_connection(void);
@@ -21,6 +21,8 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <time.h>
+#include <poll.h>
 
 #include "getopt.h"
 
@@ -41,6 +43,12 @@
 #define DEFAULT_CONFIGFILE	SYSCONFDIR "/lcdvc.conf"
 #define DEFAULT_PIDFILE		PIDFILEDIR "/lcdvc.pid"
 
+/* Console polling intervals [ms], if the console can't notify us */
+#define POLL_MIN_INTERVAL	50
+#define POLL_MAX_INTERVAL	500
+/* Interval of the keep-alive messages to LCDd [s] */
+#define NOP_INTERVAL		3
+
 
 char *help_text =
 "lcdvc - LCDproc virtual console\n"
@@ -62,6 +70,10 @@ char *help_text =
 int foreground = FALSE;
 static int report_level = UNSET_INT;
 static int report_dest = UNSET_INT;
+char *console_source = UNSET_STR;
+char *console_file = UNSET_STR;
+int console_width = 80;
+int console_height = 25;
 char *vcsa_device = UNSET_STR;
 char *vcs_device = UNSET_STR;
 char *keys[4];
@@ -97,7 +109,7 @@ int main(int argc, char **argv)
 	}
 	set_reporting( progname, report_level, report_dest );
 
-	CHAIN( e, open_vcs() );
+	CHAIN( e, open_console() );
 	CHAIN( e, setup_connection() );
 	CHAIN_END( e );
 
@@ -237,6 +249,9 @@ static int process_configfile(char *configfile)
 	if (port == UNSET_INT) {
 		port = config_get_int(progname, "Port", 0, 13666);
 	}
+	if (unix_socket == NULL) {
+		unix_socket = strdup(config_get_string(progname, "UnixSocket", 0, ""));
+	}
 	if (report_level == UNSET_INT ) {
 		report_level = config_get_int(progname, "ReportLevel", 0, RPT_WARNING);
 	}
@@ -254,6 +269,17 @@ static int process_configfile(char *configfile)
 		pidfile = strdup(config_get_string(progname, "PidFile", 0, DEFAULT_PIDFILE));
 	}
 
+	console_source = strdup(config_get_string(progname, "Source", 0, "vcs"));
+	console_file = strdup(config_get_string(progname, "File", 0, "/dev/stdin"));
+	console_width = config_get_int(progname, "FileWidth", 0, 80);
+	console_height = config_get_int(progname, "FileHeight", 0, 25);
+	if ((console_width < 1) || (console_width > 255)
+	    || (console_height < 1) || (console_height > 255)) {
+		report(RPT_WARNING, "Illegal FileWidth/FileHeight, using 80x25");
+		console_width = 80;
+		console_height = 25;
+	}
+
 	vcs_device = strdup(config_get_string(progname, "vcsDevice", 0, "/dev/vcs"));
 	vcsa_device = strdup(config_get_string(progname, "vcsaDevice", 0, "/dev/vcsa"));
 
@@ -270,31 +296,65 @@ static int main_loop(void)
 {
 	int num_bytes;
 	char buf[80];
-	short w = 0;
+	struct pollfd fds[2];
+	int server_ready = 0;
+	int timeout = POLL_MIN_INTERVAL;
+	time_t last_nop = time(NULL);
+
+	/* Sleep until the server or the console has something for us */
 
-	/* Continuously check if we get a menu event... */
+	while (!Quit) {
+		int received = 0;
+		int changed;
+		time_t now;
 
-	while (!Quit && ((num_bytes = read_response(buf, sizeof(buf)-1)) >= 0)) {
-		if (num_bytes != 0) {
+		while ((num_bytes = read_response(buf, sizeof(buf)-1)) > 0) {
 			process_response(buf);
+			received++;
+		}
+		/* Readable but nothing to read means the server has gone */
+		if ((num_bytes < 0) || (server_ready && (received == 0)))
+			break;
+
+		changed = read_vcdata();
+		update_display();
+
+		/* Send an empty line every 3 seconds to make sure the server still exists */
+		now = time(NULL);
+		if (now - last_nop >= NOP_INTERVAL) {
+			last_nop = now;
+			if (send_nop() < 0) {
+				break; /* Out of while loop */
+			}
+		}
+
+		fds[0].fd = sock;
+		fds[0].events = POLLIN;
+		fds[1].fd = console_poll_fd(&fds[1].events);
+
+		if (fds[1].fd >= 0) {
+			/* The console wakes us up itself */
+			timeout = NOP_INTERVAL * 1000;
+		}
+		else if (changed > 0) {
+			timeout = POLL_MIN_INTERVAL;
 		}
 		else {
-			read_vcdata();
-			update_display();
-
-			/* Send an empty line every 3 seconds to make sure the server still exists */
-			if (w++ >= 60) {
-				w = 0;
-				if (send_nop() < 0) {
-					break; /* Out of while loop */
-				}
+			/* Back off while the console is idle */
+			timeout = min(timeout + POLL_MIN_INTERVAL, POLL_MAX_INTERVAL);
+		}
+
+		if (poll(fds, (fds[1].fd >= 0) ? 2 : 1, timeout) < 0) {
+			if (errno != EINTR) {
+				report(RPT_ERR, "poll failed: %s", strerror(errno));
+				break;
 			}
-			usleep(50000);
+			fds[0].revents = 0;
 		}
+		server_ready = (fds[0].revents & (POLLIN | POLLHUP)) ? 1 : 0;
 	}
 
 	if (!Quit)
 		report(RPT_WARNING, "Server disconnected %d", num_bytes);
 	return 0;
 }
-
@@ -16,6 +16,9 @@
 # define FALSE   0
 #endif
 
+extern char *console_source;
+extern char *console_file;
+extern int console_width, console_height;
 extern char *vcs_device;
 extern char *vcsa_device;
 
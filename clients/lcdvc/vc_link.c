@@ -1,5 +1,12 @@
 /** \file clients/lcdvc/vc_link.c
  * Functions to handle a virtual console.
+ *
+ * The console contents come from one of several sources:
+ * - \c vcs: the Linux virtual console devices /dev/vcs and /dev/vcsa.
+ *   The kernel signals changes to the screen with POLLPRI.
+ * - \c file: a stream of terminal output read from a file, a FIFO or a
+ *   pty, rendered by a minimal terminal of a configured size. This allows
+ *   running lcdvc without a real VT.
  */
 
 /*-
@@ -15,25 +22,99 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <poll.h>
 
 #include "lcdvc.h"
 #include "vc_link.h"
 #include "shared/report.h"
 #include "shared/sockets.h"
 
+/** Operations of a console source */
+typedef struct ConsoleSource {
+	char *name;		/**< Name used in the Source setting */
+	int (*open)(void);	/**< Open the source, set up console_fd */
+	int (*read)(void);	/**< Update vc_*; 1 if changed, 0 if not, <0 on error */
+} ConsoleSource;
+
+static int open_vcs(void);
+static int read_vcs(void);
+static int open_file(void);
+static int read_file(void);
+
+static ConsoleSource sources[] = {
+	{ "vcs",  open_vcs,  read_vcs },
+	{ "file", open_file, read_file },
+	{ NULL, NULL, NULL }
+};
+
+static ConsoleSource *source = NULL;
+static int console_fd = -1;		/**< Descriptor to poll, or -1 */
+static short console_events = 0;	/**< poll() events signalling a change */
+
 int vcs0, vcsa;
 unsigned short vc_width = 0, vc_height = 0;
 unsigned short vc_cursor_x = 0, vc_cursor_y = 0;
 char *vc_buf = NULL;
+static char *vc_scratch = NULL;		/**< Buffer for comparing new data */
 
 
-int open_vcs(void)
+int open_console(void)
 {
+	for (source = sources; source->name != NULL; source++) {
+		if (strcasecmp(source->name, console_source) == 0)
+			return source->open();
+	}
+	report(RPT_ERR, "Unknown console source: %s", console_source);
+	source = NULL;
+	return -1;
+}
+
+
+int read_vcdata(void)
+{
+	if (source == NULL)
+		return -1;
+	return source->read();
+}
+
+
+int console_poll_fd(short *events)
+{
+	*events = console_events;
+	return (console_events != 0) ? console_fd : -1;
+}
+
+
+/** Resize the console buffers; the contents are cleared */
+static int resize_console(unsigned short width, unsigned short height)
+{
+	vc_width = width;
+	vc_height = height;
+
+	if (vc_width * vc_height > 0) {
+		vc_buf = realloc(vc_buf, vc_width * vc_height);
+		vc_scratch = realloc(vc_scratch, vc_width * vc_height);
+
+		if ((vc_buf == NULL) || (vc_scratch == NULL)) {
+			report(RPT_ERR, "malloc failure: %s", strerror(errno));
+			return -1;
+		}
+		memset(vc_buf, ' ', vc_width * vc_height);
+	}
+	return 0;
+}
+
+
+static int open_vcs(void)
+{
+	struct pollfd pfd;
+
 	/* Open the /dev/vcsX and /dev/vcsaX devices */
 	vcs0 = open(vcs_device, O_RDONLY);
 	if (vcs0 < 0) {
@@ -45,17 +126,32 @@ int open_vcs(void)
 		report(RPT_ERR, "Could not open %s: %s", vcsa_device, strerror(errno));
 		return -1;
 	}
+
+	/* The kernel raises POLLPRI on vcsa when the console changes, and
+	 * clears it when we read. POLLERR means it cannot notify us. */
+	pfd.fd = vcsa;
+	pfd.events = POLLPRI;
+	if ((poll(&pfd, 1, 0) >= 0) && !(pfd.revents & POLLERR)) {
+		console_fd = vcsa;
+		console_events = POLLPRI;
+	}
+	else {
+		report(RPT_INFO, "%s does not support poll, polling periodically", vcsa_device);
+	}
 	return 0;
 }
 
 
-int read_vcdata(void)
+static int read_vcs(void)
 {
 	unsigned short new_vc_height;
 	unsigned short new_vc_width;
+	unsigned short new_cursor_x, new_cursor_y;
+	int changed = 0;
 
 	int bytes_read;
 	unsigned char buf[20];
+	char *tmp;
 
 	/* Read size and cursor position from /dev/vcsa */
 	lseek(vcsa, 0, SEEK_SET);
@@ -66,32 +162,147 @@ int read_vcdata(void)
 	}
 	new_vc_height = buf[0];
 	new_vc_width = buf[1];
-	vc_cursor_x = buf[2];
-	vc_cursor_y = buf[3];
+	new_cursor_x = buf[2];
+	new_cursor_y = buf[3];
 
 	/* Screen resize or initial buffer allocation ? */
 	if ((new_vc_width != vc_width) || (new_vc_height != vc_height)) {
-		vc_width = new_vc_width;
-		vc_height = new_vc_height;
-
-		if (vc_width * vc_height > 0) {
-			vc_buf = realloc(vc_buf, vc_width * vc_height);
-
-			if (vc_buf == NULL) {
-				report(RPT_ERR, "malloc failure: %s", strerror(errno));
-				return -1;
-			}
-			memset(vc_buf, ' ', vc_width * vc_height);
-		}
+		if (resize_console(new_vc_width, new_vc_height) < 0)
+			return -1;
+		changed = 1;
+	}
+	if ((new_cursor_x != vc_cursor_x) || (new_cursor_y != vc_cursor_y)) {
+		vc_cursor_x = new_cursor_x;
+		vc_cursor_y = new_cursor_y;
+		changed = 1;
 	}
 
 	/* Read characters from /dev/cvs0 */
 	lseek(vcs0, 0, SEEK_SET);
-	bytes_read = read(vcs0, vc_buf, vc_width * vc_height);
+	bytes_read = read(vcs0, vc_scratch, vc_width * vc_height);
 	if (bytes_read != vc_width * vc_height) {
 		report(RPT_ERR, "Could not read from %s", vcs_device);
 		return -1;
 	}
+	if (memcmp(vc_scratch, vc_buf, vc_width * vc_height) != 0) {
+		tmp = vc_buf;
+		vc_buf = vc_scratch;
+		vc_scratch = tmp;
+		changed = 1;
+	}
+	return changed;
+}
+
+
+/* State of the minimal terminal used by the file source */
+static unsigned short term_x = 0, term_y = 0;
+static enum { TERM_NORMAL, TERM_ESC, TERM_CSI } term_state = TERM_NORMAL;
+
+
+/** Advance the terminal to the next line, scrolling at the bottom */
+static void term_newline(void)
+{
+	if (term_y + 1 < vc_height) {
+		term_y++;
+		return;
+	}
+	memmove(vc_buf, vc_buf + vc_width, vc_width * (vc_height - 1));
+	memset(vc_buf + vc_width * (vc_height - 1), ' ', vc_width);
+}
+
+
+/** Feed one character of output to the terminal.
+ * Escape sequences are skipped; only the basic control characters work.
+ */
+static void term_put(unsigned char ch)
+{
+	switch (term_state) {
+	  case TERM_ESC:
+		term_state = (ch == '[') ? TERM_CSI : TERM_NORMAL;
+		return;
+	  case TERM_CSI:
+		if ((ch >= 0x40) && (ch <= 0x7E))
+			term_state = TERM_NORMAL;
+		return;
+	  case TERM_NORMAL:
+		break;
+	}
+
+	switch (ch) {
+	  case 0x1B:
+		term_state = TERM_ESC;
+		break;
+	  case '\n':
+		term_x = 0;
+		term_newline();
+		break;
+	  case '\r':
+		term_x = 0;
+		break;
+	  case '\b':
+		if (term_x > 0)
+			term_x--;
+		break;
+	  case '\t':
+		term_x = min((term_x + 8) & ~7, vc_width - 1);
+		break;
+	  default:
+		if (ch < 32)
+			break;
+		if (term_x >= vc_width) {
+			term_x = 0;
+			term_newline();
+		}
+		vc_buf[vc_width * term_y + term_x++] = ch;
+	}
+}
+
+
+static int open_file(void)
+{
+	struct stat st;
+
+	console_fd = open(console_file, O_RDONLY | O_NONBLOCK | O_NOCTTY);
+	if (console_fd < 0) {
+		report(RPT_ERR, "Could not open %s: %s", console_file, strerror(errno));
+		return -1;
+	}
+	/* Regular files are always readable, so poll() can't tell us about
+	 * new data: read them periodically like tail -f does. */
+	if ((fstat(console_fd, &st) == 0) && S_ISREG(st.st_mode))
+		console_events = 0;
+	else
+		console_events = POLLIN;
+
+	if (resize_console(console_width, console_height) < 0)
+		return -1;
 	return 0;
 }
 
+
+static int read_file(void)
+{
+	unsigned char buf[1024];
+	int bytes_read;
+	int changed = 0;
+	int i;
+
+	while ((bytes_read = read(console_fd, buf, sizeof(buf))) > 0) {
+		for (i = 0; i < bytes_read; i++)
+			term_put(buf[i]);
+		changed = 1;
+	}
+	if ((bytes_read < 0) && (errno != EAGAIN)) {
+		report(RPT_ERR, "Could not read from %s: %s", console_file, strerror(errno));
+		return -1;
+	}
+	if ((bytes_read == 0) && (console_events != 0)) {
+		/* The writer of the FIFO or pty has gone: stop watching it */
+		report(RPT_INFO, "End of %s", console_file);
+		console_events = 0;
+	}
+
+	vc_cursor_x = min(term_x, vc_width - 1);
+	vc_cursor_y = term_y;
+	return changed;
+}
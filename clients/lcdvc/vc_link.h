@@ -5,7 +5,14 @@ extern unsigned short vc_width, vc_height;
 extern unsigned short vc_cursor_x, vc_cursor_y;
 extern char *vc_buf;
 
-int open_vcs(void);
+/* Open the configured console source */
+int open_console(void);
+
+/* Update the console data; returns 1 if it changed, 0 if not, <0 on error */
 int read_vcdata(void);
 
+/* Descriptor and poll() events that signal a console change, or -1 if the
+ * source has to be polled periodically */
+int console_poll_fd(short *events);
+
 #endif
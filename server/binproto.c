@@ -0,0 +1,427 @@
+/** \file server/binproto.c
+ * Parser of the compact binary client protocol.
+ *
+ * Clients that selected the binary protocol with \c "hello -binary" send
+ * length prefixed frames (see shared/binproto.h). The native commands work
+ * on handles and integers directly, so frequent widget updates need neither
+ * tokenizing nor number parsing nor a \c success response. Any text protocol
+ * command can still be sent wrapped into a BIN_CMD_TEXT frame.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "shared/report.h"
+#include "shared/sockets.h"
+#include "shared/binproto.h"
+
+#include "client.h"
+#include "screen.h"
+#include "widget.h"
+#include "drivers.h"
+#include "parse.h"
+#include "binproto.h"
+
+
+/** Read an unsigned 16 bit value in network byte order */
+static inline int get_u16(const unsigned char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+/** Read a signed 16 bit value in network byte order */
+static inline int get_s16(const unsigned char *p)
+{
+	return (int16_t) ((p[0] << 8) | p[1]);
+}
+
+/**
+ * Usage: BIN_CMD_TEXT <text command line>
+ */
+static void
+bin_text(Client *c, const unsigned char *p, int len)
+{
+	char str[len + 1];
+
+	memcpy(str, p, len);
+	str[len] = '\0';
+	parse_message(str, c);
+}
+
+
+/**
+ * Usage: BIN_CMD_SCREEN_ADD <screenid>
+ */
+static void
+bin_screen_add(Client *c, const unsigned char *p, int len)
+{
+	char id[len + 1];
+	Screen *s;
+
+	if (len == 0) {
+		sock_send_error(c->sock, "Usage: screen_add <screenid>\n");
+		return;
+	}
+	memcpy(id, p, len);
+	id[len] = '\0';
+
+	if (client_find_screen(c, id) != NULL) {
+		sock_send_error(c->sock, "Screen already exists\n");
+		return;
+	}
+
+	s = screen_create(id, c);
+	if (s == NULL) {
+		sock_send_error(c->sock, "failed to create screen\n");
+		return;
+	}
+	s->handle = client_add_handle(c, HANDLE_SCREEN, s);
+	if (s->handle < 0) {
+		s->handle = 0;
+		screen_destroy(s);
+		sock_send_error(c->sock, "Too many handles\n");
+		return;
+	}
+	if (client_add_screen(c, s) < 0) {
+		screen_destroy(s);
+		sock_send_error(c->sock, "failed to add screen\n");
+		return;
+	}
+
+	report(RPT_INFO, "Client on socket %d added screen \"%s\"", c->sock, s->id);
+	sock_printf(c->sock, "handle %d\n", s->handle);
+}
+
+
+/**
+ * Usage: BIN_CMD_SCREEN_DEL <screen handle>
+ */
+static void
+bin_screen_del(Client *c, const unsigned char *p, int len)
+{
+	Screen *s;
+
+	if (len != 2) {
+		sock_send_error(c->sock, "Usage: screen_del <screenid>\n");
+		return;
+	}
+	s = client_get_handle(c, get_u16(p), HANDLE_SCREEN);
+	if (s == NULL) {
+		sock_send_error(c->sock, "Unknown screen id\n");
+		return;
+	}
+
+	report(RPT_INFO, "Client on socket %d removed screen \"%s\"", c->sock, s->id);
+	client_remove_screen(c, s);
+	screen_destroy(s);
+}
+
+
+/**
+ * Usage: BIN_CMD_WIDGET_ADD <screen handle> <frame handle> <type> <widgetid>
+ */
+static void
+bin_widget_add(Client *c, const unsigned char *p, int len)
+{
+	Screen *s;
+	Widget *w;
+	int type;
+
+	if (len < 6) {
+		sock_send_error(c->sock, "Usage: widget_add <screenid> <widgetid> <widgettype> [-in <id>]\n");
+		return;
+	}
+
+	s = client_get_handle(c, get_u16(p), HANDLE_SCREEN);
+	if (s == NULL) {
+		sock_send_error(c->sock, "Invalid screen id\n");
+		return;
+	}
+	if (get_u16(p + 2) != 0) {
+		Widget *frame = client_get_handle(c, get_u16(p + 2), HANDLE_WIDGET);
+
+		if ((frame == NULL) || (frame->type != WID_FRAME)) {
+			sock_send_error(c->sock, "Error finding frame\n");
+			return;
+		}
+		s = frame->frame_screen;
+	}
+
+	type = p[4];
+	if ((type <= WID_NONE) || (type > WID_BIGCLOCK)) {
+		sock_send_error(c->sock, "Invalid widget type\n");
+		return;
+	}
+
+	{
+		char id[len - 5 + 1];
+
+		memcpy(id, p + 5, len - 5);
+		id[len - 5] = '\0';
+		w = widget_create(id, type, s);
+	}
+	if (w == NULL) {
+		sock_send_error(c->sock, "Error adding widget\n");
+		return;
+	}
+	w->handle = client_add_handle(c, HANDLE_WIDGET, w);
+	if (w->handle < 0) {
+		w->handle = 0;
+		widget_destroy(w);
+		sock_send_error(c->sock, "Too many handles\n");
+		return;
+	}
+	screen_add_widget(s, w);
+
+	sock_printf(c->sock, "handle %d\n", w->handle);
+}
+
+
+/**
+ * Usage: BIN_CMD_WIDGET_DEL <widget handle>
+ *
+ * Unlike the text command, this also frees the widget.
+ */
+static void
+bin_widget_del(Client *c, const unsigned char *p, int len)
+{
+	Widget *w;
+
+	if (len != 2) {
+		sock_send_error(c->sock, "Usage: widget_del <screenid> <widgetid>\n");
+		return;
+	}
+	w = client_get_handle(c, get_u16(p), HANDLE_WIDGET);
+	if (w == NULL) {
+		sock_send_error(c->sock, "Invalid widget id\n");
+		return;
+	}
+
+	screen_remove_widget(w->screen, w);
+	widget_destroy(w);
+}
+
+
+/**
+ * Usage: BIN_CMD_WIDGET_SET <widget handle> <widget-SPECIFIC-data>
+ *
+ * The widget specific data is listed in shared/binproto.h.
+ */
+static void
+bin_widget_set(Client *c, const unsigned char *p, int len)
+{
+	Widget *w;
+	Widget old;
+	int changed = 0;
+
+	if (len < 2) {
+		sock_send_error(c->sock, "Usage: widget_set <screenid> <widgetid> <widget-SPECIFIC-data>\n");
+		return;
+	}
+	w = client_get_handle(c, get_u16(p), HANDLE_WIDGET);
+	if (w == NULL) {
+		sock_send_error(c->sock, "Unknown widget id\n");
+		return;
+	}
+	p += 2;
+	len -= 2;
+
+	old = *w;
+	switch (w->type) {
+	case WID_STRING:		/* String takes "x y text" */
+	case WID_CLOCK:			/* Clock takes "x y format" */
+		if (len < 4) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if ((get_s16(p) < 0) || (get_s16(p + 2) < 0)) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		w->x = get_s16(p);
+		w->y = get_s16(p + 2);
+		changed = widget_set_text(w, (const char *) p + 4, len - 4);
+		break;
+	case WID_HBAR:			/* Hbar takes "x y length" */
+	case WID_VBAR:			/* Vbar takes "x y length" */
+		if (len != 6) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if ((get_s16(p) < 0) || (get_s16(p + 2) < 0)) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		w->x = get_s16(p);
+		w->y = get_s16(p + 2);
+		w->length = get_s16(p + 4);
+		break;
+	case WID_PBAR:			/* Pbar takes "x y width promille" */
+		if (len != 8) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if ((get_s16(p) < 0) || (get_s16(p + 2) < 0)) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		changed = widget_set_labels(w, NULL, NULL);
+		w->x = get_s16(p);
+		w->y = get_s16(p + 2);
+		w->width = get_s16(p + 4);
+		w->promille = get_s16(p + 6);
+		break;
+	case WID_ICON:			/* Icon takes "x y icon" */
+		if (len != 6) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if ((get_s16(p) < 0) || (get_s16(p + 2) < 0)) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		if (widget_icon_to_iconname(get_s16(p + 4)) == NULL) {
+			sock_send_error(c->sock, "Invalid icon name\n");
+			return;
+		}
+		w->x = get_s16(p);
+		w->y = get_s16(p + 2);
+		w->length = get_s16(p + 4);
+		break;
+	case WID_TITLE:			/* title takes "text" */
+		changed = widget_set_text(w, (const char *) p, len);
+		w->width = drivers_display_props(w->screen->display)->width;
+		break;
+	case WID_SCROLLER:		/* Scroller takes "left top right bottom speed direction text" */
+		if (len < 11) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if ((get_s16(p) < 0) || (get_s16(p + 2) < 0) ||
+		    (get_s16(p + 4) < 0) || (get_s16(p + 6) < 0)) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		if ((p[10] != 'h') && (p[10] != 'v') && (p[10] != 'm')) {
+			sock_send_error(c->sock, "Invalid direction\n");
+			return;
+		}
+		w->left = get_s16(p);
+		w->top = get_s16(p + 2);
+		w->right = get_s16(p + 4);
+		w->bottom = get_s16(p + 6);
+		w->speed = get_s16(p + 8);
+		w->length = p[10];
+		changed = widget_set_text(w, (const char *) p + 11, len - 11);
+		break;
+	case WID_NUM:			/* Num takes "x num" */
+		if (len != 4) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if (get_s16(p) < 0) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		if (get_s16(p + 2) < 0) {
+			sock_send_error(c->sock, "Invalid number\n");
+			return;
+		}
+		w->x = get_s16(p);
+		w->y = get_s16(p + 2);
+		break;
+	case WID_BIGCLOCK:		/* Bigclock takes "x format" */
+		if (len < 2) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return;
+		}
+		if (get_s16(p) < 0) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return;
+		}
+		w->x = get_s16(p);
+		changed = widget_set_text(w, (const char *) p + 2, len - 2);
+		break;
+	case WID_FRAME:
+		sock_send_error(c->sock, "Use a text frame to set frames\n");
+		return;
+	case WID_NONE:
+	default:
+		sock_send_error(c->sock, "Widget has no type\n");
+		return;
+	}
+
+	if (changed < 0)
+		sock_send_error(c->sock, "Out of memory\n");
+	else if ((changed > 0) || !widget_same_values(&old, w))
+		widget_changed(w);
+}
+
+
+/** Execute all complete frames in the client's receive buffer.
+ * Incomplete frames stay in the buffer until the rest has arrived.
+ * \param c  The client.
+ */
+void
+parse_binary_messages(Client *c)
+{
+	const unsigned char *buf = (const unsigned char *) c->inbuf;
+	int pos = 0;
+
+	debug(RPT_DEBUG, "%s(client=[%d])", __FUNCTION__, c->sock);
+
+	/* Frames wait while events are queued, as their replies would overtake them */
+	while ((c->inbuf_len - pos >= BINPROTO_HEADER_SIZE) && (c->state != GONE)
+	       && !client_events_pending(c)) {
+		int len = get_u16(buf + pos);
+		const unsigned char *body = buf + pos + BINPROTO_HEADER_SIZE;
+
+		if (len == 0) {
+			report(RPT_WARNING, "Invalid frame from client on socket %d", c->sock);
+			sock_send_error(c->sock, "Invalid frame\n");
+			c->state = GONE;
+			break;
+		}
+		if (c->inbuf_len - pos < 2 + len)
+			break;
+
+		switch (buf[pos + 2]) {
+		case BIN_CMD_TEXT:
+			bin_text(c, body, len - 1);
+			break;
+		case BIN_CMD_SCREEN_ADD:
+			bin_screen_add(c, body, len - 1);
+			break;
+		case BIN_CMD_SCREEN_DEL:
+			bin_screen_del(c, body, len - 1);
+			break;
+		case BIN_CMD_WIDGET_ADD:
+			bin_widget_add(c, body, len - 1);
+			break;
+		case BIN_CMD_WIDGET_DEL:
+			bin_widget_del(c, body, len - 1);
+			break;
+		case BIN_CMD_WIDGET_SET:
+			bin_widget_set(c, body, len - 1);
+			break;
+		default:
+			sock_printf_error(c->sock, "Invalid command \"%d\"\n", buf[pos + 2]);
+			report(RPT_WARNING, "Invalid binary command from client on socket %d: %d",
+				c->sock, buf[pos + 2]);
+		}
+		pos += 2 + len;
+	}
+
+	if (pos > 0) {
+		c->inbuf_len -= pos;
+		memmove(c->inbuf, c->inbuf + pos, c->inbuf_len);
+	}
+}
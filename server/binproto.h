@@ -0,0 +1,21 @@
+/** \file server/binproto.h
+ * Interface to the parser of the binary client protocol.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef BINPROTO_SERVER_H
+#define BINPROTO_SERVER_H
+
+#define INC_TYPES_ONLY 1
+#include "client.h"
+#undef INC_TYPES_ONLY
+
+/* Execute all complete frames in the client's receive buffer */
+void parse_binary_messages(Client *c);
+
+#endif
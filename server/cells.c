@@ -0,0 +1,258 @@
+/** \file server/cells.c
+ * Composition of screens into cell buffers.
+ *
+ * A cell buffer holds what a screen looks like independent of the drivers:
+ * a character for every cell, and the bars, icons and big numbers whose
+ * look depends on the driver as operations that own the cells they cover.
+ * Drawing into a buffer follows the rules of drawing into a driver: later
+ * drawing covers earlier drawing and everything is clipped to the display.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shared/report.h"
+
+#include "drivers.h"
+#include "cells.h"
+
+/** Owners are shorts, so this is the number of operations that fit */
+#define MAX_OPS	32767
+
+
+/**
+ * Create a blank cell buffer.
+ * \param width   Number of columns.
+ * \param height  Number of rows.
+ * \return  The buffer, or NULL on error.
+ */
+CellBuffer *
+cells_create(int width, int height)
+{
+	CellBuffer *cb = calloc(1, sizeof(CellBuffer));
+
+	if (cb == NULL) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return NULL;
+	}
+	cb->width = width;
+	cb->height = height;
+	cb->chars = malloc(width * height);
+	cb->owner = malloc(width * height * sizeof(short));
+	if ((cb->chars == NULL) || (cb->owner == NULL)) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		cells_destroy(cb);
+		return NULL;
+	}
+	cells_clear(cb);
+	return cb;
+}
+
+
+/**
+ * Free a cell buffer.
+ * \param cb  The buffer, may be NULL.
+ */
+void
+cells_destroy(CellBuffer *cb)
+{
+	if (cb == NULL)
+		return;
+	free(cb->chars);
+	free(cb->owner);
+	free(cb->ops);
+	free(cb);
+}
+
+
+/**
+ * Blank all cells and forget the operations.
+ * \param cb  The buffer.
+ */
+void
+cells_clear(CellBuffer *cb)
+{
+	int i;
+
+	memset(cb->chars, ' ', cb->width * cb->height);
+	for (i = 0; i < cb->width * cb->height; i++)
+		cb->owner[i] = -1;
+	cb->num_ops = 0;
+}
+
+
+/**
+ * Copy a buffer to another one of the same size.
+ * \param dst  Destination.
+ * \param src  Source.
+ */
+void
+cells_copy(CellBuffer *dst, const CellBuffer *src)
+{
+	int cells = src->width * src->height;
+
+	if (dst->ops_size < src->num_ops) {
+		CellOp *ops = realloc(dst->ops, src->num_ops * sizeof(CellOp));
+
+		if (ops == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			cells_clear(dst);
+			return;
+		}
+		dst->ops = ops;
+		dst->ops_size = src->num_ops;
+	}
+	memcpy(dst->chars, src->chars, cells);
+	memcpy(dst->owner, src->owner, cells * sizeof(short));
+	memcpy(dst->ops, src->ops, src->num_ops * sizeof(CellOp));
+	dst->num_ops = src->num_ops;
+}
+
+
+/** Draw a string, like the drivers' string(). */
+void
+cells_string(CellBuffer *cb, int x, int y, const char *str)
+{
+	cells_nstring(cb, x, y, str, cb->width - x + 1);
+}
+
+
+/** Draw at most len characters of a string. */
+void
+cells_nstring(CellBuffer *cb, int x, int y, const char *str, int len)
+{
+	int i;
+
+	if ((y < 1) || (y > cb->height))
+		return;
+
+	for (i = 0; (i < len) && (str[i] != '\0') && (x + i <= cb->width); i++) {
+		if (x + i >= 1) {
+			int pos = (y - 1) * cb->width + x + i - 1;
+
+			cb->chars[pos] = str[i];
+			cb->owner[pos] = -1;
+		}
+	}
+}
+
+
+/* Append an operation; returns its index, or -1 if there is no room */
+static int
+add_op(CellBuffer *cb, int kind, int x, int y, int len, int promille, int arg)
+{
+	CellOp *op;
+
+	if (cb->num_ops == cb->ops_size) {
+		int size = (cb->ops_size > 0) ? 2 * cb->ops_size : 16;
+		CellOp *ops;
+
+		if (size > MAX_OPS)
+			size = MAX_OPS;
+		if (size == cb->ops_size)
+			return -1;
+		ops = realloc(cb->ops, size * sizeof(CellOp));
+		if (ops == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			return -1;
+		}
+		cb->ops = ops;
+		cb->ops_size = size;
+	}
+
+	op = &cb->ops[cb->num_ops];
+	op->kind = kind;
+	op->x = x;
+	op->y = y;
+	op->len = len;
+	op->promille = promille;
+	op->arg = arg;
+	op->begin_label = NULL;
+	op->end_label = NULL;
+	return cb->num_ops++;
+}
+
+
+/* Let an operation own a rectangle of cells, clipped to the buffer */
+static void
+own(CellBuffer *cb, int index, int x1, int y1, int x2, int y2)
+{
+	int x, y;
+
+	if (index < 0)
+		return;
+	for (y = (y1 < 1) ? 1 : y1; (y <= y2) && (y <= cb->height); y++)
+		for (x = (x1 < 1) ? 1 : x1; (x <= x2) && (x <= cb->width); x++)
+			cb->owner[(y - 1) * cb->width + x - 1] = index;
+}
+
+
+/* Number of cells a bar of len cells of the given size fills */
+static int
+bar_cells(int len, int promille, int cellsize)
+{
+	long pixels = ((long) 2 * len * cellsize + 1) * promille / 2000;
+	int cells = (pixels + cellsize - 1) / cellsize;
+
+	return (cells < len) ? cells : len;
+}
+
+
+/** Draw a horizontal bar, like the drivers' hbar(). */
+void
+cells_hbar(CellBuffer *cb, int x, int y, int len, int promille, int pattern)
+{
+	int n = bar_cells(len, promille, display_props->cellwidth);
+
+	own(cb, add_op(cb, CELL_OP_HBAR, x, y, len, promille, pattern), x, y, x + n - 1, y);
+}
+
+
+/** Draw a vertical bar, like the drivers' vbar(). */
+void
+cells_vbar(CellBuffer *cb, int x, int y, int len, int promille, int pattern)
+{
+	int n = bar_cells(len, promille, display_props->cellheight);
+
+	own(cb, add_op(cb, CELL_OP_VBAR, x, y, len, promille, pattern), x, y - n + 1, x, y);
+}
+
+
+/** Draw a percentage bar; the labels must live until the buffer is drawn. */
+void
+cells_pbar(CellBuffer *cb, int x, int y, int width, int promille,
+	   const char *begin_label, const char *end_label)
+{
+	int index = add_op(cb, CELL_OP_PBAR, x, y, width, promille, 0);
+
+	if (index < 0)
+		return;
+	cb->ops[index].begin_label = begin_label;
+	cb->ops[index].end_label = end_label;
+	own(cb, index, x, y, x + width - 1, y);
+}
+
+
+/** Draw an icon, like the drivers' icon(). */
+void
+cells_icon(CellBuffer *cb, int x, int y, int icon)
+{
+	own(cb, add_op(cb, CELL_OP_ICON, x, y, 1, 0, icon), x, y, x, y);
+}
+
+
+/** Draw a big number, like the drivers' num(). Digits are 3 columns wide,
+ * the colon (10) 1 column; they cover all rows. */
+void
+cells_num(CellBuffer *cb, int x, int num)
+{
+	int width = (num == 10) ? 1 : 3;
+
+	own(cb, add_op(cb, CELL_OP_NUM, x, 1, width, 0, num), x, 1, x + width - 1, cb->height);
+}
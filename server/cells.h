@@ -0,0 +1,35 @@
+/** \file server/cells.h
+ * Composition of screens into cell buffers.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef CELLS_H
+#define CELLS_H
+
+#include "drivers/lcd.h"
+
+CellBuffer *cells_create(int width, int height);
+void cells_destroy(CellBuffer *cb);
+
+/* Blank all cells and forget the operations */
+void cells_clear(CellBuffer *cb);
+
+/* Copy a buffer of the same size */
+void cells_copy(CellBuffer *dst, const CellBuffer *src);
+
+/* Drawing; coordinates are 1-based like those of the drivers */
+void cells_string(CellBuffer *cb, int x, int y, const char *str);
+void cells_nstring(CellBuffer *cb, int x, int y, const char *str, int len);
+void cells_hbar(CellBuffer *cb, int x, int y, int len, int promille, int pattern);
+void cells_vbar(CellBuffer *cb, int x, int y, int len, int promille, int pattern);
+void cells_pbar(CellBuffer *cb, int x, int y, int width, int promille,
+		const char *begin_label, const char *end_label);
+void cells_icon(CellBuffer *cb, int x, int y, int icon);
+void cells_num(CellBuffer *cb, int x, int num);
+
+#endif
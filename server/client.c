@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -25,8 +26,12 @@
 #include "render.h"
 #include "input.h"
 #include "menuscreens.h"
+#include "schedule.h"
 #include "shared/report.h"
 #include "shared/LL.h"
+#include "shared/binproto.h"
+#include "shared/sockets.h"
+#include "shared/defines.h"
 
 Client *client_create(int sock)
 {
@@ -57,6 +62,20 @@ Client *client_create(int sock)
 	c->state = NEW;
 	c->name = NULL;
 	c->menu = NULL;
+	c->binary = 0;
+	c->utf8 = 0;
+	c->inbuf = NULL;
+	c->inbuf_len = 0;
+	c->handles = NULL;
+	c->handles_size = 0;
+	c->handles_used = 1;
+	c->handles_free = 0;
+	c->sleep_until = 0;
+	c->scheduled = 0;
+	c->outbuf = NULL;
+	c->outbuf_len = 0;
+	c->outbuf_size = 0;
+	c->outbuf_last = -1;
 
 	c->screenlist = LL_new();
 
@@ -85,6 +104,9 @@ client_destroy(Client *c)
 	}
 	LL_Destroy(c->messages);
 
+	/* Forget its scheduled commands */
+	schedule_drop_client(c);
+
 	/* Clean up the screenlist...*/
 	debug(RPT_DEBUG, "%s: Cleaning screenlist", __FUNCTION__);
 
@@ -119,6 +141,11 @@ client_destroy(Client *c)
 	if (c->name)
 		free(c->name);
 
+	/* The screens are gone, and so are the handles referring to them */
+	free(c->handles);
+	free(c->inbuf);
+	free(c->outbuf);
+
 	/* Remove structure */
 	free(c);
 
@@ -167,6 +194,7 @@ Screen *
 client_find_screen(Client *c, char *id)
 {
 	Screen *s;
+	LL_iter it;
 
 	if (!c)
 		return NULL;
@@ -175,14 +203,12 @@ client_find_screen(Client *c, char *id)
 
 	debug(RPT_DEBUG, "%s(c=[%d], id=\"%s\")", __FUNCTION__, c->sock, id);
 
-	LL_Rewind(c->screenlist);
-	do {
-		s = LL_Get(c->screenlist);
-		if ((s) && (0 == strcmp(s->id, id))) {
+	LL_ForEach(c->screenlist, it, s) {
+		if (0 == strcmp(s->id, id)) {
 			debug(RPT_DEBUG, "%s: Found %s", __FUNCTION__, id);
 			return s;
 		}
-	} while (LL_Next(c->screenlist) == 0);
+	}
 
 	return NULL;
 }
@@ -228,3 +254,207 @@ int client_screen_count(Client *c)
 {
 	return LL_Length(c->screenlist);
 }
+
+
+/** Switch a client to the binary protocol.
+ * \param c  The client.
+ * \retval <0  Error allocating the receive buffer.
+ * \retval  0  Success.
+ */
+int
+client_set_binary(Client *c)
+{
+	if (c->binary)
+		return 0;
+
+	c->inbuf = malloc(BINPROTO_BUFFER_SIZE);
+	if (c->inbuf == NULL) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return -1;
+	}
+	c->inbuf_len = 0;
+	c->binary = 1;
+	return 0;
+}
+
+
+/** Allocate a handle for a screen or widget of the client.
+ * Handles are small positive numbers; released ones are reused first, the
+ * last released one first, so no search is needed.
+ * \param c     The client.
+ * \param kind  Kind of the object.
+ * \param ptr   The object.
+ * \return      The handle, or -1 on error.
+ */
+int
+client_add_handle(Client *c, HandleKind kind, void *ptr)
+{
+	int h;
+
+	if (c->handles_free != 0) {
+		h = c->handles_free;
+		c->handles_free = c->handles[h].next_free;
+		c->handles[h].kind = kind;
+		c->handles[h].ptr = ptr;
+		return h;
+	}
+
+	h = c->handles_used;
+	if (h >= c->handles_size) {
+		ClientHandle *tmp;
+		int size = (c->handles_size > 0) ? c->handles_size * 2 : 16;
+
+		if (size > BINPROTO_MAX_HANDLES)
+			size = BINPROTO_MAX_HANDLES;
+		if (h >= size)
+			return -1;
+		tmp = realloc(c->handles, size * sizeof(ClientHandle));
+		if (tmp == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			return -1;
+		}
+		memset(tmp + c->handles_size, 0,
+		       (size - c->handles_size) * sizeof(ClientHandle));
+		c->handles = tmp;
+		c->handles_size = size;
+	}
+	c->handles_used++;
+	c->handles[h].kind = kind;
+	c->handles[h].ptr = ptr;
+	return h;
+}
+
+
+/** Look up a handle of the client.
+ * \param c       The client.
+ * \param handle  The handle.
+ * \param kind    Expected kind of the object.
+ * \return        The object, or NULL if the handle is invalid.
+ */
+void *
+client_get_handle(Client *c, int handle, HandleKind kind)
+{
+	if ((handle <= 0) || (handle >= c->handles_size))
+		return NULL;
+	if (c->handles[handle].kind != kind)
+		return NULL;
+	return c->handles[handle].ptr;
+}
+
+
+/** Release a handle of the client.
+ * \param c       The client.
+ * \param handle  The handle.
+ */
+void
+client_drop_handle(Client *c, int handle)
+{
+	if ((c == NULL) || (handle <= 0) || (handle >= c->handles_size))
+		return;
+	if (c->handles[handle].kind == HANDLE_FREE)
+		return;
+	c->handles[handle].kind = HANDLE_FREE;
+	c->handles[handle].ptr = NULL;
+	c->handles[handle].next_free = c->handles_free;
+	c->handles_free = handle;
+}
+
+
+/** Send an event line (\c listen, \c ignore, \c key) to a client without
+ * waiting for it. What the socket does not take is kept and sent by
+ * client_flush_events() once the client reads again. An event that equals
+ * the last one still waiting is dropped, as the client has not seen that
+ * one yet.
+ * \param c      The client.
+ * \param event  The preformatted line, including the newline.
+ * \param len    Its length.
+ * \retval <0  The event was lost: socket error or too many waiting.
+ * \retval  0  Success.
+ */
+int
+client_send_event(Client *c, const char *event, int len)
+{
+	int sent = 0;
+
+	if (c->outbuf_len == 0) {
+		sent = write(c->sock, event, len);
+		if (sent == len)
+			return 0;
+		if (sent < 0) {
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+				report(RPT_ERR, "%s: socket write error", __FUNCTION__);
+				return -1;
+			}
+			sent = 0;
+		}
+	}
+	else if ((c->outbuf_last >= 0) && (c->outbuf_len - c->outbuf_last == len)
+		 && (memcmp(c->outbuf + c->outbuf_last, event, len) == 0)) {
+		debug(RPT_DEBUG, "%s: coalesced event for client on socket %d",
+		      __FUNCTION__, c->sock);
+		return 0;
+	}
+
+	if (c->outbuf_len + len - sent > c->outbuf_size) {
+		int size = c->outbuf_len + len - sent;
+		char *p;
+
+		if (size > CLIENT_OUTBUF_MAX) {
+			report(RPT_WARNING, "%s: client on socket %d does not read, event dropped",
+			       __FUNCTION__, c->sock);
+			return -1;
+		}
+		size = (size < 256) ? 256 : min(2 * size, CLIENT_OUTBUF_MAX);
+		p = realloc(c->outbuf, size);
+		if (p == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			return -1;
+		}
+		c->outbuf = p;
+		c->outbuf_size = size;
+	}
+
+	/* A partly sent event cannot be coalesced with */
+	c->outbuf_last = (sent == 0) ? c->outbuf_len : -1;
+	memcpy(c->outbuf + c->outbuf_len, event + sent, len - sent);
+	c->outbuf_len += len - sent;
+	return 0;
+}
+
+
+/** Send as many of a client's pending events as its socket takes.
+ * \param c  The client.
+ * \retval <0  Socket error.
+ * \retval  0  Success; events may still be pending.
+ */
+int
+client_flush_events(Client *c)
+{
+	int sent;
+
+	if (c->outbuf_len == 0)
+		return 0;
+
+	sent = write(c->sock, c->outbuf, c->outbuf_len);
+	if (sent < 0)
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+
+	c->outbuf_len -= sent;
+	memmove(c->outbuf, c->outbuf + sent, c->outbuf_len);
+	if (c->outbuf_last >= 0)
+		c->outbuf_last = (c->outbuf_last >= sent) ? c->outbuf_last - sent : -1;
+	return 0;
+}
+
+
+/** Tell whether events still wait for the client's socket. The replies to
+ * the client's commands must not overtake them, so its commands are not
+ * executed until client_flush_events() has sent them all.
+ * \param c  The client.
+ * \return  1 if events are waiting, 0 if the client may be answered.
+ */
+int
+client_events_pending(Client *c)
+{
+	return (c->outbuf_len > 0);
+}
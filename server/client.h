@@ -28,6 +28,9 @@
 
 #define CLIENT_NAME_SIZE 256
 
+/** Most bytes of events kept for a client that does not read them */
+#define CLIENT_OUTBUF_MAX 16384
+
 /** Possible states of a client. */
 typedef enum _clientstate {
 	NEW,			/**< Client did not yet send \c hello. */
@@ -36,6 +39,21 @@ typedef enum _clientstate {
 } ClientState;
 
 
+/** Kinds of objects a binary protocol handle can refer to. */
+typedef enum _handlekind {
+	HANDLE_FREE = 0,	/**< Slot is unused. */
+	HANDLE_SCREEN,		/**< Handle of a Screen. */
+	HANDLE_WIDGET		/**< Handle of a Widget. */
+} HandleKind;
+
+/** Entry of a client's handle table. */
+typedef struct ClientHandle {
+	HandleKind kind;
+	void *ptr;
+	int next_free;		/**< Next free entry while this one is free; 0 ends. */
+} ClientHandle;
+
+
 /** The structure representing a client in the server. */
 typedef struct Client {
 	char *name;
@@ -48,6 +66,23 @@ typedef struct Client {
 	LinkedList *screenlist;		/**< List of client's screens. */
 
 	void* menu;			/**< Menu hierarchy, if any */
+
+	int binary;			/**< Client uses the binary protocol. */
+	int utf8;			/**< Client sends text in UTF-8. */
+	char *inbuf;			/**< Unparsed binary frames. */
+	int inbuf_len;			/**< Bytes used in \c inbuf. */
+	ClientHandle *handles;		/**< Handle table; index 0 is unused. */
+	int handles_size;		/**< Number of entries in \c handles. */
+	int handles_used;		/**< Entries below this one were handed out. */
+	int handles_free;		/**< First released entry, 0 if none. */
+
+	long sleep_until;		/**< Render tick the client sleeps until, 0 if awake. */
+	int scheduled;			/**< Number of commands in the schedule. */
+
+	char *outbuf;			/**< Events the socket did not take yet. */
+	int outbuf_len;			/**< Bytes used in \c outbuf. */
+	int outbuf_size;		/**< Bytes allocated for \c outbuf. */
+	int outbuf_last;		/**< Start of the last whole event in \c outbuf, or -1. */
 } Client;
 
 #endif
@@ -84,5 +119,26 @@ int client_remove_screen(Client *c, Screen *s);
 
 int client_screen_count(Client *c);
 
+/* Switch the client to the binary protocol */
+int client_set_binary(Client *c);
+
+/* Allocate a binary protocol handle for a screen or widget */
+int client_add_handle(Client *c, HandleKind kind, void *ptr);
+
+/* Look up a handle; NULL if it is unknown or of another kind */
+void *client_get_handle(Client *c, int handle, HandleKind kind);
+
+/* Release a handle */
+void client_drop_handle(Client *c, int handle);
+
+/* Send an event line without blocking; the rest is sent later */
+int client_send_event(Client *c, const char *event, int len);
+
+/* Send as many pending events as the socket takes */
+int client_flush_events(Client *c);
+
+/* Tell whether events wait to be sent; replies must wait for them */
+int client_events_pending(Client *c);
+
 #endif
 #endif
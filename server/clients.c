@@ -97,15 +97,15 @@ clients_remove_client(Client *c, Direction whereto)
 }
 
 Client *
-clients_getfirst(void)
+clients_getfirst(LL_iter *it)
 {
-	return (Client *) LL_GetFirst(clientlist);
+	return (Client *) LL_IterFirst(clientlist, it);
 }
 
 Client *
-clients_getnext(void)
+clients_getnext(LL_iter *it)
 {
-	return (Client *) LL_GetNext(clientlist);
+	return (Client *) LL_IterNext(it);
 }
 
 int
@@ -123,10 +123,11 @@ Client *
 clients_find_client_by_sock(int sock)
 {
 	Client *c;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(sock=%i)", __FUNCTION__, sock);
 
-	for (c = LL_GetFirst(clientlist); c; c = LL_GetNext(clientlist)) {
+	LL_ForEach(clientlist, it, c) {
 		if (c->sock == sock) {
 			return c;
 		}
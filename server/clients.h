@@ -23,9 +23,9 @@ int clients_shutdown(void);
 Client *clients_add_client(Client *c);
 Client *clients_remove_client(Client *c, Direction whereto);
 
-/* List functions */
-Client *clients_getfirst(void);
-Client *clients_getnext(void);
+/* List functions; the current client may be removed while iterating */
+Client *clients_getfirst(LL_iter *it);
+Client *clients_getnext(LL_iter *it);
 int clients_client_count(void);
 
 /* Search for a client with a particular filedescriptor...*/
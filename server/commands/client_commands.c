@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <errno.h>
 
@@ -54,8 +55,16 @@ test_func_func(Client *c, int argc, char **argv)
  *
  * It sends back a string of info about the server to the client.
  *
+ * With the \c -binary option everything the client sends after having
+ * received this response is read in the framed binary format described in
+ * shared/binproto.h; the response then ends with \c "binary 1".
+ *
+ * If LCDd drives several logical displays, \c "displays <n>" and a
+ * \c "display <d> <wid>x<hgt> <cellwid>x<cellhgt>" for each further one
+ * follow the properties of display 0.
+ *
  *\verbatim
- * Usage: hello
+ * Usage: hello [-binary]
  *\endverbatim
  *
  * \todo  Give \em real info about the server/lcd
@@ -63,16 +72,55 @@ test_func_func(Client *c, int argc, char **argv)
 int
 hello_func(Client *c, int argc, char **argv)
 {
-	if (argc > 1) {
-		sock_send_error(c->sock, "extra parameters ignored\n");
+	int binary = 0;
+	int i;
+	char displays[64 + 40 * MAX_DISPLAYS];
+
+	for (i = 1; i < argc; i++) {
+		char *p = argv[i];
+
+		/* ignore leading '-' in options: we allow both forms */
+		if (*p == '-')
+			p++;
+
+		if (strcmp(p, "binary") == 0) {
+			binary = 1;
+		}
+		else {
+			sock_send_error(c->sock, "extra parameters ignored\n");
+			break;
+		}
+	}
+
+	if (binary && (client_set_binary(c) < 0)) {
+		sock_send_error(c->sock, "binary protocol not available\n");
+		binary = 0;
 	}
 
 	debug(RPT_INFO, "Hello!");
 
-	sock_printf(c->sock, "connect LCDproc %s protocol %s lcd wid %i hgt %i cellwid %i cellhgt %i\n",
+	/* Sizes of the displays other than display 0, if there are any */
+	displays[0] = '\0';
+	if (num_displays > 1) {
+		int len = snprintf(displays, sizeof(displays), " displays %d", num_displays);
+
+		for (i = 1; i < num_displays; i++) {
+			DisplayProps *props = drivers_display_props(i);
+
+			if (props == NULL)
+				continue;
+			len += snprintf(displays + len, sizeof(displays) - len,
+					" display %d %dx%d %dx%d", i,
+					props->width, props->height,
+					props->cellwidth, props->cellheight);
+		}
+	}
+
+	sock_printf(c->sock, "connect LCDproc %s protocol %s lcd wid %i hgt %i cellwid %i cellhgt %i%s%s\n",
 		VERSION, PROTOCOL_VERSION,
 		display_props->width, display_props->height,
-		display_props->cellwidth, display_props->cellheight);
+		display_props->cellwidth, display_props->cellheight,
+		displays, (binary) ? " binary 1" : "");
 
 	/* make note that client has sent hello */
 	c->state = ACTIVE;
@@ -102,10 +150,11 @@ bye_func(Client *c, int argc, char **argv)
 }
 
 /**
- * Sets info about the client, such as its name
+ * Sets info about the client, such as its name or the character set of
+ * the text it sends (ISO 8859-1 by default).
  *
  *\verbatim
- * Usage: client_set -name <id>
+ * Usage: client_set {-name <id>|-charset {latin1|utf-8}}
  *\endverbatim
  */
 int
@@ -117,7 +166,7 @@ client_set_func(Client *c, int argc, char **argv)
 		return 1;
 
 	if (argc != 3) {
-		sock_send_error(c->sock, "Usage: client_set -name <name>\n");
+		sock_send_error(c->sock, "Usage: client_set {-name <name>|-charset {latin1|utf-8}}\n");
 		return 0;
 	}
 
@@ -151,6 +200,21 @@ client_set_func(Client *c, int argc, char **argv)
 				i++; /* bypass argument (name string)*/
 			}
 		}
+		/* Handle the "charset" option */
+		else if (strcmp(p, "charset") == 0) {
+			i++;
+			if ((strcasecmp(argv[i], "utf-8") == 0) || (strcasecmp(argv[i], "utf8") == 0))
+				c->utf8 = 1;
+			else if ((strcasecmp(argv[i], "latin1") == 0) || (strcasecmp(argv[i], "iso-8859-1") == 0))
+				c->utf8 = 0;
+			else {
+				sock_printf_error(c->sock, "unknown charset (%s)\n", argv[i]);
+				continue;
+			}
+
+			debug(RPT_DEBUG, "client_set: charset=\"%s\"", argv[i]);
+			sock_send_string(c->sock, "success\n");
+		}
 		else {
 			sock_printf_error(c->sock, "invalid parameter (%s)\n", p);
 		}
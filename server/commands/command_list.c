@@ -33,6 +33,7 @@ static client_function commands[] = {
 	{ "screen_add",     screen_add_func     },
 	{ "screen_del",     screen_del_func     },
 	{ "screen_set",     screen_set_func     },
+	{ "screen_raw",     screen_raw_func     },
 	{ "key_add",        key_add_func	},
 	{ "key_del",        key_del_func	},
 	{ "widget_add",     widget_add_func     },
@@ -49,6 +50,8 @@ static client_function commands[] = {
 	{ "noop",           noop_func           },
 	{ "info",           info_func           },
 	{ "sleep",          sleep_func          },
+	{ "after",          after_func          },
+	{ "at",             at_func             },
 	{ "bye",            bye_func            },
 	{ NULL,             NULL},
 };
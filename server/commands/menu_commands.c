@@ -864,6 +864,9 @@ menu_set_main_func(Client *c, int argc, char **argv)
 MenuEventFunc(menu_commands_handler)
 {
 	Client *c;
+	const char *name;
+	char buf[160];
+	int len;
 
 	/* Where should the message go to ? */
 	c = menuitem_get_client(item);
@@ -873,58 +876,50 @@ MenuEventFunc(menu_commands_handler)
 		return -1;
 	}
 
+	/* Menu events are queued behind the client's other events */
+	name = menuitem_eventtype_to_eventtypename(event);
+
 	/* Compose & send message */
 	if ((event == MENUEVENT_UPDATE) ||
 	    (event == MENUEVENT_MINUS) ||
 	    (event == MENUEVENT_PLUS)) {
 		switch (item->type) {
 		  case MENUITEM_CHECKBOX:
-			sock_printf(c->sock, "menuevent %s %.40s %s\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %s\n", name,
 				item->id, ((char *[]) {"off","on","gray"})[item->data.checkbox.value]);
 			break;
 		  case MENUITEM_SLIDER:
-			sock_printf(c->sock, "menuevent %s %.40s %d\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %d\n", name,
 				item->id, item->data.slider.value);
 			break;
 		  case MENUITEM_RING:
-			sock_printf(c->sock, "menuevent %s %.40s %d\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %d\n", name,
 				item->id, item->data.ring.value);
 			break;
 		  case MENUITEM_NUMERIC:
-			sock_printf(c->sock, "menuevent %s %.40s %d\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %d\n", name,
 				item->id, item->data.numeric.value);
 			break;
 		  case MENUITEM_ALPHA:
-			sock_printf(c->sock, "menuevent %s %.40s %.40s\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %.40s\n", name,
 				item->id, item->data.alpha.value);
 			break;
 		  case MENUITEM_IP:
-			sock_printf(c->sock, "menuevent %s %.40s %.40s\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s %.40s\n", name,
 				item->id, item->data.ip.value);
 			break;
 		  default:
-			sock_printf(c->sock, "menuevent %s %.40s\n",
-				menuitem_eventtype_to_eventtypename(event),
+			len = snprintf(buf, sizeof(buf), "menuevent %s %.40s\n", name,
 				item->id);
 		}
 	}
-	else if ((event == MENUEVENT_ENTER) ||
-		 (event == MENUEVENT_LEAVE)) {
-		sock_printf(c->sock, "menuevent %s %.40s\n",
-			menuitem_eventtype_to_eventtypename(event),
-			item->id);
-	}
 	else {
-		sock_printf(c->sock, "menuevent %s %.40s\n",
-			menuitem_eventtype_to_eventtypename(event),
+		/* MENUEVENT_ENTER, MENUEVENT_LEAVE and any other */
+		len = snprintf(buf, sizeof(buf), "menuevent %s %.40s\n", name,
 			item->id);
 	}
 
+	if ((len > 0) && (len < sizeof(buf)))
+		client_send_event(c, buf, len);
 	return 0;
 }
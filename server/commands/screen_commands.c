@@ -29,27 +29,34 @@
 
 #include "client.h"
 #include "screen.h"
+#include "screenlist.h"
 #include "render.h"
+#include "rawscreen.h"
+#include "sock.h"
 #include "screen_commands.h"
 
 /**
  * Tells the server the client has another screen to offer
  *
  *\verbatim
- * Usage: screen_add <id>
+ * Usage: screen_add <id> [-display <display>]
  *\endverbatim
  */
 int
 screen_add_func(Client *c, int argc, char **argv)
 {
 	int err = 0;
+	int display = 0;
 	Screen *s;
 
 	if (c->state != ACTIVE)
 		return 1;
 
-	if (argc != 2) {
-		sock_send_error(c->sock, "Usage: screen_add <screenid>\n");
+	if ((argc == 4) && ((strcmp(argv[2], "-display") == 0) || (strcmp(argv[2], "display") == 0))) {
+		display = atoi(argv[3]);
+	}
+	else if (argc != 2) {
+		sock_send_error(c->sock, "Usage: screen_add <screenid> [-display <display>]\n");
 		return 0;
 	}
 
@@ -67,6 +74,13 @@ screen_add_func(Client *c, int argc, char **argv)
 		return 0;
 	}
 
+	/* Not in the screenlist yet, so this only sets display and size */
+	if ((display != 0) && (screen_set_display(s, display) < 0)) {
+		sock_send_error(c->sock, "invalid display\n");
+		screen_destroy(s);
+		return 0;
+	}
+
 	err = client_add_screen(c, s);
 
 	if (err == 0) {
@@ -133,6 +147,7 @@ screen_del_func(Client *c, int argc, char **argv)
  *     [-priority <prio>] [-duration <int>] [-timeout <int>]
  *     [-heartbeat <type>] [-backlight <type>]
  *     [-cursor <type>] [-cursor_x <xpos>] [-cursor_y <ypos>]
+ *     [-display <display>]
  *\endverbatim
  */
 int
@@ -153,7 +168,8 @@ screen_set_func(Client *c, int argc, char **argv)
 				" [-duration <int>] [-timeout <int>]"
 				" [-heartbeat <type>] [-backlight <type>]"
 				" [-cursor <type>]"
-				" [-cursor_x <xpos>] [-cursor_y <ypos>]\n");
+				" [-cursor_x <xpos>] [-cursor_y <ypos>]"
+				" [-display <display>]\n");
 		return 0;
 	}
 	else if (argc == 2) {
@@ -212,7 +228,7 @@ screen_set_func(Client *c, int argc, char **argv)
 					number = screen_pri_name_to_pri(argv[i]);
 				}
 				if (number >= 0) {
-					s->priority = number;
+					screenlist_set_priority(s, number);
 					sock_send_string(c->sock, "success\n");
 				}
 				else {
@@ -231,8 +247,10 @@ screen_set_func(Client *c, int argc, char **argv)
 
 				/* set the duration...*/
 				number = atoi(argv[i]);
-				if (number > 0)
+				if ((number > 0) && (number != s->duration)) {
 					s->duration = number;
+					screen_changed(s);
+				}
 				sock_send_string(c->sock, "success\n");
 			}
 			else {
@@ -266,8 +284,10 @@ screen_set_func(Client *c, int argc, char **argv)
 
 				/* set the duration...*/
 				number = atoi(argv[i]);
-				if (number > 0)
+				if ((number > 0) && (number != s->width)) {
 					s->width = number;
+					screen_changed(s);
+				}
 				sock_send_string(c->sock, "success\n");
 			}
 			else {
@@ -275,6 +295,22 @@ screen_set_func(Client *c, int argc, char **argv)
 			}
 
 		}
+		/* Handle the "display" parameter*/
+		else if (strcmp(p, "display") == 0) {
+			if (argc > i + 1) {
+				i++;
+				debug(RPT_DEBUG, "screen_set: display=\"%s\"", argv[i]);
+
+				/* move the screen and take over the display's size */
+				if (screen_set_display(s, atoi(argv[i])) == 0)
+					sock_send_string(c->sock, "success\n");
+				else
+					sock_send_error(c->sock, "invalid argument at -display\n");
+			}
+			else {
+				sock_send_error(c->sock, "-display requires a parameter\n");
+			}
+		}
 		/* Handle the "hgt" parameter*/
 		else if (strcmp(p, "hgt") == 0) {
 			if (argc > i + 1) {
@@ -283,8 +319,10 @@ screen_set_func(Client *c, int argc, char **argv)
 
 				/* set the duration...*/
 				number = atoi(argv[i]);
-				if (number > 0)
+				if ((number > 0) && (number != s->height)) {
 					s->height = number;
+					screen_changed(s);
+				}
 				sock_send_string(c->sock, "success\n");
 			}
 			else {
@@ -415,6 +453,69 @@ screen_set_func(Client *c, int argc, char **argv)
 }
 
 
+/**
+ * Attaches a shared memory character buffer to a screen. Only available to
+ * clients connected through the server's Unix domain socket, as the
+ * buffer's file descriptor is passed along with the response:
+ *
+ *\verbatim
+ * rawscreen <screenid> <width> <height>
+ *\endverbatim
+ *
+ *\verbatim
+ * Usage: screen_raw <screenid>
+ *\endverbatim
+ */
+int
+screen_raw_func(Client *c, int argc, char **argv)
+{
+	Screen *s;
+	RawScreen *r;
+	char str[256];
+
+	if (c->state != ACTIVE)
+		return 1;
+
+	if (argc != 2) {
+		sock_send_error(c->sock, "Usage: screen_raw <screenid>\n");
+		return 0;
+	}
+
+	s = client_find_screen(c, argv[1]);
+	if (s == NULL) {
+		sock_send_error(c->sock, "Unknown screen id\n");
+		return 0;
+	}
+	if (s->raw != NULL) {
+		sock_send_error(c->sock, "Screen already has a raw buffer\n");
+		return 0;
+	}
+	if (!sock_is_local(c->sock)) {
+		sock_send_error(c->sock, "Raw screens need a local socket connection\n");
+		return 0;
+	}
+
+	r = rawscreen_create(s->width, s->height);
+	if (r == NULL) {
+		sock_send_error(c->sock, "failed to create raw screen\n");
+		return 0;
+	}
+
+	snprintf(str, sizeof(str), "rawscreen %s %d %d\n", s->id, r->width, r->height);
+	if (sock_send_string_fd(c->sock, str, r->fd) < 0) {
+		rawscreen_destroy(r);
+		return 0;
+	}
+	/* The client has its own copy of the descriptor now */
+	close(r->fd);
+	r->fd = -1;
+
+	s->raw = r;
+	report(RPT_INFO, "Client on socket %d attached a raw buffer to screen \"%s\"", c->sock, s->id);
+	return 0;
+}
+
+
 /**
  * Tells the server which keys the screen uses for interaction
  *
@@ -23,12 +23,14 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <time.h>
 
 #include "shared/report.h"
 #include "shared/sockets.h"
 
 #include "client.h"
 #include "render.h"
+#include "schedule.h"
 #include "server_commands.h"
 
 #define ALL_OUTPUTS_ON -1
@@ -97,9 +99,9 @@ output_func(Client *c, int argc, char **argv)
 }
 
 /**
- * The sleep_func was intended to make the server sleep for some seconds.
- * This function is currently ignored as making the server sleep actually
- * stalls it and disrupts other clients.
+ * Makes the client sleep for some seconds. The server and the other clients
+ * go on; only the messages this client sends afterwards wait until it wakes
+ * up. The reply is sent when it does.
  *
  *\verbatim
  * Usage: sleep <seconds>
@@ -151,20 +153,115 @@ sleep_func(Client *c, int argc, char **argv)
 		return 0;
 	}
 
-	/* Repeat until no more remains - should normally be zero
-	 * on exit the first time...*/
-	sock_printf(c->sock, "sleeping %d seconds\n", secs);
+	/* parse_all_client_messages() replies when the time is up */
+	c->sleep_until = schedule_tick(secs * 1000L);
+	return 0;
+}
 
-	/* whoops.... if this takes place as planned, ALL screens
-	 * will "freeze" for the alloted time...
-	 *
-	 * while ((secs = sleep(secs)) > 0)
-	 */	;
+/* Schedule a command for a client and reply */
+static int
+schedule_command(Client *c, long delay_ms, const char *command)
+{
+	const char *name = command + strspn(command, " \t");
+
+	/* sleep replies when it ends, which a scheduled command must not do */
+	if ((strncmp(name, "sleep", 5) == 0)
+	    && ((name[5] == '\0') || isspace((unsigned char) name[5]))) {
+		sock_send_error(c->sock, "sleep cannot be scheduled\n");
+		return 0;
+	}
 
-	sock_send_error(c->sock, "ignored (not fully implemented)\n");
+	if (schedule_add(c, schedule_tick(delay_ms), command) < 0) {
+		sock_printf_error(c->sock, "at most %d commands can be scheduled\n",
+				  SCHEDULE_MAX_PER_CLIENT);
+		return 0;
+	}
+	sock_send_string(c->sock, "success\n");
 	return 0;
 }
 
+/**
+ * Executes a command after some seconds. The command runs at the first
+ * render tick after the delay, and its reply is not sent: the client would
+ * take it for the reply to another command. sleep cannot be scheduled.
+ *
+ *\verbatim
+ * Usage: after <seconds> {<command>}
+ *\endverbatim
+ */
+int
+after_func(Client *c, int argc, char **argv)
+{
+	double secs;
+	char *endptr;
+
+#define MAX_DELAY (24 * 60 * 60)
+
+	if (c->state != ACTIVE)
+		return 1;
+
+	if (argc != 3) {
+		sock_send_error(c->sock, "Usage: after <secs> {<command>}\n");
+		return 0;
+	}
+
+	secs = strtod(argv[1], &endptr);
+	if ((*argv[1] == '\0') || (*endptr != '\0') || !(secs >= 0) || (secs > MAX_DELAY)) {
+		sock_printf_error(c->sock, "seconds must be between 0 and %d\n", MAX_DELAY);
+		return 0;
+	}
+
+	return schedule_command(c, (long) (secs * 1000 + 0.5), argv[2]);
+}
+
+/**
+ * Executes a command at a time of day, local time. A time that has passed
+ * today means tomorrow.
+ *
+ *\verbatim
+ * Usage: at <HH:MM[:SS]> {<command>}
+ *\endverbatim
+ */
+int
+at_func(Client *c, int argc, char **argv)
+{
+	int hour, min, sec = 0;
+	char end;
+	time_t now, then;
+	struct tm tm;
+
+	if (c->state != ACTIVE)
+		return 1;
+
+	if (argc != 3) {
+		sock_send_error(c->sock, "Usage: at <HH:MM[:SS]> {<command>}\n");
+		return 0;
+	}
+
+	if (((sscanf(argv[1], "%d:%d%c", &hour, &min, &end) != 2)
+	     && (sscanf(argv[1], "%d:%d:%d%c", &hour, &min, &sec, &end) != 3))
+	    || (hour < 0) || (hour > 23) || (min < 0) || (min > 59)
+	    || (sec < 0) || (sec > 59)) {
+		sock_send_error(c->sock, "invalid time, use HH:MM or HH:MM:SS\n");
+		return 0;
+	}
+
+	now = time(NULL);
+	localtime_r(&now, &tm);
+	tm.tm_hour = hour;
+	tm.tm_min = min;
+	tm.tm_sec = sec;
+	tm.tm_isdst = -1;
+	then = mktime(&tm);
+	if (then <= now) {
+		tm.tm_mday++;
+		tm.tm_isdst = -1;
+		then = mktime(&tm);
+	}
+
+	return schedule_command(c, (long) (then - now) * 1000L, argv[2]);
+}
+
 /**
  * Does nothing, returns "noop complete" message.
  *
@@ -17,5 +17,7 @@ int test_func_func(Client *c, int argc, char **argv);
 int noop_func(Client *c, int argc, char **argv);
 int info_func(Client *c, int argc, char **argv);
 int sleep_func(Client *c, int argc, char **argv);
+int after_func(Client *c, int argc, char **argv);
+int at_func(Client *c, int argc, char **argv);
 
 #endif
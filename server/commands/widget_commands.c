@@ -189,11 +189,13 @@ int
 widget_set_func(Client *c, int argc, char **argv)
 {
 	int i;
+	int changed = 0;
 	char *wid;
 	char *sid;
 
 	Screen *s;
 	Widget *w;
+	Widget old;
 
 	if (c->state != ACTIVE)
 		return 1;
@@ -230,9 +232,11 @@ widget_set_func(Client *c, int argc, char **argv)
 		}
 		return 0;
 	}
+	old = *w;
 	i = 3;
 	switch (w->type) {
 	case WID_STRING:		/* String takes "x y text" */
+	case WID_CLOCK:			/* Clock takes "x y format" */
 		if (argc != i + 3) {
 			sock_send_error(c->sock, "Wrong number of arguments\n");
 			return 0;
@@ -246,8 +250,7 @@ widget_set_func(Client *c, int argc, char **argv)
 
 		w->x = atoi(argv[i]);
 		w->y = atoi(argv[i + 1]);
-		free(w->text);
-		w->text = strdup(argv[i + 2]);
+		changed = widget_set_text(w, argv[i + 2], strlen(argv[i + 2]));
 		debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
 
 		break;
@@ -298,18 +301,13 @@ widget_set_func(Client *c, int argc, char **argv)
 			sock_send_error(c->sock, "Invalid coordinates\n");
 			return 0;
 		}
-		free(w->begin_label);
-		free(w->end_label);
-		w->begin_label = NULL;
-		w->end_label = NULL;
 		w->x = atoi(argv[i]);
 		w->y = atoi(argv[i + 1]);
 		w->width = atoi(argv[i + 2]);
 		w->promille = atoi(argv[i + 3]);
-		if (argc >= i + 5)
-			w->begin_label = strdup(argv[i + 4]);
-		if (argc >= i + 6)
-			w->end_label = strdup(argv[i + 5]);
+		changed = widget_set_labels(w,
+					    (argc >= i + 5) ? argv[i + 4] : NULL,
+					    (argc >= i + 6) ? argv[i + 5] : NULL);
 		debug(RPT_DEBUG, "Widget %s set to %i", wid, w->promille);
 
 		break;
@@ -343,10 +341,9 @@ widget_set_func(Client *c, int argc, char **argv)
 			return 0;
 		}
 
-		free(w->text);
-		w->text = strdup(argv[i]);
+		changed = widget_set_text(w, argv[i], strlen(argv[i]));
 		/* Set width too */
-		w->width = display_props->width;
+		w->width = drivers_display_props(w->screen->display)->width;
 		debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
 
 		break;
@@ -376,8 +373,7 @@ widget_set_func(Client *c, int argc, char **argv)
 		w->bottom = atoi(argv[i + 3]);
 		w->length = argv[i + 4][0];
 		w->speed = atoi(argv[i + 5]);
-		free(w->text);
-		w->text = strdup(argv[i + 6]);
+		changed = widget_set_text(w, argv[i + 6], strlen(argv[i + 6]));
 		debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
 
 		break;
@@ -433,6 +429,22 @@ widget_set_func(Client *c, int argc, char **argv)
 
 		debug(RPT_DEBUG, "Widget %s set to %i", wid, w->y);
 
+		break;
+	case WID_BIGCLOCK:		/* Bigclock takes "x format" */
+		if (argc != i + 2) {
+			sock_send_error(c->sock, "Wrong number of arguments\n");
+			return 0;
+		}
+
+		if (!isdigit((unsigned int) argv[i][0])) {
+			sock_send_error(c->sock, "Invalid coordinates\n");
+			return 0;
+		}
+
+		w->x = atoi(argv[i]);
+		changed = widget_set_text(w, argv[i + 1], strlen(argv[i + 1]));
+		debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
+
 		break;
 	case WID_NONE:
 	default:
@@ -440,6 +452,14 @@ widget_set_func(Client *c, int argc, char **argv)
 		return 0;
 	}
 
+	if (changed < 0) {
+		sock_send_error(c->sock, "Out of memory\n");
+		return 0;
+	}
+	/* Identical updates leave the screen as it is */
+	if ((changed > 0) || !widget_same_values(&old, w))
+		widget_changed(w);
+
 	sock_send_string(c->sock, "success\n");
 	return 0;
 }
@@ -61,6 +61,7 @@ DriverSymbols driver_symbols[] = {
 	{ "heartbeat",          offsetof(Driver, heartbeat),          0 },
 	{ "icon",               offsetof(Driver, icon),               0 },
 	{ "cursor",             offsetof(Driver, cursor),             0 },
+	{ "draw_cells",         offsetof(Driver, draw_cells),         0 },
 	{ "set_char",           offsetof(Driver, set_char),           0 },
 	{ "get_free_chars",     offsetof(Driver, get_free_chars),     0 },
 	{ "cellwidth",          offsetof(Driver, cellwidth),          0 },
@@ -71,6 +72,7 @@ DriverSymbols driver_symbols[] = {
 	{ "set_brightness",     offsetof(Driver, set_brightness),     0 },
 	{ "backlight",          offsetof(Driver, backlight),          0 },
 	{ "output",             offsetof(Driver, output),             0 },
+	{ "idle",               offsetof(Driver, idle),               0 },
 	{ "get_key",            offsetof(Driver, get_key),            0 },
 	{ "get_info",           offsetof(Driver, get_info),           0 },
 	{ NULL, 0, 0 }
@@ -461,7 +463,7 @@ driver_alt_hbar(Driver *drv, int x, int y, int len, int promille, int options)
  * \param end_label    Optional text to render at the end of the pbar.
  */
 void
-driver_pbar(Driver *drv, int x, int y, int width, int promille, char *begin_label, char *end_label)
+driver_pbar(Driver *drv, int x, int y, int width, int promille, const char *begin_label, const char *end_label)
 {
 	int begin_length, end_length, len;
 
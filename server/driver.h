@@ -47,7 +47,7 @@ bool
 driver_stay_in_foreground(Driver *driver);
 
 void
-driver_pbar(Driver *drv, int x, int y, int width, int promille, char *begin_label, char *end_label);
+driver_pbar(Driver *drv, int x, int y, int width, int promille, const char *begin_label, const char *end_label);
 
 
 /* Alternative functions for all extended functions */
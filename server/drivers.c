@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 
 #ifdef HAVE_CONFIG_H
@@ -30,9 +31,152 @@
 
 Driver *output_driver = NULL;
 LinkedList *loaded_drivers = NULL;		/**< list of loaded drivers */
-DisplayProps *display_props = NULL;		/**< properties of the display */
+DisplayProps *display_props = NULL;		/**< properties of the selected display */
+int num_displays = 1;				/**< number of logical displays */
 
-#define ForAllDrivers(drv) for (drv = LL_GetFirst(loaded_drivers); drv; drv = LL_GetNext(loaded_drivers))
+/*
+ * Every driver belongs to one logical display. The drivers_* output
+ * functions only go to the drivers of the selected display, whose
+ * properties are taken from its first output driver.
+ */
+static int current_display = 0;
+static Driver *display_drivers[MAX_DISPLAYS];	/**< first output driver of each display */
+static DisplayProps props[MAX_DISPLAYS];
+
+
+/**
+ * Continue walking the drivers of the current display.
+ * \param it  Iterator started by drivers_first_on_display().
+ * \return    The next driver of the display; \c NULL after the last.
+ */
+static Driver *
+drivers_next_on_display(LL_iter *it)
+{
+	Driver *drv;
+
+	while (((drv = LL_IterNext(it)) != NULL) && (drv->display != current_display))
+		;
+	return drv;
+}
+
+
+/**
+ * Start walking the drivers of the current display. The list's cursor is
+ * left alone, so a driver function may walk the drivers itself.
+ * \param it  Iterator to start.
+ * \return    The first driver of the display; \c NULL if there is none.
+ */
+static Driver *
+drivers_first_on_display(LL_iter *it)
+{
+	Driver *drv = LL_IterFirst(loaded_drivers, it);
+
+	if ((drv != NULL) && (drv->display != current_display))
+		drv = drivers_next_on_display(it);
+	return drv;
+}
+
+
+/*
+ * Drawing functions of a single driver, with the core's alternatives for
+ * the functions the driver does not have.
+ */
+
+static void
+draw_vbar(Driver *drv, int x, int y, int len, int promille, int pattern)
+{
+	if (drv->vbar)
+		drv->vbar(drv, x, y, len, promille, pattern);
+	else
+		driver_alt_vbar(drv, x, y, len, promille, pattern);
+}
+
+static void
+draw_hbar(Driver *drv, int x, int y, int len, int promille, int pattern)
+{
+	if (drv->hbar)
+		drv->hbar(drv, x, y, len, promille, pattern);
+	else
+		driver_alt_hbar(drv, x, y, len, promille, pattern);
+}
+
+static void
+draw_num(Driver *drv, int x, int num)
+{
+	if (drv->num)
+		drv->num(drv, x, num);
+	else
+		driver_alt_num(drv, x, num);
+}
+
+static void
+draw_icon(Driver *drv, int x, int y, int icon)
+{
+	/* Does the driver have the icon function ? */
+	if (drv->icon) {
+		/* Try driver call */
+		if (drv->icon(drv, x, y, icon) == -1) {
+			/* do alternative call if driver's function does not know the icon */
+			driver_alt_icon(drv, x, y, icon);
+		}
+	} else {
+		/* Also do alternative call if the driver does not have icon function */
+		driver_alt_icon(drv, x, y, icon);
+	}
+}
+
+
+/**
+ * Select the logical display the drivers_* output functions go to.
+ * \param display  Number of the display.
+ */
+void
+drivers_select_display(int display)
+{
+	if ((display < 0) || (display >= MAX_DISPLAYS))
+		return;
+	current_display = display;
+	display_props = (display_drivers[display] != NULL) ? &props[display] : NULL;
+}
+
+
+/**
+ * Get the selected logical display.
+ * \return  Number of the display.
+ */
+int
+drivers_current_display(void)
+{
+	return current_display;
+}
+
+
+/**
+ * Get the properties of a logical display.
+ * \param display  Number of the display.
+ * \return  The properties, or NULL if the display has no output driver.
+ */
+DisplayProps *
+drivers_display_props(int display)
+{
+	if ((display < 0) || (display >= MAX_DISPLAYS) || (display_drivers[display] == NULL))
+		return NULL;
+	return &props[display];
+}
+
+
+/* Count the displays: one more than the highest one a driver belongs to */
+static void
+drivers_count_displays(void)
+{
+	Driver *driver;
+
+	num_displays = 1;
+	for (driver = LL_GetFirst(loaded_drivers); driver; driver = LL_GetNext(loaded_drivers)) {
+		if (driver->display >= num_displays)
+			num_displays = driver->display + 1;
+	}
+}
 
 
 /**
@@ -48,6 +192,7 @@ drivers_load_driver(const char *name)
 {
 	Driver *driver;
 	const char *s;
+	int display;
 
 	debug(RPT_DEBUG, "%s(name=\"%.40s\")", __FUNCTION__, name);
 
@@ -61,7 +206,20 @@ drivers_load_driver(const char *name)
 		}
 	}
 
+	/* Kept running by drivers_unload_changed() ? */
+	for (driver = LL_GetFirst(loaded_drivers); driver; driver = LL_GetNext(loaded_drivers)) {
+		if (strcasecmp(driver->name, name) == 0)
+			return (driver_stay_in_foreground(driver)) ? 2 : 0;
+	}
+
 	/* Retrieve data from config file */
+	display = config_get_int(name, "Display", 0, 0);
+	if ((display < 0) || (display >= MAX_DISPLAYS)) {
+		report(RPT_ERR, "Display of driver %.40s must be between 0 and %d",
+		       name, MAX_DISPLAYS - 1);
+		return -1;
+	}
+
 	s = config_get_string("server", "DriverPath", 0, "");
 	char driverpath[strlen(s) + 1];
 	strcpy(driverpath, s);
@@ -73,37 +231,47 @@ drivers_load_driver(const char *name)
 	if (s == name)
 		strcat(filename, MODULE_EXTENSION);
 
+	/* Drivers that adapt to other drivers see the size of their display */
+	drivers_select_display(display);
+
 	/* Load the module */
 	driver = driver_load(name, filename);
 	if (driver == NULL) {
 		/* It failed. The message has already been given by driver_load() */
 		report(RPT_INFO, "Module %.40s could not be loaded", filename);
+		drivers_select_display(0);
 		return -1;
 	}
+	driver->display = display;
 
 	/* Add driver to list */
 	LL_Push(loaded_drivers, driver);
+	drivers_count_displays();
+
+	/* If first output driver of its display, store display properties */
+	if (driver_does_output(driver) && !display_drivers[display]) {
+		DisplayProps *p = &props[display];
 
-	/* If first output driver, store display properties */
-	if (driver_does_output(driver) && !output_driver) {
-		output_driver = driver;
+		display_drivers[display] = driver;
+		if (display == 0)
+			output_driver = driver;
 
-		/* Allocate new DisplayProps structure */
-		display_props = malloc(sizeof(DisplayProps));
-		display_props->width      = driver->width(driver);
-		display_props->height     = driver->height(driver);
+		p->width      = driver->width(driver);
+		p->height     = driver->height(driver);
 
 		if (driver->cellwidth != NULL && driver->cellwidth(driver) > 0)
-			display_props->cellwidth  = driver->cellwidth(driver);
+			p->cellwidth  = driver->cellwidth(driver);
 		else
-			display_props->cellwidth  = LCD_DEFAULT_CELLWIDTH;
+			p->cellwidth  = LCD_DEFAULT_CELLWIDTH;
 
 		if (driver->cellheight != NULL && driver->cellheight(driver) > 0)
-			display_props->cellheight = driver->cellheight(driver);
+			p->cellheight = driver->cellheight(driver);
 		else
-			display_props->cellheight = LCD_DEFAULT_CELLHEIGHT;
+			p->cellheight = LCD_DEFAULT_CELLHEIGHT;
 	}
 
+	drivers_select_display(0);
+
 	/* Return the driver type */
 	if (driver_stay_in_foreground(driver))
 		return 2;
@@ -119,14 +287,69 @@ void
 drivers_unload_all(void)
 {
 	Driver *driver;
+	int i;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
 	output_driver = NULL;
+	for (i = 0; i < MAX_DISPLAYS; i++)
+		display_drivers[i] = NULL;
 
 	while ((driver = LL_Pop(loaded_drivers)) != NULL) {
 		driver_unload(driver);
 	}
+	num_displays = 1;
+}
+
+
+/**
+ * Unload the drivers whose configuration changed, after the configuration
+ * was re-read. Drivers whose section is the same as before keep running.
+ * All drivers are unloaded if the server section or the output driver of
+ * a display changed, as the display properties and the driver path depend
+ * on them.
+ * \param names  Names of the drivers to run from now on.
+ * \param count  Number of names.
+ */
+void
+drivers_unload_changed(char **names, int count)
+{
+	Driver *driver;
+	LL_iter it;
+
+	debug(RPT_DEBUG, "%s()", __FUNCTION__);
+
+	if (loaded_drivers == NULL)
+		return;
+
+	if (config_section_changed("server")) {
+		report(RPT_INFO, "Server configuration changed, restarting all drivers");
+		drivers_unload_all();
+		return;
+	}
+
+	for (driver = LL_IterFirst(loaded_drivers, &it); driver != NULL; driver = LL_IterNext(&it)) {
+		int i;
+		int keep = !config_section_changed(driver->name);
+
+		for (i = 0; keep && (i < count); i++) {
+			if (strcasecmp(driver->name, names[i]) == 0)
+				break;
+		}
+		if (keep && (i < count))
+			continue;
+
+		if (driver == display_drivers[driver->display]) {
+			report(RPT_INFO, "Output driver configuration changed, restarting all drivers");
+			drivers_unload_all();
+			return;
+		}
+
+		report(RPT_INFO, "Configuration of driver %.40s changed, restarting it", driver->name);
+		LL_IterRemove(&it);
+		driver_unload(driver);
+	}
+	drivers_count_displays();
 }
 
 
@@ -139,10 +362,11 @@ const char *
 drivers_get_info(void)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->get_info) {
 			return drv->get_info(drv);
 		}
@@ -159,10 +383,11 @@ void
 drivers_clear(void)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->clear)
 			drv->clear(drv);
 	}
@@ -177,16 +402,100 @@ void
 drivers_flush(void)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->flush)
 			drv->flush(drv);
 	}
 }
 
 
+/* Send the character cells of a buffer as strings, one for each run */
+static void
+draw_cell_chars(Driver *drv, const CellBuffer *cb)
+{
+	char run[LCD_MAX_WIDTH + 1];
+	int x, y;
+
+	for (y = 0; y < cb->height; y++) {
+		const unsigned char *chars = cb->chars + y * cb->width;
+		const short *owner = cb->owner + y * cb->width;
+
+		for (x = 0; x < cb->width; ) {
+			int start, len;
+
+			/* The driver was cleared: blanks need not be sent */
+			if ((owner[x] >= 0) || (chars[x] == ' ')) {
+				x++;
+				continue;
+			}
+			for (start = x; (x < cb->width) && (owner[x] < 0); x++)
+				;
+			for (len = x - start; chars[start + len - 1] == ' '; len--)
+				;
+			memcpy(run, chars + start, len);
+			run[len] = '\0';
+			drv->string(drv, start + 1, y + 1, run);
+		}
+	}
+}
+
+
+/**
+ * Draw a composed screen on all drivers. Every driver is cleared and gets
+ * the bars, icons and big numbers of the buffer in their order. Then the
+ * character cells go to the driver's draw_cells() function in one call,
+ * or as one string() call for each run of characters if the driver does
+ * not have that function.
+ * \param cb  The composed screen.
+ */
+void
+drivers_draw_cells(const CellBuffer *cb)
+{
+	Driver *drv;
+	LL_iter it;
+	int i;
+
+	debug(RPT_DEBUG, "%s(ops=%d)", __FUNCTION__, cb->num_ops);
+
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
+		if (drv->clear)
+			drv->clear(drv);
+
+		for (i = 0; i < cb->num_ops; i++) {
+			const CellOp *op = &cb->ops[i];
+
+			switch (op->kind) {
+			case CELL_OP_HBAR:
+				draw_hbar(drv, op->x, op->y, op->len, op->promille, op->arg);
+				break;
+			case CELL_OP_VBAR:
+				draw_vbar(drv, op->x, op->y, op->len, op->promille, op->arg);
+				break;
+			case CELL_OP_PBAR:
+				driver_pbar(drv, op->x, op->y, op->len, op->promille,
+					    op->begin_label, op->end_label);
+				break;
+			case CELL_OP_ICON:
+				draw_icon(drv, op->x, op->y, op->arg);
+				break;
+			case CELL_OP_NUM:
+				draw_num(drv, op->x, op->arg);
+				break;
+			}
+		}
+
+		if (drv->draw_cells)
+			drv->draw_cells(drv, cb);
+		else if (drv->string)
+			draw_cell_chars(drv, cb);
+	}
+}
+
+
 /**
  * Write string to all loaded drivers.
  * Call string() function of all loaded drivers that have a flush() function defined.
@@ -198,10 +507,11 @@ void
 drivers_string(int x, int y, const char *string)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, string=\"%.40s\")", __FUNCTION__, x, y, string);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->string)
 			drv->string(drv, x, y, string);
 	}
@@ -219,10 +529,11 @@ void
 drivers_chr(int x, int y, char c)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, c='%c')", __FUNCTION__, x, y, c);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->chr)
 			drv->chr(drv, x, y, c);
 	}
@@ -243,6 +554,7 @@ void
 drivers_vbar(int x, int y, int len, int promille, int pattern)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, len=%d, promille=%d, pattern=%d)",
 	      __FUNCTION__, x, y, len, promille, pattern);
@@ -253,12 +565,8 @@ drivers_vbar(int x, int y, int len, int promille, int pattern)
 	 */
 
 
-	ForAllDrivers(drv) {
-		if (drv->vbar)
-			drv->vbar(drv, x, y, len, promille, pattern);
-		else
-			driver_alt_vbar(drv, x, y, len, promille, pattern);
-	}
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it))
+		draw_vbar(drv, x, y, len, promille, pattern);
 }
 
 
@@ -276,16 +584,13 @@ void
 drivers_hbar(int x, int y, int len, int promille, int pattern)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, len=%d, promille=%d, pattern=%d)",
 	      __FUNCTION__, x, y, len, promille, pattern);
 
-	ForAllDrivers(drv) {
-		if (drv->hbar)
-			drv->hbar(drv, x, y, len, promille, pattern);
-		else
-			driver_alt_hbar(drv, x, y, len, promille, pattern);
-	}
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it))
+		draw_hbar(drv, x, y, len, promille, pattern);
 }
 
 
@@ -307,8 +612,9 @@ void
 drivers_pbar(int x, int y, int width, int promille, char *begin_label, char *end_label)
 {
 	Driver *drv;
+	LL_iter it;
 
-	ForAllDrivers(drv)
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it))
 		driver_pbar(drv, x, y, width, promille, begin_label, end_label);
 }
 
@@ -324,15 +630,12 @@ void
 drivers_num(int x, int num)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, num=%d)", __FUNCTION__, x, num);
 
-	ForAllDrivers(drv) {
-		if (drv->num)
-			drv->num(drv, x, num);
-		else
-			driver_alt_num(drv, x, num);
-	}
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it))
+		draw_num(drv, x, num);
 }
 
 
@@ -346,10 +649,11 @@ void
 drivers_heartbeat(int state)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(state=%d)", __FUNCTION__, state);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->heartbeat)
 			drv->heartbeat(drv, state);
 		else
@@ -372,22 +676,12 @@ void
 drivers_icon(int x, int y, int icon)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, icon=ICON_%s)", __FUNCTION__, x, y, widget_icon_to_iconname(icon));
 
-	ForAllDrivers(drv) {
-		/* Does the driver have the icon function ? */
-		if (drv->icon) {
-			/* Try driver call */
-			if (drv->icon(drv, x, y, icon) == -1) {
-				/* do alternative call if driver's function does not know the icon */
-				driver_alt_icon(drv, x, y, icon);
-			}
-		} else {
-			/* Also do alternative call if the driver does not have icon function */
-			driver_alt_icon(drv, x, y, icon);
-		}
-	}
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it))
+		draw_icon(drv, x, y, icon);
 }
 
 
@@ -403,10 +697,11 @@ void
 drivers_cursor(int x, int y, int state)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(x=%d, y=%d, state=%d)", __FUNCTION__, x, y, state);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->cursor)
 			drv->cursor(drv, x, y, state);
 		else
@@ -424,16 +719,36 @@ void
 drivers_backlight(int state)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(state=%d)", __FUNCTION__, state);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->backlight)
 			drv->backlight(drv, state);
 	}
 }
 
 
+/**
+ * Tell whether a driver of the current display animates the heartbeat
+ * itself. Those count their calls, so they need the heartbeat every frame.
+ * \return  1 if there is such a driver, 0 if the server core animates it.
+ */
+int
+drivers_own_heartbeat(void)
+{
+	Driver *drv;
+	LL_iter it;
+
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
+		if (drv->heartbeat)
+			return 1;
+	}
+	return 0;
+}
+
+
 /**
  * Set output on all drivers.
  * Call ouptput() function of all drivers that have an ouptput() function defined.
@@ -443,10 +758,11 @@ void
 drivers_output(int state)
 {
 	Driver *drv;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(state=%d)", __FUNCTION__, state);
 
-	ForAllDrivers(drv) {
+	for (drv = drivers_first_on_display(&it); drv; drv = drivers_next_on_display(&it)) {
 		if (drv->output)
 			drv->output(drv, state);
 	}
@@ -454,12 +770,31 @@ drivers_output(int state)
 
 
 /**
- * Get key presses from loaded drivers.
+ * Let the drivers of all displays do pending work, such as collecting the
+ * transfers that completed since they flushed. Called on every processing
+ * stroke, so that this happens while the server waits.
+ */
+void
+drivers_idle(void)
+{
+	Driver *drv;
+	LL_iter it;
+
+	LL_ForEach(loaded_drivers, it, drv) {
+		if (drv->idle)
+			drv->idle(drv);
+	}
+}
+
+
+/**
+ * Get key presses from the drivers of all displays.
+ * \param display  Set to the display of the driver that generated the key.
  * \return  Pointer to key string for first driver ithat has a get_key() function defined
  *          and for which the get_key() function returns a key; otherwise \c NULL.
  */
 const char *
-drivers_get_key(void)
+drivers_get_key(int *display)
 {
 	/* Find the first input keystroke, if any */
 	Driver *drv;
@@ -467,15 +802,15 @@ drivers_get_key(void)
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	ForAllDrivers(drv) {
+	for (drv = LL_GetFirst(loaded_drivers); drv; drv = LL_GetNext(loaded_drivers)) {
 		if (drv->get_key) {
 			keystroke = drv->get_key(drv);
 			if (keystroke != NULL) {
 				report(RPT_INFO, "Driver [%.40s] generated keystroke %.40s", drv->name, keystroke);
+				*display = drv->display;
 				return keystroke;
 			}
 		}
 	}
 	return NULL;
 }
-
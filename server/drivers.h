@@ -20,7 +20,20 @@ typedef struct DisplayProps {
 	int cellwidth, cellheight;
 } DisplayProps;
 
+/** Maximum number of logical displays */
+#define MAX_DISPLAYS	16
+
 extern DisplayProps *display_props;
+extern int num_displays;
+
+void
+drivers_select_display(int display);
+
+int
+drivers_current_display(void);
+
+DisplayProps *
+drivers_display_props(int display);
 
 int
 drivers_load_driver(const char *name);
@@ -28,6 +41,9 @@ drivers_load_driver(const char *name);
 void
 drivers_unload_all(void);
 
+void
+drivers_unload_changed(char **names, int count);
+
 const char *
 drivers_get_info(void);
 
@@ -37,6 +53,9 @@ drivers_clear(void);
 void
 drivers_flush(void);
 
+void
+drivers_draw_cells(const CellBuffer *cb);
+
 void
 drivers_string(int x, int y, const char *string);
 
@@ -79,8 +98,14 @@ drivers_backlight(int brightness);
 void
 drivers_output(int state);
 
+int
+drivers_own_heartbeat(void);
+
+void
+drivers_idle(void);
+
 const char *
-drivers_get_key(void);
+drivers_get_key(int *display);
 
 
 extern Driver *output_driver;
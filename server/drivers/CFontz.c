@@ -67,7 +67,7 @@ typedef struct CFontz_private_data {
 	unsigned char *backingstore;
 
 	/* definable characters */
-	CGmode ccmode;
+	CCAllocator cca;
 
 	int contrast;
 	int brightness;
@@ -122,7 +122,7 @@ CFontz_init(Driver *drvthis)
 	p->fd = -1;
 	p->cellwidth = DEFAULT_CELL_WIDTH;
 	p->cellheight = DEFAULT_CELL_HEIGHT;
-	p->ccmode = standard;
+	lib_cc_init(&p->cca, 0, NUM_CCs, p->cellheight);
 
 	debug(RPT_INFO, "CFontz: init(%p)", drvthis);
 
@@ -633,29 +633,8 @@ CFontz_vbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = drvthis->private_data;
 
-	if (p->ccmode != vbar) {
-		unsigned char vBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: vbar: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return;
-		}
-		p->ccmode = vbar;
-
-		memset(vBar, 0x00, sizeof(vBar));
-
-		for (i = 1; i < p->cellheight; i++) {
-			// add pixel line per pixel line ...
-			// NOTE: cellwidth != bar width: 0x1F = 0xFF & ((1 << (p->cellwidth - 1)) - 1)
-			vBar[p->cellheight - i] = 0x1F;
-			CFontz_set_char(drvthis, i, vBar);
-		}
-	}
-
-	lib_vbar_static(drvthis, x, y, len, promille, options, p->cellheight, 0);
+	/* NOTE: cellwidth != bar width: 0x1F = 0xFF & ((1 << (p->cellwidth - 1)) - 1) */
+	lib_vbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellheight, 0x1F);
 }
 
 
@@ -673,28 +652,8 @@ CFontz_hbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = drvthis->private_data;
 
-	if (p->ccmode != hbar) {
-		unsigned char hBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: hbar: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return;
-		}
-		p->ccmode = hbar;
-
-		memset(hBar, 0x00, sizeof(hBar));
-
-		for (i = 1; i <= p->cellwidth; i++) {
-			// fill pixel columns from left to right.
-			memset(hBar, 0xFF & ~((1 << (p->cellwidth - i)) - 1), sizeof(hBar)-1);
-			CFontz_set_char(drvthis, i, hBar);
-		}
-	}
-
-	lib_hbar_static(drvthis, x, y, len, promille, options | BAR_SEAMLESS, p->cellwidth, 0);
+	/* the bottom pixel row stays empty */
+	lib_hbar_cc(drvthis, &p->cca, x, y, len, promille, options | BAR_SEAMLESS, p->cellwidth, p->cellheight - 1);
 }
 
 
@@ -708,22 +667,17 @@ MODULE_EXPORT void
 CFontz_num(Driver *drvthis, int x, int num)
 {
 PrivateData *p = drvthis->private_data;
-int do_init = 0;
+int do_init;
 
 	if ((num < 0) || (num > 10))
 		return;
 
-	if (p->ccmode != bignum) {
-		if (p->ccmode != standard) {
-			/* Not supported (yet) */
-			report(RPT_WARNING, "%s: num: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return;
-		}
-
-		p->ccmode = bignum;
-
-		do_init = 1;
+	/* Big numbers need all custom characters */
+	do_init = lib_cc_claim_all(&p->cca);
+	if (do_init < 0) {
+		report(RPT_WARNING, "%s: num: cannot combine big numbers with other user-defined characters",
+				drvthis->name);
+		return;
 	}
 
 	// Lib_adv_bignum does everything needed to show the bignumbers.
@@ -858,18 +812,18 @@ CFontz_icon(Driver *drvthis, int x, int y, int icon)
 		  b_______ };
 	*/
 
+	unsigned char *glyph = NULL;
+
 	/* Yes we know, this is a VERY BAD implementation :-) */
 	switch (icon) {
 		case ICON_BLOCK_FILLED:
 			CFontz_raw_chr(drvthis, x, y, (p->newfirmware) ? 0x1F : 255);
 			break;
 		case ICON_HEART_FILLED:
-			CFontz_set_char(drvthis, 0, heart_filled);
-			CFontz_raw_chr(drvthis, x, y, 0);
+			glyph = heart_filled;
 			break;
 		case ICON_HEART_OPEN:
-			CFontz_set_char(drvthis, 0, heart_open);
-			CFontz_raw_chr(drvthis, x, y, 0);
+			glyph = heart_open;
 			break;
 		case ICON_ARROW_UP:
 			CFontz_raw_chr(drvthis, x, y, 0xDE);
@@ -884,16 +838,13 @@ CFontz_icon(Driver *drvthis, int x, int y, int icon)
 			CFontz_raw_chr(drvthis, x, y, 0xDF);
 			break;
 		case ICON_CHECKBOX_OFF:
-			CFontz_set_char(drvthis, 3, checkbox_off);
-			CFontz_raw_chr(drvthis, x, y, 3);
+			glyph = checkbox_off;
 			break;
 		case ICON_CHECKBOX_ON:
-			CFontz_set_char(drvthis, 4, checkbox_on);
-			CFontz_raw_chr(drvthis, x, y, 4);
+			glyph = checkbox_on;
 			break;
 		case ICON_CHECKBOX_GRAY:
-			CFontz_set_char(drvthis, 5, checkbox_gray);
-			CFontz_raw_chr(drvthis, x, y, 5);
+			glyph = checkbox_gray;
 			break;
 		case ICON_SELECTOR_AT_LEFT:
 			if (!p->newfirmware)
@@ -909,6 +860,14 @@ CFontz_icon(Driver *drvthis, int x, int y, int icon)
 			return -1; /* Let the core do other icons */
 	}
 
+	if (glyph != NULL) {
+		/* Let the core do it if all custom characters are taken */
+		int c = lib_cc_get(drvthis, &p->cca, glyph);
+
+		if (c < 0)
+			return -1;
+		CFontz_raw_chr(drvthis, x, y, c);
+	}
 	return 0;
 }
 
@@ -959,7 +918,7 @@ CFontz_clear(Driver *drvthis)
 	PrivateData *p = drvthis->private_data;
 
 	memset(p->framebuf, ' ', p->width * p->height);
-	p->ccmode = standard;
+	lib_cc_frame(&p->cca);
 }
 
 
@@ -984,12 +943,16 @@ CFontz_string(Driver *drvthis, int x, int y, unsigned char string[])
 	if ((y < 0) || (y >= p->height))
 		return;
 
+	if (p->newfirmware) {
+		lib_charmap_string(p->framebuf + (y * p->width), p->width, x,
+				   (const char *) string, CFontz_charmap);
+		return;
+	}
+
 	for (i = 0; (string[i] != '\0') && (x < p->width); i++, x++) {
 		/* Check for buffer overflows... */
 		if (x >= 0)
-			p->framebuf[(y * p->width) + x] = (p->newfirmware)
-							  ? CFontz_charmap[(unsigned) string[i]]
-							  : string[i];
+			p->framebuf[(y * p->width) + x] = string[i];
 	}
 }
 
@@ -1185,7 +1185,6 @@ MODULE_EXPORT void
 CFontzPacket_string (Driver *drvthis, int x, int y, const char string[])
 {
 	PrivateData *p = drvthis->private_data;
-	int i;
 
 	/* Convert 1-based coords to 0-based... */
 	x--;
@@ -1194,13 +1193,8 @@ CFontzPacket_string (Driver *drvthis, int x, int y, const char string[])
 	if ((y < 0) || (y >= p->height))
 		return;
 
-	for (i = 0; (string[i] != '\0') && (x < p->width); i++, x++) {
-		/* Check for buffer overflows... */
-		if (x >= 0) {
-			p->framebuf[(y * p->width) + x] =
-				p->model_desc->charmap[(unsigned char) string[i]];
-		}
-	}
+	lib_charmap_string(p->framebuf + (y * p->width), p->width, x, string,
+			   p->model_desc->charmap);
 }
 
 
@@ -577,10 +577,9 @@ IOWarrior_flush(Driver *drvthis)
         /* always flush a full line */
         unsigned char buffer[LCD_MAX_WIDTH];
 
-        for (count = 0; count < p->width; count++) {
-          buffer[count] = HD44780_charmap[(unsigned char) p->framebuf[offset+count]];
-          p->backingstore[offset+count] = p->framebuf[offset+count];
-        }
+        count = p->width;
+        lib_charmap_translate(buffer, p->framebuf + offset, count, HD44780_charmap);
+        memcpy(p->backingstore + offset, p->framebuf + offset, count);
         iowlcd_set_text(p, 0, y, count, buffer);
         debug(RPT_DEBUG, "%s: flushed %d chars at (%d,%d)",
 			drvthis->name, count, 0, y);
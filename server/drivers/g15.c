@@ -63,6 +63,7 @@ static inline int g15_send(int sock, char *buf, unsigned int len) { return -1; }
 
 #include "lcd.h"
 #include "g15.h"
+#include "pixfmt.h"
 
 #include "shared/defines.h"
 #include "shared/report.h"
@@ -229,39 +230,13 @@ static void g15_pixmap_to_lcd(unsigned char *lcd_buffer, unsigned char const *da
 	A2    pixels of the 43-pixel high display.)
 */
 
-	const unsigned int stride = G15_LCD_WIDTH / 8;
-	unsigned int row, col;
-
 	lcd_buffer[0] = 0x03; /* Set output report 3 */
 	memset(lcd_buffer + 1, 0, G15_LCD_OFFSET - 1);
 	lcd_buffer += G15_LCD_OFFSET;
 
 	/* 43 pixels height, requires 6 bytes for each column */
-	for (row = 0; row < 6; row++) {
-		for (col = 0; col < G15_LCD_WIDTH; col++) {
-			unsigned int bit = col % 8;
-
-			/* Copy a 1x8 column of pixels across from the source
-			 * image to the LCD buffer. */
-
-			*lcd_buffer++ =
-				(((data[stride * 0] << bit) & 0x80) >> 7) |
-				(((data[stride * 1] << bit) & 0x80) >> 6) |
-				(((data[stride * 2] << bit) & 0x80) >> 5) |
-				(((data[stride * 3] << bit) & 0x80) >> 4) |
-				(((data[stride * 4] << bit) & 0x80) >> 3) |
-				(((data[stride * 5] << bit) & 0x80) >> 2) |
-				(((data[stride * 6] << bit) & 0x80) >> 1) |
-				(((data[stride * 7] << bit) & 0x80) >> 0);
-
-			if (bit == 7)
-				data++;
-		}
-		/* Jump down seven pixel-rows in the source image,
-		 * since we've just done a row of eight pixels in one pass
-		 * (and we counted one pixel-row while we were going). */
-		data += 7 * stride;
-	}
+	pixfmt_linear_to_vpage(lcd_buffer, G15_LCD_WIDTH, 1,
+			       data, G15_LCD_WIDTH / 8, G15_LCD_WIDTH, 6 * 8, 1);
 }
 
 // Blasts a single frame onscreen, to the lcd...
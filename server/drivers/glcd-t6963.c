@@ -101,7 +101,8 @@ glcd_t6963_init(Driver *drvthis)
 	port_config->delayBus = drvthis->config_get_bool(drvthis->name, "delayBus", 0, 0);
 
 	/* Now initialize port */
-	if (t6963_low_init(port_config) == -1) {
+	if (t6963_low_init(port_config,
+			   drvthis->config_get_string(drvthis->name, "PortDevice", 0, "")) == -1) {
 		report(RPT_ERR, "GLCD/T6963: Error initializing port 0x%03X: %s",
 		       port_config->port, strerror(errno));
 		return -1;
@@ -120,6 +121,7 @@ glcd_t6963_init(Driver *drvthis)
 
 	/* Turn on display, text off, graphics on, cursor off */
 	t6963_low_command(port_config, SET_DISPLAY_MODE | GRAPHIC_ON);
+	t6963_low_flush(port_config);
 
 	debug(RPT_DEBUG, "GLCD/T6963: init() done");
 
@@ -168,6 +170,7 @@ glcd_t6963_blit(PrivateData *p)
 			t6963_low_command(ct_data->port_config, AUTO_RESET);
 		}
 	}
+	t6963_low_flush(ct_data->port_config);
 }
 
 
@@ -73,8 +73,9 @@
 
 #include "hd44780-4bit.h"
 #include "hd44780-low.h"
+#include "hd44780-lpt.h"
 #include "lpt-port.h"
-#include "port.h"
+#include "lpt-io.h"
 #include "shared/report.h"
 
 #include <stdio.h>
@@ -120,60 +121,57 @@ hd_init_4bit(Driver *drvthis)
 	int enableLines = EN1 | EN2 | ((p->numDisplays == 3) ? EnMask[2] : 0);
 
 	// Reserve the port registers
-	if (port_access_multiple(p->port,3)) {
-		report(RPT_ERR, "%s: cannot get IO-permission for 0x%03X: %s",
-				drvthis->name, p->port, strerror(errno));
+	if (hd_lpt_open(drvthis) != 0)
 		return -1;
-	}
 
 	hd44780_functions->senddata = lcdstat_HD44780_senddata;
 	hd44780_functions->backlight = lcdstat_HD44780_backlight;
 	hd44780_functions->readkeypad = lcdstat_HD44780_readkeypad;
 
 	// powerup the lcd now
-	port_out(p->port + 2, 0 ^ OUTMASK);
-	port_out(p->port, 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x03);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
 
 	/* We'll now send 0x03 a coulpe of times,
 	 * which is in fact (FUNCSET | IF_8BIT) >> 4 */
-	port_out(p->port, enableLines | 0x03);
-	port_out(p->port + 2, ALLEXT ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, enableLines | 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, ALLEXT ^ OUTMASK);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
-	port_out(p->port, 0x03);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	hd44780_functions->uPause(p, 15000);
 
-	port_out(p->port, enableLines | 0x03);
-	port_out(p->port + 2, ALLEXT ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, enableLines | 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, ALLEXT ^ OUTMASK);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
-	port_out(p->port, 0x03);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	hd44780_functions->uPause(p, 5000);
 
-	port_out(p->port, enableLines | 0x03);
-	port_out(p->port + 2, ALLEXT ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, enableLines | 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, ALLEXT ^ OUTMASK);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
-	port_out(p->port, 0x03);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	hd44780_functions->uPause(p, 100);
 
-	port_out(p->port, enableLines | 0x03);
-	port_out(p->port + 2, ALLEXT ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, enableLines | 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, ALLEXT ^ OUTMASK);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
-	port_out(p->port, 0x03);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x03);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	hd44780_functions->uPause(p, 100);
 
 	// now in 8-bit mode...  set 4-bit mode
-	port_out(p->port, 0x02);
+	lpt_out(p->lpt, LPT_DATA, 0x02);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
 
-	port_out(p->port, enableLines | 0x02);
-	port_out(p->port + 2, ALLEXT ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, enableLines | 0x02);
+	lpt_out(p->lpt, LPT_CONTROL, ALLEXT ^ OUTMASK);
 	if (p->delayBus) hd44780_functions->uPause(p, 1);
-	port_out(p->port, 0x02);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, 0x02);
+	lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	hd44780_functions->uPause(p, 100);
 
 	// Set up two-line, small character (5x8) mode
@@ -220,17 +218,17 @@ lcdstat_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char
 			enableLines = EnMask[displayID - 1];
 		}
 
-		port_out(p->port, portControl | h);
+		lpt_out(p->lpt, LPT_DATA, portControl | h);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port, enableLines | portControl | h);
+		lpt_out(p->lpt, LPT_DATA, enableLines | portControl | h);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port, portControl | h);
+		lpt_out(p->lpt, LPT_DATA, portControl | h);
 
-		port_out(p->port, portControl | l);
+		lpt_out(p->lpt, LPT_DATA, portControl | l);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port, enableLines | portControl | l);
+		lpt_out(p->lpt, LPT_DATA, enableLines | portControl | l);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port, portControl | l);
+		lpt_out(p->lpt, LPT_DATA, portControl | l);
 	}
 
 	if (p->numDisplays > 3) {
@@ -240,17 +238,17 @@ lcdstat_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char
 			enableLines = EnMask[(displayID - 1)];
 		}
 
-		port_out(p->port, portControl | h);
+		lpt_out(p->lpt, LPT_DATA, portControl | h);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port + 2, enableLines ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, enableLines ^ OUTMASK);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port + 2, 0 ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 
-		port_out(p->port, portControl | l);
+		lpt_out(p->lpt, LPT_DATA, portControl | l);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port + 2, enableLines ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, enableLines ^ OUTMASK);
 		if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-		port_out(p->port + 2, 0 ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
 	}
 }
 
@@ -264,7 +262,7 @@ void lcdstat_HD44780_backlight(PrivateData *p, unsigned char state)
 {
 	p->backlight_bit = ((have_backlight_pin(p)||state)?0:BL);
 
-	port_out(p->port, p->backlight_bit);
+	lpt_out(p->lpt, LPT_DATA, p->backlight_bit);
 }
 
 
@@ -280,8 +278,8 @@ unsigned char lcdstat_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 
 	/* If at most two controllers and NO backlight, 10 bits may be used */
 	if ((p->numDisplays <= 2) && (have_backlight_pin(p))) {
-		port_out(p->port, ~YData & 0x003F);
-		port_out(p->port + 2, (((~YData & 0x03C0) >> 6)) ^ OUTMASK);
+		lpt_out(p->lpt, LPT_DATA, ~YData & 0x003F);
+		lpt_out(p->lpt, LPT_CONTROL, (((~YData & 0x03C0) >> 6)) ^ OUTMASK);
 	}
 	else {
 		/*
@@ -289,22 +287,22 @@ unsigned char lcdstat_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 		 * Note: If three displays are used, have_backlight must be
 		 * set to 'no' in the config.
 		 */
-		port_out(p->port, (~YData & 0x001F) | p->backlight_bit);
+		lpt_out(p->lpt, LPT_DATA, (~YData & 0x001F) | p->backlight_bit);
 		/*
 		 * With at most three controllers or backlight 9 bits may be
 		 * used.
 		 */
 		if (p->numDisplays<=3) {
-			port_out(p->port + 2, (((~YData & 0x01E0) >> 5)) ^ OUTMASK);
+			lpt_out(p->lpt, LPT_CONTROL, (((~YData & 0x01E0) >> 5)) ^ OUTMASK);
 		}
 	}
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 
 	/* Read inputs */
-	readval = ~ port_in(p->port + 1) ^ INMASK;
+	readval = ~ lpt_in(p->lpt, LPT_STATUS) ^ INMASK;
 
 	/* Put port back into idle state for backlight */
-	port_out(p->port, p->backlight_bit);
+	lpt_out(p->lpt, LPT_DATA, p->backlight_bit);
 
 	/* And convert value back (MSB first) */
 	return (((readval & FAULT) / FAULT <<4) |		/* pin 15 */
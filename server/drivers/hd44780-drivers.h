@@ -44,6 +44,7 @@
 # include "hd44780-ethlcd.h"
 #endif
 #include "hd44780-usblcd.h"
+#include "hd44780-sim.h"
 #ifdef WITH_RASPBERRYPI
 # include "hd44780-rpi.h"
 #endif
@@ -118,6 +119,8 @@ static const ConnectionMapping connectionMapping[] = {
 #ifdef HAVE_GPIOD
 	{ "gpiod",         HD44780_CT_GPIOD,         IF_TYPE_PARPORT,  hd_init_gpiod     },
 #endif
+	/* simulated controller */
+	{ "sim",           HD44780_CT_SIM,           IF_TYPE_NONE,     hd_init_sim       },
 	/* add new connection types in the correct section above or here */
 
 	/* default, end of structure element (do not delete) */
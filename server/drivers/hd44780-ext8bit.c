@@ -54,8 +54,9 @@
 
 #include "hd44780-ext8bit.h"
 #include "hd44780-low.h"
+#include "hd44780-lpt.h"
 #include "lpt-port.h"
-#include "port.h"
+#include "lpt-io.h"
 #include "shared/report.h"
 
 #include <stdio.h>
@@ -92,11 +93,8 @@ hd_init_ext8bit(Driver *drvthis)
 	HD44780_functions *hd44780_functions = p->hd44780_functions;
 
 	// Reserve the port registers
-	if (port_access_multiple(p->port,3)) {
-		report(RPT_ERR, "%s: cannot get IO-permission for 0x%03X: %s",
-				drvthis->name, p->port, strerror(errno));
+	if (hd_lpt_open(drvthis) != 0)
 		return -1;
-	}
 
 	hd44780_functions->senddata = lcdtime_HD44780_senddata;
 	hd44780_functions->backlight = lcdtime_HD44780_backlight;
@@ -144,12 +142,12 @@ lcdtime_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char
 
 	portControl |= p->backlight_bit;
 
-	port_out(p->port + 2, portControl ^ OUTMASK);
-	port_out(p->port, ch);
+	lpt_out(p->lpt, LPT_CONTROL, portControl ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, ch);
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-	port_out(p->port + 2, (enableLines|portControl) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (enableLines|portControl) ^ OUTMASK);
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-	port_out(p->port + 2, portControl ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, portControl ^ OUTMASK);
 }
 
 
@@ -164,7 +162,7 @@ void lcdtime_HD44780_backlight(PrivateData *p, unsigned char state)
 
 	// Semaphores not needed because backlight will not go together with
 	// the bargraph anyway...
-	port_out(p->port + 2, p->backlight_bit ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, p->backlight_bit ^ OUTMASK);
 }
 
 
@@ -179,19 +177,19 @@ unsigned char lcdtime_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 	unsigned char readval;
 
 	// Convert the positive logic to the negative logic on the LPT port
-	port_out(p->port, ~YData & 0x00FF);
+	lpt_out(p->lpt, LPT_DATA, ~YData & 0x00FF);
 	// 9 bits output if backlight is used, 10 bits otherwise
 	if (have_backlight_pin(p))
-		port_out(p->port + 2, (((~YData & 0x0100) >> 8) | p->backlight_bit) ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, (((~YData & 0x0100) >> 8) | p->backlight_bit) ^ OUTMASK);
 	else
-		port_out(p->port + 2, (((~YData & 0x0100) >> 8) | ((~YData & 0x0200) >> 6)) ^ OUTMASK);
+		lpt_out(p->lpt, LPT_CONTROL, (((~YData & 0x0100) >> 8) | ((~YData & 0x0200) >> 6)) ^ OUTMASK);
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 
 	// Read inputs
-	readval = ~ port_in(p->port + 1) ^ INMASK;
+	readval = ~ lpt_in(p->lpt, LPT_STATUS) ^ INMASK;
 
 	// Put port back into idle state
-	port_out(p->port, p->backlight_bit ^ OUTMASK);
+	lpt_out(p->lpt, LPT_DATA, p->backlight_bit ^ OUTMASK);
 
 	// And convert value back (MSB first).
 	return (((readval & FAULT) / FAULT <<4) |		/* pin 15 */
@@ -210,10 +208,10 @@ unsigned char lcdtime_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 void lcdtime_HD44780_output(PrivateData *p, int data)
 {
 	// Setup data bus
-	port_out(p->port, data);
+	lpt_out(p->lpt, LPT_DATA, data);
 	// Strobe the latch (374 latches on rising edge, 3/574 on trailing.  No matter)
-	port_out(p->port + 2, (LE | p->backlight_bit) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (LE | p->backlight_bit) ^ OUTMASK);
         if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-	port_out(p->port + 2, (p->backlight_bit) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (p->backlight_bit) ^ OUTMASK);
         if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 }
@@ -17,9 +17,12 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include "hd44780-lcd2usb.h"
 #include "hd44780-low.h"
+#include "usb-io.h"
 #include "shared/report.h"
 
 /* connection type specific functions to be exposed using pointers in init() */
@@ -29,6 +32,9 @@ unsigned char lcd2usb_HD44780_scankeypad(PrivateData *p);
 void lcd2usb_HD44780_close(PrivateData *p);
 void lcd2usb_HD44780_set_contrast(PrivateData *p, unsigned char value);
 void lcd2usb_HD44780_flush(PrivateData *p);
+void lcd2usb_HD44780_idle(PrivateData *p);
+
+static void lcd2usb_send_buffer(PrivateData *p);
 
 
 /**
@@ -53,8 +59,7 @@ int
 hd_init_lcd2usb(Driver *drvthis)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
-
-	struct usb_bus *bus;
+	const char *mock;
 
 	p->hd44780_functions->senddata = lcd2usb_HD44780_senddata;
 	p->hd44780_functions->backlight = lcd2usb_HD44780_backlight;
@@ -62,11 +67,28 @@ hd_init_lcd2usb(Driver *drvthis)
 	p->hd44780_functions->close = lcd2usb_HD44780_close;
 	p->hd44780_functions->set_contrast = lcd2usb_HD44780_set_contrast;
 	p->hd44780_functions->flush = lcd2usb_HD44780_flush;
+	p->hd44780_functions->idle = lcd2usb_HD44780_idle;
+
+	p->libusbHandle = NULL;
+	if ((p->usb = malloc(sizeof(UsbIO))) == NULL) {
+		report(RPT_ERR, "hd_init_lcd2usb: could not allocate USB output");
+		return -1;
+	}
+
+	/* Without a device the commands are written to a file */
+	mock = drvthis->config_get_string(drvthis->name, "USBMock", 0, "");
+	if (mock[0] != '\0') {
+		if (usb_io_open_mock(p->usb, mock, 0) < 0) {
+			report(RPT_ERR, "hd_init_lcd2usb: cannot write %s: %s", mock, strerror(errno));
+			free(p->usb);
+			p->usb = NULL;
+			return -1;
+		}
+		report(RPT_INFO, "hd_init_lcd2usb: logging commands to %s instead of a device", mock);
+		goto connected;
+	}
 
 	/* try to find USB device */
-#if 0
-	usb_debug = 2;
-#endif
 
 	libusb_init(NULL);
 
@@ -74,10 +96,11 @@ hd_init_lcd2usb(Driver *drvthis)
 	ssize_t count = libusb_get_device_list(NULL, &list);
 	if (count < 0) {
 		report(RPT_WARNING, "hd_init_lcd2usb: list error %s", libusb_strerror(count));
+		free(p->usb);
+		p->usb = NULL;
 		return -1;
 	}
 
-	p->libusbHandle = NULL;
 	struct libusb_device_descriptor descriptor;
 	for(ssize_t i = 0; i<count; i++) {
 		libusb_device *device = list[i];
@@ -122,9 +145,21 @@ hd_init_lcd2usb(Driver *drvthis)
 	}
 	else {
 		report(RPT_ERR, "hd_init_lcd2usb: no (matching) LCD2USB device found");
+		free(p->usb);
+		p->usb = NULL;
+		return -1;
+	}
+
+	if (usb_io_open(p->usb, NULL, p->libusbHandle, 0) < 0) {
+		report(RPT_ERR, "hd_init_lcd2usb: could not allocate USB transfers");
+		free(p->usb);
+		p->usb = NULL;
+		lcd2usb_HD44780_close(p);
 		return -1;
 	}
 
+connected:
+
 	/* allocate and initialize send buffer */
 	if ((p->tx_buf.buffer = malloc(LCD2USB_MAX_CMD)) == NULL) {
 		report(RPT_ERR, "hd_init_lcd2usb: could not allocate send buffer");
@@ -157,46 +192,64 @@ lcd2usb_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char
 	int id = (displayID == 0) ? LCD2USB_CTRL_BOTH
 	: ((displayID == 1) ? LCD2USB_CTRL_0 : LCD2USB_CTRL_1);
 
-	/* flush current buffer if target or command type are different */
+	/* send current buffer if target or command type are different */
 	if ((p->tx_buf.type >= 0) && (p->tx_buf.type != (type | id)))
-		lcd2usb_HD44780_flush(p);
+		lcd2usb_send_buffer(p);
 
 	/* add new item to buffer */
 	p->tx_buf.type = (type | id);
 	p->tx_buf.buffer[p->tx_buf.use_count++] = ch;
 
-	/* flush buffer if it's full */
+	/* send buffer if it's full */
 	if (p->tx_buf.use_count == LCD2USB_MAX_CMD)
-		lcd2usb_HD44780_flush(p);
+		lcd2usb_send_buffer(p);
 }
 
 /**
- * Actually send data or command to the display.
+ * Queue the buffered data or command as one message to the display.
  * \param p  Pointer to driver's private data structure.
  */
-void
-lcd2usb_HD44780_flush(PrivateData *p)
+static void
+lcd2usb_send_buffer(PrivateData *p)
 {
 	/* only if some data available */
 	if (p->tx_buf.use_count == 0)
 		return;
 
-	/* construct and send message */
-	if (libusb_control_transfer(
-			p->libusbHandle,
-			LIBUSB_REQUEST_TYPE_VENDOR,
-			p->tx_buf.type | (p->tx_buf.use_count - 1),
-			p->tx_buf.buffer[0] | (p->tx_buf.buffer[1] << 8),
-			p->tx_buf.buffer[2] | (p->tx_buf.buffer[3] << 8),
-			NULL, 0, 1000) < 0) {
-		p->hd44780_functions->drv_report(RPT_WARNING, "lcd2usb_HD44780_flush: flush failed");
-	}
+	/* construct and queue message */
+	usb_io_control(p->usb, LIBUSB_REQUEST_TYPE_VENDOR,
+		       p->tx_buf.type | (p->tx_buf.use_count - 1),
+		       p->tx_buf.buffer[0] | (p->tx_buf.buffer[1] << 8),
+		       p->tx_buf.buffer[2] | (p->tx_buf.buffer[3] << 8),
+		       NULL, 0);
 
 	/* buffer is now free again. Not necessary to clear what's in it. */
 	p->tx_buf.type = -1;
 	p->tx_buf.use_count = 0;
 }
 
+/**
+ * Actually send the queued data and commands to the display. The transfers
+ * are not waited for; they complete while the server sleeps.
+ * \param p  Pointer to driver's private data structure.
+ */
+void
+lcd2usb_HD44780_flush(PrivateData *p)
+{
+	lcd2usb_send_buffer(p);
+	usb_io_flush(p->usb);
+}
+
+/**
+ * Collect the transfers that completed since the last flush.
+ * \param p  Pointer to driver's private data structure.
+ */
+void
+lcd2usb_HD44780_idle(PrivateData *p)
+{
+	usb_io_poll(p->usb);
+}
+
 /**
  * Turn display backlight on or off.
  * Backlight is turned on or off by toggeling between the brightness and
@@ -213,9 +266,8 @@ lcd2usb_HD44780_backlight(PrivateData *p, unsigned char state)
 	p->hd44780_functions->drv_debug(RPT_DEBUG, "lcd2usb_HD44780_backlight: Setting backlight to %d", promille);
 
 	/* and set it (converted from [0,1000] -> [0,255]) */
-	if (libusb_control_transfer(p->libusbHandle, LIBUSB_REQUEST_TYPE_VENDOR, LCD2USB_SET_BRIGHTNESS,
-			     (promille * 255) / 1000, 0, NULL, 0, 1000) < 0)
-		p->hd44780_functions->drv_report(RPT_WARNING, "lcd2usb_HD44780_backlight: setting backlight failed");
+	usb_io_control(p->usb, LIBUSB_REQUEST_TYPE_VENDOR, LCD2USB_SET_BRIGHTNESS,
+		       (promille * 255) / 1000, 0, NULL, 0);
 }
 
 
@@ -227,9 +279,8 @@ lcd2usb_HD44780_backlight(PrivateData *p, unsigned char state)
 void
 lcd2usb_HD44780_set_contrast(PrivateData *p, unsigned char value)
 {
-	if (libusb_control_transfer(p->libusbHandle, LIBUSB_REQUEST_TYPE_VENDOR, LCD2USB_SET_CONTRAST,
-			     value, 0, NULL, 0, 1000) < 0)
-		p->hd44780_functions->drv_report(RPT_WARNING, "lcd2usb_HD44780_set_contrast: setting contrast failed");
+	usb_io_control(p->usb, LIBUSB_REQUEST_TYPE_VENDOR, LCD2USB_SET_CONTRAST,
+		       value, 0, NULL, 0);
 }
 
 
@@ -244,6 +295,13 @@ lcd2usb_HD44780_scankeypad(PrivateData *p)
 	unsigned char buffer[2];
 	int nBytes;
 
+	/* the mock device has no keys */
+	if (p->libusbHandle == NULL)
+		return '\0';
+
+	/* the request must not overtake queued output */
+	usb_io_drain(p->usb);
+
 	/* send control request and accept return value */
 	nBytes = libusb_control_transfer(
 		p->libusbHandle,
@@ -271,6 +329,12 @@ lcd2usb_HD44780_scankeypad(PrivateData *p)
 void
 lcd2usb_HD44780_close(PrivateData *p)
 {
+	if (p->usb != NULL) {
+		lcd2usb_send_buffer(p);
+		usb_io_close(p->usb);
+		free(p->usb);
+		p->usb = NULL;
+	}
 	if (p->libusbHandle != NULL) {
 		libusb_close(p->libusbHandle);
 		p->libusbHandle = NULL;
@@ -34,6 +34,7 @@
 #endif
 
 #include "i2c.h"
+#include "lcd_lib.h"
 
 /** \name Symbolic names for connection types
  *@{*/
@@ -67,6 +68,7 @@
 #define HD44780_CT_UGPIO		27
 #define HD44780_CT_EZIO			28
 #define HD44780_CT_GPIOD		29
+#define HD44780_CT_SIM			30
 /**@}*/
 
 /** \name Symbolic names for interface types
@@ -78,6 +80,7 @@
 #define IF_TYPE_I2C		4
 #define IF_TYPE_TCP		5
 #define IF_TYPE_SPI		6
+#define IF_TYPE_NONE		7
 /**@}*/
 
 /** \name Symbolic name for specific models
@@ -190,6 +193,7 @@ typedef struct tx_buffer_t {
 typedef struct hd44780_private_data {
 	/* parallel connection types */
 	unsigned int port;	/**< parallel port */
+	struct lpt_io *lpt;	/**< access to the parallel port, see lpt-io.h */
 
 	/* serial connection types */
 	int fd;			/**< file handle to serial device */
@@ -207,6 +211,7 @@ typedef struct hd44780_private_data {
 
 #ifdef HAVE_LIBUSB_1_0
 	libusb_device_handle *libusbHandle;
+	struct usb_io *usb;	/**< queued output to the device, see usb-io.h */
 #endif
 
 #ifdef HAVE_LIBFTDI
@@ -254,7 +259,7 @@ typedef struct hd44780_private_data {
 	unsigned char *backingstore;	/**< buffer for incremental updates */
 
 	CGram cc[NUM_CCs];	/**< the custom character cache */
-	CGmode ccmode;		/**< character mode of the current screen */
+	CCAllocator cca;	/**< assigns glyphs to the custom characters */
 
 	/* Connection type data */
 	int connectiontype;
@@ -435,6 +440,11 @@ typedef struct hwDependentFns {
 	 */
 	void (*output) (PrivateData *p, int data);
 
+	/** Do pending work of the interface while the server waits.
+	 * \param p  pointer to private date structure
+	 */
+	void (*idle) (PrivateData *p);
+
 	/** Close the interface on shutdown */
 	void (*close) (PrivateData *p);
 } HD44780_functions;
@@ -0,0 +1,104 @@
+/** \file server/drivers/hd44780-lpt.c
+ * Parallel port access shared by the LPT connection types of the \c hd44780
+ * driver (\c 4bit, \c ext8bit and \c winamp).
+ *
+ * The port is accessed with direct I/O, or through the ppdev device set
+ * with \c PortDevice. With ppdev the writes and pauses of a whole frame
+ * are queued and sent when the driver flushes; see lpt-io.c.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "hd44780-lpt.h"
+#include "hd44780-low.h"
+#include "lpt-io.h"
+#include "shared/report.h"
+
+static void hd_lpt_uPause(PrivateData *p, int usecs);
+static void hd_lpt_flush(PrivateData *p);
+static void hd_lpt_close(PrivateData *p);
+
+
+/**
+ * Get access to the parallel port and route pauses through it.
+ * \param drvthis  Pointer to driver structure.
+ * \retval 0       Success.
+ * \retval -1      Error.
+ */
+int
+hd_lpt_open(Driver *drvthis)
+{
+	PrivateData *p = (PrivateData*) drvthis->private_data;
+	const char *device = drvthis->config_get_string(drvthis->name, "PortDevice", 0, "");
+
+	if ((p->lpt = malloc(sizeof(LptIO))) == NULL) {
+		report(RPT_ERR, "%s: error allocating port", drvthis->name);
+		return -1;
+	}
+
+	// Reserve the port registers
+	if (lpt_open(p->lpt, p->port, 3, device) != 0) {
+		if (device[0] == '\0')
+			report(RPT_ERR, "%s: cannot get IO-permission for 0x%03X: %s",
+					drvthis->name, p->port, strerror(errno));
+		else
+			report(RPT_ERR, "%s: cannot open port device %s: %s",
+					drvthis->name, device, strerror(errno));
+		free(p->lpt);
+		p->lpt = NULL;
+		return -1;
+	}
+	if (device[0] != '\0')
+		report(RPT_INFO, "%s: using port device %s", drvthis->name, device);
+
+	p->hd44780_functions->uPause = hd_lpt_uPause;
+	p->hd44780_functions->flush = hd_lpt_flush;
+	p->hd44780_functions->close = hd_lpt_close;
+
+	return 0;
+}
+
+
+/**
+ * Delay a number of microseconds, in order with the port writes.
+ * \param p      Pointer to driver's private data structure.
+ * \param usecs  Number of micro-seconds to sleep.
+ */
+static void
+hd_lpt_uPause(PrivateData *p, int usecs)
+{
+	lpt_pause(p->lpt, usecs * p->delayMult);
+}
+
+
+/**
+ * Send the queued port writes.
+ * \param p      Pointer to driver's private data structure.
+ */
+static void
+hd_lpt_flush(PrivateData *p)
+{
+	lpt_flush(p->lpt);
+}
+
+
+/**
+ * Release the parallel port.
+ * \param p      Pointer to driver's private data structure.
+ */
+static void
+hd_lpt_close(PrivateData *p)
+{
+	if (p->lpt != NULL) {
+		lpt_close(p->lpt);
+		free(p->lpt);
+		p->lpt = NULL;
+	}
+}
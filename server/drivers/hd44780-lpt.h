@@ -0,0 +1,9 @@
+#ifndef HD_LPT_H
+#define HD_LPT_H
+
+#include "lcd.h"					  /* for Driver */
+
+// get the parallel port for the LPT connection types
+int hd_lpt_open(Driver *drvthis);
+
+#endif
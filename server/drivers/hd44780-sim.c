@@ -0,0 +1,336 @@
+/** \file server/drivers/hd44780-sim.c
+ * \c sim connection type of \c hd44780 driver for Hitachi HD44780 based LCD
+ * displays.
+ *
+ * Instead of talking to hardware this connection type simulates one HD44780
+ * controller: its DDRAM and CGRAM, the address counter, the 4 or 8 bit bus
+ * framing and the execution time of each instruction. The driver's delays
+ * only advance a simulated clock, so nothing ever sleeps.
+ *
+ * On close the resulting display contents and the bus statistics are
+ * reported and written to the file given with \c SimDumpFile. This allows
+ * comparing the cost of display update strategies without a display.
+ */
+
+/*
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include "hd44780-sim.h"
+#include "hd44780-low.h"
+#include "shared/report.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/** \name Execution times of the controller in microseconds (at 270 kHz)
+ *@{*/
+#define SIM_EXEC_CLEAR		1520	/**< clear display and return home */
+#define SIM_EXEC_INSTR		37	/**< all other instructions */
+#define SIM_EXEC_DATA		37	/**< write to DDRAM or CGRAM */
+/**@}*/
+
+#define SIM_DDRAM_SIZE		0x80
+#define SIM_CGRAM_SIZE		0x40
+
+/** State of the simulated controller and the bus statistics */
+typedef struct sim_state {
+	unsigned char ddram[SIM_DDRAM_SIZE];
+	unsigned char cgram[SIM_CGRAM_SIZE];
+	int addr;		/**< address counter */
+	int in_cgram;		/**< address counter points into CGRAM */
+	int increment;		/**< entry mode: +1 or -1 */
+	int bus_4bit;		/**< interface is in 4 bit mode */
+	int display_on;
+	int backlight;
+
+	unsigned long transfers;	/**< bus transfers (bytes or nibbles) */
+	unsigned long instructions;	/**< instructions received */
+	unsigned long data;		/**< data bytes received */
+	unsigned long busy_us;		/**< total execution time of the controller */
+	unsigned long pause_us;		/**< total delays requested by the driver */
+	unsigned long violations;	/**< transfers while the controller was busy */
+	unsigned long long now;		/**< simulated clock [us] */
+	unsigned long long busy_until;	/**< end of the current execution [us] */
+
+	char *dumpfile;		/**< file to write the results to, or NULL */
+} SimState;
+
+void sim_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char flags, unsigned char ch);
+void sim_HD44780_uPause(PrivateData *p, int usecs);
+void sim_HD44780_backlight(PrivateData *p, unsigned char state);
+void sim_HD44780_close(PrivateData *p);
+
+
+/**
+ * Initialize the connection type.
+ * \param drvthis  Pointer to driver structure.
+ * \retval 0       Success.
+ * \retval -1      Error.
+ */
+int
+hd_init_sim(Driver *drvthis)
+{
+	PrivateData *p = (PrivateData *) drvthis->private_data;
+	HD44780_functions *hd44780_functions = p->hd44780_functions;
+	const char *s;
+	SimState *sim;
+
+	sim = calloc(1, sizeof(SimState));
+	if (sim == NULL) {
+		report(RPT_ERR, "%s: sim: unable to allocate memory", drvthis->name);
+		return -1;
+	}
+	p->connection_data = sim;
+
+	memset(sim->ddram, ' ', sizeof(sim->ddram));
+	sim->increment = 1;
+
+	/* Bus width to simulate */
+	s = drvthis->config_get_string(drvthis->name, "SimInterface", 0, "8bit");
+	if (strcasecmp(s, "4bit") == 0)
+		sim->bus_4bit = 1;
+	else if (strcasecmp(s, "8bit") != 0) {
+		report(RPT_ERR, "%s: sim: unknown SimInterface %s", drvthis->name, s);
+		return -1;
+	}
+
+	s = drvthis->config_get_string(drvthis->name, "SimDumpFile", 0, NULL);
+	if (s != NULL)
+		sim->dumpfile = strdup(s);
+
+	report(RPT_INFO, "%s: sim: simulating a %s interface", drvthis->name,
+		(sim->bus_4bit) ? "4 bit" : "8 bit");
+
+	hd44780_functions->senddata = sim_HD44780_senddata;
+	hd44780_functions->uPause = sim_HD44780_uPause;
+	hd44780_functions->backlight = sim_HD44780_backlight;
+	hd44780_functions->close = sim_HD44780_close;
+
+	if (sim->bus_4bit) {
+		/* After power on the controller is in 8 bit mode: the three
+		 * nibbles 0x03 and then 0x02 bring it into 4 bit mode. */
+		sim->transfers += 4;
+		sim_HD44780_uPause(p, 15000);
+		sim_HD44780_uPause(p, 4100);
+		sim_HD44780_uPause(p, 100);
+		sim_HD44780_uPause(p, 40);
+		common_init(p, IF_4BIT);
+	}
+	else {
+		common_init(p, IF_8BIT);
+	}
+
+	return 0;
+}
+
+
+/**
+ * Execute an instruction of the simulated controller.
+ * \param sim  Simulation state.
+ * \param ch   Instruction byte.
+ * \return     Execution time in microseconds.
+ */
+static int
+sim_instruction(SimState *sim, unsigned char ch)
+{
+	if (ch & 0x80) {		/* set DDRAM address */
+		sim->addr = ch & 0x7F;
+		sim->in_cgram = 0;
+	}
+	else if (ch & 0x40) {		/* set CGRAM address */
+		sim->addr = ch & 0x3F;
+		sim->in_cgram = 1;
+	}
+	else if (ch & 0x20) {		/* function set */
+		sim->bus_4bit = (ch & IF_8BIT) ? 0 : 1;
+	}
+	else if (ch & 0x10) {		/* cursor or display shift */
+		if (!(ch & 0x08))
+			sim->addr = (sim->addr + ((ch & 0x04) ? 1 : -1)) & 0x7F;
+	}
+	else if (ch & 0x08) {		/* display on/off control */
+		sim->display_on = (ch & 0x04) ? 1 : 0;
+	}
+	else if (ch & 0x04) {		/* entry mode set */
+		sim->increment = (ch & 0x02) ? 1 : -1;
+	}
+	else if (ch & 0x02) {		/* return home */
+		sim->addr = 0;
+		sim->in_cgram = 0;
+		return SIM_EXEC_CLEAR;
+	}
+	else if (ch & 0x01) {		/* clear display */
+		memset(sim->ddram, ' ', sizeof(sim->ddram));
+		sim->addr = 0;
+		sim->in_cgram = 0;
+		sim->increment = 1;
+		return SIM_EXEC_CLEAR;
+	}
+	return SIM_EXEC_INSTR;
+}
+
+
+/**
+ * Send data or commands to the simulated display.
+ * \param p          Pointer to driver's private data structure.
+ * \param displayID  ID of the display (or 0 for all) to send data to.
+ * \param flags      Defines whether to end a command or data.
+ * \param ch         The value to send.
+ */
+void
+sim_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char flags, unsigned char ch)
+{
+	SimState *sim = (SimState *) p->connection_data;
+	int exec;
+
+	sim->transfers += (sim->bus_4bit) ? 2 : 1;
+
+	/* Without a busy flag the driver has to wait long enough itself */
+	if (sim->now < sim->busy_until) {
+		sim->violations++;
+		sim->now = sim->busy_until;
+	}
+
+	if (flags == RS_DATA) {
+		if (sim->in_cgram) {
+			sim->cgram[sim->addr] = ch & 0x1F;
+			sim->addr = (sim->addr + sim->increment) & (SIM_CGRAM_SIZE - 1);
+		}
+		else {
+			sim->ddram[sim->addr] = ch;
+			sim->addr = (sim->addr + sim->increment) & (SIM_DDRAM_SIZE - 1);
+		}
+		sim->data++;
+		exec = SIM_EXEC_DATA;
+	}
+	else {
+		sim->instructions++;
+		exec = sim_instruction(sim, ch);
+	}
+	sim->busy_us += exec;
+	sim->busy_until = sim->now + exec;
+}
+
+
+/**
+ * Advance the simulated clock instead of waiting.
+ * \param p      Pointer to driver's private data structure.
+ * \param usecs  Microseconds to wait.
+ */
+void
+sim_HD44780_uPause(PrivateData *p, int usecs)
+{
+	SimState *sim = (SimState *) p->connection_data;
+
+	usecs *= p->delayMult;
+	sim->pause_us += usecs;
+	sim->now += usecs;
+}
+
+
+/**
+ * Turn the simulated backlight on or off.
+ * \param p      Pointer to driver's private data structure.
+ * \param state  New backlight status.
+ */
+void
+sim_HD44780_backlight(PrivateData *p, unsigned char state)
+{
+	SimState *sim = (SimState *) p->connection_data;
+
+	sim->backlight = state;
+}
+
+
+/**
+ * Write the display contents and statistics.
+ * \param p   Pointer to driver's private data structure.
+ * \param f   Stream to write to.
+ */
+static void
+sim_dump(PrivateData *p, FILE *f)
+{
+	SimState *sim = (SimState *) p->connection_data;
+	int x, y, i;
+
+	fprintf(f, "interface %s\n", (sim->bus_4bit) ? "4bit" : "8bit");
+	fprintf(f, "transfers %lu\n", sim->transfers);
+	fprintf(f, "instructions %lu\n", sim->instructions);
+	fprintf(f, "data %lu\n", sim->data);
+	fprintf(f, "busy_us %lu\n", sim->busy_us);
+	fprintf(f, "pause_us %lu\n", sim->pause_us);
+	fprintf(f, "wall_us %llu\n", (sim->now > sim->busy_until) ? sim->now : sim->busy_until);
+	fprintf(f, "violations %lu\n", sim->violations);
+	fprintf(f, "display %s\n", (sim->display_on) ? "on" : "off");
+	fprintf(f, "backlight %s\n", (sim->backlight) ? "on" : "off");
+
+	/* Same addressing as HD44780_position() for a single controller */
+	for (y = 0; y < p->height; y++) {
+		fprintf(f, "row%d |", y + 1);
+		for (x = 0; x < p->width; x++) {
+			int addr;
+			unsigned char ch;
+
+			if (has_extended_mode(p))
+				addr = x + y * p->line_address;
+			else
+				addr = x + (y % 2) * 0x40 + (((y % 4) >= 2) ? p->width : 0);
+			ch = sim->ddram[addr & (SIM_DDRAM_SIZE - 1)];
+			/* custom characters are shown by their number */
+			fputc((ch < 8) ? '0' + ch : ((ch < 0x20) ? '.' : ch), f);
+		}
+		fprintf(f, "|\n");
+	}
+
+	for (i = 0; i < NUM_CCs; i++) {
+		fprintf(f, "cgram%d", i);
+		for (y = 0; y < 8; y++)
+			fprintf(f, " %02x", sim->cgram[i * 8 + y]);
+		fprintf(f, "\n");
+	}
+}
+
+
+/**
+ * Report the statistics and write the dump file.
+ * \param p  Pointer to driver's private data structure.
+ */
+void
+sim_HD44780_close(PrivateData *p)
+{
+	SimState *sim = (SimState *) p->connection_data;
+
+	if (sim == NULL)
+		return;
+
+	report(RPT_NOTICE, "HD44780: sim: %lu transfers, %lu instructions, %lu data bytes, "
+		"%lu us busy, %lu us delays, %lu violations",
+		sim->transfers, sim->instructions, sim->data,
+		sim->busy_us, sim->pause_us, sim->violations);
+
+	if (sim->dumpfile != NULL) {
+		FILE *f = fopen(sim->dumpfile, "w");
+
+		if (f != NULL) {
+			sim_dump(p, f);
+			fclose(f);
+		}
+		else {
+			report(RPT_ERR, "HD44780: sim: cannot write %s: %s",
+				sim->dumpfile, strerror(errno));
+		}
+		free(sim->dumpfile);
+	}
+
+	free(sim);
+	p->connection_data = NULL;
+}
@@ -0,0 +1,9 @@
+#ifndef HD_SIM_H
+#define HD_SIM_H
+
+#include "lcd.h"			  /* for Driver */
+
+// initialise this particular driver
+int hd_init_sim(Driver *drvthis);
+
+#endif
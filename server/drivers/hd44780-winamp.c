@@ -63,8 +63,9 @@
 
 #include "hd44780-winamp.h"
 #include "hd44780-low.h"
+#include "hd44780-lpt.h"
 #include "lpt-port.h"
-#include "port.h"
+#include "lpt-io.h"
 #include "shared/report.h"
 
 #include <stdio.h>
@@ -125,11 +126,8 @@ hd_init_winamp(Driver *drvthis)
 	}
 
 	// Reserve the port registers
-	if (port_access_multiple(p->port,3)) {
-		report(RPT_ERR, "%s: cannot get IO-permission for 0x%03X: %s",
-				drvthis->name, p->port, strerror(errno));
+	if (hd_lpt_open(drvthis) != 0)
 		return -1;
-	}
 
 	hd44780_functions->senddata = lcdwinamp_HD44780_senddata;
 	hd44780_functions->backlight = lcdwinamp_HD44780_backlight;
@@ -182,15 +180,15 @@ lcdwinamp_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned cha
 		enableLines = EnMask[displayID - 1];
 
 	// 40 nS setup time for RS valid to EN high, so set RS
-	port_out(p->port + 2, portControl ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, portControl ^ OUTMASK);
 
 	// Output the actual data
-	port_out(p->port, ch);
+	lpt_out(p->lpt, LPT_DATA, ch);
 
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 
 	// then set EN high
-	port_out(p->port + 2, (enableLines|portControl) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (enableLines|portControl) ^ OUTMASK);
 
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 
@@ -201,7 +199,7 @@ lcdwinamp_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned cha
 	// ABOVE TEXT ignored now, using delays if delayBus is specified
 
 	// Set EN low and we're done...
-	port_out(p->port + 2, portControl ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, portControl ^ OUTMASK);
 
 	// 10 nS data hold time provided by the length of ISA write for EN
 }
@@ -216,7 +214,7 @@ void lcdwinamp_HD44780_backlight(PrivateData *p, unsigned char state)
 {
 	p->backlight_bit = (state ? 0 : BL);
 
-	port_out(p->port + 2, p->backlight_bit ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, p->backlight_bit ^ OUTMASK);
 }
 
 
@@ -232,12 +230,12 @@ unsigned char lcdwinamp_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 
 	// 8 bits output
 	// Convert the positive logic to the negative logic on the LPT port
-	port_out(p->port, ~YData & 0x00FF);
+	lpt_out(p->lpt, LPT_DATA, ~YData & 0x00FF);
 
 	if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 
 	// Read inputs
-	readval = ~ port_in(p->port + 1) ^ INMASK;
+	readval = ~ lpt_in(p->lpt, LPT_STATUS) ^ INMASK;
 
 	// And convert value back (MSB first).
 	return (((readval & FAULT) / FAULT <<4) |		/* pin 15 */
@@ -256,10 +254,10 @@ unsigned char lcdwinamp_HD44780_readkeypad(PrivateData *p, unsigned int YData)
 void lcdwinamp_HD44780_output(PrivateData *p, int data)
 {
 	// Setup data bus
-	port_out(p->port, data);
+	lpt_out(p->lpt, LPT_DATA, data);
 	// Strobe the latch (374 latches on rising edge, 373 on trailing. No matter)
-	port_out(p->port + 2, (LE | p->backlight_bit) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (LE | p->backlight_bit) ^ OUTMASK);
         if (p->delayBus) p->hd44780_functions->uPause(p, 1);
-	port_out(p->port + 2, (p->backlight_bit) ^ OUTMASK);
+	lpt_out(p->lpt, LPT_CONTROL, (p->backlight_bit) ^ OUTMASK);
         if (p->delayBus) p->hd44780_functions->uPause(p, 1);
 }
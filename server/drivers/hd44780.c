@@ -336,7 +336,7 @@ HD44780_init(Driver *drvthis)
 				 * controller property, not a display
 				 * property !!! */
 	p->cellwidth = 5;
-	p->ccmode = standard;
+	lib_cc_init(&p->cca, 0, NUM_CCs, p->cellheight);
 	p->backlightstate = -1;	/* Init to invalid value */
 	p->fd = -1;
 
@@ -595,6 +595,7 @@ HD44780_init(Driver *drvthis)
 	p->hd44780_functions->readkeypad = NULL;
 	p->hd44780_functions->scankeypad = NULL;
 	p->hd44780_functions->output = NULL;
+	p->hd44780_functions->idle = NULL;
 	p->hd44780_functions->close = NULL;
 	p->hd44780_functions->flush = NULL;
 	p->hd44780_functions->reset = NULL;
@@ -974,7 +975,7 @@ HD44780_clear(Driver *drvthis)
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 
 	memset(p->framebuf, ' ', p->width * p->height);
-	p->ccmode = standard;
+	lib_cc_frame(&p->cca);
 }
 
 
@@ -1012,7 +1013,6 @@ MODULE_EXPORT void
 HD44780_string(Driver *drvthis, int x, int y, const char string[])
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
-	int i;
 
 	x--;			/* Convert 1-based coords to 0-based */
 	y--;
@@ -1020,11 +1020,8 @@ HD44780_string(Driver *drvthis, int x, int y, const char string[])
 	if ((y < 0) || (y >= p->height))
 		return;
 
-	for (i = 0; (string[i] != '\0') && (x < p->width); i++, x++) {
-		if (x >= 0)	/* no write left of left border */
-			p->framebuf[(y * p->width) + x] =
-				available_charmaps[p->charmap].charmap[(unsigned char) string[i]];
-	}
+	lib_charmap_string(p->framebuf + (y * p->width), p->width, x, string,
+			   available_charmaps[p->charmap].charmap);
 }
 
 
@@ -1222,28 +1219,7 @@ HD44780_vbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 
-	if (p->ccmode != vbar) {
-		unsigned char vBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: vbar: cannot combine two modes using user-defined characters",
-				drvthis->name);
-			return;
-		}
-		p->ccmode = vbar;
-
-		memset(vBar, 0x00, sizeof(vBar));
-
-		for (i = 1; i < p->cellheight; i++) {
-			/* add pixel line per pixel line ... */
-			vBar[p->cellheight - i] = 0xFF;
-			HD44780_set_char(drvthis, i, vBar);
-		}
-	}
-
-	lib_vbar_static(drvthis, x, y, len, promille, options, p->cellheight, 0);
+	lib_vbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellheight, 0xFF);
 }
 
 
@@ -1261,27 +1237,7 @@ HD44780_hbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 
-	if (p->ccmode != hbar) {
-		unsigned char hBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: hbar: cannot combine two modes using user-defined characters",
-			      drvthis->name);
-			return;
-		}
-
-		p->ccmode = hbar;
-
-		for (i = 1; i <= p->cellwidth; i++) {
-			/* fill pixel columns from left to right. */
-			memset(hBar, 0xFF & ~((1 << (p->cellwidth - i)) - 1), sizeof(hBar));
-			HD44780_set_char(drvthis, i, hBar);
-		}
-	}
-
-	lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+	lib_hbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellwidth, p->cellheight);
 }
 
 
@@ -1295,22 +1251,17 @@ MODULE_EXPORT void
 HD44780_num(Driver *drvthis, int x, int num)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
-	int do_init = 0;
+	int do_init;
 
 	if ((num < 0) || (num > 10))
 		return;
 
-	if (p->ccmode != bignum) {
-		if (p->ccmode != standard) {
-			/* Not supported (yet) */
-			report(RPT_WARNING, "%s: num: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return;
-		}
-
-		p->ccmode = bignum;
-
-		do_init = 1;
+	/* Big numbers need all custom characters */
+	do_init = lib_cc_claim_all(&p->cca);
+	if (do_init < 0) {
+		report(RPT_WARNING, "%s: num: cannot combine big numbers with other user-defined characters",
+				drvthis->name);
+		return;
 	}
 
 	/* Lib_adv_bignum does everything needed to show the bignumbers. */
@@ -1451,6 +1402,9 @@ HD44780_icon(Driver *drvthis, int x, int y, int icon)
 		  b__XXXXX,
 		  b__XXXXX };
 
+	unsigned char *glyph;
+	int c;
+
 	/* Icons from CGROM will always work */
 	switch (icon) {
 	    case ICON_ARROW_LEFT:
@@ -1461,72 +1415,40 @@ HD44780_icon(Driver *drvthis, int x, int y, int icon)
 		return 0;
 	}
 
-	/* The full block works except if ccmode=bignum */
-	if (icon == ICON_BLOCK_FILLED) {
-		if (p->ccmode != bignum) {
-			HD44780_set_char(drvthis, 0, block_filled);
-			HD44780_chr(drvthis, x, y, 0);
-			return 0;
-		}
-		else {
-			return -1;
-		}
-	}
-
-	/* The heartbeat icons do not work in bignum and vbar mode */
-	if ((icon == ICON_HEART_FILLED) || (icon == ICON_HEART_OPEN)) {
-		if ((p->ccmode != bignum) && (p->ccmode != vbar)) {
-			switch (icon) {
-			    case ICON_HEART_FILLED:
-				HD44780_set_char(drvthis, 7, heart_filled);
-				HD44780_chr(drvthis, x, y, 7);
-				return 0;
-			    case ICON_HEART_OPEN:
-				HD44780_set_char(drvthis, 7, heart_open);
-				HD44780_chr(drvthis, x, y, 7);
-				return 0;
-			}
-		}
-		else {
-			return -1;
-		}
-	}
-
-	/* All other icons work only in the standard or icon ccmode */
-	if (p->ccmode != icons) {
-		if (p->ccmode != standard) {
-			/* Not supported (yet) */
-			report(RPT_WARNING, "%s: num: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return -1;
-		}
-		p->ccmode = icons;
-	}
-
 	switch (icon) {
+		case ICON_BLOCK_FILLED:
+			glyph = block_filled;
+			break;
+		case ICON_HEART_FILLED:
+			glyph = heart_filled;
+			break;
+		case ICON_HEART_OPEN:
+			glyph = heart_open;
+			break;
 		case ICON_ARROW_UP:
-			HD44780_set_char(drvthis, 1, arrow_up);
-			HD44780_chr(drvthis, x, y, 1);
+			glyph = arrow_up;
 			break;
 		case ICON_ARROW_DOWN:
-			HD44780_set_char(drvthis, 2, arrow_down);
-			HD44780_chr(drvthis, x, y, 2);
+			glyph = arrow_down;
 			break;
 		case ICON_CHECKBOX_OFF:
-			HD44780_set_char(drvthis, 3, checkbox_off);
-			HD44780_chr(drvthis, x, y, 3);
+			glyph = checkbox_off;
 			break;
 		case ICON_CHECKBOX_ON:
-			HD44780_set_char(drvthis, 4, checkbox_on);
-			HD44780_chr(drvthis, x, y, 4);
+			glyph = checkbox_on;
 			break;
 		case ICON_CHECKBOX_GRAY:
-			HD44780_set_char(drvthis, 5, checkbox_gray);
-			HD44780_chr(drvthis, x, y, 5);
+			glyph = checkbox_gray;
 			break;
 		default:
 			return -1;	/* Let the core do other icons */
 	}
+
+	/* Let the core do it if all custom characters are taken */
+	c = lib_cc_get(drvthis, &p->cca, glyph);
+	if (c < 0)
+		return -1;
+	HD44780_chr(drvthis, x, y, c);
 	return 0;
 }
 
@@ -1725,6 +1647,20 @@ HD44780_output(Driver *drvthis, int on)
 }
 
 
+/**
+ * Let the connection type do pending work while the server waits.
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+HD44780_idle(Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if (p->hd44780_functions->idle != NULL)
+		p->hd44780_functions->idle(p);
+}
+
+
 /**
  * Parse a span list, a comma separated list of numbers (e.g. "1,4,2").
  * \param spanListArray  Array to store vertical spans.
@@ -42,6 +42,7 @@ MODULE_EXPORT int  HD44780_get_brightness(Driver *drvthis, int state);
 MODULE_EXPORT void HD44780_set_brightness(Driver *drvthis, int state, int promille);
 MODULE_EXPORT void HD44780_backlight(Driver *drvthis, int on);
 MODULE_EXPORT void HD44780_output(Driver *drvthis, int state);
+MODULE_EXPORT void HD44780_idle(Driver *drvthis);
 
 MODULE_EXPORT const char *HD44780_get_key(Driver *drvthis);
 
@@ -289,10 +289,14 @@ imon_flush(Driver *drvthis)
 MODULE_EXPORT void
 imon_string(Driver *drvthis, int x, int y, const char string[])
 {
-	int i;
+	PrivateData *p = drvthis->private_data;
+
+	y--; x--;
+
+	if ((y < 0) || (y >= p->height))
+		return;
 
-	for (i = 0; string[i] != '\0'; i++)
-		imon_chr(drvthis, x+i, y, string[i]);
+	lib_charmap_string(p->framebuf + (y * p->width), p->width, x, string, p->charmap);
 }
 
 
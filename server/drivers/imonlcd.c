@@ -26,6 +26,7 @@
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <sys/uio.h>
 #ifdef HAVE_STDINT_H
 # include <stdint.h>
 #endif
@@ -43,6 +44,8 @@
 #include "imonlcd.h"
 
 #define IMONLCD_PACKET_DATA_SIZE 7
+#define IMONLCD_FIRST_PACKET     0x20	/**< Memory register of the first packet */
+#define IMONLCD_NUM_PACKETS      28	/**< Packets per screen (0x20 - 0x3b) */
 
 #define DEFAULT_DEVICE       "/dev/lcd0"
 #define DEFAULT_SIZE         "96x16"	/**< This is the size in "pixels" (colXrow) */
@@ -51,6 +54,7 @@
 #define DEFAULT_DISCMODE     0	/**< spin the "slim" disc */
 #define DEFAULT_ON_EXIT      1	/**< show the big clock */
 #define DEFAULT_PROTOCOL     0	/**< protocol for 15c2:ffdc device */
+#define DEFAULT_PARTIAL      1	/**< only send changed packets */
 
 
 #define ON_EXIT_SHOWMSG      0	/**< Do nothing - just leave the "shutdown"
@@ -78,6 +82,8 @@ typedef struct imonlcd_private_data {
 	/* framebuffer and backingstore for current contents */
 	unsigned char *framebuf;
 	unsigned char *backingstore;
+	int backingstore_valid;	/* display shows the backing store */
+	int partial;		/* only send packets that changed */
 
 	int bytesperline;
 
@@ -238,6 +244,7 @@ static void setBuiltinProgressBars(int topLine, int botLine, int topProgress, in
 static int lengthToPixels(int length);
 static void send_command_data(uint64_t commandData, PrivateData *p);
 static int send_packet(PrivateData *p);
+static int send_packets(PrivateData *p, struct iovec *iov, int count);
 
 /**
  * Initialize the driver.
@@ -367,6 +374,9 @@ imonlcd_init(Driver *drvthis)
 	/* Get the "disc-mode" setting */
 	p->discMode = drvthis->config_get_bool(drvthis->name, "DiscMode", 0, DEFAULT_DISCMODE);
 
+	/* Get the "partial update" setting */
+	p->partial = drvthis->config_get_bool(drvthis->name, "PartialUpdate", 0, DEFAULT_PARTIAL);
+
 	/*
 	 * We need a little bit of extra memory in the frame buffer so that
 	 * all of the last 7-byte-long packet data will be within the frame
@@ -400,6 +410,7 @@ imonlcd_init(Driver *drvthis)
 		return -1;
 	}
 	memset(p->backingstore, ' ', p->bytesperline * p->height);
+	p->backingstore_valid = 0;
 
 	imonlcd_display_init(drvthis);
 
@@ -536,35 +547,54 @@ imonlcd_flush(Driver *drvthis)
 {
 	PrivateData *p = drvthis->private_data;
 
-	unsigned char msb;
-	int offset = 0, ret;
+	unsigned char packets[IMONLCD_NUM_PACKETS][8];
+	struct iovec iov[IMONLCD_NUM_PACKETS];
+	int size = p->bytesperline * p->height;
+	int offset, i, count = 0, bytes, ret;
+
+	/* If nothing has changed, don't refresh. */
+	if (p->backingstore_valid && (memcmp(p->backingstore, p->framebuf, size) == 0))
+		return;
 
 	/*
-	 * The display only provides for a complete screen refresh. If
-	 * nothing has changed, don't refresh.
+	 * Each packet carries the address of the 7 bytes of display memory
+	 * it fills, so only the packets whose bytes changed are sent. All of
+	 * them are written with a single writev().
 	 */
-	if (memcmp(p->backingstore, p->framebuf, (p->bytesperline * p->height)) == 0)
-		return;
+	for (i = 0, offset = 0; i < IMONLCD_NUM_PACKETS; i++, offset += IMONLCD_PACKET_DATA_SIZE) {
+		int len = size - offset;
+
+		if (len > IMONLCD_PACKET_DATA_SIZE)
+			len = IMONLCD_PACKET_DATA_SIZE;
+		if (p->partial && p->backingstore_valid
+		    && ((len <= 0) || (memcmp(p->backingstore + offset, p->framebuf + offset, len) == 0)))
+			continue;
 
-	for (msb = 0x20; msb < 0x3c; msb++) {
 		/* Copy the packet data from the frame buffer. */
-		memcpy(p->tx_buf, p->framebuf + offset, IMONLCD_PACKET_DATA_SIZE);
+		memcpy(packets[count], p->framebuf + offset, IMONLCD_PACKET_DATA_SIZE);
 
 		/* Add the memory register byte to the packet data. */
-		p->tx_buf[IMONLCD_PACKET_DATA_SIZE] = msb;
-
-		ret = send_packet(p);
-		if (ret < 0)
-			report(RPT_ERR, "imonlcd_flush: sending data for msb=%x: %s\n",
-					(int) msb, strerror(errno));
-		else if (ret != sizeof(p->tx_buf))
-			report(RPT_ERR, "imonlcd: incomplete write\n");
+		packets[count][IMONLCD_PACKET_DATA_SIZE] = IMONLCD_FIRST_PACKET + i;
 
-		offset += IMONLCD_PACKET_DATA_SIZE;
+		iov[count].iov_base = packets[count];
+		iov[count].iov_len = sizeof(packets[count]);
+		count++;
 	}
 
+	bytes = count * sizeof(packets[0]);
+	ret = send_packets(p, iov, count);
+	if (ret < 0)
+		report(RPT_ERR, "imonlcd_flush: sending %d packets: %s\n",
+				count, strerror(errno));
+	else if (ret != bytes)
+		report(RPT_ERR, "imonlcd: incomplete write\n");
+	else
+		report(RPT_DEBUG, "imonlcd_flush: sent %d of %d packets (%d bytes)",
+				count, IMONLCD_NUM_PACKETS, ret);
+
 	/* Update the backing store. */
-	memcpy(p->backingstore, p->framebuf, (p->bytesperline * p->height));
+	memcpy(p->backingstore, p->framebuf, size);
+	p->backingstore_valid = (ret == bytes);
 }
 
 
@@ -1130,6 +1160,23 @@ send_packet(PrivateData *p)
 	return write(p->imon_fd, p->tx_buf, sizeof(p->tx_buf));
 }
 
+/**
+ * Sends several packets to the screen with one system call. The kernel
+ * driver still receives them as separate 8 byte writes.
+ *
+ * \param p      The private data structure containing the file descriptor.
+ * \param iov    The packets.
+ * \param count  Number of packets.
+ * \return       Number of bytes written or error code.
+ */
+static int
+send_packets(PrivateData *p, struct iovec *iov, int count)
+{
+	if (count == 0)
+		return 0;
+	return writev(p->imon_fd, iov, count);
+}
+
 
 /**
  * Sets the contrast of the display.
@@ -1195,6 +1242,9 @@ imonlcd_backlight(Driver *drvthis, int on)
 		send_command_data(p->command_display_on, p);
 	else
 		send_command_data(p->command_shutdown, p);
+
+	/* Send the whole screen again with the next flush. */
+	p->backingstore_valid = 0;
 }
 
 
@@ -116,6 +116,39 @@ typedef enum {
 	bignum,			/* big numbers */
 } CGmode;
 
+/* Kinds of drawing operations in a cell buffer */
+#define CELL_OP_HBAR	1
+#define CELL_OP_VBAR	2
+#define CELL_OP_PBAR	3
+#define CELL_OP_ICON	4
+#define CELL_OP_NUM	5
+
+/* A bar, icon or big number in a cell buffer. The fields are the arguments
+ * of the driver function that draws it. */
+typedef struct CellOp {
+	int kind;		/* CELL_OP_* */
+	int x, y;
+	int len;		/* length of a bar, width of a pbar */
+	int promille;		/* level of a bar */
+	int arg;		/* bar pattern, icon or big number */
+	const char *begin_label;	/* labels of a pbar, may be NULL */
+	const char *end_label;
+} CellOp;
+
+/* The composed contents of a screen, as handed to the drivers. Cell (x,y)
+ * (1-based) has index (y-1) * width + (x-1). If its owner is -1 the cell
+ * shows the character chars[index]; otherwise it is drawn by the operation
+ * ops[owner]. The server draws the operations, in order, before it calls
+ * a driver's draw_cells() function. */
+typedef struct CellBuffer {
+	int width, height;
+	unsigned char *chars;
+	short *owner;
+	CellOp *ops;
+	int num_ops;		/* operations in use */
+	int ops_size;		/* operations allocated */
+} CellBuffer;
+
 /* What does the shared module handle look like on the current platform? */
 #define MODULE_HANDLE void*
 
@@ -161,6 +194,7 @@ typedef struct lcd_logical_driver {
 	void (*heartbeat)	(struct lcd_logical_driver *drvthis, int state);
 	int (*icon)		(struct lcd_logical_driver *drvthis, int x, int y, int icon);
 	void (*cursor)		(struct lcd_logical_driver *drvthis, int x, int y, int type);
+	void (*draw_cells)	(struct lcd_logical_driver *drvthis, const CellBuffer *cells);
 
 	/* user-defined character functions, are those still supported ? */
 	void (*set_char)	(struct lcd_logical_driver *drvthis, int n, unsigned char *dat);
@@ -175,6 +209,7 @@ typedef struct lcd_logical_driver {
 	void (*set_brightness)	(struct lcd_logical_driver *drvthis, int state, int promille);
 	void (*backlight)	(struct lcd_logical_driver *drvthis, int on);
 	void (*output)		(struct lcd_logical_driver *drvthis, int state);
+	void (*idle)		(struct lcd_logical_driver *drvthis);
 
 	/* informational functions */
 	const char * (*get_info) (struct lcd_logical_driver *drvthis);
@@ -192,6 +227,9 @@ typedef struct lcd_logical_driver {
 				   Driver should cast this to it's own
 				   private structure pointer */
 
+	int display;		/* Logical display the driver shows, set from
+				   the Display setting of its section */
+
 
 	/******** Functions in server core available for drivers ********/
 
@@ -5,7 +5,10 @@
  * to this library.
  */
 
+#include <string.h>
+
 #include "lcd.h"
+#include "lcd_lib.h"
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -79,3 +82,292 @@ lib_vbar_static (Driver *drvthis, int x, int y, int len, int promille, int optio
 		}
 	}
 }
+
+
+/**
+ * Translate bytes through a 256 byte character map. The bytes are looked
+ * up four at a time; NUL is translated like any other byte, as it is the
+ * first custom character of many displays.
+ * \param dst      Output buffer.
+ * \param src      Bytes to translate.
+ * \param len      Number of bytes.
+ * \param charmap  Table giving the display code of every character.
+ */
+void
+lib_charmap_translate (unsigned char *dst, const unsigned char *src, int len, const unsigned char *charmap)
+{
+	int i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		unsigned char c0 = charmap[src[i]];
+		unsigned char c1 = charmap[src[i + 1]];
+		unsigned char c2 = charmap[src[i + 2]];
+		unsigned char c3 = charmap[src[i + 3]];
+
+		dst[i] = c0;
+		dst[i + 1] = c1;
+		dst[i + 2] = c2;
+		dst[i + 3] = c3;
+	}
+	for (; i < len; i++)
+		dst[i] = charmap[src[i]];
+}
+
+
+/**
+ * Write a string into a row of the frame buffer, translating it through a
+ * character map, as drivers do in their string() function. The string is
+ * clipped to the row first and then translated as a whole, instead of
+ * testing every character for the end of the string and the row.
+ * \param row      First byte of the row in the frame buffer.
+ * \param width    Number of columns of the row.
+ * \param x        Column of the first character (0-based, may be negative).
+ * \param src      String to write.
+ * \param charmap  Table giving the display code of every character.
+ * \return         Number of columns written.
+ */
+int
+lib_charmap_string (unsigned char *row, int width, int x, const char *src, const unsigned char *charmap)
+{
+	int n;
+
+	if (x < 0) {
+		/* skip the part left of the left border */
+		n = strnlen(src, -x);
+		if (n < -x)
+			return 0;
+		src += n;
+		x = 0;
+	}
+	if (x >= width)
+		return 0;
+
+	n = strnlen(src, width - x);
+	lib_charmap_translate(row + x, (const unsigned char *) src, n, charmap);
+	return n;
+}
+
+
+/**
+ * Copy the character cells of a composed screen into a frame buffer of one
+ * byte per cell, as drivers do in their draw_cells() function. Cells drawn
+ * by an operation are left alone, and so is what lies outside the buffer.
+ * \param framebuf  Frame buffer.
+ * \param width     Number of columns of the frame buffer.
+ * \param height    Number of rows of the frame buffer.
+ * \param cells     The composed screen.
+ */
+void
+lib_draw_cells (unsigned char *framebuf, int width, int height, const CellBuffer *cells)
+{
+	int w = (cells->width < width) ? cells->width : width;
+	int h = (cells->height < height) ? cells->height : height;
+	int x, y;
+
+	for (y = 0; y < h; y++) {
+		unsigned char *row = framebuf + y * width;
+		const unsigned char *chars = cells->chars + y * cells->width;
+		const short *owner = cells->owner + y * cells->width;
+
+		for (x = 0; x < w; x++) {
+			if (owner[x] < 0)
+				row[x] = chars[x];
+		}
+	}
+}
+
+
+/**
+ * Initialize a custom character allocator. All slots are considered to
+ * hold unknown patterns.
+ * \param cca         Allocator to initialize (usually part of the private data).
+ * \param first       Number of the first custom character.
+ * \param num_slots   Number of custom characters to manage.
+ * \param cellheight  Number of pixel rows per character.
+ */
+void
+lib_cc_init (CCAllocator *cca, int first, int num_slots, int cellheight)
+{
+	memset(cca, 0, sizeof(CCAllocator));
+	cca->first = first;
+	cca->num_slots = (num_slots < CC_MAX_SLOTS) ? num_slots : CC_MAX_SLOTS;
+	cca->cellheight = (cellheight < CC_MAX_HEIGHT) ? cellheight : CC_MAX_HEIGHT;
+	cca->frame = 1;
+}
+
+
+/**
+ * Start a new frame. Drivers call this from their clear() function: the
+ * characters of the previous frame are gone, so their slots may be reused.
+ * \param cca  Allocator.
+ */
+void
+lib_cc_frame (CCAllocator *cca)
+{
+	cca->frame++;
+}
+
+
+/**
+ * Get a custom character showing the glyph. The glyph is only uploaded
+ * with set_char() if no slot holds it already.
+ * \param drvthis  Pointer to driver structure.
+ * \param cca      Allocator.
+ * \param glyph    Pattern of cellheight rows, as for set_char().
+ * \return         Character code to write; -1 if all slots are in use by this frame.
+ */
+int
+lib_cc_get (Driver *drvthis, CCAllocator *cca, unsigned char *glyph)
+{
+	int lru = -1;
+	int i;
+
+	for (i = 0; i < cca->num_slots; i++) {
+		CCSlot *slot = &cca->slot[i];
+
+		if (slot->valid && (memcmp(slot->glyph, glyph, cca->cellheight) == 0)) {
+			slot->last_used = cca->frame;
+			return cca->first + i;
+		}
+		if (slot->last_used == cca->frame)
+			continue;
+		/* Prefer empty slots, then the least recently used one */
+		if ((lru < 0) || (cca->slot[lru].valid && (!slot->valid
+				|| (slot->last_used < cca->slot[lru].last_used))))
+			lru = i;
+	}
+	if (lru < 0)
+		return -1;
+
+	memcpy(cca->slot[lru].glyph, glyph, cca->cellheight);
+	cca->slot[lru].valid = 1;
+	cca->slot[lru].last_used = cca->frame;
+	cca->claimed = 0;
+	drvthis->set_char(drvthis, cca->first + lru, glyph);
+
+	return cca->first + lru;
+}
+
+
+/**
+ * Claim all slots for the rest of the frame, for big numbers which use
+ * a fixed set of custom characters.
+ * \param cca  Allocator.
+ * \retval  1  The caller has to load its characters.
+ * \retval  0  The characters of the previous claim are still loaded.
+ * \retval -1  Some slots are in use by this frame already.
+ */
+int
+lib_cc_claim_all (CCAllocator *cca)
+{
+	int was_claimed = cca->claimed;
+	int i;
+
+	for (i = 0; i < cca->num_slots; i++) {
+		if ((cca->slot[i].last_used == cca->frame) && !was_claimed)
+			return -1;
+	}
+	for (i = 0; i < cca->num_slots; i++) {
+		cca->slot[i].valid = 0;
+		cca->slot[i].last_used = cca->frame;
+	}
+	cca->claimed = 1;
+
+	return (was_claimed) ? 0 : 1;
+}
+
+
+/**
+ * Place a hbar like lib_hbar_static(), but take the characters for the
+ * partial blocks from a custom character allocator. Only the glyphs that
+ * are on screen occupy slots, so bars can be mixed with icons.
+ * \param drvthis    Pointer to driver structure.
+ * \param cca        Allocator.
+ * \param x          Horizontal character position (column) of the starting point.
+ * \param y          Vertical character position (row) of the starting point.
+ * \param len        Number of characters that the bar is long at 100%
+ * \param promille   Current length level of the bar in promille.
+ * \param options    Options (BAR_SEAMLESS: use custom characters for full blocks).
+ * \param cellwidth  Width of a character in pixels.
+ * \param barheight  Number of pixel rows the bar fills, from the top.
+ */
+void
+lib_hbar_cc (Driver *drvthis, CCAllocator *cca, int x, int y, int len, int promille, int options, int cellwidth, int barheight)
+{
+	int total_pixels  = ((long) 2 * len * cellwidth + 1 ) * promille / 2000;
+	int pos;
+
+	for (pos = 0; pos < len; pos ++ ) {
+
+		int pixels = total_pixels - cellwidth * pos;
+
+		if ( pixels >= cellwidth && !( options & BAR_SEAMLESS ) ) {
+			/* write a "full" block to the screen... */
+			drvthis->icon (drvthis, x+pos, y, ICON_BLOCK_FILLED);
+		}
+		else if ( pixels > 0 ) {
+			/* write a (partial) block... */
+			unsigned char glyph[CC_MAX_HEIGHT];
+			int n = ( pixels < cellwidth ) ? pixels : cellwidth;
+			int c;
+
+			memset(glyph, 0, sizeof(glyph));
+			memset(glyph, 0xFF & ~((1 << (cellwidth - n)) - 1),
+				( barheight < cca->cellheight ) ? barheight : cca->cellheight);
+			c = lib_cc_get(drvthis, cca, glyph);
+			if ( c >= 0 )
+				drvthis->chr (drvthis, x+pos, y, c);
+			if ( pixels < cellwidth )
+				break;
+		}
+		else {
+			; /* write nothing (not even a space) */
+		}
+	}
+}
+
+
+/**
+ * Place a vbar like lib_vbar_static(), but take the characters for the
+ * partial blocks from a custom character allocator.
+ * \param drvthis     Pointer to driver structure.
+ * \param cca         Allocator.
+ * \param x           Horizontal character position (column) of the starting point.
+ * \param y           Vertical character position (row) of the starting point.
+ * \param len         Number of characters that the bar is high at 100%
+ * \param promille    Current height level of the bar in promille.
+ * \param options     Options (currently unused).
+ * \param cellheight  Height of a character in pixels.
+ * \param rowmask     Pixels set in each row of a partial block.
+ */
+void
+lib_vbar_cc (Driver *drvthis, CCAllocator *cca, int x, int y, int len, int promille, int options, int cellheight, unsigned char rowmask)
+{
+	int total_pixels = ((long) 2 * len * cellheight + 1 ) * promille / 2000;
+	int pos;
+
+	for (pos = 0; pos < len; pos ++ ) {
+
+		int pixels = total_pixels - cellheight * pos;
+
+		if ( pixels >= cellheight ) {
+			/* write a "full" block to the screen... */
+			drvthis->icon (drvthis, x, y-pos, ICON_BLOCK_FILLED);
+		}
+		else if ( pixels > 0 ) {
+			/* write a partial block... */
+			unsigned char glyph[CC_MAX_HEIGHT];
+			int c;
+
+			memset(glyph, 0, sizeof(glyph));
+			memset(glyph + cca->cellheight - pixels, rowmask, pixels);
+			c = lib_cc_get(drvthis, cca, glyph);
+			if ( c >= 0 )
+				drvthis->chr (drvthis, x, y-pos, c);
+			break;
+		}
+		else {
+			; /* write nothing (not even a space) */
+		}
+	}
+}
@@ -7,6 +7,43 @@
 
 void lib_hbar_static (Driver *drvthis, int x, int y, int len, int promille, int options, int cellwidth, int cc_offset);
 void lib_vbar_static (Driver *drvthis, int x, int y, int len, int promille, int options, int cellheight, int cc_offset);
+void lib_charmap_translate (unsigned char *dst, const unsigned char *src, int len, const unsigned char *charmap);
+int lib_charmap_string (unsigned char *row, int width, int x, const char *src, const unsigned char *charmap);
+void lib_draw_cells (unsigned char *framebuf, int width, int height, const CellBuffer *cells);
+
+/** Maximum number of custom characters a CCAllocator manages */
+#define CC_MAX_SLOTS	16
+/** Maximum number of pixel rows of a custom character */
+#define CC_MAX_HEIGHT	16
+
+/** One custom character slot of the display */
+typedef struct CCSlot {
+	unsigned char glyph[CC_MAX_HEIGHT];	/**< Pattern currently in the slot */
+	int valid;			/**< Pattern is known */
+	unsigned long last_used;	/**< Frame the slot was used in last */
+} CCSlot;
+
+/**
+ * Assigns the glyphs requested during a frame to the custom characters of
+ * the display. Glyphs that are already loaded are reused; otherwise the
+ * slot that has not been used for the longest time is overwritten. Slots
+ * that have been used in the current frame are never taken away.
+ */
+typedef struct CCAllocator {
+	int first;			/**< Number of the first custom character */
+	int num_slots;			/**< Number of custom characters */
+	int cellheight;			/**< Pixel rows per glyph */
+	unsigned long frame;		/**< Current frame number */
+	int claimed;			/**< All slots hold the big number glyphs */
+	CCSlot slot[CC_MAX_SLOTS];
+} CCAllocator;
+
+void lib_cc_init (CCAllocator *cca, int first, int num_slots, int cellheight);
+void lib_cc_frame (CCAllocator *cca);
+int lib_cc_get (Driver *drvthis, CCAllocator *cca, unsigned char *glyph);
+int lib_cc_claim_all (CCAllocator *cca);
+void lib_hbar_cc (Driver *drvthis, CCAllocator *cca, int x, int y, int len, int promille, int options, int cellwidth, int barheight);
+void lib_vbar_cc (Driver *drvthis, CCAllocator *cca, int x, int y, int len, int promille, int options, int cellheight, unsigned char rowmask);
 
 #endif
 
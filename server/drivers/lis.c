@@ -184,7 +184,6 @@ lis_ftdi_line_to_display(Driver *drvthis, int line, unsigned char *string, int l
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 	unsigned char buffer[128];
 	int err;
-	int i;
 
 	if (len > p->width || line < 1 || line > p->height) {
 		return -EINVAL;
@@ -193,10 +192,8 @@ lis_ftdi_line_to_display(Driver *drvthis, int line, unsigned char *string, int l
 	buffer[1] = 0;
 	buffer[2] = 0xA7;
 
-	for (i=0; i < len; i++) {
-		buffer[i+3] = UPD16314_charmap[(unsigned char)string[i]];
-	}
-	buffer[i+3] = 0x00;
+	lib_charmap_translate(buffer + 3, string, len, UPD16314_charmap);
+	buffer[len+3] = 0x00;
 
 	err = lis_ftdi_write_command(drvthis, buffer, len+4);
 	if (err < 0) {
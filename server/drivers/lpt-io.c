@@ -0,0 +1,292 @@
+/** \file server/drivers/lpt-io.c
+ * Queued access to a parallel port, either directly or through ppdev.
+ *
+ * Drivers for displays wired to the parallel port toggle the port lines
+ * one write at a time and wait in between. With direct I/O (the default)
+ * this costs an I/O instruction per write but needs root privileges. The
+ * Linux ppdev driver gives access to the port to anyone allowed to open
+ * /dev/parportN, but each write is a system call. So for ppdev the writes
+ * and pauses are queued and sent together:
+ *
+ * - A write of the value a register already has is left out.
+ * - Pauses without a write in between are waited for at once.
+ * - A pause at the end of the queue is not waited for right away; the
+ *   time that passed until the next write is subtracted from it.
+ *
+ * The mock port (device \c mock or \c mock:file) does not access any
+ * hardware. It logs the writes and pauses to the file, one per line, which
+ * allows to check what a driver sends without a display.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#ifdef HAVE_LINUX_PPDEV_H
+# include <linux/parport.h>
+# include <linux/ppdev.h>
+#endif
+
+#include "lpt-io.h"
+#include "lpt-port.h"
+
+static const char reg_names[] = "DSC";
+
+static void lpt_settle(LptIO *lpt);
+static void lpt_write(LptIO *lpt, int reg, unsigned char val);
+
+
+/**
+ * Gets access to a parallel port.
+ * \param lpt     The port.
+ * \param port    Base address of the port, for direct I/O.
+ * \param count   Number of registers used, from the base address on.
+ * \param device  ppdev device, \c mock[:file], or empty for direct I/O.
+ * \retval 0   Success.
+ * \retval -1  Error, see errno.
+ */
+int
+lpt_open(LptIO *lpt, unsigned short port, unsigned short count, const char *device)
+{
+	lpt->port = port;
+	lpt->count = count;
+	lpt->fd = -1;
+	lpt->trace = NULL;
+	lpt->reg_known = 0;
+	lpt->mock_status = 0;
+	lpt->queued = 0;
+	lpt->pending = 0;
+	timerclear(&lpt->pending_since);
+
+	if (device == NULL || device[0] == '\0') {
+		lpt->mode = LPT_DIRECT;
+		return port_access_multiple(port, count);
+	}
+
+	if (strncmp(device, "mock", 4) == 0 && (device[4] == '\0' || device[4] == ':')) {
+		lpt->mode = LPT_MOCK;
+		if (device[4] == ':' && (lpt->trace = fopen(device + 5, "w")) == NULL)
+			return -1;
+		return 0;
+	}
+
+#ifdef HAVE_LINUX_PPDEV_H
+	lpt->mode = LPT_PPDEV;
+	if ((lpt->fd = open(device, O_RDWR)) < 0)
+		return -1;
+	ioctl(lpt->fd, PPEXCL);		/* Keep the printer driver away if we can */
+	if (ioctl(lpt->fd, PPCLAIM) < 0) {
+		int e = errno;
+
+		close(lpt->fd);
+		lpt->fd = -1;
+		errno = e;
+		return -1;
+	}
+	return 0;
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+
+/**
+ * Sends what is queued and releases the port.
+ * \param lpt  The port.
+ */
+void
+lpt_close(LptIO *lpt)
+{
+	lpt_flush(lpt);
+
+	switch (lpt->mode) {
+	    case LPT_DIRECT:
+		port_deny_multiple(lpt->port, lpt->count);
+		break;
+	    case LPT_PPDEV:
+#ifdef HAVE_LINUX_PPDEV_H
+		if (lpt->fd >= 0) {
+			ioctl(lpt->fd, PPRELEASE);
+			close(lpt->fd);
+		}
+#endif
+		break;
+	    case LPT_MOCK:
+		if (lpt->trace != NULL)
+			fclose(lpt->trace);
+		break;
+	}
+	lpt->fd = -1;
+	lpt->trace = NULL;
+}
+
+
+/**
+ * Queues a write or a pause. Called by lpt_out() and lpt_pause().
+ * \param lpt    The port.
+ * \param usecs  Pause in microseconds, or -1 to write \c val to \c reg.
+ * \param reg    Register to write.
+ * \param val    Value to write.
+ */
+void
+lpt_queue(LptIO *lpt, int usecs, int reg, unsigned char val)
+{
+	LptOp *op;
+
+	if (usecs >= 0 && lpt->queued > 0 && lpt->queue[lpt->queued - 1].usecs >= 0) {
+		lpt->queue[lpt->queued - 1].usecs += usecs;
+		return;
+	}
+
+	if (lpt->queued == LPT_QUEUE_SIZE)
+		lpt_flush(lpt);
+
+	op = &lpt->queue[lpt->queued++];
+	op->usecs = usecs;
+	op->reg = reg;
+	op->val = val;
+}
+
+
+/**
+ * Reads a register after sending the queue. Called by lpt_in().
+ * \param lpt  The port.
+ * \param reg  Register to read.
+ * \return     The value read.
+ */
+int
+lpt_read(LptIO *lpt, int reg)
+{
+	unsigned char val = 0;
+
+	lpt_flush(lpt);
+	lpt_settle(lpt);
+
+	if (lpt->mode == LPT_MOCK) {
+		val = (reg == LPT_STATUS) ? lpt->mock_status : lpt->reg[reg];
+		if (lpt->trace != NULL)
+			fprintf(lpt->trace, "%c -> %02x\n", reg_names[reg], val);
+		return val;
+	}
+
+#ifdef HAVE_LINUX_PPDEV_H
+	switch (reg) {
+	    case LPT_DATA:
+		ioctl(lpt->fd, PPRDATA, &val);
+		break;
+	    case LPT_STATUS:
+		ioctl(lpt->fd, PPRSTATUS, &val);
+		break;
+	    case LPT_CONTROL:
+		ioctl(lpt->fd, PPRCONTROL, &val);
+		break;
+	}
+#endif
+	return val;
+}
+
+
+/**
+ * Sends the queued writes.
+ * \param lpt  The port.
+ */
+void
+lpt_flush(LptIO *lpt)
+{
+	int i;
+
+	for (i = 0; i < lpt->queued; i++) {
+		LptOp *op = &lpt->queue[i];
+
+		if (op->usecs >= 0) {
+			lpt->pending += op->usecs;
+			continue;
+		}
+		if ((lpt->reg_known & (1 << op->reg)) && lpt->reg[op->reg] == op->val)
+			continue;
+
+		lpt_settle(lpt);
+		lpt_write(lpt, op->reg, op->val);
+		lpt->reg[op->reg] = op->val;
+		lpt->reg_known |= 1 << op->reg;
+	}
+	lpt->queued = 0;
+
+	/* The last pause runs while the caller does other things */
+	if (lpt->pending > 0 && !timerisset(&lpt->pending_since))
+		gettimeofday(&lpt->pending_since, NULL);
+
+	if (lpt->trace != NULL)
+		fflush(lpt->trace);
+}
+
+
+/** Waits for the rest of the pending pause. */
+static void
+lpt_settle(LptIO *lpt)
+{
+	if (lpt->pending <= 0)
+		return;
+
+	if (lpt->mode == LPT_MOCK) {
+		if (lpt->trace != NULL)
+			fprintf(lpt->trace, "P %d\n", lpt->pending);
+	}
+	else {
+		if (timerisset(&lpt->pending_since)) {
+			struct timeval now, passed;
+
+			gettimeofday(&now, NULL);
+			timersub(&now, &lpt->pending_since, &passed);
+			if (passed.tv_sec > 0 || passed.tv_usec >= lpt->pending)
+				lpt->pending = 0;
+			else if (passed.tv_sec == 0)
+				lpt->pending -= passed.tv_usec;
+		}
+		if (lpt->pending > 0)
+			timing_uPause(lpt->pending);
+	}
+	lpt->pending = 0;
+	timerclear(&lpt->pending_since);
+}
+
+
+/** Writes a register right away. */
+static void
+lpt_write(LptIO *lpt, int reg, unsigned char val)
+{
+	if (lpt->mode == LPT_MOCK) {
+		if (lpt->trace != NULL)
+			fprintf(lpt->trace, "%c %02x\n", reg_names[reg], val);
+		return;
+	}
+
+#ifdef HAVE_LINUX_PPDEV_H
+	if (reg == LPT_DATA) {
+		ioctl(lpt->fd, PPWDATA, &val);
+	}
+	else if (reg == LPT_CONTROL) {
+		/* ppdev sets the data direction separately */
+		if (!(lpt->reg_known & (1 << LPT_CONTROL))
+		    || ((lpt->reg[LPT_CONTROL] ^ val) & ENBI)) {
+			int reverse = (val & ENBI) ? 1 : 0;
+
+			ioctl(lpt->fd, PPDATADIR, &reverse);
+		}
+		ioctl(lpt->fd, PPWCONTROL, &val);
+	}
+#endif
+}
@@ -0,0 +1,108 @@
+/** \file server/drivers/lpt-io.h
+ * Queued access to a parallel port, either directly or through ppdev.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifndef LPT_IO_H
+#define LPT_IO_H
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "port.h"
+#include "timing.h"
+
+/** \name Registers, as offsets from the base address
+ *@{*/
+#define LPT_DATA	0
+#define LPT_STATUS	1
+#define LPT_CONTROL	2
+/**@}*/
+
+/** Number of writes and pauses queued before they are sent */
+#define LPT_QUEUE_SIZE	1024
+
+/** How the port is accessed */
+typedef enum {
+	LPT_DIRECT,		/**< in/out instructions, needs root */
+	LPT_PPDEV,		/**< Linux ppdev device */
+	LPT_MOCK		/**< No port, writes are logged to a file */
+} LptMode;
+
+/** One queued write or pause */
+typedef struct {
+	int usecs;		/**< Pause in microseconds, or -1 for a write */
+	unsigned char reg;	/**< Register written */
+	unsigned char val;	/**< Value written */
+} LptOp;
+
+/**
+ * A parallel port. With direct I/O every write and pause is carried out
+ * immediately. With ppdev they are queued and sent by lpt_flush(), which
+ * skips writes that don't change a register and combines the pauses in
+ * between; a pause at the end of the queue is only waited for when the
+ * next write is due. Reading a register sends the queue first.
+ */
+typedef struct lpt_io {
+	LptMode mode;
+	unsigned short port;	/**< Base address for direct I/O */
+	unsigned short count;	/**< Number of registers used */
+	int fd;			/**< ppdev device */
+	FILE *trace;		/**< Log of the mock port */
+
+	unsigned char reg[3];	/**< Last value written to each register */
+	int reg_known;		/**< Bit per register: value in reg is valid */
+	unsigned char mock_status;	/**< Status the mock port reads */
+
+	LptOp queue[LPT_QUEUE_SIZE];
+	int queued;
+
+	int pending;		/**< Pause not yet waited for */
+	struct timeval pending_since;	/**< When it started, if the queue was sent since */
+} LptIO;
+
+int lpt_open(LptIO *lpt, unsigned short port, unsigned short count, const char *device);
+void lpt_close(LptIO *lpt);
+void lpt_flush(LptIO *lpt);
+void lpt_queue(LptIO *lpt, int usecs, int reg, unsigned char val);
+int lpt_read(LptIO *lpt, int reg);
+
+/*
+ * Direct I/O stays inline, so it costs no more than port_out() and
+ * timing_uPause() themselves.
+ */
+
+/** Writes a register. */
+static inline void
+lpt_out(LptIO *lpt, int reg, unsigned char val)
+{
+	if (lpt->mode == LPT_DIRECT)
+		port_out(lpt->port + reg, val);
+	else
+		lpt_queue(lpt, -1, reg, val);
+}
+
+/** Reads a register, after the queued writes are sent. */
+static inline int
+lpt_in(LptIO *lpt, int reg)
+{
+	if (lpt->mode == LPT_DIRECT)
+		return port_in(lpt->port + reg);
+	return lpt_read(lpt, reg);
+}
+
+/** Pauses before the next write or read. */
+static inline void
+lpt_pause(LptIO *lpt, int usecs)
+{
+	if (lpt->mode == LPT_DIRECT)
+		timing_uPause(usecs);
+	else if (usecs > 0)
+		lpt_queue(lpt, usecs, 0, 0);
+}
+
+#endif
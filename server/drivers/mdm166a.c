@@ -30,6 +30,7 @@
 #include "lcd.h"
 #include "mdm166a.h"
 #include "glcd_font5x8.h"
+#include "pixfmt.h"
 #include "shared/report.h"
 
 /*
@@ -364,26 +365,22 @@ mdm166a_flush(Driver *drvthis)
 	int const PATH_OUT[1] = {0xff7f0004};
 	char Cmd[64];
 	int packed_begin = MDM166A_SCREENSIZE;
-	int xpos = 0, ypos = 0, i, j;
+	int i, j;
 
 	if (!p->changed)
 		return;
 
-	/* First clear the packed framebuffer area */
-	memset(p->framebuf + packed_begin, 0, MDM166A_PACKEDSIZE);
-
 	/*
 	 * Convert framebuffer by packing pixel values from each column into
-	 * 2 adjacent bytes (= 16 bit) of the packed part of the framebuffer.
+	 * 2 adjacent bytes (= 16 bit) of the packed part of the framebuffer,
+	 * top pixel in the most significant bit.
 	 */
 	/* FIXME: Using the same memory area for framebuffer and packed
 	 * framebuffer is hard to read. Better if two memory areas would be
 	 * used.
 	 */
-	for (xpos = 0; xpos < MDM166A_XSIZE; xpos++)
-		for (ypos = 0; ypos < MDM166A_YSIZE; ypos++)
-			if (p->framebuf[ypos * MDM166A_XSIZE + xpos])
-				p->framebuf[packed_begin + (2 * xpos) + (ypos / 8)] |= (1 << (7 - (ypos % 8)));
+	pixfmt_bytes_to_vpage(p->framebuf + packed_begin, 1, 2, p->framebuf,
+			      MDM166A_XSIZE, MDM166A_YSIZE, 0);
 
 	/* Write data to display */
 	/* Set position (0,0) */
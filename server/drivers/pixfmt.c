@@ -0,0 +1,201 @@
+/** \file server/drivers/pixfmt.c
+ * Conversion between the pixel formats of graphic displays. Drivers keep
+ * their frame buffer in whatever format is easiest to draw into and use
+ * these functions to convert it to the format of the display when it is
+ * sent. The formats are described in pixfmt.h.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#include "pixfmt.h"
+
+/** Number of pixels of a row pixfmt_bytes_to_vpage() packs at a time */
+#define CHUNK_WIDTH	128
+
+
+/**
+ * Transpose an 8x8 block of pixels. The 8 source bytes are rows in linear
+ * format, the 8 destination bytes are columns with the top pixel in bit 7.
+ * The block is transposed in a 64 bit word by swapping 1x1, 2x2 and 4x4
+ * sub-blocks across the diagonal.
+ * \param dst         First column.
+ * \param dst_stride  Distance between columns in bytes.
+ * \param src         First row.
+ * \param src_stride  Distance between rows in bytes; may be negative.
+ */
+void
+pixfmt_transpose8(unsigned char *dst, int dst_stride, const unsigned char *src, int src_stride)
+{
+	uint64_t x = 0, t;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		x = (x << 8) | src[i * src_stride];
+
+	t = (x ^ (x >> 7)) & UINT64_C(0x00AA00AA00AA00AA);
+	x = x ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & UINT64_C(0x0000CCCC0000CCCC);
+	x = x ^ t ^ (t << 14);
+	t = (x ^ (x >> 28)) & UINT64_C(0x00000000F0F0F0F0);
+	x = x ^ t ^ (t << 28);
+
+	for (i = 0; i < 8; i++)
+		dst[i * dst_stride] = (unsigned char) (x >> (56 - 8 * i));
+}
+
+
+/**
+ * Pack a row of pixels from byte per pixel to linear format, one pixel at a
+ * time. This is the reference for pixfmt_pack_row(), which uses it for the
+ * pixels its SIMD path leaves.
+ * \param dst    Output, (width + 7) / 8 bytes.
+ * \param src    Input, width bytes.
+ * \param width  Number of pixels.
+ */
+void
+pixfmt_pack_row_scalar(unsigned char *dst, const unsigned char *src, int width)
+{
+	int i, k;
+
+	for (i = 0; i < width; i += 8) {
+		int n = (width - i < 8) ? width - i : 8;
+		unsigned char b = 0;
+
+		for (k = 0; k < n; k++)
+			b = (b << 1) | (src[i + k] != 0);
+		dst[i / 8] = b << (8 - n);
+	}
+}
+
+
+/**
+ * Pack a row of pixels from byte per pixel to linear format. If width is
+ * not a multiple of 8 the unused bits of the last byte are cleared.
+ * \param dst    Output, (width + 7) / 8 bytes.
+ * \param src    Input, width bytes.
+ * \param width  Number of pixels.
+ */
+void
+pixfmt_pack_row(unsigned char *dst, const unsigned char *src, int width)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 16 <= width; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+		unsigned int m;
+
+		/*
+		 * Reverse the bytes of each half, so that the mask puts the
+		 * leftmost pixel into the most significant bit.
+		 */
+		v = _mm_shufflelo_epi16(v, 0x1B);
+		v = _mm_shufflehi_epi16(v, 0x1B);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		m = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) & 0xFFFF;
+
+		dst[i / 8] = m & 0xFF;
+		dst[i / 8 + 1] = m >> 8;
+	}
+#endif
+
+	if (i < width)
+		pixfmt_pack_row_scalar(dst + i / 8, src + i, width - i);
+}
+
+
+/**
+ * Convert pixels from linear to vpage format. Rows below the last page
+ * that are not part of the image are cleared.
+ * \param dst             Output.
+ * \param page_stride     Distance between pages in the output.
+ * \param col_stride      Distance between columns in the output.
+ * \param src             Input.
+ * \param bytes_per_line  Distance between rows of the input.
+ * \param width           Number of pixels per row.
+ * \param height          Number of rows.
+ * \param lsb_top         Bit 0 is the top pixel of a page, not bit 7.
+ */
+void
+pixfmt_linear_to_vpage(unsigned char *dst, int page_stride, int col_stride,
+		       const unsigned char *src, int bytes_per_line,
+		       int width, int height, int lsb_top)
+{
+	int page, bx, r, c;
+
+	for (page = 0; page * 8 < height; page++) {
+		const unsigned char *rows = src + page * 8 * bytes_per_line;
+		int nrows = (height - page * 8 < 8) ? height - page * 8 : 8;
+		unsigned char *out = dst + page * page_stride;
+
+		for (bx = 0; bx * 8 < width; bx++) {
+			unsigned char block[8];
+			unsigned char cols[8];
+			int ncols = (width - bx * 8 < 8) ? width - bx * 8 : 8;
+
+			/* the bottom row comes first if it ends up in bit 7 */
+			for (r = 0; r < 8; r++)
+				block[lsb_top ? 7 - r : r] = (r < nrows) ? rows[r * bytes_per_line + bx] : 0;
+
+			if (ncols == 8) {
+				pixfmt_transpose8(out + bx * 8 * col_stride, col_stride, block, 1);
+				continue;
+			}
+			pixfmt_transpose8(cols, 1, block, 1);
+			for (c = 0; c < ncols; c++)
+				out[(bx * 8 + c) * col_stride] = cols[c];
+		}
+	}
+}
+
+
+/**
+ * Convert pixels from byte per pixel to vpage format. The rows of a page
+ * are packed to linear format a chunk at a time and then transposed.
+ * \param dst          Output.
+ * \param page_stride  Distance between pages in the output.
+ * \param col_stride   Distance between columns in the output.
+ * \param src          Input, width bytes per row.
+ * \param width        Number of pixels per row.
+ * \param height       Number of rows.
+ * \param lsb_top      Bit 0 is the top pixel of a page, not bit 7.
+ */
+void
+pixfmt_bytes_to_vpage(unsigned char *dst, int page_stride, int col_stride,
+		      const unsigned char *src, int width, int height, int lsb_top)
+{
+	unsigned char linear[8 * (CHUNK_WIDTH / 8)];
+	int page, x, r;
+
+	for (page = 0; page * 8 < height; page++) {
+		int nrows = (height - page * 8 < 8) ? height - page * 8 : 8;
+
+		for (x = 0; x < width; x += CHUNK_WIDTH) {
+			int n = (width - x < CHUNK_WIDTH) ? width - x : CHUNK_WIDTH;
+
+			for (r = 0; r < nrows; r++)
+				pixfmt_pack_row(linear + r * (CHUNK_WIDTH / 8),
+						src + (page * 8 + r) * width + x, n);
+
+			pixfmt_linear_to_vpage(dst + page * page_stride + x * col_stride,
+					       page_stride, col_stride,
+					       linear, CHUNK_WIDTH / 8, n, nrows, lsb_top);
+		}
+	}
+}
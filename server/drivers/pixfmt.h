@@ -0,0 +1,40 @@
+/** \file server/drivers/pixfmt.h
+ * Conversion between the pixel formats of graphic displays.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifndef PIXFMT_H
+#define PIXFMT_H
+
+/*
+ * Formats:
+ *
+ * byte per pixel:  one byte per pixel, row by row; any non-zero byte is set.
+ * linear:          one bit per pixel, row by row; the most significant bit
+ *                  of a byte is the leftmost of its 8 pixels.
+ * vpage:           one bit per pixel, 8 rows (a page) at a time; a byte holds
+ *                  the 8 pixels of one column of a page. With lsb_top bit 0
+ *                  is the top pixel (KS0108, SED1520 and most other
+ *                  controllers), otherwise bit 7 is.
+ *
+ * The output of a vpage conversion is addressed by two strides: the byte of
+ * column x of page n is at dst[n * page_stride + x * col_stride]. Displays
+ * that expect one page after the other use page_stride = width and
+ * col_stride = 1; displays that expect all pages of a column before the
+ * next column use page_stride = 1 and col_stride = number of pages.
+ */
+
+void pixfmt_transpose8(unsigned char *dst, int dst_stride, const unsigned char *src, int src_stride);
+void pixfmt_pack_row(unsigned char *dst, const unsigned char *src, int width);
+void pixfmt_pack_row_scalar(unsigned char *dst, const unsigned char *src, int width);
+void pixfmt_linear_to_vpage(unsigned char *dst, int page_stride, int col_stride,
+			    const unsigned char *src, int bytes_per_line,
+			    int width, int height, int lsb_top);
+void pixfmt_bytes_to_vpage(unsigned char *dst, int page_stride, int col_stride,
+			   const unsigned char *src, int width, int height, int lsb_top);
+
+#endif
@@ -0,0 +1,619 @@
+/** \file server/drivers/record.c
+ * LCDd \c record driver.
+ * It writes every frame that differs from the previous one to a file,
+ * together with the time it was shown. Only the changed cells, the cursor,
+ * the backlight state and new custom characters are stored, so recordings
+ * of long sessions stay small. The format is described in shared/lcdrec.h;
+ * \c lcdreplay dumps and compares recordings.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include "lcd.h"
+#include "lcd_lib.h"
+#include "record.h"
+#include "shared/report.h"
+#include "shared/lcdrec.h"
+
+/** Unchanged cells up to this number are written instead of starting a new run */
+#define RECORD_MAX_GAP	2
+
+
+/** private data for the \c record driver */
+typedef struct record_private_data {
+	int width;		/**< display width in characters */
+	int height;		/**< display height in characters */
+	int cellwidth;		/**< character cell width */
+	int cellheight;		/**< character cell height */
+	unsigned char *framebuf;	/**< frame being drawn */
+	unsigned char *lastframe;	/**< frame last written to the file */
+
+	int cursor_x, cursor_y, cursor_state;
+	int last_cursor_x, last_cursor_y, last_cursor_state;
+	int backlight;		/**< current backlight state */
+	int last_backlight;	/**< backlight state in the file, -1 if none */
+	unsigned char cc[LCDREC_NUM_CCS][LCD_DEFAULT_CELLHEIGHT];	/**< custom characters */
+	unsigned int cc_changed;	/**< bitmask of custom characters not written yet */
+	CCAllocator cca;	/**< custom character allocation for bars */
+
+	FILE *file;		/**< the recording */
+	char *filename;		/**< name of the recording */
+	unsigned char *out;	/**< encoding buffer for one frame */
+	struct timeval last_time;	/**< time of the last frame written */
+	unsigned long frames;	/**< number of frames written */
+} PrivateData;
+
+
+/* Vars for the server core */
+MODULE_EXPORT char *api_version = API_VERSION;
+MODULE_EXPORT int stay_in_foreground = 0;
+MODULE_EXPORT int supports_multiple = 1;
+MODULE_EXPORT char *symbol_prefix = "record_";
+
+
+/**
+ * Append a varint to the buffer.
+ * \param out    Write position.
+ * \param value  Number to store.
+ * \return       New write position.
+ */
+static unsigned char *
+put_varint(unsigned char *out, unsigned long value)
+{
+	while (value >= 0x80) {
+		*out++ = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	*out++ = value;
+	return out;
+}
+
+
+/**
+ * Initialize the driver.
+ * \param drvthis  Pointer to driver structure.
+ * \retval 0       Success.
+ * \retval <0      Error.
+ */
+MODULE_EXPORT int
+record_init (Driver *drvthis)
+{
+	PrivateData *p;
+	char buf[256];
+	const char *s;
+	unsigned char header[LCDREC_HEADER_SIZE];
+	int append;
+
+	/* Allocate and store private data */
+	p = (PrivateData *) calloc(1, sizeof(PrivateData));
+	if (p == NULL)
+		return -1;
+	if (drvthis->store_private_ptr(drvthis, p))
+		return -1;
+
+	/* initialize private data */
+	p->cellwidth = LCD_DEFAULT_CELLWIDTH;
+	p->cellheight = LCD_DEFAULT_CELLHEIGHT;
+	p->last_cursor_state = CURSOR_OFF;
+	p->cursor_state = CURSOR_OFF;
+	p->last_backlight = -1;
+	lib_cc_init(&p->cca, 0, LCDREC_NUM_CCS, p->cellheight);
+
+	// Set display sizes
+	if ((drvthis->request_display_width() > 0)
+	    && (drvthis->request_display_height() > 0)) {
+		// Use size from primary driver
+		p->width = drvthis->request_display_width();
+		p->height = drvthis->request_display_height();
+	}
+	else {
+		/* Use our own size from config file */
+		strncpy(buf, drvthis->config_get_string(drvthis->name, "Size", 0, RECORD_DEFAULT_SIZE), sizeof(buf));
+		buf[sizeof(buf)-1] = '\0';
+		if ((sscanf(buf , "%dx%d", &p->width, &p->height) != 2)
+		    || (p->width <= 0) || (p->width > LCD_MAX_WIDTH)
+		    || (p->height <= 0) || (p->height > LCD_MAX_HEIGHT)) {
+			report(RPT_WARNING, "%s: cannot read Size: %s; using default %s",
+					drvthis->name, buf, RECORD_DEFAULT_SIZE);
+			sscanf(RECORD_DEFAULT_SIZE, "%dx%d", &p->width, &p->height);
+		}
+	}
+
+	// Allocate the frame buffers; a frame never needs 4 bytes per cell
+	p->framebuf = malloc(p->width * p->height);
+	p->lastframe = malloc(p->width * p->height);
+	p->out = malloc(4 * p->width * p->height + 256);
+	if ((p->framebuf == NULL) || (p->lastframe == NULL) || (p->out == NULL)) {
+		report(RPT_ERR, "%s: unable to create framebuffer", drvthis->name);
+		return -1;
+	}
+	memset(p->framebuf, ' ', p->width * p->height);
+	memset(p->lastframe, ' ', p->width * p->height);
+
+	/* Open the recording */
+	s = drvthis->config_get_string(drvthis->name, "Output", 0, NULL);
+	if (s == NULL) {
+		report(RPT_ERR, "%s: no Output file given", drvthis->name);
+		return -1;
+	}
+	p->filename = strdup(s);
+	append = drvthis->config_get_bool(drvthis->name, "Append", 0, 0);
+
+	p->file = fopen(p->filename, (append) ? "ab" : "wb");
+	if (p->file == NULL) {
+		report(RPT_ERR, "%s: cannot open %s: %s", drvthis->name, p->filename, strerror(errno));
+		return -1;
+	}
+
+	memcpy(header, LCDREC_MAGIC, LCDREC_MAGIC_LEN);
+	header[LCDREC_MAGIC_LEN] = LCDREC_VERSION;
+	header[LCDREC_MAGIC_LEN + 1] = p->width & 0xFF;
+	header[LCDREC_MAGIC_LEN + 2] = p->height & 0xFF;
+	header[LCDREC_MAGIC_LEN + 3] = p->cellwidth;
+	header[LCDREC_MAGIC_LEN + 4] = p->cellheight;
+	if ((fwrite(header, sizeof(header), 1, p->file) != 1) || (fflush(p->file) != 0)) {
+		report(RPT_ERR, "%s: cannot write to %s: %s", drvthis->name, p->filename, strerror(errno));
+		return -1;
+	}
+	gettimeofday(&p->last_time, NULL);
+
+	report(RPT_INFO, "%s: recording to %s", drvthis->name, p->filename);
+	report(RPT_DEBUG, "%s: init() done", drvthis->name);
+
+	return 0;
+}
+
+
+/**
+ * Close the driver (do necessary clean-up).
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+record_close (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if (p != NULL) {
+		if (p->file != NULL) {
+			fclose(p->file);
+			report(RPT_INFO, "%s: %lu frames recorded", drvthis->name, p->frames);
+		}
+		if (p->filename != NULL)
+			free(p->filename);
+		if (p->framebuf != NULL)
+			free(p->framebuf);
+		if (p->lastframe != NULL)
+			free(p->lastframe);
+		if (p->out != NULL)
+			free(p->out);
+
+		free(p);
+	}
+	drvthis->store_private_ptr(drvthis, NULL);
+}
+
+
+/**
+ * Return the display width in characters.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of characters the display is wide.
+ */
+MODULE_EXPORT int
+record_width (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->width;
+}
+
+
+/**
+ * Return the display height in characters.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of characters the display is high.
+ */
+MODULE_EXPORT int
+record_height (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->height;
+}
+
+
+/**
+ * Return the width of a character in pixels.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of pixel columns a character cell is wide.
+ */
+MODULE_EXPORT int
+record_cellwidth (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->cellwidth;
+}
+
+
+/**
+ * Return the height of a character in pixels.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of pixel lines a character cell is high.
+ */
+MODULE_EXPORT int
+record_cellheight (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->cellheight;
+}
+
+
+/**
+ * Clear the screen.
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+record_clear (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	memset(p->framebuf, ' ', p->width * p->height);
+	p->cursor_state = CURSOR_OFF;
+	lib_cc_frame(&p->cca);
+}
+
+
+/**
+ * Write the differences to the previous frame to the recording.
+ * Nothing is written if the frame did not change.
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+record_flush (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+	unsigned char *out = p->out;
+	unsigned char *flags;
+	unsigned char *runs_start;
+	unsigned char runs_buf[4];
+	int size = p->width * p->height;
+	int runs = 0;
+	int pos, end, prev_end;
+	struct timeval now;
+	long delay;
+	int i;
+
+	if (p->file == NULL)
+		return;
+
+	/* Leave room for the type, the delay and the flags: the delay is only
+	 * known once we decide to write the frame. Its varint needs at most
+	 * 5 bytes for 32 bit values. */
+	out += 8;
+	flags = out++;
+	*flags = 0;
+
+	/* Changed cells as runs; short gaps are included in a run */
+	runs_start = out;
+	prev_end = 0;
+	for (pos = 0; pos < size; pos = end) {
+		if (p->framebuf[pos] == p->lastframe[pos]) {
+			end = pos + 1;
+			continue;
+		}
+		end = pos + 1;
+		for (i = end; (i < size) && (i - end <= RECORD_MAX_GAP); i++) {
+			if (p->framebuf[i] != p->lastframe[i])
+				end = i + 1;
+		}
+		out = put_varint(out, pos - prev_end);
+		out = put_varint(out, end - pos);
+		memcpy(out, p->framebuf + pos, end - pos);
+		out += end - pos;
+		prev_end = end;
+		runs++;
+	}
+	if (runs > 0) {
+		/* Prepend the number of runs */
+		int n = put_varint(runs_buf, runs) - runs_buf;
+
+		memmove(runs_start + n, runs_start, out - runs_start);
+		memcpy(runs_start, runs_buf, n);
+		out += n;
+		*flags |= LCDREC_F_CHARS;
+		memcpy(p->lastframe, p->framebuf, size);
+	}
+
+	if ((p->cursor_state != p->last_cursor_state)
+	    || ((p->cursor_state != CURSOR_OFF)
+		&& ((p->cursor_x != p->last_cursor_x) || (p->cursor_y != p->last_cursor_y)))) {
+		out = put_varint(out, p->cursor_x);
+		out = put_varint(out, p->cursor_y);
+		*out++ = p->cursor_state;
+		p->last_cursor_x = p->cursor_x;
+		p->last_cursor_y = p->cursor_y;
+		p->last_cursor_state = p->cursor_state;
+		*flags |= LCDREC_F_CURSOR;
+	}
+
+	if (p->backlight != p->last_backlight) {
+		*out++ = p->backlight;
+		p->last_backlight = p->backlight;
+		*flags |= LCDREC_F_BACKLIGHT;
+	}
+
+	if (p->cc_changed != 0) {
+		unsigned char *count = out++;
+
+		*count = 0;
+		for (i = 0; i < LCDREC_NUM_CCS; i++) {
+			if (p->cc_changed & (1 << i)) {
+				*out++ = i;
+				memcpy(out, p->cc[i], p->cellheight);
+				out += p->cellheight;
+				(*count)++;
+			}
+		}
+		p->cc_changed = 0;
+		*flags |= LCDREC_F_CUSTOM;
+	}
+
+	if (*flags == 0)
+		return;
+
+	/* Now fill in the header right in front of the flags */
+	gettimeofday(&now, NULL);
+	delay = (now.tv_sec - p->last_time.tv_sec) * 1000
+		+ (now.tv_usec - p->last_time.tv_usec) / 1000;
+	if (delay < 0)
+		delay = 0;
+	p->last_time = now;
+
+	{
+		unsigned char head[8];
+		int n;
+
+		head[0] = LCDREC_FRAME;
+		n = put_varint(head + 1, delay) - head;
+		memcpy(flags - n, head, n);
+
+		if ((fwrite(flags - n, out - (flags - n), 1, p->file) != 1)
+		    || (fflush(p->file) != 0)) {
+			report(RPT_ERR, "%s: cannot write to %s: %s; recording stopped",
+			       drvthis->name, p->filename, strerror(errno));
+			fclose(p->file);
+			p->file = NULL;
+			return;
+		}
+	}
+	p->frames++;
+}
+
+
+/**
+ * Print a string on the screen at position (x,y).
+ * The upper-left corner is (1,1), the lower-right corner is (p->width, p->height).
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param string   String that gets written.
+ */
+MODULE_EXPORT void
+record_string (Driver *drvthis, int x, int y, const char string[])
+{
+	PrivateData *p = drvthis->private_data;
+	int i;
+
+	x--; y--; // Convert 1-based coords to 0-based...
+
+	if ((y < 0) || (y >= p->height))
+		return;
+
+	for (i = 0; (string[i] != '\0') && (x < p->width); i++, x++) {
+		if (x >= 0)	// no write left of left border
+			p->framebuf[(y * p->width) + x] = string[i];
+	}
+}
+
+
+/**
+ * Write the character cells of a composed screen.
+ * \param drvthis  Pointer to driver structure.
+ * \param cells    The composed screen.
+ */
+MODULE_EXPORT void
+record_draw_cells (Driver *drvthis, const CellBuffer *cells)
+{
+	PrivateData *p = drvthis->private_data;
+
+	lib_draw_cells(p->framebuf, p->width, p->height, cells);
+}
+
+
+/**
+ * Print a character on the screen at position (x,y).
+ * The upper-left corner is (1,1), the lower-right corner is (p->width, p->height).
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param c        Character that gets written.
+ */
+MODULE_EXPORT void
+record_chr (Driver *drvthis, int x, int y, char c)
+{
+	PrivateData *p = drvthis->private_data;
+
+	y--; x--;
+
+	if ((x >= 0) && (y >= 0) && (x < p->width) && (y < p->height))
+		p->framebuf[(y * p->width) + x] = c;
+}
+
+
+/**
+ * Draw a vertical bar bottom-up.
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column) of the starting point.
+ * \param y        Vertical character position (row) of the starting point.
+ * \param len      Number of characters that the bar is high at 100%
+ * \param promille Current height level of the bar in promille.
+ * \param options  Options (currently unused).
+ */
+MODULE_EXPORT void
+record_vbar (Driver *drvthis, int x, int y, int len, int promille, int options)
+{
+	PrivateData *p = drvthis->private_data;
+
+	lib_vbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellheight, 0xFF);
+}
+
+
+/**
+ * Draw a horizontal bar to the right.
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column) of the starting point.
+ * \param y        Vertical character position (row) of the starting point.
+ * \param len      Number of characters that the bar is long at 100%
+ * \param promille Current length level of the bar in promille.
+ * \param options  Options (currently unused).
+ */
+MODULE_EXPORT void
+record_hbar (Driver *drvthis, int x, int y, int len, int promille, int options)
+{
+	PrivateData *p = drvthis->private_data;
+
+	lib_hbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellwidth, p->cellheight);
+}
+
+
+/**
+ * Place an icon on the screen.
+ * Only the filled block is drawn here, as a custom character; the server
+ * core draws the other icons with normal characters.
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param icon     symbolic value representing the icon.
+ * \retval 0       Icon has been successfully defined/written.
+ * \retval <0      Server core shall define/write the icon.
+ */
+MODULE_EXPORT int
+record_icon (Driver *drvthis, int x, int y, int icon)
+{
+	PrivateData *p = drvthis->private_data;
+	unsigned char block_filled[CC_MAX_HEIGHT];
+	int c;
+
+	if (icon != ICON_BLOCK_FILLED)
+		return -1;
+
+	memset(block_filled, 0, sizeof(block_filled));
+	memset(block_filled, (1 << p->cellwidth) - 1, p->cellheight);
+	c = lib_cc_get(drvthis, &p->cca, block_filled);
+	if (c < 0)
+		return -1;
+	record_chr(drvthis, x, y, c);
+	return 0;
+}
+
+
+/**
+ * Set cursor position and state.
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal cursor position (column).
+ * \param y        Vertical cursor position (row).
+ * \param state    New cursor state.
+ */
+MODULE_EXPORT void
+record_cursor (Driver *drvthis, int x, int y, int state)
+{
+	PrivateData *p = drvthis->private_data;
+
+	p->cursor_x = x;
+	p->cursor_y = y;
+	p->cursor_state = state;
+}
+
+
+/**
+ * Define a custom character.
+ * \param drvthis  Pointer to driver structure.
+ * \param n        Custom character to define [0 - (NUM_CCs-1)].
+ * \param dat      Array of 8 (=cellheight) bytes, each representing a pixel row
+ *                 starting from the top to bottom.
+ *                 The bits in each byte represent the pixels where the LSB
+ *                 (least significant bit) is the rightmost pixel in each pixel row.
+ */
+MODULE_EXPORT void
+record_set_char (Driver *drvthis, int n, unsigned char *dat)
+{
+	PrivateData *p = drvthis->private_data;
+	unsigned char mask = (1 << p->cellwidth) - 1;
+	int row;
+
+	if ((n < 0) || (n >= LCDREC_NUM_CCS) || (dat == NULL))
+		return;
+
+	for (row = 0; row < p->cellheight; row++) {
+		unsigned char letter = dat[row] & mask;
+
+		if (p->cc[n][row] != letter) {
+			p->cc[n][row] = letter;
+			p->cc_changed |= 1 << n;
+		}
+	}
+}
+
+
+/**
+ * Get total number of custom characters available.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of custom characters.
+ */
+MODULE_EXPORT int
+record_get_free_chars (Driver *drvthis)
+{
+	return LCDREC_NUM_CCS;
+}
+
+
+/**
+ * Turn the display backlight on or off.
+ * \param drvthis  Pointer to driver structure.
+ * \param on       New backlight status.
+ */
+MODULE_EXPORT void
+record_backlight (Driver *drvthis, int on)
+{
+	PrivateData *p = drvthis->private_data;
+
+	p->backlight = (on) ? 1 : 0;
+}
+
+
+/**
+ * Provide some information about this driver.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Constant string with information.
+ */
+MODULE_EXPORT const char *
+record_get_info (Driver *drvthis)
+{
+	static char *info_string = "Frame recording driver";
+
+	return info_string;
+}
@@ -0,0 +1,26 @@
+#ifndef LCD_RECORD_H
+#define LCD_RECORD_H
+
+MODULE_EXPORT int  record_init (Driver *drvthis);
+MODULE_EXPORT void record_close (Driver *drvthis);
+MODULE_EXPORT int  record_width (Driver *drvthis);
+MODULE_EXPORT int  record_height (Driver *drvthis);
+MODULE_EXPORT int  record_cellwidth (Driver *drvthis);
+MODULE_EXPORT int  record_cellheight (Driver *drvthis);
+MODULE_EXPORT void record_clear (Driver *drvthis);
+MODULE_EXPORT void record_flush (Driver *drvthis);
+MODULE_EXPORT void record_string (Driver *drvthis, int x, int y, const char string[]);
+MODULE_EXPORT void record_draw_cells (Driver *drvthis, const CellBuffer *cells);
+MODULE_EXPORT void record_chr (Driver *drvthis, int x, int y, char c);
+MODULE_EXPORT void record_vbar (Driver *drvthis, int x, int y, int len, int promille, int options);
+MODULE_EXPORT void record_hbar (Driver *drvthis, int x, int y, int len, int promille, int options);
+MODULE_EXPORT int  record_icon (Driver *drvthis, int x, int y, int icon);
+MODULE_EXPORT void record_cursor (Driver *drvthis, int x, int y, int state);
+MODULE_EXPORT void record_set_char (Driver *drvthis, int n, unsigned char *dat);
+MODULE_EXPORT int  record_get_free_chars (Driver *drvthis);
+MODULE_EXPORT void record_backlight (Driver *drvthis, int on);
+MODULE_EXPORT const char * record_get_info (Driver *drvthis);
+
+#define RECORD_DEFAULT_SIZE "20x4"
+
+#endif
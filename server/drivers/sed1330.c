@@ -73,14 +73,11 @@
 
 #include "lcd.h"
 #include "sed1330.h"
-#include "port.h"
 #include "lpt-port.h"
+#include "lpt-io.h"
 #include "shared/report.h"
 #include "timing.h"
 
-/* Use uPause from timing.h */
-#define uPause timing_uPause
-
 /* Keypad settings */
 #define KEYPAD_AUTOREPEAT_DELAY 500
 #define KEYPAD_AUTOREPEAT_FREQ 15
@@ -132,6 +129,7 @@ typedef struct sed1330_private_data {
 	int nWR;
 
 	int port;		/**< LPT port to use */
+	LptIO lpt;		/**< Access to the port */
 
 	unsigned char *framebuf_text;
 	unsigned char *lcd_contents_text;
@@ -397,7 +395,8 @@ sed1330_init(Driver * drvthis)
 
 	/* Arrange for access to port */
 	debug(RPT_DEBUG, "%s: getting port access", __FUNCTION__);
-	if (port_access_multiple(p->port, 3)) {
+	if (lpt_open(&p->lpt, p->port, 3,
+		     drvthis->config_get_string(drvthis->name, "PortDevice", 0, ""))) {
 		report(RPT_ERR, "%s: cannot get IO-permission for 0x%03X: %s",
 		       drvthis->name, p->port, strerror(errno));
 		return -1;
@@ -413,13 +412,13 @@ sed1330_init(Driver * drvthis)
 
 	/* End reset-state */
 	debug(RPT_DEBUG, "%s: initializing LCD", __FUNCTION__);
-	port_out(p->port+2, (p->nWR) ^ OUTMASK);		/* raise ^WR */
-	port_out(p->port+2, (p->nRESET | p->nWR) ^ OUTMASK);	/* lower RESET */
-	uPause(200);
-	port_out(p->port+2, (p->nWR) ^ OUTMASK);		/* raise RESET */
-	uPause(200);
-	port_out(p->port+2, (p->nRESET | p->nWR) ^ OUTMASK);	/* lower RESET */
-	uPause(4000);
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nWR) ^ OUTMASK);		/* raise ^WR */
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR) ^ OUTMASK);	/* lower RESET */
+	lpt_pause(&p->lpt, 200);
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nWR) ^ OUTMASK);		/* raise RESET */
+	lpt_pause(&p->lpt, 200);
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR) ^ OUTMASK);	/* lower RESET */
+	lpt_pause(&p->lpt, 4000);
 
 	switch (p->type) {
 	    case TYPE_G321D:
@@ -482,6 +481,7 @@ sed1330_init(Driver * drvthis)
 
 	sed1330_flush(drvthis);
 	sed1330_command(p, CMD_DISP_EN, 0, NULL);	/* And display on */
+	lpt_flush(&p->lpt);
 
 	report(RPT_DEBUG, "%s: init() done", drvthis->name);
 
@@ -500,19 +500,18 @@ void
 sed1330_command(PrivateData * p, char command, int datacount, unsigned char *data)
 {
 	int i;
-	int port = p->port;
 
-	port_out(port+2, (p->nRESET | p->nWR | p->A0) ^ OUTMASK);	/* set A0 to indicate command */
-	port_out(port, command);	/* set up command */
-	port_out(port+2, (p->nRESET | p->A0) ^ OUTMASK);		/* lower ^WR */
-	port_out(port+2, (p->nRESET | p->nWR | p->A0) ^ OUTMASK);	/* rise ^WR again */
-	port_out(port+2, (p->nRESET | p->nWR) ^ OUTMASK);		/* clear A0 to indicate data */
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR | p->A0) ^ OUTMASK);	/* set A0 to indicate command */
+	lpt_out(&p->lpt, LPT_DATA, command);	/* set up command */
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->A0) ^ OUTMASK);		/* lower ^WR */
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR | p->A0) ^ OUTMASK);	/* rise ^WR again */
+	lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR) ^ OUTMASK);		/* clear A0 to indicate data */
 
 	/* Optionally output data */
 	for (i = 0; i < datacount; i++) {
-		port_out(port, data[i]);	/* set up data */
-		port_out(port + 2, (p->nRESET) ^ OUTMASK);		/* lower ^WR */
-		port_out(port + 2, (p->nRESET | p->nWR) ^ OUTMASK);	/* rise ^WR again */
+		lpt_out(&p->lpt, LPT_DATA, data[i]);	/* set up data */
+		lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET) ^ OUTMASK);		/* lower ^WR */
+		lpt_out(&p->lpt, LPT_CONTROL, (p->nRESET | p->nWR) ^ OUTMASK);	/* rise ^WR again */
 	}
 }
 
@@ -530,6 +529,8 @@ sed1330_close(Driver * drvthis)
 	if (p != NULL) {
 		int i, j;
 
+		lpt_close(&p->lpt);
+
 		for (i = 0; i < KEYPAD_MAXX; i++) {
 			if (p->keyMapDirect[i] != NULL)
 				free(p->keyMapDirect[i]);
@@ -739,6 +740,7 @@ sed1330_flush(Driver * drvthis)
 			memcpy(p->lcd_contents_graph + start_pos, p->framebuf_graph + start_pos, len);
 		}
 	}
+	lpt_flush(&p->lpt);
 }
 
 
@@ -1048,10 +1050,10 @@ sed1330_readkeypad(PrivateData * p, unsigned int YData)
 	 * Output 8 bits. Convert the positive logic to the negative logic on
 	 * the LPT port.
 	 */
-	port_out(p->port, ~YData & 0x00FF);
+	lpt_out(&p->lpt, LPT_DATA, ~YData & 0x00FF);
 
 	/* Read inputs */
-	readval = ~port_in(p->port + 1) ^ INMASK;
+	readval = ~lpt_in(&p->lpt, LPT_STATUS) ^ INMASK;
 
 	/* And convert value back (MSB first). */
 	return (((readval & FAULT) / FAULT << 4) |		/* pin 15 */
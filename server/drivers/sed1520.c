@@ -28,11 +28,9 @@
 #include "glcd_font5x8.h"
 #include "sed1520fm.h"
 #include "shared/report.h"
-#include "port.h"
 #include "timing.h"
 #include "lpt-port.h"
-
-#define uPause timing_uPause
+#include "lpt-io.h"
 
 #ifndef DEFAULT_PORT
 # define DEFAULT_PORT	0x378
@@ -55,6 +53,7 @@
 /** private data for the \c sed1520 driver */
 typedef struct sed1520_private_data {
     unsigned short port;
+    LptIO lpt;
     int interface;
     int delayMult;
     int haveInverter;
@@ -83,40 +82,40 @@ static void
 writecommand(PrivateData *p, int value, int chip)
 {
     if (p->interface == 68) {
-	port_out(p->port + 2, 0 ^ OUTMASK);
-	port_out(p->port, value);
+	lpt_out(&p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_DATA, value);
 	/* cycle E */
-	port_out(p->port + 2, ((chip & CS1) + (chip & CS2)) ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_CONTROL, ((chip & CS1) + (chip & CS2)) ^ OUTMASK);
 	if (p->delayMult)
-	    uPause(p->delayMult);
-	port_out(p->port + 2, 0 ^ OUTMASK);
+	    lpt_pause(&p->lpt, p->delayMult);
+	lpt_out(&p->lpt, LPT_CONTROL, 0 ^ OUTMASK);
     }
     else {
-	port_out(p->port, value);
+	lpt_out(&p->lpt, LPT_DATA, value);
 	if (p->haveInverter) {
 	    /*
 	     * lower WR, rise A0 and CS1 and/or CS2 taking bit inversion of
 	     * parallel port into account. External inverter required!
 	     */
-	    port_out(p->port + 2, WR + CS1 - (chip & CS1) + (chip & CS2));
+	    lpt_out(&p->lpt, LPT_CONTROL, WR + CS1 - (chip & CS1) + (chip & CS2));
 	    /* rise WR */
-	    port_out(p->port + 2, CS1 - (chip & CS1) + (chip & CS2));
+	    lpt_out(&p->lpt, LPT_CONTROL, CS1 - (chip & CS1) + (chip & CS2));
 	    if (p->delayMult)
-		uPause(p->delayMult);
+		lpt_pause(&p->lpt, p->delayMult);
 	    /* lower WR again */
-	    port_out(p->port + 2, WR + CS1 - (chip & CS1) + (chip & CS2));
+	    lpt_out(&p->lpt, LPT_CONTROL, WR + CS1 - (chip & CS1) + (chip & CS2));
 	    if (p->delayMult)
-		uPause(p->delayMult);
+		lpt_pause(&p->lpt, p->delayMult);
 	}
 	else {			/* No inverter connected */
 	    /* Note: CS?-(chip&CS?) drive the pin low if controller is set */
-	    port_out(p->port + 2, (WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
-	    port_out(p->port + 2, (CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+	    lpt_out(&p->lpt, LPT_CONTROL, (WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+	    lpt_out(&p->lpt, LPT_CONTROL, (CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
 	    if (p->delayMult)
-		uPause(p->delayMult);
-	    port_out(p->port + 2, (WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+		lpt_pause(&p->lpt, p->delayMult);
+	    lpt_out(&p->lpt, LPT_CONTROL, (WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
 	    if (p->delayMult)
-		uPause(p->delayMult);
+		lpt_pause(&p->lpt, p->delayMult);
 	}
     }
 }
@@ -131,34 +130,34 @@ static void
 writedata(PrivateData *p, int value, int chip)
 {
     if (p->interface == 68) {
-	port_out(p->port + 2, (A0) ^ OUTMASK);
-	port_out(p->port, value);
+	lpt_out(&p->lpt, LPT_CONTROL, (A0) ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_DATA, value);
 	/* cycle E */
-	port_out(p->port + 2, (A0 + (chip & CS1) + (chip & CS2)) ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_CONTROL, (A0 + (chip & CS1) + (chip & CS2)) ^ OUTMASK);
 	if (p->delayMult)
-	    uPause(p->delayMult);
-	port_out(p->port + 2, (A0) ^ OUTMASK);
+	    lpt_pause(&p->lpt, p->delayMult);
+	lpt_out(&p->lpt, LPT_CONTROL, (A0) ^ OUTMASK);
     }
     else {
-	port_out(p->port, value);
+	lpt_out(&p->lpt, LPT_DATA, value);
 	if (p->haveInverter) {
 	    /* lower WR and A0, rise CS1 and/or CS2. See also writecommand. */
-	    port_out(p->port + 2, A0 + WR + CS1 - (chip & CS1) + (chip & CS2));
-	    port_out(p->port + 2, A0 + CS1 - (chip & CS1) + (chip & CS2));
+	    lpt_out(&p->lpt, LPT_CONTROL, A0 + WR + CS1 - (chip & CS1) + (chip & CS2));
+	    lpt_out(&p->lpt, LPT_CONTROL, A0 + CS1 - (chip & CS1) + (chip & CS2));
 	    if (p->delayMult)
-		uPause(p->delayMult);
-	    port_out(p->port + 2, A0 + WR + CS1 - (chip & CS1) + (chip & CS2));
+		lpt_pause(&p->lpt, p->delayMult);
+	    lpt_out(&p->lpt, LPT_CONTROL, A0 + WR + CS1 - (chip & CS1) + (chip & CS2));
 	    if (p->delayMult)
-		uPause(p->delayMult);
+		lpt_pause(&p->lpt, p->delayMult);
 	}
 	else {
-	    port_out(p->port + 2, (A0 + WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
-	    port_out(p->port + 2, (A0 + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+	    lpt_out(&p->lpt, LPT_CONTROL, (A0 + WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+	    lpt_out(&p->lpt, LPT_CONTROL, (A0 + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
 	    if (p->delayMult)
-		uPause(p->delayMult);
-	    port_out(p->port + 2, (A0 + WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
+		lpt_pause(&p->lpt, p->delayMult);
+	    lpt_out(&p->lpt, LPT_CONTROL, (A0 + WR + CS1 - (chip & CS1) + CS2 - (chip & CS2)) ^ OUTMASK);
 	    if (p->delayMult)
-		uPause(p->delayMult);
+		lpt_pause(&p->lpt, p->delayMult);
 	}
     }
 }
@@ -275,8 +274,10 @@ sed1520_init(Driver * drvthis)
     memset(p->framebuf, '\0', PIXELWIDTH * HEIGHT);
 
     /* Open port */
-    if (port_access_multiple(p->port, 3)) {
-	report(RPT_ERR, "%s: unable to access port 0x%03X", drvthis->name, p->port);
+    if (lpt_open(&p->lpt, p->port, 3,
+		 drvthis->config_get_string(drvthis->name, "PortDevice", 0, ""))) {
+	report(RPT_ERR, "%s: unable to access port 0x%03X: %s", drvthis->name, p->port,
+	       strerror(errno));
 	return -1;
     }
 
@@ -314,6 +315,7 @@ sed1520_init(Driver * drvthis)
     writecommand(p, DISP_ON, CS1 + CS2);
     writecommand(p, DISP_START_LINE, CS1 + CS2);
     selectpage(p, 3);
+    lpt_flush(&p->lpt);
 
     report(RPT_DEBUG, "%s: init() done", drvthis->name);
     return 0;
@@ -328,6 +330,8 @@ sed1520_close(Driver * drvthis)
     PrivateData *p = drvthis->private_data;
 
     if (p != NULL) {
+	lpt_close(&p->lpt);
+
 	if (p->framebuf != NULL)
 	    free(p->framebuf);
 
@@ -407,6 +411,7 @@ sed1520_flush(Driver * drvthis)
 	for (j = PIXELWIDTH / 2; j < PIXELWIDTH; j++)
 	    writedata(p, p->framebuf[j + (i * PIXELWIDTH)], CS2);
     }
+    lpt_flush(&p->lpt);
 }
 
 /**
@@ -35,8 +35,8 @@
 #include "lcd.h"
 #include "stv5730.h"
 #include "shared/report.h"
-#include "port.h"
 #include "timing.h"
+#include "lpt-io.h"
 
 #ifndef LPTPORT
 #define LPTPORT 0x378
@@ -82,6 +82,7 @@
 /** private data for the \c stv5730 driver */
 typedef struct stv5730_private_data {
     unsigned int port;
+    LptIO lpt;
     unsigned int charattrib;
     unsigned int flags;
     char *framebuf;
@@ -135,25 +136,22 @@ unsigned char stv5730_to_ascii[256] =
     };
 
 
-//static void stv5730_upause(int delayCalls);
-#define stv5730_upause timing_uPause
-
 /////////////////////////////////////////////////////////////////
 // This function returns true if a powered and working STV5730
 // hardware is present at p->port
 static int
-stv5730_detect (unsigned int port)
+stv5730_detect (LptIO *lpt)
 {
     int i;
 
     for (i = 0; i < 10; i++) {
-	port_out(port, STV5730_TEST_O);
-	stv5730_upause(IODELAY);
-	if ((port_in(port + 1) & STV5730_TEST_I) == 0)
+	lpt_out(lpt, LPT_DATA, STV5730_TEST_O);
+	lpt_pause(lpt, IODELAY);
+	if ((lpt_in(lpt, LPT_STATUS) & STV5730_TEST_I) == 0)
 	    return -1;
-	port_out(port, 0);
-	stv5730_upause(IODELAY);
-	if ((port_in(port + 1) & STV5730_TEST_I) != 0)
+	lpt_out(lpt, LPT_DATA, 0);
+	lpt_pause(lpt, IODELAY);
+	if ((lpt_in(lpt, LPT_STATUS) & STV5730_TEST_I) != 0)
 	    return -1;
       }
     return 0;
@@ -163,10 +161,10 @@ stv5730_detect (unsigned int port)
 // returns 0 if a valid video signal is connected to the video
 // input
 static int
-stv5730_is_mute (unsigned int port)
+stv5730_is_mute (LptIO *lpt)
 {
-    stv5730_upause(IODELAY);
-    return ((port_in(port + 1) & STV5730_MUTE) ? 0 : 1);
+    lpt_pause(lpt, IODELAY);
+    return ((lpt_in(lpt, LPT_STATUS) & STV5730_MUTE) ? 0 : 1);
 }
 
 /////////////////////////////////////////////////////////////////
@@ -175,78 +173,78 @@ stv5730_is_mute (unsigned int port)
 // 8 bit writes repeat the high byte, 0 byte writes repeat the last
 // written word
 static void
-stv5730_write16bit (unsigned int port, unsigned int flags, unsigned int value)
+stv5730_write16bit (LptIO *lpt, unsigned int flags, unsigned int value)
 {
     int i;
 
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CLK + flags);
 
     for (i = 15; i >= 0; i--) {
 	char databit = ((value & (1 << i)) != 0) ? STV5730_DATA : 0;
 
-	port_out(port, databit + STV5730_CLK + flags);
-	stv5730_upause(IODELAY);
-	port_out(port, databit + flags);
-	stv5730_upause(IODELAY);
-	port_out(port, databit + STV5730_CLK + flags);
-	stv5730_upause(IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + STV5730_CLK + flags);
+	lpt_pause(lpt, IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + flags);
+	lpt_pause(lpt, IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + STV5730_CLK + flags);
+	lpt_pause(lpt, IODELAY);
     }
 
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
-    stv5730_upause(IODELAY);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
 }
 
 static void
-stv5730_write8bit (unsigned int port, unsigned int flags, unsigned int value)
+stv5730_write8bit (LptIO *lpt, unsigned int flags, unsigned int value)
 {
     int i;
 
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CLK + flags);
 
     for (i = 7; i >= 0; i--) {
 	char databit = ((value & (1 << i)) != 0) ? STV5730_DATA : 0;
 
-	port_out(port, databit + STV5730_CLK + flags);
-	stv5730_upause(IODELAY);
-	port_out(port, databit + flags);
-	stv5730_upause(IODELAY);
-	port_out(port, databit + STV5730_CLK + flags);
-	stv5730_upause(IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + STV5730_CLK + flags);
+	lpt_pause(lpt, IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + flags);
+	lpt_pause(lpt, IODELAY);
+	lpt_out(lpt, LPT_DATA, databit + STV5730_CLK + flags);
+	lpt_pause(lpt, IODELAY);
     }
 
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
 }
 
 static void
-stv5730_write0bit (unsigned int port, unsigned int flags)
+stv5730_write0bit (LptIO *lpt, unsigned int flags)
 {
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CLK + flags);
-
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + STV5730_CLK + flags);
-    stv5730_upause(IODELAY);
-    port_out(port, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CLK + flags);
+
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + STV5730_CLK + flags);
+    lpt_pause(lpt, IODELAY);
+    lpt_out(lpt, LPT_DATA, STV5730_CSN + flags);
 }
 
 
@@ -254,12 +252,12 @@ stv5730_write0bit (unsigned int port, unsigned int flags)
 // sets the memory pointer inside the stv5730 to the position
 // row, col.
 static void
-stv5730_locate (unsigned int port, unsigned int flags, int row, int col)
+stv5730_locate (LptIO *lpt, unsigned int flags, int row, int col)
 {
     if (row < 0 || row >= STV5730_HGT || col < 0 || col >= STV5730_WID)
 	return;
 
-    stv5730_write16bit(port, flags, (row << 8) + col);
+    stv5730_write16bit(lpt, flags, (row << 8) + col);
 }
 
 /////////////////////////////////////////////////////////////////
@@ -313,50 +311,52 @@ stv5730_init (Driver *drvthis)
     }
 
     // Initialize the Port and the stv5730
-    if (port_access(p->port) || port_access(p->port + 1)) {
+    if (lpt_open(&p->lpt, p->port, 2,
+		 drvthis->config_get_string(drvthis->name, "PortDevice", 0, ""))) {
 	  report(RPT_ERR,
-	      "%s: cannot get IO-permission for 0x%03X! Are we running as root?",
-	       drvthis->name, p->port);
+	      "%s: cannot get IO-permission for 0x%03X: %s",
+	       drvthis->name, p->port, strerror(errno));
 	  return -1;
     }
 
-    if (stv5730_detect(p->port)) {
+    if (stv5730_detect(&p->lpt)) {
 	  report(RPT_ERR, "%s: no STV5730 hardware found at 0x%03X ",
 			  drvthis->name, p->port);
 	  return -1;
     }
 
-    port_out(p->port, 0);
+    lpt_out(&p->lpt, LPT_DATA, 0);
 
     // Reset the STV5730
-    stv5730_write16bit(p->port, p->flags, 0x3000);
-    stv5730_write16bit(p->port, p->flags, 0x3000);
-    stv5730_write16bit(p->port, p->flags, 0x00db);
-    stv5730_write16bit(p->port, p->flags, 0x1000);
+    stv5730_write16bit(&p->lpt, p->flags, 0x3000);
+    stv5730_write16bit(&p->lpt, p->flags, 0x3000);
+    stv5730_write16bit(&p->lpt, p->flags, 0x00db);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1000);
 
     // Setup Mode + Control Register for video detection
-    stv5730_write16bit(p->port, p->flags, STV5730_REG_MODE);
-    stv5730_write16bit(p->port, p->flags, 0x1576);
+    stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_MODE);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1576);
 
-    stv5730_write16bit(p->port, p->flags, STV5730_REG_CONTROL);
-    stv5730_write16bit(p->port, p->flags, 0x1FF4);
+    stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_CONTROL);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1FF4);
 
     report(RPT_INFO, "%s: detecting video signal: ", drvthis->name);
+    lpt_flush(&p->lpt);
     usleep (50000);
 
-    if (stv5730_is_mute(p->port)) {
+    if (stv5730_is_mute(&p->lpt)) {
 	  report(RPT_INFO, "%s: no video signal found; using full page mode", drvthis->name);
 	  // Setup Mode + Control for full page mode
 	  p->charattrib = STV5730_ATTRIB;
-	  stv5730_write16bit(p->port, p->flags, STV5730_REG_MODE);
-	  stv5730_write16bit(p->port, p->flags, 0x15A6);
+	  stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_MODE);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x15A6);
 
-	  stv5730_write16bit(p->port, p->flags, STV5730_REG_CONTROL);
+	  stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_CONTROL);
 #ifdef PAL
-	  stv5730_write16bit(p->port, p->flags, 0x1FD5);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x1FD5);
 #endif
 #ifdef NTSC
-	  stv5730_write16bit(p->port, p->flags, 0x1ED4);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x1ED4);
 #endif
 
     }
@@ -364,35 +364,35 @@ stv5730_init (Driver *drvthis)
 	  report(RPT_INFO, "%s: video signal found, using mixed mode (B&W)", drvthis->name);
 	  // Setup Mode + Control for mixed mode, disable color
 	  p->charattrib = 0;
-	  stv5730_write16bit(p->port, p->flags, STV5730_REG_MODE);
-	  stv5730_write16bit(p->port, p->flags, 0x1576);
+	  stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_MODE);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x1576);
 
-	  stv5730_write16bit(p->port, p->flags, STV5730_REG_CONTROL);
+	  stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_CONTROL);
 #ifdef PAL
-	  stv5730_write16bit(p->port, p->flags, 0x1DD4);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x1DD4);
 #endif
 #ifdef NTSC
-	  stv5730_write16bit(p->port, p->flags, 0x1CF4);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x1CF4);
 #endif
       }
 
     // Position Register
-    stv5730_write16bit(p->port, p->flags, STV5730_REG_POSITION);
-    stv5730_write16bit(p->port, p->flags, 0x1000 + 64 * 30 + 30);
+    stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_POSITION);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1000 + 64 * 30 + 30);
 
     // Color Register
-    stv5730_write16bit(p->port, p->flags, STV5730_REG_COLOR);
-    stv5730_write16bit(p->port, p->flags, 0x1000 + (STV5730_COL_SBACK << 9) +
+    stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_COLOR);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1000 + (STV5730_COL_SBACK << 9) +
 			(STV5730_COL_CBORD << 6) + STV5730_COL_CBACK);
 
     // Zoom Register: Zoom first line
-    stv5730_write16bit(p->port, p->flags, STV5730_REG_ZOOM);
-    stv5730_write16bit(p->port, p->flags, 0x1000 + 4);
+    stv5730_write16bit(&p->lpt, p->flags, STV5730_REG_ZOOM);
+    stv5730_write16bit(&p->lpt, p->flags, 0x1000 + 4);
 
     // Set the Row Attributes
     for (i = 0; i <= 10; i++) {
-	  stv5730_write16bit(p->port, p->flags, 0x00C0 + i);
-	  stv5730_write16bit(p->port, p->flags, 0x10C0);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x00C0 + i);
+	  stv5730_write16bit(&p->lpt, p->flags, 0x10C0);
     }
 
     // Allocate our own framebuffer
@@ -405,6 +405,7 @@ stv5730_init (Driver *drvthis)
 
     // clear screen
     memset(p->framebuf, 0, STV5730_WID * STV5730_HGT);
+    lpt_flush(&p->lpt);
 
     report(RPT_DEBUG, "%s: init() done", drvthis->name);
 
@@ -420,6 +421,8 @@ stv5730_close (Driver *drvthis)
     PrivateData *p = drvthis->private_data;
 
     if (p != NULL) {
+	lpt_close(&p->lpt);
+
 	if (p->framebuf != NULL)
 	    free(p->framebuf);
 
@@ -489,23 +492,24 @@ stv5730_flush (Driver *drvthis)
     PrivateData *p = drvthis->private_data;
     int i, j, atr;
 
-    stv5730_locate(p->port, p->flags, 0, 0);
+    stv5730_locate(&p->lpt, p->flags, 0, 0);
 
     for (i = 0; i < STV5730_HGT; i++) {
 	if (i == 0)
 	    atr = (STV5730_COL_FLINE << 8);
 	else
 	    atr = (STV5730_COL_TEXT << 8);
-	stv5730_write16bit(p->port, p->flags, 0x1000 + atr + p->framebuf[i * STV5730_WID] +
+	stv5730_write16bit(&p->lpt, p->flags, 0x1000 + atr + p->framebuf[i * STV5730_WID] +
 			      p->charattrib);
 	for (j = 1; j < STV5730_WID; j++) {
 	    if (p->framebuf[j + (i * STV5730_WID) - 1] !=
 		p->framebuf[j + (i * STV5730_WID)])
-		stv5730_write8bit(p->port, p->flags, p->framebuf[j + (i * STV5730_WID)]);
+		stv5730_write8bit(&p->lpt, p->flags, p->framebuf[j + (i * STV5730_WID)]);
 	    else
-		stv5730_write0bit(p->port, p->flags);
+		stv5730_write0bit(&p->lpt, p->flags);
 	}
     }
+    lpt_flush(&p->lpt);
 }
 
 /////////////////////////////////////////////////////////////////
@@ -123,7 +123,8 @@ t6963_init(Driver *drvthis)
 
 	/* Initialize port and timing */
 	debug(RPT_DEBUG, "T6963: Initializing parallel port at 0x%03X", p->port_config->port);
-	if (t6963_low_init(p->port_config) == -1) {
+	if (t6963_low_init(p->port_config,
+			   drvthis->config_get_string(drvthis->name, "PortDevice", 0, "")) == -1) {
 		report(RPT_ERR, "%s: Error initializing port 0x%03X: %s",
 		       drvthis->name, p->port_config->port, strerror(errno));
 		return -1;
@@ -174,6 +175,7 @@ t6963_init(Driver *drvthis)
 
 	/* Turn on display, text on, graphics off, cursor off */
 	t6963_low_command(p->port_config, SET_DISPLAY_MODE | TEXT_ON);
+	t6963_low_flush(p->port_config);
 
 	debug(RPT_INFO, "%s: init() done", drvthis->name);
 
@@ -317,6 +319,7 @@ t6963_flush(Driver *drvthis)
 			t6963_low_auto_write(p->port_config, ' ');
 	}
 	t6963_low_command(p->port_config, AUTO_RESET);
+	t6963_low_flush(p->port_config);
 }
 
 /**
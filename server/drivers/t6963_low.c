@@ -30,8 +30,8 @@
 
 #include <stdio.h>
 
-#include "port.h"
 #include "lpt-port.h"
+#include "lpt-io.h"
 #include "timing.h"
 #include "t6963_low.h"
 
@@ -47,14 +47,16 @@
  * Acquires access to parallel port and initializes timing. The parallel port
  * must be an I/O-address between 0x200 and 0x400.
  * \param p        Pointer to port configuration.
+ * \param device   ppdev device to access the port through, or empty for
+ *                 direct I/O.
  * \return  0 on success, -1 if an error occured.
  */
 int
-t6963_low_init(T6963_port *p) {
+t6963_low_init(T6963_port *p, const char *device) {
 	if ((p->port < 0x200) || (p->port > 0x400))
 		return -1;
 
-	if (port_access_multiple(p->port, 3))
+	if (lpt_open(&p->lpt, p->port, 3, device))
 		return -1;
 
 	if (timing_init() == -1)
@@ -71,7 +73,17 @@ t6963_low_init(T6963_port *p) {
 void
 t6963_low_close(T6963_port *p) {
 	if ((p->port >= 0x200) && (p->port <= 0x400))
-		port_deny_multiple(p->port, 3);
+		lpt_close(&p->lpt);
+}
+
+/**
+ * Sends the queued port writes to the display.
+ * \param p        Pointer to port configuration.
+ */
+void
+t6963_low_flush(T6963_port *p)
+{
+	lpt_flush(&p->lpt);
 }
 
 /**
@@ -156,16 +168,16 @@ t6963_low_dsp_ready(T6963_port *p, u8 sta)
 
 		do {
 			portcontrol = T_CMD | nWR | nRD | nCE;
-			port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+			lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 			/* lower nRD, nCE, set bi-directional mode */
 			portcontrol = T_CMD | nWR | ENBI;
-			port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+			lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 			/* possible wait required here: tACC = 150 ns max */
 			if (p->delayBus)
-				timing_uPause(1);
-			val = port_in(T6963_DATA_PORT(p->port));
+				lpt_pause(&p->lpt, 1);
+			val = lpt_in(&p->lpt, LPT_DATA);
 			portcontrol = T_CMD | nWR | nRD | nCE;
-			port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+			lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 			loop++;
 			if (loop == 100)
 				return -1;
@@ -173,12 +185,12 @@ t6963_low_dsp_ready(T6963_port *p, u8 sta)
 	}
 	else {
 		portcontrol = T_CMD | nWR | nRD | nCE;
-		port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+		lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 		portcontrol = T_CMD | nWR;
-		port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
-		timing_uPause(150);
+		lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
+		lpt_pause(&p->lpt, 150);
 		portcontrol = T_CMD | nWR | nRD | nCE;
-		port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+		lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 	}
 
 	return 0;
@@ -196,13 +208,13 @@ t6963_low_send(T6963_port *p, u8 type, u8 byte)
 	int portcontrol = 0;
 
 	portcontrol = type | nWR | nRD | nCE;
-	port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
-	port_out(T6963_DATA_PORT(p->port), byte);
+	lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_DATA, byte);
 	portcontrol = type | nRD;	/* lower nWR, nCE */
-	port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 	/* possible wait required here: tWR */
 	if (p->delayBus)
-		timing_uPause(1);
+		lpt_pause(&p->lpt, 1);
 	portcontrol = type | nWR | nRD | nCE;
-	port_out(T6963_CONTROL_PORT(p->port), portcontrol ^ OUTMASK);
+	lpt_out(&p->lpt, LPT_CONTROL, portcontrol ^ OUTMASK);
 }
@@ -21,6 +21,8 @@
 #ifndef T6963_IO_H
 #define T6963_IO_H
 
+#include "lpt-io.h"
+
 /*
  * These are the maximum values the controller supports in single-scan
  * configuration with FontSelector (FS) = 8x8. Dual-scan configuration is
@@ -96,11 +98,13 @@ typedef struct t6963_port_config {
 	unsigned int port;
 	short bidirectLPT;
 	short delayBus;
+	LptIO lpt;		/**< Access to the port */
 } T6963_port;
 
 /* External usable functions */
-int t6963_low_init(T6963_port *p);
+int t6963_low_init(T6963_port *p, const char *device);
 void t6963_low_close(T6963_port *p);
+void t6963_low_flush(T6963_port *p);
 void t6963_low_data(T6963_port *p, u8 byte);
 void t6963_low_auto_write(T6963_port *p, u8 byte);
 void t6963_low_command(T6963_port *p, u8 byte);
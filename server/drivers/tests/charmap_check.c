@@ -0,0 +1,197 @@
+/** \file server/drivers/tests/charmap_check.c
+ * Checks lib_charmap_translate() and lib_charmap_string() against a loop
+ * translating one byte at a time, and with -b measures the unrolled
+ * translation against that loop on 80 column strings.
+ *
+ * lib_charmap_translate() is run for every length up to 80 bytes at every
+ * alignment, with every byte value in the input. lib_charmap_string() is
+ * run for strings of every length at every column from left of the row to
+ * right of it, as the drivers' string() functions did it before.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "lcd_lib.h"
+
+#define MAX_LEN		80
+#define ROUNDS		1000000
+#define SENTINEL	0xA5
+
+static int failures = 0;
+static unsigned int seed = 2463534242u;
+static unsigned char charmap[256];
+
+
+/* xorshift: the same pseudo random bytes on every run */
+static unsigned int
+next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+
+static void
+fail(const char *what, int a, int b, int c)
+{
+	if (failures++ < 10)
+		fprintf(stderr, "charmap_check: %s differs (%d, %d, %d)\n", what, a, b, c);
+}
+
+
+/* One byte at a time, the loop the unrolled translation replaced */
+static void
+plain_translate(unsigned char *dst, const unsigned char *src, int len, const unsigned char *map)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = map[src[i]];
+}
+
+
+static void
+check_translate(void)
+{
+	unsigned char src[8 + MAX_LEN], want[MAX_LEN + 8], got[MAX_LEN + 8];
+	int len, offset, i, n;
+
+	for (n = 0; n < 256 / MAX_LEN + 2; n++) {
+		/* Every byte value shows up at every position */
+		for (i = 0; i < sizeof(src); i++)
+			src[i] = (n * MAX_LEN + i * 7) & 0xFF;
+
+		for (len = 0; len <= MAX_LEN; len++) {
+			for (offset = 0; offset < 8; offset++) {
+				memset(want, SENTINEL, sizeof(want));
+				memset(got, SENTINEL, sizeof(got));
+				plain_translate(want + offset, src + offset, len, charmap);
+				lib_charmap_translate(got + offset, src + offset, len, charmap);
+				if (memcmp(got, want, sizeof(got)) != 0)
+					fail("lib_charmap_translate", n, len, offset);
+			}
+		}
+	}
+}
+
+
+static void
+check_string(void)
+{
+	unsigned char want[MAX_LEN + 2], got[MAX_LEN + 2];
+	char str[MAX_LEN + 1];
+	int width, len, x, i, count;
+
+	for (i = 0; i < MAX_LEN; i++)
+		str[i] = 1 + next_random() % 255;
+
+	for (width = 1; width <= 40; width += 13) {
+		for (len = 0; len <= width + 2; len++) {
+			str[len] = '\0';
+			for (x = -len - 2; x <= width + 2; x++) {
+				memset(want, SENTINEL, sizeof(want));
+				memset(got, SENTINEL, sizeof(got));
+
+				/* The string() functions before lib_charmap_string() */
+				count = 0;
+				for (i = 0; (str[i] != '\0') && (x + i < width); i++) {
+					if (x + i >= 0) {
+						want[1 + x + i] = charmap[(unsigned char) str[i]];
+						count++;
+					}
+				}
+
+				if (lib_charmap_string(got + 1, width, x, str, charmap) != count)
+					fail("lib_charmap_string count", width, len, x);
+				if (memcmp(got, want, sizeof(got)) != 0)
+					fail("lib_charmap_string", width, len, x);
+			}
+			str[len] = 1 + next_random() % 255;
+		}
+	}
+}
+
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/* Times one translation function on the rows of a 80x4 text screen */
+static double
+time_translate(void (*volatile translate)(unsigned char *, const unsigned char *, int, const unsigned char *))
+{
+	static unsigned char text[4][MAX_LEN], frame[4][MAX_LEN];
+	double t;
+	int i, n;
+
+	for (i = 0; i < sizeof(text); i++)
+		text[i / MAX_LEN][i % MAX_LEN] = next_random();
+
+	t = now();
+	for (n = 0; n < ROUNDS; n++)
+		for (i = 0; i < 4; i++)
+			translate(frame[i], text[i], MAX_LEN, charmap);
+	return (now() - t) * 1e9 / (4.0 * ROUNDS);
+}
+
+
+static void
+benchmark(void)
+{
+	printf("plain loop:            %6.2f ns per 80 columns\n", time_translate(plain_translate));
+	printf("lib_charmap_translate: %6.2f ns per 80 columns\n", time_translate(lib_charmap_translate));
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int c, i;
+	int bench = 0;
+
+	while ((c = getopt(argc, argv, "b")) != -1) {
+		if (c == 'b')
+			bench = 1;
+		else {
+			fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	/* A charmap that is no permutation, like the real ones */
+	for (i = 0; i < 256; i++)
+		charmap[i] = next_random() & 0xFF;
+
+	check_translate();
+	check_string();
+	if (failures > 0) {
+		fprintf(stderr, "charmap_check: %d failures\n", failures);
+		return 1;
+	}
+	printf("charmap_check: all translations match the reference\n");
+
+	if (bench)
+		benchmark();
+	return 0;
+}
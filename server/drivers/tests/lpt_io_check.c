@@ -0,0 +1,225 @@
+/** \file server/drivers/tests/lpt_io_check.c
+ * Checks the queued parallel port access of lpt-io.c on its mock port.
+ *
+ * A fixed sequence of writes, pauses and a read must reach the port as
+ * expected: writes that leave a register unchanged are left out, pauses
+ * without a write in between are waited for at once, a pause before a
+ * read is waited for, and the queue keeps its order when it fills up.
+ * Then the writes of a character sent to an HD44780 in 4 bit mode are
+ * queued for a line of text, and the numbers of writes queued and sent
+ * are printed.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef HAVE_PCSTYLE_LPT_CONTROL
+
+#include "lpt-io.h"
+
+#define TRACE		"lpt_io_check.trace"
+#define DEVICE		"mock:" TRACE
+#define MAX_LINES	(4 * LPT_QUEUE_SIZE)
+
+static int failures = 0;
+static char lines[MAX_LINES][32];
+
+
+static void
+fail(const char *what, long a, long b)
+{
+	if (failures++ < 10)
+		fprintf(stderr, "lpt_io_check: %s (%ld, %ld)\n", what, a, b);
+}
+
+
+static void
+open_mock(LptIO *lpt)
+{
+	if (lpt_open(lpt, 0x378, 3, DEVICE) < 0) {
+		perror(TRACE);
+		exit(1);
+	}
+}
+
+
+/* Reads the lines of the trace */
+static int
+read_trace(void)
+{
+	FILE *f = fopen(TRACE, "r");
+	int n = 0;
+
+	if (f == NULL) {
+		perror(TRACE);
+		exit(1);
+	}
+	while (n < MAX_LINES && fgets(lines[n], sizeof(lines[n]), f) != NULL) {
+		lines[n][strcspn(lines[n], "\n")] = '\0';
+		n++;
+	}
+	fclose(f);
+	return n;
+}
+
+
+static void
+check_sequence(void)
+{
+	static const char *want[] = {
+		"D 01",
+		"P 15",		/* two pauses, the write of the same value left out */
+		"C 04",
+		"D 02",
+		"P 40",		/* waited for before the read */
+		"S -> 5a",
+		"C 05",
+		"D 03",		/* the trailing pause is dropped at close */
+	};
+	LptIO lpt;
+	int n, i;
+
+	open_mock(&lpt);
+	lpt.mock_status = 0x5a;
+	lpt_out(&lpt, LPT_DATA, 0x01);
+	lpt_pause(&lpt, 10);
+	lpt_pause(&lpt, 5);
+	lpt_out(&lpt, LPT_DATA, 0x01);
+	lpt_out(&lpt, LPT_CONTROL, 0x04);
+	lpt_pause(&lpt, 0);
+	lpt_out(&lpt, LPT_DATA, 0x02);
+	lpt_pause(&lpt, 40);
+	if (lpt_in(&lpt, LPT_STATUS) != 0x5a)
+		fail("wrong status read", 0, 0);
+	lpt_out(&lpt, LPT_CONTROL, 0x05);
+	lpt_flush(&lpt);
+	lpt_out(&lpt, LPT_CONTROL, 0x05);
+	lpt_out(&lpt, LPT_DATA, 0x03);
+	lpt_pause(&lpt, 100);
+	lpt_close(&lpt);
+
+	n = read_trace();
+	if (n != sizeof(want) / sizeof(want[0]))
+		fail("wrong number of lines in the sequence", n, sizeof(want) / sizeof(want[0]));
+	for (i = 0; i < n && i < sizeof(want) / sizeof(want[0]); i++) {
+		if (strcmp(lines[i], want[i]) != 0)
+			fail("unexpected line in the sequence", i, 0);
+	}
+}
+
+
+/* More writes than the queue holds must arrive in order */
+static void
+check_overflow(void)
+{
+	LptIO lpt;
+	int n, i;
+
+	open_mock(&lpt);
+	for (i = 0; i < 3 * LPT_QUEUE_SIZE / 2; i++) {
+		lpt_out(&lpt, LPT_DATA, i & 0xFF);
+		lpt_pause(&lpt, 1 + (i & 3));
+	}
+	lpt_close(&lpt);
+
+	/* Every write is followed by its pause, except the last one */
+	n = read_trace();
+	if (n != 3 * LPT_QUEUE_SIZE - 1)
+		fail("wrong number of lines after the queue filled", n, 3 * LPT_QUEUE_SIZE - 1);
+	for (i = 0; i < n; i++) {
+		char want[32];
+		int k = i / 2;
+
+		if (i % 2 == 0)
+			snprintf(want, sizeof(want), "D %02x", k & 0xFF);
+		else
+			snprintf(want, sizeof(want), "P %d", 1 + (k & 3));
+		if (strcmp(lines[i], want) != 0) {
+			fail("queue lost its order", i, 0);
+			break;
+		}
+	}
+}
+
+
+/*
+ * The writes of hd44780-4bit for a character: each nibble is put on the
+ * data lines with RS, then the enable line is pulsed.
+ */
+static void
+check_hd44780(void)
+{
+	static const char text[] = "Hello, parallel port";
+	LptIO lpt;
+	int queued = 0, sent = 0, want = 1, prev = -1, n, i, half;
+
+	open_mock(&lpt);
+	for (i = 0; text[i] != '\0'; i++) {
+		for (half = 0; half < 2; half++) {
+			unsigned char nibble = half ? (text[i] & 0x0F) : (text[i] >> 4);
+			unsigned char rs = 0x10;
+
+			lpt_out(&lpt, LPT_DATA, rs | nibble);
+			lpt_pause(&lpt, 1);
+			lpt_out(&lpt, LPT_DATA, 0x40 | rs | nibble);
+			lpt_pause(&lpt, 1);
+			lpt_out(&lpt, LPT_DATA, rs | nibble);
+			lpt_out(&lpt, LPT_CONTROL, 0x0B);	/* backlight, unchanged */
+			queued += 4;
+
+			/* The first write only counts if the nibble differs */
+			want += (nibble != prev) ? 3 : 2;
+			prev = nibble;
+		}
+		lpt_pause(&lpt, 40);
+	}
+	lpt_close(&lpt);
+
+	n = read_trace();
+	for (i = 0; i < n; i++) {
+		if (lines[i][0] == 'D' || lines[i][0] == 'C')
+			sent++;
+	}
+	if (sent != want)
+		fail("unexpected number of writes for a line of text", sent, want);
+	printf("lpt_io_check: %d characters: %d writes queued, %d sent\n",
+	       (int) strlen(text), queued, sent);
+}
+
+
+int
+main(void)
+{
+	check_sequence();
+	check_overflow();
+	check_hd44780();
+	remove(TRACE);
+
+	if (failures > 0) {
+		fprintf(stderr, "lpt_io_check: %d failures\n", failures);
+		return 1;
+	}
+	printf("lpt_io_check: all port accesses as expected\n");
+	return 0;
+}
+
+#else
+
+int
+main(void)
+{
+	printf("lpt_io_check: no parallel port support on this platform\n");
+	return 77;	/* skipped */
+}
+
+#endif
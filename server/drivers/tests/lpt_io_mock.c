@@ -0,0 +1,17 @@
+/** \file server/drivers/tests/lpt_io_mock.c
+ * Builds lpt-io.c for lpt_io_check, where the platform has a parallel
+ * port. The drivers build it into their own modules.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef HAVE_PCSTYLE_LPT_CONTROL
+# include "lpt-io.c"
+#endif
@@ -0,0 +1,305 @@
+/** \file server/drivers/tests/pixfmt_check.c
+ * Checks the pixel format conversions of pixfmt.c against per-pixel
+ * reference code, and with -b measures how fast they are.
+ *
+ * pixfmt_transpose8() is a permutation of bits: every output bit is a copy
+ * of one input bit. Running each of the 256 values through each row of the
+ * block therefore tries every input bit alone and with all others of its
+ * row, which covers all 8x8 patterns. pixfmt_pack_row() is run against
+ * pixfmt_pack_row_scalar() for every row width up to 80 pixels at every
+ * alignment of the input: with every zero/non-zero pattern of 16 pixels
+ * (the width of the SIMD path) for rows up to 32 pixels, every byte value
+ * in every position and random rows. The vpage conversions are compared
+ * pixel by pixel.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "pixfmt.h"
+
+#define MAX_WIDTH	140	/* more than one chunk of pixfmt_bytes_to_vpage() */
+#define MAX_HEIGHT	20
+#define PACK_WIDTH	80
+#define SENTINEL	0xA5
+
+#ifndef min
+# define min(a,b)	(((a) < (b)) ? (a) : (b))
+#endif
+
+static int failures = 0;
+static unsigned int seed = 2463534242u;
+
+
+/* xorshift: the same pseudo random patterns on every run */
+static unsigned int
+next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+
+static void
+fail(const char *what, int a, int b, int c)
+{
+	if (failures++ < 10)
+		fprintf(stderr, "pixfmt_check: %s differs (%d, %d, %d)\n", what, a, b, c);
+}
+
+
+/* Transpose bit by bit: column c, top pixel in bit 7 */
+static void
+ref_transpose8(unsigned char *dst, const unsigned char *src)
+{
+	int r, c;
+
+	for (c = 0; c < 8; c++) {
+		dst[c] = 0;
+		for (r = 0; r < 8; r++)
+			if (src[r] & (0x80 >> c))
+				dst[c] |= 0x80 >> r;
+	}
+}
+
+
+static void
+check_transpose8(void)
+{
+	unsigned char src[8], want[8], got[8 * 3];
+	unsigned char rev[8 * 2];
+	int row, value, i, n;
+
+	for (row = 0; row < 8; row++) {
+		for (value = 0; value < 256; value++) {
+			memset(src, 0, sizeof(src));
+			src[row] = value;
+			ref_transpose8(want, src);
+			pixfmt_transpose8(got, 1, src, 1);
+			if (memcmp(got, want, 8) != 0)
+				fail("pixfmt_transpose8", row, value, 0);
+		}
+	}
+
+	/* Random blocks, with strides as the vpage conversions use them */
+	for (n = 0; n < 100000; n++) {
+		for (i = 0; i < 8; i++) {
+			src[i] = next_random();
+			rev[(7 - i) * 2] = src[i];
+		}
+		ref_transpose8(want, src);
+		pixfmt_transpose8(got, 3, rev + 14, -2);
+		for (i = 0; i < 8; i++)
+			if (got[i * 3] != want[i])
+				fail("pixfmt_transpose8 with strides", n, i, 0);
+	}
+}
+
+
+/* Packs a row both ways and compares, including the bytes after it */
+static void
+compare_pack_row(const unsigned char *src, int width, int offset)
+{
+	unsigned char want[PACK_WIDTH / 8 + 2], got[PACK_WIDTH / 8 + 2];
+	int bytes = (width + 7) / 8;
+
+	memset(want, SENTINEL, sizeof(want));
+	memset(got, SENTINEL, sizeof(got));
+	pixfmt_pack_row_scalar(want, src, width);
+	pixfmt_pack_row(got, src, width);
+	if (memcmp(got, want, sizeof(got)) != 0)
+		fail("pixfmt_pack_row", width, offset, bytes);
+}
+
+
+static void
+check_pack_row(void)
+{
+	unsigned char buf[16 + PACK_WIDTH];
+	int width, offset, pattern, pos, value, i, n;
+
+	for (width = 0; width <= PACK_WIDTH; width++) {
+		for (offset = 0; offset < 16; offset++) {
+			unsigned char *src = buf + offset;
+
+			/* Every zero/non-zero pattern over the first 16 pixels,
+			 * up to the widths where the SIMD path runs twice */
+			for (pattern = 0; (width <= 32) && (pattern < (1 << min(width, 16))); pattern++) {
+				for (i = 0; i < width; i++)
+					src[i] = ((i < 16) && (pattern & (1 << i)))
+						 ? 1 + (pattern + i) % 255 : 0;
+				compare_pack_row(src, width, offset);
+			}
+
+			/* Every byte value in every position */
+			for (pos = 0; (offset == 0) && (pos < width); pos++) {
+				for (value = 0; value < 256; value++) {
+					memset(src, 0, width);
+					src[pos] = value;
+					compare_pack_row(src, width, offset);
+				}
+			}
+
+			/* Random rows */
+			for (n = 0; n < 100; n++) {
+				for (i = 0; i < width; i++)
+					src[i] = (next_random() & 1) ? next_random() : 0;
+				compare_pack_row(src, width, offset);
+			}
+		}
+	}
+}
+
+
+/* Byte of column x of page p, as the conversions store it */
+static unsigned char
+ref_vpage(const unsigned char *pixels, int width, int height, int x, int page, int lsb_top)
+{
+	unsigned char b = 0;
+	int r;
+
+	for (r = 0; r < 8; r++) {
+		int y = page * 8 + r;
+
+		if ((y < height) && pixels[y * width + x])
+			b |= lsb_top ? (1 << r) : (0x80 >> r);
+	}
+	return b;
+}
+
+
+static void
+check_vpage(void)
+{
+	static unsigned char pixels[MAX_WIDTH * MAX_HEIGHT];
+	static unsigned char linear[(MAX_WIDTH + 7) / 8 * MAX_HEIGHT];
+	static unsigned char out[MAX_WIDTH * (MAX_HEIGHT + 7) / 8 * 2];
+	static const int widths[] = { 1, 7, 8, 9, 16, 31, 64, 100, 127, 128, 129, 140 };
+	int w, height, lsb_top, layout, x, y, page;
+
+	for (w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+		int width = widths[w];
+		int bpl = (width + 7) / 8;
+
+		for (height = 1; height <= MAX_HEIGHT; height++) {
+			int pages = (height + 7) / 8;
+
+			for (y = 0; y < width * height; y++)
+				pixels[y] = (next_random() % 3 == 0) ? next_random() | 1 : 0;
+			for (y = 0; y < height; y++)
+				pixfmt_pack_row_scalar(linear + y * bpl, pixels + y * width, width);
+
+			for (lsb_top = 0; lsb_top <= 1; lsb_top++) {
+				for (layout = 0; layout <= 1; layout++) {
+					/* one page after the other, or all pages of a column */
+					int page_stride = layout ? 1 : width;
+					int col_stride = layout ? pages : 1;
+
+					memset(out, 0, sizeof(out));
+					pixfmt_linear_to_vpage(out, page_stride, col_stride, linear, bpl,
+							       width, height, lsb_top);
+					for (page = 0; page < pages; page++)
+						for (x = 0; x < width; x++)
+							if (out[page * page_stride + x * col_stride]
+							    != ref_vpage(pixels, width, height, x, page, lsb_top))
+								fail("pixfmt_linear_to_vpage", width, height, x);
+
+					memset(out, 0, sizeof(out));
+					pixfmt_bytes_to_vpage(out, page_stride, col_stride, pixels,
+							      width, height, lsb_top);
+					for (page = 0; page < pages; page++)
+						for (x = 0; x < width; x++)
+							if (out[page * page_stride + x * col_stride]
+							    != ref_vpage(pixels, width, height, x, page, lsb_top))
+								fail("pixfmt_bytes_to_vpage", width, height, x);
+				}
+			}
+		}
+	}
+}
+
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/* Times the conversions of a 256x64 frame buffer */
+static void
+benchmark(void)
+{
+	static unsigned char pixels[256 * 64];
+	static unsigned char out[256 * 64 / 8];
+	const int rounds = 20000;
+	double t;
+	int i, n;
+
+	for (i = 0; i < sizeof(pixels); i++)
+		pixels[i] = (next_random() & 1) ? 0xFF : 0;
+
+	t = now();
+	for (n = 0; n < rounds; n++)
+		for (i = 0; i < 64; i++)
+			pixfmt_pack_row_scalar(out + i * 32, pixels + i * 256, 256);
+	printf("pack_row scalar: %8.2f us per frame\n", (now() - t) * 1e6 / rounds);
+
+	t = now();
+	for (n = 0; n < rounds; n++)
+		for (i = 0; i < 64; i++)
+			pixfmt_pack_row(out + i * 32, pixels + i * 256, 256);
+	printf("pack_row:        %8.2f us per frame\n", (now() - t) * 1e6 / rounds);
+
+	t = now();
+	for (n = 0; n < rounds; n++)
+		pixfmt_bytes_to_vpage(out, 256, 1, pixels, 256, 64, 1);
+	printf("bytes_to_vpage:  %8.2f us per frame\n", (now() - t) * 1e6 / rounds);
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int c;
+	int bench = 0;
+
+	while ((c = getopt(argc, argv, "b")) != -1) {
+		if (c == 'b')
+			bench = 1;
+		else {
+			fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	check_transpose8();
+	check_pack_row();
+	check_vpage();
+	if (failures > 0) {
+		fprintf(stderr, "pixfmt_check: %d failures\n", failures);
+		return 1;
+	}
+	printf("pixfmt_check: all conversions match the reference\n");
+
+	if (bench)
+		benchmark();
+	return 0;
+}
@@ -0,0 +1,213 @@
+/** \file server/drivers/tests/usb_io_check.c
+ * Checks the queued USB output of usb-io.c on its mock device.
+ *
+ * A fixed sequence of writes must give exactly the expected transfers:
+ * stream writes are merged up to the packet size, but not across other
+ * endpoints, messages or control transfers. Then the same stream of small
+ * writes, as a driver sends when it updates single characters, is sent
+ * merged and as messages of its own, with more writes than the queue
+ * holds. Both must deliver the same bytes in order; the merged writes
+ * must take the fewest transfers that hold them. The transfer counts of
+ * both are printed, as each transfer costs the device a poll interval.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "usb-io.h"
+#include "shared/report.h"
+
+#define TRACE		"usb_io_check.trace"
+#define STREAM_WRITES	1000
+#define MAX_TRANSFERS	(2 * STREAM_WRITES)
+
+static int failures = 0;
+
+
+static void
+fail(const char *what, long a, long b)
+{
+	if (failures++ < 10)
+		fprintf(stderr, "usb_io_check: %s (%ld, %ld)\n", what, a, b);
+}
+
+
+/* Reads the transfer lines of the trace, without the summary */
+static int
+read_trace(char lines[][512], int max)
+{
+	FILE *f = fopen(TRACE, "r");
+	int n = 0;
+
+	if (f == NULL) {
+		perror(TRACE);
+		exit(1);
+	}
+	while (n < max && fgets(lines[n], sizeof(lines[n]), f) != NULL) {
+		lines[n][strcspn(lines[n], "\n")] = '\0';
+		if (lines[n][0] != '#')
+			n++;
+	}
+	fclose(f);
+	return n;
+}
+
+
+static void
+check_sequence(void)
+{
+	static const char *want[] = {
+		"I 01 8: 61 62 63 64 65 66 67 68",
+		"I 01 2: 69 6a",
+		"I 02 2: 78 79",
+		"I 01 1: 6b",
+		"I 01 2: 6c 6d",
+		"I 01 1: 6e",
+		"C 40 01 0002 0003 1: 7a",
+		"I 01 8: 6f 70 71 72 73 74 75 76",
+		"I 01 1: 77",
+	};
+	static char lines[16][512];
+	UsbIO u;
+	int n, i;
+
+	if (usb_io_open_mock(&u, TRACE, 8) < 0) {
+		perror(TRACE);
+		exit(1);
+	}
+	usb_io_write(&u, 0x01, (unsigned char *) "abc", 3, 1);
+	usb_io_write(&u, 0x01, (unsigned char *) "defghij", 7, 1);	/* fills a transfer */
+	usb_io_write(&u, 0x02, (unsigned char *) "xy", 2, 1);		/* other endpoint */
+	usb_io_write(&u, 0x01, (unsigned char *) "k", 1, 1);
+	usb_io_write(&u, 0x01, (unsigned char *) "lm", 2, 0);		/* a message */
+	usb_io_write(&u, 0x01, (unsigned char *) "n", 1, 1);
+	usb_io_write(&u, 0x01, (unsigned char *) "toolong!!", 9, 0);	/* rejected */
+	usb_io_control(&u, 0x40, 0x01, 2, 3, (unsigned char *) "z", 1);
+	usb_io_flush(&u);
+	usb_io_write(&u, 0x01, (unsigned char *) "opqrstuvw", 9, 1);	/* split */
+	usb_io_close(&u);
+
+	n = read_trace(lines, 16);
+	if (n != sizeof(want) / sizeof(want[0]))
+		fail("wrong number of transfers in the sequence", n, sizeof(want) / sizeof(want[0]));
+	for (i = 0; i < n && i < sizeof(want) / sizeof(want[0]); i++) {
+		if (strcmp(lines[i], want[i]) != 0)
+			fail("unexpected transfer in the sequence", i, 0);
+	}
+}
+
+
+/* Sends the stream and returns the number of transfers */
+static long
+send_stream(const unsigned char *stream, const int *sizes, int merge)
+{
+	static char lines[MAX_TRANSFERS][512];
+	unsigned char got[3 * STREAM_WRITES];
+	int n, i, pos, len, total = 0;
+	long transfers;
+	UsbIO u;
+
+	if (usb_io_open_mock(&u, TRACE, USB_IO_MAX_PACKET) < 0) {
+		perror(TRACE);
+		exit(1);
+	}
+	for (i = 0; i < STREAM_WRITES; i++) {
+		usb_io_write(&u, 0x01, stream + total, sizes[i], merge);
+		total += sizes[i];
+		if (i % 300 == 299)
+			usb_io_flush(&u);	/* a frame ends */
+	}
+	usb_io_close(&u);
+	transfers = u.transfers;
+
+	/* Put the data of the transfers together again */
+	n = read_trace(lines, MAX_TRANSFERS);
+	if (n != transfers)
+		fail("trace and counter disagree", n, transfers);
+	pos = 0;
+	for (i = 0; i < n; i++) {
+		char *p = lines[i];
+		int off;
+
+		if (sscanf(p, "I 01 %d:%n", &len, &off) != 1 || len > USB_IO_MAX_PACKET) {
+			fail("unexpected transfer in the stream", i, merge);
+			continue;
+		}
+		p += off;
+		while (len-- > 0 && pos < sizeof(got)) {
+			unsigned int byte;
+
+			if (sscanf(p, " %2x%n", &byte, &off) != 1)
+				break;
+			got[pos++] = byte;
+			p += off;
+		}
+	}
+	if (pos != total || memcmp(got, stream, total) != 0)
+		fail("stream arrived changed", pos, merge);
+
+	return transfers;
+}
+
+
+static void
+check_stream(void)
+{
+	unsigned char stream[3 * STREAM_WRITES];
+	int sizes[STREAM_WRITES];
+	long merged, unmerged, least = 0;
+	int i, total = 0, frame = 0;
+
+	/* Cursor moves and characters of one to three bytes */
+	for (i = 0; i < STREAM_WRITES; i++) {
+		sizes[i] = 1 + (i * 7) % 3;
+		frame += sizes[i];
+		if (i % 300 == 299 || i == STREAM_WRITES - 1) {
+			least += (frame + USB_IO_MAX_PACKET - 1) / USB_IO_MAX_PACKET;
+			frame = 0;
+		}
+	}
+	for (i = 0; i < sizeof(stream); i++)
+		stream[i] = i * 13;
+
+	merged = send_stream(stream, sizes, 1);
+	unmerged = send_stream(stream, sizes, 0);
+	if (unmerged != STREAM_WRITES)
+		fail("messages were merged", unmerged, STREAM_WRITES);
+	if (merged != least)
+		fail("merged writes took more transfers than needed", merged, least);
+
+	for (i = 0; i < STREAM_WRITES; i++)
+		total += sizes[i];
+	printf("usb_io_check: %d writes, %d bytes: %ld transfers merged, %ld unmerged\n",
+	       STREAM_WRITES, total, merged, unmerged);
+}
+
+
+int
+main(void)
+{
+	/* The rejected write of the sequence is reported, keep quiet */
+	set_reporting("usb_io_check", RPT_CRIT, RPT_DEST_STDERR);
+
+	check_sequence();
+	check_stream();
+	remove(TRACE);
+
+	if (failures > 0) {
+		fprintf(stderr, "usb_io_check: %d failures\n", failures);
+		return 1;
+	}
+	printf("usb_io_check: all transfers as expected\n");
+	return 0;
+}
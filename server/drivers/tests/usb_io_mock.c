@@ -0,0 +1,11 @@
+/** \file server/drivers/tests/usb_io_mock.c
+ * Builds usb-io.c for usb_io_check. The drivers build it into their own
+ * modules, and a source in ../ would put its object into that directory.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include "usb-io.c"
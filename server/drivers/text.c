@@ -30,6 +30,7 @@
 #include <string.h>
 
 #include "lcd.h"
+#include "lcd_lib.h"
 #include "text.h"
 #include "shared/report.h"
 
@@ -219,6 +220,20 @@ text_string (Driver *drvthis, int x, int y, const char string[])
 }
 
 
+/**
+ * Write the character cells of a composed screen.
+ * \param drvthis  Pointer to driver structure.
+ * \param cells    The composed screen.
+ */
+MODULE_EXPORT void
+text_draw_cells (Driver *drvthis, const CellBuffer *cells)
+{
+	PrivateData *p = drvthis->private_data;
+
+	lib_draw_cells((unsigned char *) p->framebuf, p->width, p->height, cells);
+}
+
+
 /**
  * Print a character on the screen at position (x,y).
  * The upper-left corner is (1,1), the lower-right corner is (p->width, p->height).
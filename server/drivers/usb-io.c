@@ -0,0 +1,419 @@
+/** \file server/drivers/usb-io.c
+ * Queued asynchronous output to USB displays.
+ *
+ * Drivers for USB displays used to send every command as a synchronous
+ * libusb transfer, so each one cost a round trip to the device before the
+ * next could be sent. Here the transfers are queued while the driver draws
+ * and submitted together by usb_io_flush():
+ *
+ * - Up to USB_IO_IN_FLIGHT transfers are on their way at once. Transfers
+ *   to different endpoints are not mixed, so they arrive in order.
+ * - Writes to an endpoint that takes a byte stream are merged until a
+ *   transfer is full; writes that are messages of their own are not.
+ * - The flush does not wait for the last transfers. They complete while
+ *   LCDd sleeps and are collected by usb_io_poll() from the driver's
+ *   idle function, at the next flush, or by usb_io_drain() before the
+ *   driver reads from the device.
+ *
+ * The mock device (usb_io_open_mock()) does not access any hardware. It
+ * logs the transfers to a file, one per line, and at the end how many
+ * writes went into how many transfers, to measure what a driver sends
+ * without a display.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "usb-io.h"
+#include "shared/report.h"
+
+static void usb_io_reset(UsbIO *u, UsbIOMode mode, int packet_size);
+static UsbOp *usb_io_queue(UsbIO *u);
+static void usb_io_send(UsbIO *u, UsbOp *op);
+static void usb_io_wait(UsbIO *u, int max_in_flight);
+
+
+/* Sets up an empty queue */
+static void
+usb_io_reset(UsbIO *u, UsbIOMode mode, int packet_size)
+{
+	int i;
+
+	memset(u, 0, sizeof(UsbIO));
+	u->mode = mode;
+	u->packet_size = (packet_size > 0 && packet_size <= USB_IO_MAX_PACKET)
+			 ? packet_size : USB_IO_MAX_PACKET;
+	u->timeout = 1000;
+	u->in_flight_key = -1;
+	for (i = 0; i < USB_IO_IN_FLIGHT; i++)
+		u->slot[i].usb = u;
+}
+
+
+#ifdef HAVE_LIBUSB_1_0
+/**
+ * Prepares output to an open device.
+ * \param u            The output.
+ * \param ctx          libusb context the device was opened in; may be NULL.
+ * \param handle       The device.
+ * \param packet_size  Largest transfer the device takes.
+ * \retval 0   Success.
+ * \retval -1  Error.
+ */
+int
+usb_io_open(UsbIO *u, libusb_context *ctx, libusb_device_handle *handle, int packet_size)
+{
+	int i;
+
+	usb_io_reset(u, USB_IO_LIBUSB, packet_size);
+	u->ctx = ctx;
+	u->handle = handle;
+
+	for (i = 0; i < USB_IO_IN_FLIGHT; i++) {
+		if ((u->slot[i].xfer = libusb_alloc_transfer(0)) == NULL) {
+			usb_io_close(u);
+			return -1;
+		}
+	}
+	return 0;
+}
+#endif
+
+
+/**
+ * Prepares output to the mock device.
+ * \param u            The output.
+ * \param file         File the transfers are logged to; NULL or empty for none.
+ * \param packet_size  Largest transfer the device would take.
+ * \retval 0   Success.
+ * \retval -1  Error, see errno.
+ */
+int
+usb_io_open_mock(UsbIO *u, const char *file, int packet_size)
+{
+	usb_io_reset(u, USB_IO_MOCK, packet_size);
+	if (file != NULL && file[0] != '\0' && (u->trace = fopen(file, "w")) == NULL)
+		return -1;
+	return 0;
+}
+
+
+/**
+ * Sends what is queued, waits for it and frees the transfers. Transfers
+ * the device does not take are cancelled. The device itself is left open.
+ * \param u  The output.
+ */
+void
+usb_io_close(UsbIO *u)
+{
+	usb_io_drain(u);
+
+	if (u->mode == USB_IO_MOCK) {
+		if (u->trace != NULL) {
+			fprintf(u->trace, "# %ld writes in %ld transfers, %ld bytes\n",
+				u->writes, u->transfers, u->bytes);
+			fclose(u->trace);
+		}
+		u->trace = NULL;
+		return;
+	}
+
+#ifdef HAVE_LIBUSB_1_0
+	{
+		int i;
+
+		/* The drain gives up when the device does not answer: cancel
+		 * what is still on its way and collect the completions */
+		if (u->in_flight > 0) {
+			for (i = 0; i < USB_IO_IN_FLIGHT; i++) {
+				if (u->slot[i].busy)
+					libusb_cancel_transfer(u->slot[i].xfer);
+			}
+			usb_io_wait(u, 0);
+		}
+
+		/* libusb still owns a transfer that did not complete */
+		for (i = 0; i < USB_IO_IN_FLIGHT; i++) {
+			if (u->slot[i].busy)
+				report(RPT_WARNING, "usb_io_close: transfer did not complete, not freed");
+			else if (u->slot[i].xfer != NULL)
+				libusb_free_transfer(u->slot[i].xfer);
+			u->slot[i].xfer = NULL;
+		}
+	}
+#endif
+	debug(RPT_DEBUG, "usb_io_close: %ld writes in %ld transfers, %ld failed",
+	      u->writes, u->transfers, u->errors);
+}
+
+
+/* Returns a free entry at the end of the queue */
+static UsbOp *
+usb_io_queue(UsbIO *u)
+{
+	if (u->queued == USB_IO_QUEUE_SIZE)
+		usb_io_flush(u);
+	return &u->queue[u->queued++];
+}
+
+
+/**
+ * Queues an interrupt transfer to the device.
+ * \param u         The output.
+ * \param endpoint  OUT endpoint.
+ * \param data      Data to send.
+ * \param len       Number of bytes.
+ * \param merge     The endpoint takes a byte stream: the data may share
+ *                  transfers with the writes before and after it, and may
+ *                  be longer than a transfer. Otherwise it is a message of
+ *                  its own and must fit into one.
+ */
+void
+usb_io_write(UsbIO *u, unsigned char endpoint, const unsigned char *data, int len, int merge)
+{
+	UsbOp *op;
+
+	u->writes++;
+
+	if (!merge) {
+		if (len > u->packet_size) {
+			report(RPT_ERR, "usb_io_write: %d bytes do not fit into a transfer", len);
+			return;
+		}
+		op = usb_io_queue(u);
+		memset(op, 0, sizeof(UsbOp));
+		op->endpoint = endpoint;
+		op->len = len;
+		memcpy(op->data, data, len);
+		return;
+	}
+
+	while (len > 0) {
+		int n;
+
+		op = (u->queued > 0) ? &u->queue[u->queued - 1] : NULL;
+		if (op == NULL || op->control || !op->merge || op->endpoint != endpoint
+		    || op->len == u->packet_size) {
+			op = usb_io_queue(u);
+			memset(op, 0, sizeof(UsbOp));
+			op->endpoint = endpoint;
+			op->merge = 1;
+		}
+		n = u->packet_size - op->len;
+		if (n > len)
+			n = len;
+		memcpy(op->data + op->len, data, n);
+		op->len += n;
+		data += n;
+		len -= n;
+	}
+}
+
+
+/**
+ * Queues a control transfer to the device.
+ * \param u             The output.
+ * \param request_type  bmRequestType; must be a host-to-device request.
+ * \param request       bRequest.
+ * \param value         wValue.
+ * \param index         wIndex.
+ * \param data          Data to send; may be NULL if len is 0.
+ * \param len           Number of bytes.
+ */
+void
+usb_io_control(UsbIO *u, unsigned char request_type, unsigned char request,
+	       unsigned short value, unsigned short index,
+	       const unsigned char *data, int len)
+{
+	UsbOp *op;
+
+	u->writes++;
+	if (len > u->packet_size) {
+		report(RPT_ERR, "usb_io_control: %d bytes do not fit into a transfer", len);
+		return;
+	}
+
+	op = usb_io_queue(u);
+	memset(op, 0, sizeof(UsbOp));
+	op->control = 1;
+	op->endpoint = request_type;
+	op->request = request;
+	op->value = value;
+	op->index = index;
+	op->len = len;
+	if (len > 0)
+		memcpy(op->data, data, len);
+}
+
+
+/**
+ * Submits the queued transfers. Returns once the last of them is on its
+ * way, not when it arrived.
+ * \param u  The output.
+ */
+void
+usb_io_flush(UsbIO *u)
+{
+	int i;
+
+	/* Collect what completed since the last flush */
+	if (u->in_flight > 0)
+		usb_io_wait(u, u->in_flight);
+
+	for (i = 0; i < u->queued; i++)
+		usb_io_send(u, &u->queue[i]);
+	u->queued = 0;
+
+	if (u->trace != NULL)
+		fflush(u->trace);
+}
+
+
+/**
+ * Submits the queued transfers and waits until all have completed.
+ * \param u  The output.
+ */
+void
+usb_io_drain(UsbIO *u)
+{
+	usb_io_flush(u);
+	usb_io_wait(u, 0);
+}
+
+
+/**
+ * Collects the transfers that completed, without waiting for any.
+ * \param u  The output.
+ */
+void
+usb_io_poll(UsbIO *u)
+{
+	if (u->in_flight > 0)
+		usb_io_wait(u, u->in_flight);
+}
+
+
+#ifdef HAVE_LIBUSB_1_0
+/* Completion of a transfer */
+static void LIBUSB_CALL
+usb_io_done(struct libusb_transfer *xfer)
+{
+	UsbSlot *slot = xfer->user_data;
+	UsbIO *u = slot->usb;
+
+	slot->busy = 0;
+	u->in_flight--;
+	if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+		u->errors++;
+		report(RPT_WARNING, "usb_io: transfer failed with status %d", xfer->status);
+	}
+}
+#endif
+
+
+/* Sends one transfer */
+static void
+usb_io_send(UsbIO *u, UsbOp *op)
+{
+	u->transfers++;
+	u->bytes += op->len;
+
+	if (u->mode == USB_IO_MOCK) {
+		if (u->trace != NULL) {
+			int i;
+
+			if (op->control)
+				fprintf(u->trace, "C %02x %02x %04x %04x %d:", op->endpoint,
+					op->request, op->value, op->index, op->len);
+			else
+				fprintf(u->trace, "I %02x %d:", op->endpoint, op->len);
+			for (i = 0; i < op->len; i++)
+				fprintf(u->trace, " %02x", op->data[i]);
+			fputc('\n', u->trace);
+		}
+		return;
+	}
+
+#ifdef HAVE_LIBUSB_1_0
+	{
+		int key = op->control ? -1 : op->endpoint;
+		UsbSlot *slot = NULL;
+		int i, rc;
+
+		/* Transfers to another endpoint might overtake the ones on their way */
+		if (u->in_flight > 0 && key != u->in_flight_key)
+			usb_io_wait(u, 0);
+		if (u->in_flight == USB_IO_IN_FLIGHT)
+			usb_io_wait(u, USB_IO_IN_FLIGHT - 1);
+
+		for (i = 0; i < USB_IO_IN_FLIGHT; i++) {
+			if (!u->slot[i].busy) {
+				slot = &u->slot[i];
+				break;
+			}
+		}
+		if (slot == NULL)
+			return;		/* the device does not answer */
+
+		if (op->control) {
+			libusb_fill_control_setup(slot->buf, op->endpoint, op->request,
+						  op->value, op->index, op->len);
+			memcpy(slot->buf + USB_IO_SETUP_SIZE, op->data, op->len);
+			libusb_fill_control_transfer(slot->xfer, u->handle, slot->buf,
+						     usb_io_done, slot, u->timeout);
+		}
+		else {
+			memcpy(slot->buf, op->data, op->len);
+			libusb_fill_interrupt_transfer(slot->xfer, u->handle, op->endpoint,
+						       slot->buf, op->len,
+						       usb_io_done, slot, u->timeout);
+		}
+
+		rc = libusb_submit_transfer(slot->xfer);
+		if (rc != 0) {
+			u->errors++;
+			report(RPT_WARNING, "usb_io: cannot submit transfer: %s", libusb_error_name(rc));
+			return;
+		}
+		slot->busy = 1;
+		u->in_flight++;
+		u->in_flight_key = key;
+	}
+#endif
+}
+
+
+/* Handles completions until no more than max_in_flight transfers are left */
+static void
+usb_io_wait(UsbIO *u, int max_in_flight)
+{
+#ifdef HAVE_LIBUSB_1_0
+	struct timeval tv;
+
+	if (u->mode != USB_IO_LIBUSB)
+		return;
+
+	/* Collect what is done already */
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+	libusb_handle_events_timeout_completed(u->ctx, &tv, NULL);
+
+	/* Wait for the rest; transfers time out if the device does not answer */
+	while (u->in_flight > max_in_flight) {
+		tv.tv_sec = 0;
+		tv.tv_usec = 100000;
+		if (libusb_handle_events_timeout_completed(u->ctx, &tv, NULL) != 0)
+			break;
+	}
+#endif
+}
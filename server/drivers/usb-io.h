@@ -0,0 +1,103 @@
+/** \file server/drivers/usb-io.h
+ * Queued asynchronous output to USB displays.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifndef USB_IO_H
+#define USB_IO_H
+
+#include <stdio.h>
+
+#ifdef HAVE_LIBUSB_1_0
+# include <libusb-1.0/libusb.h>
+#endif
+
+/** Number of transfers queued before they are sent */
+#define USB_IO_QUEUE_SIZE	64
+/** Number of transfers on their way at the same time */
+#define USB_IO_IN_FLIGHT	8
+/** Largest transfer, in bytes */
+#define USB_IO_MAX_PACKET	64
+/** Size of the setup packet in front of the data of a control transfer */
+#define USB_IO_SETUP_SIZE	8
+
+/** How the transfers are sent */
+typedef enum {
+	USB_IO_LIBUSB,		/**< Asynchronous libusb-1.0 transfers */
+	USB_IO_MOCK		/**< No device, transfers are logged to a file */
+} UsbIOMode;
+
+/** One queued transfer */
+typedef struct {
+	int control;		/**< Control transfer, else interrupt transfer */
+	unsigned char endpoint;	/**< Endpoint; bmRequestType of a control transfer */
+	unsigned char request;	/**< bRequest of a control transfer */
+	unsigned short value;	/**< wValue of a control transfer */
+	unsigned short index;	/**< wIndex of a control transfer */
+	int merge;		/**< Later writes may be appended */
+	int len;		/**< Number of bytes of data */
+	unsigned char data[USB_IO_MAX_PACKET];
+} UsbOp;
+
+struct usb_io;
+
+/** A transfer on its way */
+typedef struct {
+	struct usb_io *usb;	/**< Device it belongs to */
+	int busy;		/**< Submitted and not completed */
+#ifdef HAVE_LIBUSB_1_0
+	struct libusb_transfer *xfer;
+#endif
+	unsigned char buf[USB_IO_SETUP_SIZE + USB_IO_MAX_PACKET];
+} UsbSlot;
+
+/**
+ * Output to a USB device. Writes are queued and sent by usb_io_flush()
+ * as asynchronous transfers, several of them on their way at a time, so
+ * that the driver does not wait a round trip for each one. Consecutive
+ * writes to a stream endpoint are merged into transfers of up to
+ * packet_size bytes. Transfers complete while LCDd does other things and
+ * are collected by usb_io_poll() or the next flush; usb_io_drain() waits
+ * for all of them, as needed before reading from the device.
+ */
+typedef struct usb_io {
+	UsbIOMode mode;
+#ifdef HAVE_LIBUSB_1_0
+	libusb_context *ctx;
+	libusb_device_handle *handle;
+#endif
+	int packet_size;	/**< Largest transfer the device takes */
+	int timeout;		/**< Transfer timeout in milliseconds */
+	FILE *trace;		/**< Log of the mock device */
+
+	UsbOp queue[USB_IO_QUEUE_SIZE];
+	int queued;
+
+	UsbSlot slot[USB_IO_IN_FLIGHT];
+	int in_flight;		/**< Number of busy slots */
+	int in_flight_key;	/**< Endpoint they go to; -1 for control */
+
+	long writes;		/**< Writes queued */
+	long transfers;		/**< Transfers sent */
+	long bytes;		/**< Bytes of data sent */
+	long errors;		/**< Transfers that failed */
+} UsbIO;
+
+#ifdef HAVE_LIBUSB_1_0
+int usb_io_open(UsbIO *u, libusb_context *ctx, libusb_device_handle *handle, int packet_size);
+#endif
+int usb_io_open_mock(UsbIO *u, const char *file, int packet_size);
+void usb_io_close(UsbIO *u);
+void usb_io_write(UsbIO *u, unsigned char endpoint, const unsigned char *data, int len, int merge);
+void usb_io_control(UsbIO *u, unsigned char request_type, unsigned char request,
+		    unsigned short value, unsigned short index,
+		    const unsigned char *data, int len);
+void usb_io_flush(UsbIO *u);
+void usb_io_drain(UsbIO *u);
+void usb_io_poll(UsbIO *u);
+
+#endif
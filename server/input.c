@@ -23,9 +23,9 @@
 #include "drivers.h"
 
 #define INC_TYPES_ONLY 1
-#include "client.h"
 #include "screen.h"
 #undef INC_TYPES_ONLY
+#include "client.h"
 #include "screenlist.h"
 #include "menuscreens.h"
 #include "input.h"
@@ -78,28 +78,39 @@ void input_shutdown()
 }
 
 
-void handle_input(void)
+int handle_input(void)
 {
 	const char *key;
+	int display;
+	int n = 0;
 	Screen *current_screen;
 	Client *current_client;
 	KeyReservation *kr;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	current_screen = screenlist_current();
-	if (current_screen)
-		current_client = current_screen->client;
-	else
-		current_client = NULL;
-
 	/* Handle all keypresses */
-	while ((key = drivers_get_key()) != NULL) {
+	while ((key = drivers_get_key(&display)) != NULL) {
+		n++;
+
+		/* The key acts on the display of the driver that generated it */
+		drivers_select_display(display);
+		current_screen = screenlist_current();
+		if (current_screen)
+			current_client = current_screen->client;
+		else
+			current_client = NULL;
 
 		/* keys from key_add have highest priority */
 		if (current_screen && screen_find_key(current_screen, key)) {
-			sock_printf(current_client->sock, "key %s %s\n",
-				    key, current_screen->id);
+			char event[1024];
+			int len = snprintf(event, sizeof(event), "key %s %s\n",
+					   key, current_screen->id);
+
+			if ((len > 0) && (len < sizeof(event)))
+				client_send_event(current_client, event, len);
+			else
+				report(RPT_WARNING, "%s: screen id too long for key event", __FUNCTION__);
 			continue;
 		}
 
@@ -108,12 +119,14 @@ void handle_input(void)
 		if (kr && kr->client) {
 			/* A hit ! */
 			debug(RPT_DEBUG, "%s: reserved key: \"%.40s\"", __FUNCTION__, key);
-			sock_printf(kr->client->sock, "key %s\n", key);
+			client_send_event(kr->client, kr->event, kr->event_len);
 		} else {
 			debug(RPT_DEBUG, "%s: left over key: \"%.40s\"", __FUNCTION__, key);
 			input_internal_key(key);
 		}
 	}
+	drivers_select_display(0);
+	return n;
 }
 
 
@@ -121,6 +134,9 @@ void
 input_internal_key(const char *key)
 {
 	if (is_menu_key(key) || screenlist_current() == menuscreen) {
+		/* The menu is built for its own display, not the key's */
+		if (menuscreen != NULL)
+			drivers_select_display(menuscreen->display);
 		menuscreen_key_handler(key);
 	}
 	else {
@@ -151,6 +167,7 @@ input_internal_key(const char *key)
 int input_reserve_key(const char *key, bool exclusive, Client *client)
 {
 	KeyReservation *kr;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", exclusive=%d, client=[%d])",
 		__FUNCTION__, key, exclusive, (client?client->sock:-1));
@@ -158,7 +175,7 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 	/* Find out if this key is already reserved in a way that interferes
 	 * with the new reservation.
 	 */
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
+	LL_ForEach(keylist, it, kr) {
 		if (strcmp(kr->key, key) == 0) {
 			if (kr->exclusive || exclusive) {
 				/* Sorry ! */
@@ -169,9 +186,23 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 
 	/* We can now safely add it ! */
 	kr = malloc(sizeof(KeyReservation));
+	if (kr == NULL) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return -1;
+	}
 	kr->key = strdup(key);
 	kr->exclusive = exclusive;
 	kr->client = client;
+	kr->event_len = strlen(key) + sizeof("key \n") - 1;
+	kr->event = malloc(kr->event_len + 1);
+	if ((kr->key == NULL) || (kr->event == NULL)) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		free(kr->key);
+		free(kr->event);
+		free(kr);
+		return -1;
+	}
+	sprintf(kr->event, "key %s\n", key);
 	LL_Push(keylist, kr);
 
 	report(RPT_INFO, "Key \"%.40s\" is now reserved %s by client [%d]",
@@ -183,16 +214,18 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 void input_release_key(const char *key, Client *client)
 {
 	KeyReservation *kr;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", client=[%d])", __FUNCTION__, key, (client ? client->sock : -1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
+	LL_ForEach(keylist, it, kr) {
 		if ((kr->client == client) && (strcmp(kr->key, key) == 0)) {
 			report(RPT_INFO, "Key \"%.40s\" reserved %s by client [%d] and is now released",
 				key, (kr->exclusive ? "exclusively" : "shared"), (client ? client->sock : -1));
 			free(kr->key);
+			free(kr->event);
 			free(kr);
-			LL_DeleteNode(keylist, NEXT);
+			LL_IterRemove(&it);
 			return;
 		}
 	}
@@ -201,17 +234,18 @@ void input_release_key(const char *key, Client *client)
 void input_release_client_keys(Client *client)
 {
 	KeyReservation *kr;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(client=[%d])", __FUNCTION__, (client ? client->sock : -1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
+	LL_ForEach(keylist, it, kr) {
 		if (kr->client == client) {
 			report(RPT_INFO, "Key \"%.40s\" reserved %s by client [%d] and is now released",
 				kr->key, (kr->exclusive ? "exclusively" : "shared"), (client ? client->sock : -1));
 			free(kr->key);
+			free(kr->event);
 			free(kr);
-			// jump to node before deleted one to not miss any
-			LL_DeleteNode(keylist, PREV);
+			LL_IterRemove(&it);
 		}
 	}
 }
@@ -219,10 +253,11 @@ void input_release_client_keys(Client *client)
 KeyReservation *input_find_key(const char *key, Client *client)
 {
 	KeyReservation *kr;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", client=[%d])", __FUNCTION__, key, (client?client->sock:-1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
+	LL_ForEach(keylist, it, kr) {
 		if (strcmp(kr->key, key) == 0) {
 			if (kr->exclusive || client == kr->client) {
 				return kr;
@@ -21,13 +21,16 @@
 #endif
 #include "shared/defines.h"
 
-/* Accepts and uses keypad input while displaying screens... */
-void handle_input(void);
+/* Accepts and uses keypad input while displaying screens...
+ * Returns the number of keys handled. */
+int handle_input(void);
 
 typedef struct KeyReservation {
 	char *key;
 	bool exclusive;
 	Client *client;		/* NULL for internal clients */
+	char *event;		/* "key <key>\n" sent to the client */
+	int event_len;
 } KeyReservation;
 
 
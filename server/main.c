@@ -52,6 +52,7 @@
 /* TODO: fill in what to include otherwise */
 
 #include "shared/report.h"
+#include "shared/report_async.h"
 #include "shared/defines.h"
 
 #include "drivers.h"
@@ -64,6 +65,7 @@
 #include "serverscreens.h"
 #include "menuscreens.h"
 #include "input.h"
+#include "schedule.h"
 #include "shared/configfile.h"
 #include "drivers.h"
 #include "main.h"
@@ -83,6 +85,7 @@
 #define DEFAULT_ROTATE_SERVER_SCREEN	SERVERSCREEN_ON
 #define DEFAULT_REPORTDEST		RPT_DEST_STDERR
 #define DEFAULT_REPORTLEVEL		RPT_WARNING
+#define DEFAULT_REPORTASYNC		1
 
 #define DEFAULT_FRAME_INTERVAL		125000
 #define DEFAULT_SCREEN_DURATION		32
@@ -134,6 +137,7 @@ int num_drivers = 0;
 static int foreground_mode = UNSET_INT;
 static int report_dest = UNSET_INT;
 static int report_level = UNSET_INT;
+static int report_async = UNSET_INT;
 
 static int stored_argc;
 static char **stored_argv;
@@ -233,6 +237,10 @@ main(int argc, char **argv)
 	install_signal_handlers(!foreground_mode);
 		/* Only catch SIGHUP if not in foreground mode */
 
+	/* The report thread does not survive the fork above */
+	if (report_async)
+		report_async_start();
+
 	/* Startup the subparts of the server */
 	CHAIN(e, sock_init(bind_addr, bind_port));
 	CHAIN(e, screenlist_init());
@@ -276,6 +284,7 @@ clear_settings(void)
 	default_duration = UNSET_INT;
 	report_dest = UNSET_INT;
 	report_level = UNSET_INT;
+	report_async = UNSET_INT;
 
 	for (i = 0; i < num_drivers; i++) {
 		free(drivernames[i]);
@@ -295,6 +304,7 @@ process_command_line(int argc, char **argv)
 	debug(RPT_DEBUG, "%s(argc=%d, argv=...)", __FUNCTION__, argc);
 
 	/* Reset getopt */
+	optind = 1; /* The command line is parsed again on reload */
 	opterr = 0; /* Prevent some messages to stderr */
 
 	/* Analyze options here.. (please try to keep list of options the
@@ -467,6 +477,7 @@ process_configfile(char *configfile)
 	if (report_level == UNSET_INT) {
 		report_level = config_get_int("Server", "ReportLevel", 0, UNSET_INT);
 	}
+	report_async = config_get_bool("Server", "ReportAsync", 0, DEFAULT_REPORTASYNC);
 
 
 	/* Read drivers */
@@ -527,6 +538,8 @@ set_default_settings(void)
 		report_dest = DEFAULT_REPORTDEST;
 	if (report_level == UNSET_INT)
 		report_level = DEFAULT_REPORTLEVEL;
+	if (report_async == UNSET_INT)
+		report_async = DEFAULT_REPORTASYNC;
 
 
 	/* Use default driver */
@@ -681,11 +694,21 @@ init_drivers(void)
 	}
 
 	/* Do we have a running output driver ?*/
-	if (output_driver)
-		return 0;
+	if (!output_driver) {
+		report(RPT_ERR, "There is no output driver");
+		return -1;
+	}
 
-	report(RPT_ERR, "There is no output driver");
-	return -1;
+	/* And does every display have one ? */
+	for (i = 0; i < num_displays; i++) {
+		if (drivers_display_props(i) == NULL) {
+			report(RPT_ERR, "There is no output driver for display %d", i);
+			return -1;
+		}
+	}
+	if (num_displays > 1)
+		report(RPT_NOTICE, "Driving %d displays", num_displays);
+	return 0;
 }
 
 
@@ -717,9 +740,7 @@ do_reload(void)
 {
 	int e = 0;
 
-	drivers_unload_all();		/* Close all drivers */
-
-	config_clear();
+	config_clear();			/* Kept to find what changed */
 	clear_settings();
 
 	/* Reread command line*/
@@ -733,14 +754,21 @@ do_reload(void)
 	/* Set default values */
 	CHAIN(e, (set_default_settings(), 0));
 
-	/* Set reporting values */
+	/* Set reporting values (not while the report thread writes) */
+	report_async_stop();
 	CHAIN(e, set_reporting("LCDd", report_level, report_dest));
 	CHAIN(e, (report(RPT_INFO, "Set report level to %d, output to %s", report_level,
 			((report_dest == RPT_DEST_SYSLOG) ? "syslog" : "stderr")), 0));
+	if (report_async)
+		report_async_start();
 
-	/* And restart the drivers */
+	/* And restart the drivers whose configuration changed */
+	CHAIN(e, (drivers_unload_changed(drivernames, num_drivers), 0));
 	CHAIN(e, init_drivers());
 	CHAIN_END(e, "Critical error while reloading, abort.");
+
+	/* Draw everything again, with the new settings */
+	render_forget(NULL);
 }
 
 
@@ -754,6 +782,10 @@ do_mainloop(void)
 	long int process_lag = 0;
 	long int render_lag = 0;
 	long int t_diff;
+	long int next_stroke = 0;	/* Timer value of the next rendering stroke */
+	long int ahead;			/* Frames to skip while sleeping */
+	int changed = 1;		/* Something may look different now */
+	int d;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
@@ -776,9 +808,13 @@ do_mainloop(void)
                 process_lag += t_diff;
 		if (process_lag > 0) {
 			/* Time for a processing stroke */
-			sock_poll_clients();		/* poll clients for input*/
-			parse_all_client_messages();	/* analyze input from network clients*/
-			handle_input();		/* handle key input from devices*/
+			if (sock_poll_clients() != 0)	/* poll clients for input*/
+				changed = 1;
+			if (parse_all_client_messages() > 0)	/* analyze input from network clients*/
+				changed = 1;
+			if (handle_input() > 0)		/* handle key input from devices*/
+				changed = 1;
+			drivers_idle();			/* let drivers finish their output */
 
 			/* We've done the job... */
 			process_lag = 0 - (1e6/PROCESS_FREQ);
@@ -787,30 +823,58 @@ do_mainloop(void)
 
 		render_lag += t_diff;
 		if (render_lag > 0) {
-			/* Time for a rendering stroke */
-			timer ++;
-			screenlist_process();
-			s = screenlist_current();
-
-			/* TODO: Move this call to every client connection
-			 *       and every screen add...
-			 */
-			if (s == server_screen) {
-				update_server_screen();
-			}
-			render_screen(s, timer);
-
-			/* We've done the job... */
+			/* The timer counts the frames that passed */
 			if (render_lag > frame_interval * MAX_RENDER_LAG_FRAMES) {
 				/* Cause rendering slowdown because too much lag */
 				render_lag = frame_interval * MAX_RENDER_LAG_FRAMES;
 			}
-			render_lag -= frame_interval;
+			do {
+				timer ++;
+				if (schedule_run(timer) > 0)	/* execute commands that are due */
+					changed = 1;
+				render_lag -= frame_interval;
+			} while (render_lag > 0);
 			/* Note: this DOES make a fixed frequency (except with slowdown) */
+
+			if (changed || (timer >= next_stroke)) {
+				/* Time for a rendering stroke */
+				changed = 0;
+				next_stroke = schedule_next();
+
+				/* All displays are rendered in the same stroke */
+				for (d = 0; d < num_displays; d++) {
+					drivers_select_display(d);
+					screenlist_process();
+					s = screenlist_current();
+
+					/* TODO: Move this call to every client connection
+					 *       and every screen add...
+					 */
+					if (s == server_screen) {
+						update_server_screen();
+					}
+					if (s != NULL) {
+						render_screen(s, timer);
+					}
+					else {
+						/* A display without screens stays blank */
+						render_blank();
+					}
+					next_stroke = min(next_stroke, screenlist_next_due());
+				}
+				drivers_select_display(0);
+
+				/* Nothing changes before the next stroke, unless
+				 * a processing stroke changes something */
+				next_stroke = max(min(next_stroke, render_next_due()), timer + 1);
+			}
 		}
 
-		/* Sleep just as long as needed */
-		sleeptime = min(0-process_lag, 0-render_lag);
+		/* Sleep just as long as needed: until the next processing
+		 * stroke, or the frame of the next rendering stroke (a second
+		 * at most, so that the product does not overflow) */
+		ahead = changed ? 0 : min(next_stroke - timer - 1, (long) (1e6 / frame_interval));
+		sleeptime = min(0-process_lag, ahead * frame_interval - render_lag);
 		if (sleeptime > 0) {
 			usleep(sleeptime);
 		}
@@ -819,6 +883,7 @@ do_mainloop(void)
 		if (got_reload_signal) {
 			got_reload_signal = 0;
 			do_reload();
+			changed = 1;
 		}
 	}
 
@@ -850,6 +915,9 @@ exit_program(int val)
 		report(RPT_NOTICE, buf);	/* report it */
 	}
 
+	/* Write queued messages, the rest are written directly */
+	report_async_stop();
+
 	/* Set emergency reporting and flush all messages if not done already. */
 	if (report_level == UNSET_INT)
 		report_level = DEFAULT_REPORTLEVEL;
@@ -862,6 +930,7 @@ exit_program(int val)
 
 	/* Shutdown things if server start was complete */
 	clients_shutdown();		/* shutdown clients (must come first) */
+	schedule_shutdown();		/* forget scheduled commands (must come after clients_shutdown) */
 	menuscreens_shutdown();
 	screenlist_shutdown();		/* shutdown screens (must come after client_shutdown) */
 	input_shutdown();		/* shutdown key input part */
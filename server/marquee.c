@@ -0,0 +1,349 @@
+/** \file server/marquee.c
+ * Precomputed scrolling of title and scroller widgets.
+ *
+ * Where a scrolling text is shown depends only on the frame counter modulo
+ * a period, so the offsets of a whole period are worked out once when the
+ * text or the scrolling parameters change. They are kept as a list of
+ * steps, each the first tick an offset is shown from; a frame looks up its
+ * step, which is usually the one of the previous frame or the next one.
+ *
+ * The schedules are those render.c used to compute every frame: wrapping
+ * scrollers move one character every speed ticks (or speed characters
+ * every tick if it is negative), bouncing scrollers and titles move to
+ * the end and back.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shared/report.h"
+#include "shared/defines.h"
+
+#include "marquee.h"
+
+
+/* Make room for a track of len characters */
+static int
+reserve_track(Marquee *m, int len)
+{
+	if (len + 1 > m->track_size) {
+		char *p = realloc(m->track, len + 1);
+
+		if (p == NULL)
+			return -1;
+		m->track = p;
+		m->track_size = len + 1;
+	}
+	m->track_len = len;
+	m->track[len] = '\0';
+	return 0;
+}
+
+
+/* Append a step shown from tick start on, unless the offset stays */
+static int
+add_step(Marquee *m, long start, int offset)
+{
+	if ((m->num_steps > 0) && (m->steps[m->num_steps - 1].offset == offset))
+		return 0;
+
+	if (m->num_steps == m->steps_size) {
+		int size = (m->steps_size > 0) ? 2 * m->steps_size : 16;
+		MarqueeStep *p = realloc(m->steps, size * sizeof(MarqueeStep));
+
+		if (p == NULL)
+			return -1;
+		m->steps = p;
+		m->steps_size = size;
+	}
+	m->steps[m->num_steps].start = start;
+	m->steps[m->num_steps].offset = offset;
+	m->num_steps++;
+	return 0;
+}
+
+
+/* Schedule of a scroller that wraps around after len characters */
+static int
+schedule_wrap(Marquee *m, int len)
+{
+	int k;
+
+	if (m->speed > 0) {
+		for (k = 0; k < len; k++)
+			if (add_step(m, (long) k * m->speed, k) < 0)
+				return -1;
+		m->period = (long) len * m->speed;
+	}
+	else if (m->speed < 0) {
+		int n = max(len / -m->speed, 1);
+
+		for (k = 0; k < n; k++)
+			if (add_step(m, k, k * -m->speed) < 0)
+				return -1;
+		m->period = n;
+	}
+	return 0;
+}
+
+
+/* Schedule of a scroller that moves through range offsets and back */
+static int
+schedule_bounce(Marquee *m, int range)
+{
+	int k;
+
+	if (m->speed > 0) {
+		for (k = 0; k < 2 * range; k++)
+			if (add_step(m, (long) k * m->speed,
+				     (k < range) ? k : 2 * range - 1 - k) < 0)
+				return -1;
+		m->period = 2L * range * m->speed;
+	}
+	else if (m->speed < 0) {
+		int s = -m->speed;
+		int n = max(range / s, 1);
+
+		for (k = 0; k < 2 * n; k++)
+			if (add_step(m, k, (k < n) ? k * s : range - 1 - (k - n) * s) < 0)
+				return -1;
+		m->period = 2L * n;
+	}
+	return 0;
+}
+
+
+/*
+ * Schedule of a title: it moves one character every delay ticks, or, if
+ * that would take too long, across the length in length ticks and stops
+ * at the end. Then it moves back the same way.
+ */
+static int
+schedule_title(Marquee *m)
+{
+	int len = m->length;
+	int max_offset = len - m->width;
+	int hold = (m->speed < len / max_offset) ? m->speed : 1;
+	int k;
+
+	for (k = 0; k < 2 * len; k++) {
+		int offset = k % len;
+
+		if (hold == 1)
+			offset /= m->speed;
+		offset = min(offset, max_offset);
+		if ((k / len) & 1)
+			offset = max_offset - offset;
+		if (add_step(m, (long) k * hold, offset) < 0)
+			return -1;
+	}
+	m->period = 2L * len * hold;
+	return 0;
+}
+
+
+/* Build the track and the schedule */
+static int
+build(Marquee *m)
+{
+	int len = m->length;
+
+	m->num_steps = 0;
+	m->period = 1;
+
+	if ((m->kind == MARQUEE_WRAP) && (len > m->width)) {
+		/* gap, text, gap and the text again up to a window */
+		int gap = m->width / 2;
+
+		if (reserve_track(m, 2 * gap + len + m->width) < 0)
+			return -1;
+		memset(m->track, ' ', gap);
+		memcpy(m->track + gap, m->text, len);
+		memset(m->track + gap + len, ' ', gap);
+		memcpy(m->track + 2 * gap + len, m->text, m->width);
+		if (schedule_wrap(m, len + gap) < 0)
+			return -1;
+	}
+	else {
+		/* the text itself; a wrapping one fits */
+		if (reserve_track(m, len) < 0)
+			return -1;
+		memcpy(m->track, m->text, len);
+
+		if ((m->kind == MARQUEE_HORIZ) && (len + 1 > m->width)) {
+			if (schedule_bounce(m, len + 1 - m->width) < 0)
+				return -1;
+		}
+		else if ((m->kind == MARQUEE_VERT) && (len > m->width)) {
+			int lines = len / m->width + ((len % m->width) ? 1 : 0);
+
+			if ((lines > m->lines)
+			    && (schedule_bounce(m, lines - m->lines + 1) < 0))
+				return -1;
+		}
+		else if ((m->kind == MARQUEE_TITLE) && (len > m->width) && (m->speed > 0)) {
+			if (schedule_title(m) < 0)
+				return -1;
+		}
+	}
+
+	/* no motion: the text stays at the start */
+	if (m->num_steps == 0)
+		return add_step(m, 0, 0);
+	return 0;
+}
+
+
+/**
+ * Get the marquee of a widget up to date. It is created if there is none
+ * yet, and rebuilt if the text or any of the parameters changed.
+ * \param mp     The widget's marquee; may point to NULL.
+ * \param text   The widget's text.
+ * \param kind   How the text scrolls, MARQUEE_*.
+ * \param width  Visible characters per line.
+ * \param lines  Visible lines.
+ * \param speed  Speed of a scroller, or delay of a title.
+ * \return  The marquee, or NULL on error.
+ */
+Marquee *
+marquee_update(Marquee **mp, const char *text, int kind, int width, int lines, int speed)
+{
+	Marquee *m = *mp;
+
+	if (m == NULL) {
+		m = calloc(1, sizeof(Marquee));
+		if (m == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			return NULL;
+		}
+		*mp = m;
+	}
+
+	if (m->valid && (m->text == text) && (m->kind == kind) && (m->width == width)
+	    && (m->lines == lines) && (m->speed == speed))
+		return m;
+
+	m->text = text;
+	m->length = strlen(text);
+	m->kind = kind;
+	m->width = width;
+	m->lines = lines;
+	m->speed = speed;
+	m->cursor = 0;
+	m->drawn = -1;
+	m->valid = 0;
+
+	if (build(m) < 0) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return NULL;
+	}
+	m->valid = 1;
+	return m;
+}
+
+
+/**
+ * Look up the offset into the track to show at a tick.
+ * \param m      The marquee.
+ * \param timer  A value increased with every frame.
+ * \return  The offset.
+ */
+int
+marquee_offset(Marquee *m, long timer)
+{
+	long t = timer % m->period;
+	int i = m->cursor;
+	int lo, hi;
+
+	if (t < 0)
+		t += m->period;
+
+	/* the previous step, or the one after it */
+	if ((t >= m->steps[i].start)
+	    && ((i + 1 == m->num_steps) || (t < m->steps[i + 1].start)))
+		return m->steps[i].offset;
+	i = (i + 1 == m->num_steps) ? 0 : i + 1;
+	if ((t >= m->steps[i].start)
+	    && ((i + 1 == m->num_steps) || (t < m->steps[i + 1].start))) {
+		m->cursor = i;
+		return m->steps[i].offset;
+	}
+
+	/* the timer jumped */
+	lo = 0;
+	hi = m->num_steps - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+
+		if (m->steps[mid].start <= t)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	m->cursor = lo;
+	return m->steps[lo].offset;
+}
+
+
+/**
+ * Work out how long the offset shown at a tick stays.
+ * \param m      The marquee.
+ * \param timer  A value increased with every frame.
+ * \return  Ticks until the offset changes, or -1 if it never does.
+ */
+long
+marquee_next(Marquee *m, long timer)
+{
+	long t, next;
+	int i;
+
+	if (m->num_steps < 2)
+		return -1;
+
+	marquee_offset(m, timer);
+	i = m->cursor;
+	t = timer % m->period;
+	if (t < 0)
+		t += m->period;
+
+	if (i + 1 < m->num_steps)
+		next = m->steps[i + 1].start;
+	else if (m->steps[0].offset != m->steps[i].offset)
+		next = m->period;
+	else	/* the period starts with the offset it ends with */
+		next = m->period + m->steps[1].start;
+	return next - t;
+}
+
+
+/**
+ * Mark a marquee as outdated, so that it is rebuilt before it is used.
+ * \param m  The marquee; may be NULL.
+ */
+void
+marquee_invalidate(Marquee *m)
+{
+	if (m != NULL)
+		m->valid = 0;
+}
+
+
+/**
+ * Free a marquee.
+ * \param m  The marquee; may be NULL.
+ */
+void
+marquee_destroy(Marquee *m)
+{
+	if (m == NULL)
+		return;
+	free(m->track);
+	free(m->steps);
+	free(m);
+}
@@ -0,0 +1,69 @@
+/** \file server/marquee.h
+ * Precomputed scrolling of title and scroller widgets.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef MARQUEE_H
+#define MARQUEE_H
+
+/** Kinds of scrolling */
+#define MARQUEE_WRAP	'm'	/**< Scroller that wraps around with a gap */
+#define MARQUEE_HORIZ	'h'	/**< Scroller that moves left and right */
+#define MARQUEE_VERT	'v'	/**< Scroller that moves up and down */
+#define MARQUEE_TITLE	't'	/**< Title that moves left and right */
+
+/** The offset shown from a tick of the schedule on */
+typedef struct MarqueeStep {
+	long start;		/**< First tick of the step */
+	int offset;		/**< Characters (or lines) into the track */
+} MarqueeStep;
+
+/**
+ * The track and step schedule of a widget. The track is the text as it
+ * scrolls by, so every frame shows a window of it that starts at the
+ * offset of the current step. Both are built when the text or the
+ * parameters change.
+ */
+typedef struct Marquee {
+	const char *text;	/**< Text the track was built from */
+	int length;		/**< Its length */
+	int kind;		/**< MARQUEE_* */
+	int width;		/**< Visible characters per line */
+	int lines;		/**< Visible lines */
+	int speed;		/**< Speed of the scroller; delay of the title */
+	int valid;		/**< 0 once the text has changed */
+
+	char *track;		/**< Text with gaps, repeated for wraparound */
+	int track_len;		/**< Length of the track */
+	int track_size;		/**< Bytes allocated for track */
+
+	MarqueeStep *steps;	/**< Steps of one period, by start */
+	int num_steps;		/**< Number of steps */
+	int steps_size;		/**< Steps allocated */
+	long period;		/**< Ticks until the schedule repeats */
+	int cursor;		/**< Step of the previous lookup */
+
+	int drawn;		/**< Offset drawn last; or -1 */
+} Marquee;
+
+/* Get a marquee up to date; returns NULL on error */
+Marquee *marquee_update(Marquee **mp, const char *text, int kind,
+			int width, int lines, int speed);
+
+/* Offset to show at a tick */
+int marquee_offset(Marquee *m, long timer);
+
+/* Ticks from a tick until the offset changes; -1 if it never does */
+long marquee_next(Marquee *m, long timer);
+
+/* Mark a marquee as outdated; m may be NULL */
+void marquee_invalidate(Marquee *m);
+
+void marquee_destroy(Marquee *m);
+
+#endif
@@ -42,6 +42,25 @@
 
 extern Menu *custom_main_menu;
 
+/**
+ * Widgets of the menu screen. menu_build_screen() creates one row of
+ * widgets per display line and menu_update_screen() fills the rows with
+ * the items scrolled into view, so updates do not depend on the number
+ * of items in the menu.
+ */
+static struct {
+	Menu *menu;			/**< Menu the widgets were built for */
+	Screen *screen;			/**< Screen holding the widgets */
+	Widget *title;
+	Widget *text[LCD_MAX_HEIGHT];	/**< Item text per display line */
+	Widget *icon[LCD_MAX_HEIGHT];	/**< Checkbox per display line */
+	Widget *selector;
+	Widget *upscroller;
+	Widget *downscroller;
+	MenuItem **items;		/**< Items that are not hidden */
+	int items_size;			/**< Entries allocated for items */
+} view;
+
 
 /**
  * Search a menu for an entry by index, ignoring hidden entries.
@@ -54,12 +73,13 @@ menu_get_subitem(Menu *menu, int index)
 {
 	MenuItem *item;
 	int i = 0;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], index=%d)", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"), index);
-	for (item = LL_GetFirst(menu->data.menu.contents);
+	for (item = LL_IterFirst(menu->data.menu.contents, &it);
 	     item != NULL;
-	     item = LL_GetNext(menu->data.menu.contents)) {
+	     item = LL_IterNext(&it)) {
 		/* hidden items don't count at all... */
 		if (! item->is_hidden) {
 			if (i == index)
@@ -82,12 +102,13 @@ menu_get_index_of(Menu *menu, char *item_id)
 {
 	MenuItem *item;
 	int i = 0;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], item_id=%s)", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"), item_id);
-	for (item = LL_GetFirst(menu->data.menu.contents);
+	for (item = LL_IterFirst(menu->data.menu.contents, &it);
 	     item != NULL;
-	     item = LL_GetNext(menu->data.menu.contents)) {
+	     item = LL_IterNext(&it)) {
 		/* hidden items don't count at all... */
 		if (! item->is_hidden) {
 			if (strcmp(item_id, item->id) == 0)
@@ -109,18 +130,31 @@ menu_visible_item_count(Menu *menu)
 {
 	MenuItem *item;
 	int i = 0;
+	LL_iter it;
 
-	for (item = LL_GetFirst(menu->data.menu.contents);
+	if (menu->data.menu.visible_count >= 0)
+		return menu->data.menu.visible_count;
+
+	for (item = LL_IterFirst(menu->data.menu.contents, &it);
 	     item != NULL;
-	     item = LL_GetNext(menu->data.menu.contents))
+	     item = LL_IterNext(&it))
 	{
 		if (! item->is_hidden)
 			++i;
 	}
+	menu->data.menu.visible_count = i;
 	return i;
 }
 
 
+void
+menu_invalidate_visible_count(Menu *menu)
+{
+	if ((menu != NULL) && (menu->type == MENUITEM_MENU))
+		menu->data.menu.visible_count = -1;
+}
+
+
 #define LV_LABEL_ONLY	1	/**< Fill string with label only */
 #define LV_VALUE_ONLY	2	/**< Fill string with value only */
 #define LV_LABEL_VALU	3	/**< Fill string with label & beginning of value */
@@ -150,7 +184,7 @@ fill_labeled_value(char *string, int len, const char *text, const char *value, i
 		if ((value != NULL) &&
 		    (textlen + strlen(value) < len - 1)) {
 			memset(string, ' ', len);
-			strncpy(string, text, textlen);
+			memcpy(string, text, textlen);
 			strcpy(string + len - strlen(value), value);
 		}
 		else {
@@ -161,14 +195,14 @@ fill_labeled_value(char *string, int len, const char *text, const char *value, i
 			switch (mode) {
 			  case LV_LABEL_VALU:	// show fist chars in value
 				memset(string, ' ', len);
-			  	strncpy(string, text, textlen);
+			  	memcpy(string, text, textlen);
 				strncpy(string + textlen + 2, value, len - textlen - 2);
 				strcpy(string + len - 2, "..");
 				string[len] = '\0';
 				break;
 			  case LV_LABEL_ALUE:	// show last chars in value
 				memset(string, ' ', len);
-			  	strncpy(string, text, textlen);
+			  	memcpy(string, text, textlen);
 				strcpy(string + textlen + 2, "..");
 				strcpy(string + textlen + 4,
 				       value + strlen(value) - len + textlen + 4);
@@ -208,6 +242,7 @@ menu_create(char *id, MenuEventFunc(*event_func),
 	if (new_menu != NULL) {
 		new_menu->data.menu.contents = LL_new();
 		new_menu->data.menu.association = NULL;
+		new_menu->data.menu.visible_count = 0;
 	}
 
 	return new_menu;
@@ -225,6 +260,8 @@ menu_destroy(Menu *menu)
 
 	if (custom_main_menu == menu)
 		custom_main_menu = NULL;
+	if (view.menu == menu)
+		view.menu = NULL;
 
 	menu_destroy_all_items(menu);
 	LL_Destroy(menu->data.menu.contents);
@@ -247,6 +284,7 @@ menu_add_item(Menu *menu, MenuItem *item)
 	/* Add the item to the menu */
 	LL_Push(menu->data.menu.contents, item);
 	item->parent = menu;
+	menu->data.menu.visible_count = -1;
 }
 
 
@@ -255,6 +293,7 @@ menu_remove_item(Menu *menu, MenuItem *item)
 {
 	int i;
 	MenuItem *item2;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], item=[%s])", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"),
@@ -264,11 +303,12 @@ menu_remove_item(Menu *menu, MenuItem *item)
 		return;
 
 	/* Find the item */
-	for (item2 = LL_GetFirst(menu->data.menu.contents), i = 0;
+	for (item2 = LL_IterFirst(menu->data.menu.contents, &it), i = 0;
 	     item2 != NULL;
-	     item2 = LL_GetNext(menu->data.menu.contents), i++) {
+	     item2 = LL_IterNext(&it), i++) {
 		if (item == item2) {
-			LL_DeleteNode(menu->data.menu.contents, NEXT);
+			LL_IterRemove(&it);
+			menu->data.menu.visible_count = -1;
 			if (menu->data.menu.selector_pos >= i) {
 				menu->data.menu.selector_pos--;
 				if (menu->data.menu.scroll > 0)
@@ -295,6 +335,7 @@ menu_destroy_all_items(Menu *menu)
 		menuitem_destroy(item);
 		LL_Remove(menu->data.menu.contents, item, NEXT);
 	}
+	menu->data.menu.visible_count = 0;
 }
 
 
@@ -368,12 +409,15 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 {
 	Widget *w;
 	MenuItem *subitem;
-	int itemnr;
+	int line;
+	int count;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], screen=[%s])", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"),
 			((s != NULL) ? s->id : "(null)"));
 
+	view.menu = NULL;
 	if ((menu == NULL) || (s == NULL))
 		return;
 
@@ -382,109 +426,164 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 
 	/* Create menu title widget */
 	w = widget_create("title", WID_TITLE, s);
-	if (w != NULL) {
-		screen_add_widget(s, w);
-		w->text = strdup(menu->text);
-		w->x = 1;
-	}	
-
-	/* Create widgets for each subitem in the menu */
-	for (subitem = LL_GetFirst(menu->data.menu.contents), itemnr = 0;
-	     subitem != NULL;
-	     subitem = LL_GetNext(menu->data.menu.contents), itemnr ++)
-	{
+	if (w == NULL)
+		return;
+	screen_add_widget(s, w);
+	widget_set_text(w, menu->text, strlen(menu->text));
+	w->x = 1;
+	view.title = w;
+
+	/* Create the widgets for each line; they show the items
+	 * that are scrolled into view */
+	for (line = 0; line < display_props->height; line++) {
 		char buf[10];
 
-		if (subitem->is_hidden)
-			continue;
-		snprintf(buf, sizeof(buf)-1, "text%d", itemnr);
-		buf[sizeof(buf)-1] = '\0';
+		snprintf(buf, sizeof(buf), "text%d", line);
 		w = widget_create(buf, WID_STRING, s);
 					/* (buf will be copied) */
-		if (w != NULL) {
-			screen_add_widget(s, w);
-			w->x = 2;
-
-			switch (subitem->type) {
-			  case MENUITEM_CHECKBOX:
-
-				/* Limit string length */
-				w->text = strdup(subitem->text);
-				if (strlen(subitem->text) >= display_props->width-2)
-					w->text[display_props->width-2] = '\0';
-
-				/* Add icon for checkbox */
-				snprintf(buf, sizeof(buf)-1, "icon%d", itemnr);
-				buf[sizeof(buf)-1] = '\0';
-				w = widget_create(buf, WID_ICON, s);
-						/* (buf will be copied) */
-				screen_add_widget(s, w);
-				w->x = display_props->width - 1;
-				w->length = ICON_CHECKBOX_OFF;
-				break;
-			  case MENUITEM_RING:
-				/* Create string for text + ringtext */
-				w->text = malloc(display_props->width);
-				break;
-			  case MENUITEM_MENU:
-				/* Limit string length */
-				w->text = malloc(strlen(subitem->text) + 4);
-				strcpy(w->text, subitem->text);
-				strcat(w->text, " >");
-				if (strlen(subitem->text) >= display_props->width-1)
-					w->text[display_props->width-1] = '\0';
-				break;
-			  case MENUITEM_ACTION:
-			  case MENUITEM_SLIDER:
-			  case MENUITEM_NUMERIC:
-			  case MENUITEM_ALPHA:
-			  case MENUITEM_IP:
-				/* Limit string length */
-				w->text = malloc(display_props->width);
-				strncpy(w->text, subitem->text, display_props->width);
-				w->text[display_props->width-1] = '\0';
-				break;
-			 default:
-				assert(!"unexpected menuitem type");
-			}
-		}
+		if (w == NULL)
+			return;
+		screen_add_widget(s, w);
+		w->x = 2;
+		w->y = line + 1;
+		view.text[line] = w;
+
+		/* Add icon for checkboxes */
+		snprintf(buf, sizeof(buf), "icon%d", line);
+		w = widget_create(buf, WID_ICON, s);
+		if (w == NULL)
+			return;
+		screen_add_widget(s, w);
+		w->x = display_props->width - 1;
+		w->y = line + 1;
+		w->length = ICON_CHECKBOX_OFF;
+		view.icon[line] = w;
 	}
 
 	/* Add arrow for selection on the left */
 	w = widget_create("selector", WID_ICON, s);
-	if (w != NULL) {
-		screen_add_widget(s, w);
-		w->length = ICON_SELECTOR_AT_LEFT;
-		w->x = 1;
-	}
+	if (w == NULL)
+		return;
+	screen_add_widget(s, w);
+	w->length = ICON_SELECTOR_AT_LEFT;
+	w->x = 1;
+	view.selector = w;
 
 	/* Add scrollers on the right side on top and bottom */
 	/* TODO: when menu is in a frame, these can be removed */
 	w = widget_create("upscroller", WID_ICON, s);
-	if (w != NULL) {
-		screen_add_widget(s, w);
-		w->length = ICON_ARROW_UP;
-		w->x = display_props->width;
-		w->y = 1;
-	}
+	if (w == NULL)
+		return;
+	screen_add_widget(s, w);
+	w->length = ICON_ARROW_UP;
+	w->x = display_props->width;
+	w->y = 1;
+	view.upscroller = w;
 
 	w = widget_create("downscroller", WID_ICON, s);
-	if (w != NULL) {
-		screen_add_widget(s, w);
-		w->length = ICON_ARROW_DOWN;
-		w->x = display_props->width;
-		w->y = display_props->height;
+	if (w == NULL)
+		return;
+	screen_add_widget(s, w);
+	w->length = ICON_ARROW_DOWN;
+	w->x = display_props->width;
+	w->y = display_props->height;
+	view.downscroller = w;
+
+	/* Remember the visible items; the screen is rebuilt whenever
+	 * an item of the menu is added, removed or modified */
+	count = 0;
+	for (subitem = LL_IterFirst(menu->data.menu.contents, &it);
+	     subitem != NULL;
+	     subitem = LL_IterNext(&it)) {
+		if (subitem->is_hidden)
+			continue;
+		if (count >= view.items_size) {
+			int size = (view.items_size > 0) ? 2 * view.items_size : 16;
+			MenuItem **items = realloc(view.items, size * sizeof(MenuItem *));
+
+			if (items == NULL) {
+				report(RPT_ERR, "%s: Could not allocate memory", __FUNCTION__);
+				return;
+			}
+			view.items = items;
+			view.items_size = size;
+		}
+		view.items[count++] = subitem;
 	}
+	menu->data.menu.visible_count = count;
+
+	view.menu = menu;
+	view.screen = s;
+}
+
+
+/**
+ * Show a menu item on the widgets of a display line.
+ * \param subitem  Item to show.
+ * \param text     String widget of the line.
+ * \param icon     Icon widget of the line, used by checkboxes.
+ */
+static void
+menu_fill_line(MenuItem *subitem, Widget *text, Widget *icon)
+{
+	char buf[LCD_MAX_WIDTH+1];
+	char value[LCD_MAX_WIDTH+1];
+	char *p;
+	int len = display_props->width - 1;
+
+	buf[0] = '\0';
+	icon->type = WID_NONE;
+
+	switch (subitem->type) {
+	  case MENUITEM_CHECKBOX:
+		/* Limit string length */
+		snprintf(buf, display_props->width - 1, "%s", subitem->text);
 
+		/* Update icon value for checkbox */
+		icon->type = WID_ICON;
+		icon->length = ((int[]){ICON_CHECKBOX_OFF,ICON_CHECKBOX_ON,ICON_CHECKBOX_GRAY})[subitem->data.checkbox.value];
+		break;
+	  case MENUITEM_RING:
+		p = LL_GetByIndex(subitem->data.ring.strings, subitem->data.ring.value);
+		fill_labeled_value(buf, len, subitem->text, p, LV_VALUE_ONLY);
+		break;
+	  case MENUITEM_MENU:
+		/* Limit string length */
+		snprintf(buf, display_props->width, "%s >", subitem->text);
+		break;
+	  case MENUITEM_ACTION:
+		/* Limit string length */
+		snprintf(buf, display_props->width, "%s", subitem->text);
+		break;
+	  case MENUITEM_SLIDER:
+		snprintf(value, display_props->width, "%d", subitem->data.slider.value);
+		fill_labeled_value(buf, len, subitem->text, value, LV_LABEL_VALU);
+		break;
+	  case MENUITEM_NUMERIC:
+		snprintf(value, display_props->width, "%d", subitem->data.numeric.value);
+		fill_labeled_value(buf, len, subitem->text, value, LV_LABEL_VALU);
+		break;
+	  case MENUITEM_ALPHA:
+		fill_labeled_value(buf, len, subitem->text, subitem->data.alpha.value, LV_LABEL_VALU);
+		break;
+	  case MENUITEM_IP:
+		fill_labeled_value(buf, len, subitem->text, subitem->data.ip.value, LV_LABEL_ALUE);
+		break;
+	  default:
+		assert(!"unexpected menuitem type");
+		buf[0] = '\0';
+		break;
+	}
+	text->type = WID_STRING;
+	widget_set_text(text, buf, strlen(buf));
 }
 
 
 void menu_update_screen(MenuItem *menu, Screen *s)
 {
-	Widget *w;
-	MenuItem *subitem;
-	int itemnr;
-	int hidden_count = 0;
+	int line;
+	int scroll;
+	int count;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], screen=[%s])", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"),
@@ -493,107 +592,46 @@ void menu_update_screen(MenuItem *menu, Screen *s)
 	if ((menu == NULL) || (s == NULL))
 		return;
 
-	/* Update widgets for the title */
-	w = screen_find_widget(s, "title");
-	if (w == NULL)
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "title");
-	w->y = 1 - menu->data.menu.scroll;
+	if ((view.menu != menu) || (view.screen != s)) {
+		report(RPT_ERR, "%s: widgets of menu %s not built", __FUNCTION__, menu->id);
+		return;
+	}
+
+	scroll = menu->data.menu.scroll;
+	count = menu_visible_item_count(menu);
+
+	/* Update widget for the title */
+	view.title->y = 1 - scroll;
 
 	/* TODO: remove next 3 limes when rendering is safe */
-	w->type = ((w->y > 0) && (w->y <= display_props->height))
+	view.title->type = ((view.title->y > 0) && (view.title->y <= display_props->height))
 		  ? WID_TITLE
 		  : WID_NONE;	/* make invisible */
 
-	/* Update widgets for each subitem in the menu */
-	for (subitem = LL_GetFirst(menu->data.menu.contents), itemnr = 0;
-	     subitem != NULL;
-	     subitem = LL_GetNext(menu->data.menu.contents), itemnr ++)
-	{
-		char buf[LCD_MAX_WIDTH];	// long enough for "icon%d" and such
-		char *p;
-		int len = display_props->width - 1;
-
-		if (subitem->is_hidden) {
-			debug(RPT_DEBUG, "%s: menu %s has hidden menu: %s",
-			      __FUNCTION__, menu->id, subitem->id);
-			hidden_count++;
-			continue;
-		}
-		snprintf(buf, sizeof(buf)-1, "text%d", itemnr);
-		buf[sizeof(buf)-1] = '\0';
-		w = screen_find_widget(s, buf);
-		if (w == NULL)
-			report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, buf);
-		w->y = 2 + itemnr - hidden_count - menu->data.menu.scroll;
-
-		/* TODO: remove next 3 lines when rendering is safe */
-		w->type = ((w->y > 0) && (w->y <= display_props->height))
-			  ? WID_STRING
-			  : WID_NONE;	/* make invisible */
+	/* Update the lines with the items scrolled into view */
+	for (line = 0; line < display_props->height; line++) {
+		int index = line - 1 + scroll;
 
-		switch (subitem->type) {
-		  case MENUITEM_CHECKBOX:
-			/* Update icon value for checkbox */
-			snprintf(buf, sizeof(buf)-1, "icon%d", itemnr);
-			buf[sizeof(buf)-1] = '\0';
-			w = screen_find_widget(s, buf);
-			if (w == NULL)
-				report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, buf);
-			w->y = 2 + itemnr - menu->data.menu.scroll;
-			w->length = ((int[]){ICON_CHECKBOX_OFF,ICON_CHECKBOX_ON,ICON_CHECKBOX_GRAY})[subitem->data.checkbox.value];
-
-			/* TODO: remove next 3 lines when rendering is safe */
-			w->type = ((w->y > 0) && (w->y <= display_props->height))
-				  ? WID_ICON
-				  : WID_NONE;	/* make invisible */
-			break;
-		  case MENUITEM_RING:
-			p = LL_GetByIndex(subitem->data.ring.strings, subitem->data.ring.value);
-			fill_labeled_value(w->text, len, subitem->text, p, LV_VALUE_ONLY);
-
-			break;
-		    case MENUITEM_SLIDER:
-			snprintf(buf, display_props->width, "%d", subitem->data.slider.value);
-			buf[display_props->width-1] = '\0';
-			fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_NUMERIC:
-			snprintf(buf, display_props->width, "%d", subitem->data.numeric.value);
-			buf[display_props->width-1] = '\0';
-			fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_ALPHA:
-			fill_labeled_value(w->text, len, subitem->text, subitem->data.alpha.value, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_IP:
-			fill_labeled_value(w->text, len, subitem->text, subitem->data.ip.value, LV_LABEL_ALUE);
-		    	break;
-		  default:
-                      break;
+		if ((index < 0) || (index >= count)) {
+			view.text[line]->type = WID_NONE;
+			view.icon[line]->type = WID_NONE;
+			continue;
 		}
+		menu_fill_line(view.items[index], view.text[line], view.icon[line]);
 	}
 
 	/* Update selector position */
-	w = screen_find_widget(s, "selector");
-	if (w != NULL)
-		w->y = 2 + menu->data.menu.selector_pos - menu->data.menu.scroll;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "selector");
+	view.selector->y = 2 + menu->data.menu.selector_pos - scroll;
 
 	/* Enable upscroller (if necessary) */
-	w = screen_find_widget(s, "upscroller");
-	if (w != NULL)
-		w->type = (menu->data.menu.scroll > 0) ? WID_ICON : WID_NONE;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "upscroller");
+	view.upscroller->type = (scroll > 0) ? WID_ICON : WID_NONE;
 
 	/* Enable downscroller (if necessary) */
-	w = screen_find_widget(s, "downscroller");
-	if (w != NULL)
-		w->type = (menu_visible_item_count(menu) >= menu->data.menu.scroll + display_props->height)
-			? WID_ICON : WID_NONE;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "downscroller");
+	view.downscroller->type = (count >= scroll + display_props->height)
+		? WID_ICON : WID_NONE;
+
+	/* Only called on navigation and changes of the menu */
+	widget_changed(view.title);
 }
 
 
@@ -79,6 +79,10 @@ MenuItem *menu_get_current_item(Menu *menu);
 /** Finds an item in the menu by the given id. */
 MenuItem *menu_find_item(Menu *menu, char *id, bool recursive);
 
+/** Forgets the number of visible items of a menu, e.g. because the
+ * visibility of one of its items changed. */
+void menu_invalidate_visible_count(Menu *menu);
+
 /** sets the association member of a Menu. */
 void menu_set_association(Menu *menu, void *assoc);
 
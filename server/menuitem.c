@@ -673,6 +673,14 @@ void menuitem_rebuild_screen(MenuItem *item, Screen *s)
 	}
 }
 
+/* Set the text of a widget on a menu screen and note the change */
+static void
+menuitem_set_widget_text(Widget *w, const char *text)
+{
+	if ((w != NULL) && (widget_set_text(w, text, strlen(text)) > 0))
+		widget_changed(w);
+}
+
 void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 {
 	Widget *w;
@@ -688,7 +696,7 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 		/* Only add a title if enough space... */
 		w = widget_create("text", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup(item->text);
+		menuitem_set_widget_text(w, item->text);
 		w->x = 1;
 		w->y = 1;
 	}
@@ -707,7 +715,6 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 
 	w = widget_create("min", WID_STRING, s);
 	screen_add_widget(s, w);
-	w->text = NULL;
 	w->x = 1;
 	if (display_props->height > 2) {
 		w->y = display_props->height / 2 + 2;
@@ -717,7 +724,6 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 
 	w = widget_create("max", WID_STRING, s);
 	screen_add_widget(s, w);
-	w->text = NULL;
 	w->x = 1;
 	if (display_props->height > 2) {
 		w->y = display_props->height / 2 + 2;
@@ -741,14 +747,14 @@ void menuitem_rebuild_screen_numeric(MenuItem *item, Screen *s)
 		/* Only add a title if enough space... */
 		w = widget_create("text", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup(item->text);
+		menuitem_set_widget_text(w, item->text);
 		w->x = 1;
 		w->y = 1;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
-	w->text = malloc(MAX_NUMERIC_LEN);
+	menuitem_set_widget_text(w, "");
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
 
@@ -756,7 +762,7 @@ void menuitem_rebuild_screen_numeric(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup("");
+		menuitem_set_widget_text(w, "");
 		w->x = 1;
 		w->y = display_props->height;
 	}
@@ -777,14 +783,14 @@ void menuitem_rebuild_screen_alpha(MenuItem *item, Screen *s)
 		/* Only add a title if enough space... */
 		w = widget_create("text", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup(item->text);
+		menuitem_set_widget_text(w, item->text);
 		w->x = 1;
 		w->y = 1;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
-	w->text = malloc(item->data.alpha.maxlength+1);
+	menuitem_set_widget_text(w, "");
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
 
@@ -792,7 +798,7 @@ void menuitem_rebuild_screen_alpha(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup("");
+		menuitem_set_widget_text(w, "");
 		w->x = 1;
 		w->y = display_props->height;
 	}
@@ -813,14 +819,14 @@ void menuitem_rebuild_screen_ip(MenuItem *item, Screen *s)
 		/* Only add a title if enough space... */
 		w = widget_create("text", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup(item->text);
+		menuitem_set_widget_text(w, item->text);
 		w->x = 1;
 		w->y = 1;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
-	w->text = malloc(item->data.ip.maxlength+1);
+	menuitem_set_widget_text(w, "");
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
 
@@ -828,7 +834,7 @@ void menuitem_rebuild_screen_ip(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
-		w->text = strdup("");
+		menuitem_set_widget_text(w, "");
 		w->x = 1;
 		w->y = display_props->height;
 	}
@@ -894,13 +900,11 @@ void menuitem_update_screen_slider(MenuItem *item, Screen *s)
 		/ (item->data.slider.maxvalue - item->data.slider.minvalue);
 
 	w = screen_find_widget(s, "min");
-	if (w->text) free(w->text);
-	w->text = strdup(item->data.slider.mintext);
+	menuitem_set_widget_text(w, item->data.slider.mintext);
 
 	w = screen_find_widget(s, "max");
-	if (w->text) free(w->text);
 	w->x = 1 + display_props->width - max_len;
-	w->text = strdup(item->data.slider.maxtext);
+	menuitem_set_widget_text(w, item->data.slider.maxtext);
 }
 
 void menuitem_update_screen_numeric(MenuItem *item, Screen *s)
@@ -915,7 +919,7 @@ void menuitem_update_screen_numeric(MenuItem *item, Screen *s)
 		return;
 
 	w = screen_find_widget(s, "value");
-	strcpy(w->text, item->data.numeric.edit_str + item->data.numeric.edit_offs);
+	menuitem_set_widget_text(w, item->data.numeric.edit_str + item->data.numeric.edit_offs);
 
 	s->cursor = CURSOR_DEFAULT_ON;
 	s->cursor_x = w->x + item->data.numeric.edit_pos - item->data.numeric.edit_offs;
@@ -924,8 +928,7 @@ void menuitem_update_screen_numeric(MenuItem *item, Screen *s)
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
 		w = screen_find_widget(s, "error");
-		free(w->text);
-		w->text = strdup(error_strs[item->data.numeric.error_code]);
+		menuitem_set_widget_text(w, error_strs[item->data.numeric.error_code]);
 	}
 }
 
@@ -942,12 +945,17 @@ void menuitem_update_screen_alpha(MenuItem *item, Screen *s)
 
 	w = screen_find_widget(s, "value");
 	if (item->data.alpha.password_char == '\0') {
-		strcpy(w->text, item->data.alpha.edit_str + item->data.alpha.edit_offs);
+		menuitem_set_widget_text(w, item->data.alpha.edit_str + item->data.alpha.edit_offs);
 	} else {
 		int len = strlen(item->data.alpha.edit_str) - item->data.alpha.edit_offs;
+		char *hidden = malloc(len + 1);
 
-		memset(w->text, item->data.alpha.password_char, len);
-		w->text[len] = '\0';
+		if (hidden != NULL) {
+			memset(hidden, item->data.alpha.password_char, len);
+			hidden[len] = '\0';
+			menuitem_set_widget_text(w, hidden);
+			free(hidden);
+		}
 	}
 
 	s->cursor = CURSOR_DEFAULT_ON;
@@ -957,8 +965,7 @@ void menuitem_update_screen_alpha(MenuItem *item, Screen *s)
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
 		w = screen_find_widget(s, "error");
-		free(w->text);
-		w->text = strdup(error_strs[item->data.alpha.error_code]);
+		menuitem_set_widget_text(w, error_strs[item->data.alpha.error_code]);
 	}
 }
 
@@ -974,8 +981,7 @@ void menuitem_update_screen_ip(MenuItem *item, Screen *s)
 		return;
 
 	w = screen_find_widget(s, "value");
-	if (w != NULL)
-		strcpy(w->text, item->data.ip.edit_str + item->data.ip.edit_offs);
+	menuitem_set_widget_text(w, item->data.ip.edit_str + item->data.ip.edit_offs);
 
 	s->cursor = CURSOR_DEFAULT_ON;
 	s->cursor_x = w->x + item->data.ip.edit_pos - item->data.ip.edit_offs;
@@ -984,8 +990,7 @@ void menuitem_update_screen_ip(MenuItem *item, Screen *s)
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
 		w = screen_find_widget(s, "error");
-		free(w->text);
-		w->text = strdup(error_strs[item->data.ip.error_code]);
+		menuitem_set_widget_text(w, error_strs[item->data.ip.error_code]);
 	}
 }
 
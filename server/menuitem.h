@@ -140,6 +140,8 @@ typedef struct MenuItem {
 			void *association;      /**< To associate an object
                                                    with this menu */
 			LinkedList *contents;	/**< What's in this menu */
+			int visible_count;	/**< Number of items that are
+						   not hidden; -1 if unknown */
 		} menu;
 		struct action {
 			/* nothing */
@@ -223,6 +223,10 @@ menuscreen_inform_item_modified(MenuItem * item)
 	debug(RPT_DEBUG, "%s(item=[%s])", __FUNCTION__,
 	      ((item != NULL) ? item->id : "(null)"));
 
+	/* The item may have been hidden or shown */
+	if (item != NULL)
+		menu_invalidate_visible_count(item->parent);
+
 	if ((active_menuitem == NULL) || (item == NULL))
 		return;
 
@@ -264,14 +268,14 @@ menuscreen_switch_item(MenuItem * new_menuitem)
 	}
 	else if (old_menuitem && !new_menuitem) {
 		/* leave menu system */
-		menuscreen->priority = PRI_HIDDEN;
+		screenlist_set_priority(menuscreen, PRI_HIDDEN);
 	}
 	else if (!old_menuitem && new_menuitem) {
 		/* Menu is becoming active */
 		menuitem_reset(active_menuitem);
 		menuitem_rebuild_screen(active_menuitem, menuscreen);
 
-		menuscreen->priority = PRI_INPUT;
+		screenlist_set_priority(menuscreen, PRI_INPUT);
 	}
 	else {
 		/* We're left with the usual case: a menu level switch */
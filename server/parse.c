@@ -25,7 +25,9 @@
 #include "clients.h"
 #include "commands/command_list.h"
 #include "parse.h"
+#include "binproto.h"
 #include "sock.h"
+#include "main.h"
 
 #define MAX_ARGUMENTS 40
 
@@ -47,7 +49,12 @@ static inline int is_closing_quote(char x, char q) {
 }
 
 
-static void parse_message(const char *str, Client *c)
+/** Split a text command line into arguments and call the command function.
+ * \param str  The command line.
+ * \param c    The client that sent it.
+ */
+void
+parse_message(const char *str, Client *c)
 {
 	typedef enum { ST_INITIAL, ST_WHITESPACE, ST_ARGUMENT, ST_FINAL } State;
 	State state = ST_INITIAL;
@@ -196,27 +203,54 @@ static void parse_message(const char *str, Client *c)
 }
 
 
-void
+int
 parse_all_client_messages(void)
 {
 	Client *c;
+	LL_iter it;
+	int n = 0;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	for (c = clients_getfirst(); c != NULL; c = clients_getnext()) {
+	/* The iterator allows destroying the current client */
+	for (c = clients_getfirst(&it); c != NULL; c = clients_getnext(&it)) {
 		char *str;
 
-		/* And parse all its messages...*/
-		for (str = client_get_message(c); str != NULL; str = client_get_message(c)) {
+		/* The replies follow the events the client has not taken yet,
+		 * so its messages wait until these are sent */
+		if (client_events_pending(c))
+			continue;
+
+		/* A sleeping client's messages wait until it wakes up */
+		if (c->sleep_until != 0) {
+			if (c->sleep_until > timer)
+				continue;
+			c->sleep_until = 0;
+			sock_send_string(c->sock, "success\n");
+		}
+
+		/* And parse all its messages, as long as no events are queued */
+		while (!client_events_pending(c) && ((str = client_get_message(c)) != NULL)) {
 			parse_message(str, c);
 			free(str);
+			n++;
 
-			if (c->state == GONE) {
-				sock_destroy_client_socket(c);
+			if ((c->state == GONE) || (c->sleep_until != 0))
 				break;
-			}
 		}
+
+		/* Binary clients keep their frames in their own buffer */
+		if (c->binary && (c->state != GONE) && (c->sleep_until == 0)
+		    && !client_events_pending(c)) {
+			if (c->inbuf_len > 0)
+				n++;
+			parse_binary_messages(c);
+		}
+
+		if (c->state == GONE)
+			sock_destroy_client_socket(c);
 	}
+	return n;
 }
 
 
@@ -12,7 +12,15 @@
 #ifndef PARSE_H
 #define PARSE_H
 
+#define INC_TYPES_ONLY 1
+#include "client.h"
+#undef INC_TYPES_ONLY
+
 // This should be pretty self-explanatory...
-void parse_all_client_messages(void);
+// Returns the number of messages handled.
+int parse_all_client_messages(void);
+
+/* Parse and execute a single text protocol command line */
+void parse_message(const char *str, Client *c);
 
 #endif
@@ -0,0 +1,239 @@
+/** \file server/rawscreen.c
+ * Shared memory character buffers ("raw screens") for local clients.
+ *
+ * Clients that mirror a complete text buffer (like lcdvc) would otherwise
+ * have to escape every changed line into a widget_set command that LCDd
+ * parses again. A raw screen is a segment of shared memory that the client
+ * writes directly. LCDd copies it into a private snapshot whenever the
+ * sequence counter in the header changed, and renders that snapshot.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "shared/report.h"
+#include "shared/defines.h"
+
+#include "screen.h"
+#include "render.h"
+#include "rawscreen.h"
+
+#if defined(HAVE_MEMFD_CREATE) && !defined(MFD_ALLOW_SEALING)
+# undef HAVE_MEMFD_CREATE
+#endif
+
+
+/** Create an anonymous file to back the shared memory.
+ * \param size  Size of the segment.
+ * \return      File descriptor, or -1 on error.
+ */
+static int
+rawscreen_create_fd(size_t size)
+{
+	int fd;
+
+#ifdef HAVE_MEMFD_CREATE
+	fd = memfd_create("LCDd-rawscreen", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd >= 0) {
+		if (ftruncate(fd, size) < 0) {
+			close(fd);
+			return -1;
+		}
+		/* Keep the client from shrinking the segment under our feet */
+		fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+		return fd;
+	}
+#endif
+	{
+		char name[] = "/tmp/LCDd-rawscreen-XXXXXX";
+
+		fd = mkstemp(name);
+		if (fd < 0)
+			return -1;
+		unlink(name);
+		if (ftruncate(fd, size) < 0) {
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+
+/** Create a raw screen.
+ * \param width   Number of columns.
+ * \param height  Number of rows.
+ * \return        Pointer to the new raw screen, NULL on error.
+ */
+RawScreen *
+rawscreen_create(int width, int height)
+{
+	RawScreen *r;
+	int y;
+
+	debug(RPT_DEBUG, "%s(width=%d, height=%d)", __FUNCTION__, width, height);
+
+	if ((width <= 0) || (height <= 0) || (width > 0xFFFF) || (height > 0xFFFF))
+		return NULL;
+
+	r = calloc(1, sizeof(RawScreen));
+	if (r == NULL) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return NULL;
+	}
+	r->width = width;
+	r->height = height;
+	r->shm_size = RAWSCREEN_SIZE(width, height);
+	r->snapshot = malloc(height * (width + 1));
+	r->scratch = malloc(height * (width + 1));
+	if ((r->snapshot == NULL) || (r->scratch == NULL)) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		free(r->snapshot);
+		free(r->scratch);
+		free(r);
+		return NULL;
+	}
+
+	r->fd = rawscreen_create_fd(r->shm_size);
+	if (r->fd < 0) {
+		report(RPT_ERR, "%s: Cannot create shared memory: %s",
+			__FUNCTION__, strerror(errno));
+		free(r->snapshot);
+		free(r->scratch);
+		free(r);
+		return NULL;
+	}
+
+	r->shm = mmap(NULL, r->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0);
+	if (r->shm == MAP_FAILED) {
+		report(RPT_ERR, "%s: Cannot map shared memory: %s",
+			__FUNCTION__, strerror(errno));
+		close(r->fd);
+		free(r->snapshot);
+		free(r->scratch);
+		free(r);
+		return NULL;
+	}
+
+	r->shm->magic = RAWSCREEN_MAGIC;
+	r->shm->version = RAWSCREEN_VERSION;
+	r->shm->header_size = sizeof(RawScreenHeader);
+	r->shm->width = width;
+	r->shm->height = height;
+	r->shm->seq = 0;
+	r->shm->cursor = CURSOR_OFF;
+	r->shm->cursor_x = 1;
+	r->shm->cursor_y = 1;
+	memset(rawscreen_cells(r->shm), ' ', width * height);
+
+	for (y = 0; y < height; y++) {
+		char *row = r->snapshot + y * (width + 1);
+
+		memset(row, ' ', width);
+		row[width] = '\0';
+	}
+	r->last_seq = 0;
+	r->cursor = CURSOR_OFF;
+	r->cursor_x = 1;
+	r->cursor_y = 1;
+
+	return r;
+}
+
+
+/** Destroy a raw screen.
+ * \param r  Raw screen to destroy.
+ */
+void
+rawscreen_destroy(RawScreen *r)
+{
+	if (r == NULL)
+		return;
+
+	munmap(r->shm, r->shm_size);
+	if (r->fd >= 0)
+		close(r->fd);
+	free(r->snapshot);
+	free(r->scratch);
+	free(r);
+}
+
+
+/** Take over the client's cells if they changed.
+ * The copy is only accepted if the sequence counter was even and unchanged
+ * while copying; otherwise the previous snapshot stays and we try again on
+ * the next frame.
+ * \param r  Raw screen.
+ * \retval 0  Snapshot unchanged.
+ * \retval 1  Snapshot updated.
+ */
+int
+rawscreen_update(RawScreen *r)
+{
+	uint32_t seq;
+	const char *cells;
+	char *tmp;
+	int cursor, cursor_x, cursor_y;
+	int x, y;
+
+	seq = r->shm->seq;
+	if ((seq == r->last_seq) || (seq & 1))
+		return 0;
+	__sync_synchronize();
+
+	/* Don't trust header_size: the client may have scribbled over it */
+	cells = (const char *) r->shm + sizeof(RawScreenHeader);
+	for (y = 0; y < r->height; y++) {
+		char *row = r->scratch + y * (r->width + 1);
+
+		memcpy(row, cells + y * r->width, r->width);
+		/* A NUL would cut the row short in drivers_string() */
+		for (x = 0; x < r->width; x++) {
+			if (row[x] == '\0')
+				row[x] = ' ';
+		}
+		row[r->width] = '\0';
+	}
+	cursor = r->shm->cursor;
+	cursor_x = r->shm->cursor_x;
+	cursor_y = r->shm->cursor_y;
+
+	__sync_synchronize();
+	if (r->shm->seq != seq)
+		return 0;
+
+	tmp = r->snapshot;
+	r->snapshot = r->scratch;
+	r->scratch = tmp;
+	r->last_seq = seq;
+
+	switch (cursor) {
+	  case CURSOR_DEFAULT_ON:
+	  case CURSOR_BLOCK:
+	  case CURSOR_UNDER:
+		r->cursor = cursor;
+		break;
+	  default:
+		r->cursor = CURSOR_OFF;
+	}
+	r->cursor_x = max(1, min(cursor_x, r->width));
+	r->cursor_y = max(1, min(cursor_y, r->height));
+
+	return 1;
+}
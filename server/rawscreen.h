@@ -0,0 +1,44 @@
+/** \file server/rawscreen.h
+ * Shared memory character buffers that local clients write directly.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef RAWSCREEN_SERVER_H
+#define RAWSCREEN_SERVER_H
+
+#include "shared/rawscreen.h"
+
+/** Server side state of a raw screen */
+typedef struct RawScreen {
+	RawScreenHeader *shm;	/**< Mapping shared with the client */
+	size_t shm_size;	/**< Size of the mapping */
+	int fd;			/**< Descriptor of the segment, -1 once handed over */
+	int width, height;	/**< Dimensions */
+	uint32_t last_seq;	/**< Sequence counter of the current snapshot */
+	char *snapshot;		/**< Consistent copy: height rows of width+1 bytes */
+	char *scratch;		/**< Copy buffer used while reading the segment */
+	int cursor;		/**< Cursor state of the snapshot */
+	int cursor_x, cursor_y;	/**< Cursor position of the snapshot */
+} RawScreen;
+
+/* Create a shared raw screen of the given size */
+RawScreen *rawscreen_create(int width, int height);
+
+/* Unmap and free a raw screen */
+void rawscreen_destroy(RawScreen *r);
+
+/* Take over the client's cells if they changed; returns 1 if they did */
+int rawscreen_update(RawScreen *r);
+
+/* Get a NUL terminated row (0-based) of the current snapshot */
+static inline const char *rawscreen_row(RawScreen *r, int y)
+{
+	return r->snapshot + y * (r->width + 1);
+}
+
+#endif
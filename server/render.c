@@ -36,16 +36,25 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/time.h>
 
 #include "shared/report.h"
 #include "shared/LL.h"
 #include "shared/defines.h"
 
+#include "main.h"
+
 #include "drivers.h"
 #include "screen.h"
 #include "screenlist.h"
 #include "widget.h"
 #include "render.h"
+#include "rawscreen.h"
+#include "cells.h"
+#include "marquee.h"
 
 #define BUFSIZE 1024	/* larger than display width => large enough */
 
@@ -60,9 +69,37 @@ int titlespeed = 1;
 int output_state = 0;
 char *server_msg_text;
 int server_msg_expire = 0;
+static int server_msg_display = 0;	/* Display the message is shown on */
+
+/** Which part of a widget list render_frame() draws */
+#define RENDER_ALL	0	/**< All widgets */
+#define RENDER_STATIC	1	/**< The widgets before the first animated one */
+#define RENDER_ANIMATED	2	/**< The first animated widget and all after it */
+
+/** Longest time a screen that does not change is not drawn, in microseconds */
+#define RENDER_MAX_IDLE	1000000
+
+/** What was drawn on a display last, see render_screen() */
+typedef struct DisplayState {
+	Screen *screen;		/**< Screen drawn; or NULL */
+	unsigned int version;	/**< Its composition key, see render_key() */
+	long next;		/**< Frame it has to be drawn again at the latest */
+	int backlight;		/**< Backlight state set */
+	int heartbeat;		/**< Heartbeat shown: -1 for none, else its phase */
+	int output;		/**< Output state set */
+	int cursor, cursor_x, cursor_y;
+	int message;		/**< A server message was shown */
+	int blank;		/**< The display was blanked */
+} DisplayState;
 
+static DisplayState displays[MAX_DISPLAYS];
 
-static void render_frame(LinkedList *list, int left, int top, int right, int bottom, int fwid, int fhgt, char fscroll, int fspeed, long timer);
+static CellBuffer *target;		/* Buffer the widgets are drawn into */
+static int composed_titlespeed = 1;	/* titlespeed of the cached compositions */
+static unsigned int render_generation = 0;	/* Changes when they are outdated */
+
+
+static int render_frame(LinkedList *list, int left, int top, int right, int bottom, int fwid, int fhgt, char fscroll, int fspeed, long timer, int pass);
 static void render_string(Widget *w, int left, int top, int right, int bottom, int fy);
 static void render_hbar(Widget *w, int left, int top, int right, int bottom, int fy);
 static void render_vbar(Widget *w, int left, int top, int right, int bottom);
@@ -70,15 +107,25 @@ static void render_pbar(Widget *w, int left, int top, int right, int bottom);
 static void render_title(Widget *w, int left, int top, int right, int bottom, long timer);
 static void render_scroller(Widget *w, int left, int top, int right, int bottom, long timer);
 static void render_num(Widget *w, int left, int top, int right, int bottom);
+static void render_clock(Widget *w, int left, int top, int right, int bottom, int fy);
+static void render_bigclock(Widget *w, int left, int top, int right, int bottom);
+static void render_raw(Screen *s);
+static void render_timed(int backlight_set, int heartbeat_set, long timer, int *backlight_state, int *heartbeat_phase);
+static unsigned int render_key(Screen *s);
+static CellBuffer *render_compose(Screen *s, long timer);
+static long render_next_change(Screen *s, long timer);
+static int render_is_animated(Widget *w, int vis_width);
 
 
 /**
  * Renders a screen. The following actions are taken in order:
  *
- * \li  Clear the screen.
+ * \li  Work out the backlight and heartbeat states.
+ * \li  Skip the frame if it would look like the one drawn last.
  * \li  Set the backlight.
  * \li  Set out-of-band data (output).
- * \li  Render the frame contents.
+ * \li  Compose the frame contents and the raw screen cells (if any).
+ * \li  Draw the composed cells on the cleared screen.
  * \li  Set the cursor.
  * \li  Draw the heartbeat.
  * \li  Show any server message.
@@ -91,19 +138,21 @@ static void render_num(Widget *w, int left, int top, int right, int bottom);
 int
 render_screen(Screen *s, long timer)
 {
+	CellBuffer *cells;
+	DisplayState *shown;
+	unsigned int key;
 	int tmp_state = 0;
-
-	debug(RPT_DEBUG, "%s(screen=[%.40s], timer=%ld)  ==== START RENDERING ====", __FUNCTION__, s->id, timer);
+	int backlight_state, heartbeat_state, heartbeat_phase, message;
+	long n;
 
 	if (s == NULL)
 		return -1;
 
-	/* 1. Clear the LCD screen... */
-	drivers_clear();
+	debug(RPT_DEBUG, "%s(screen=[%.40s], timer=%ld)  ==== START RENDERING ====", __FUNCTION__, s->id, timer);
 
-	/* 2. Set up the backlight */
+	/* 1. Find the backlight and heartbeat states */
 	/*-
-	 * 2.1:
+	 * 1.1:
 	 * First we find out who has set the backlight:
 	 *   a) the screen,
 	 *   b) the client, or
@@ -125,60 +174,66 @@ render_screen(Screen *s, long timer)
 	}
 
 	/*-
-	 * 2.2:
-	 * If one of the backlight options (FLASH or BLINK) has been set turn
-	 * it on/off based on a timed algorithm.
+	 * 1.2:
+	 * The heartbeat is found the same way.
 	 */
-	/* NOTE: dirty stripping of other options... */
-	/* Backlight flash: check timer and flip backlight as appropriate */
-	if (tmp_state & BACKLIGHT_FLASH) {
-		drivers_backlight(
-			(
-				(tmp_state & BACKLIGHT_ON)
-				^ ((timer & 7) == 7)
-			) ? BACKLIGHT_ON : BACKLIGHT_OFF);
+	if (heartbeat != HEARTBEAT_OPEN) {
+		heartbeat_state = heartbeat;
 	}
-	/* Backlight blink: check timer and flip backlight as appropriate */
-	else if (tmp_state & BACKLIGHT_BLINK) {
-		drivers_backlight(
-			(
-				(tmp_state & BACKLIGHT_ON)
-				^ ((timer & 14) == 14)
-			) ? BACKLIGHT_ON : BACKLIGHT_OFF);
+	else if ((s->client != NULL) && (s->client->heartbeat != HEARTBEAT_OPEN)) {
+		heartbeat_state = s->client->heartbeat;
+	}
+	else if (s->heartbeat != HEARTBEAT_OPEN) {
+		heartbeat_state = s->heartbeat;
 	}
 	else {
-		/* Simple: Only send lowest bit then... */
-		drivers_backlight(tmp_state & BACKLIGHT_ON);
+		heartbeat_state = heartbeat_fallback;
 	}
 
-	/* 3. Output ports from LCD - outputs depend on the current screen */
+	/*-
+	 * 1.3:
+	 * Both can change with the timer.
+	 */
+	render_timed(tmp_state, heartbeat_state, timer, &backlight_state, &heartbeat_phase);
+
+	message = (server_msg_expire > 0) && (server_msg_display == drivers_current_display());
+
+	/*
+	 * 2. Nothing to do if the screen still looks like it did the last
+	 *    time it was drawn on this display and nothing is due yet.
+	 */
+	shown = &displays[drivers_current_display()];
+	key = render_key(s);
+	if ((shown->screen == s) && (shown->version == key) && (timer < shown->next)
+	    && (shown->backlight == backlight_state) && (shown->heartbeat == heartbeat_phase)
+	    && (shown->output == output_state) && (shown->cursor == s->cursor)
+	    && (shown->cursor_x == s->cursor_x) && (shown->cursor_y == s->cursor_y)
+	    && !shown->message && !message) {
+		debug(RPT_DEBUG, "==== NOTHING CHANGED ====");
+		return 0;
+	}
+
+	/* 3. Set up the backlight */
+	drivers_backlight(backlight_state);
+
+	/* 4. Output ports from LCD - outputs depend on the current screen */
 	drivers_output(output_state);
 
-	/* 4. Draw a frame... */
-	render_frame(s->widgetlist, 0, 0,
-			display_props->width, display_props->height,
-			s->width, s->height, 'v', max(s->duration / s->height, 1), timer);
+	/* 5. Compose and draw a frame... */
+	cells = render_compose(s, timer);
+	if (cells != NULL)
+		drivers_draw_cells(cells);
+	else
+		drivers_clear();
 
-	/* 5. Set the cursor */
+	/* 6. Set the cursor */
 	drivers_cursor(s->cursor_x, s->cursor_y, s->cursor);
 
-	/* 6. Set the heartbeat */
-	if (heartbeat != HEARTBEAT_OPEN) {
-		tmp_state = heartbeat;
-	}
-	else if ((s->client != NULL) && (s->client->heartbeat != HEARTBEAT_OPEN)) {
-		tmp_state = s->client->heartbeat;
-	}
-	else if (s->heartbeat != HEARTBEAT_OPEN) {
-		tmp_state = s->heartbeat;
-	}
-	else {
-		tmp_state = heartbeat_fallback;
-	}
-	drivers_heartbeat(tmp_state);
+	/* 7. Set the heartbeat */
+	drivers_heartbeat(heartbeat_state);
 
-	/* 7. If there is an server message that is not expired, display it */
-	if (server_msg_expire > 0) {
+	/* 8. If there is an server message that is not expired, display it */
+	if (message) {
 		drivers_string(display_props->width - strlen(server_msg_text) + 1,
 				display_props->height, server_msg_text);
 		server_msg_expire--;
@@ -187,18 +242,341 @@ render_screen(Screen *s, long timer)
 		}
 	}
 
-	/* 8. Flush display out, frame and all... */
+	/* 9. Flush display out, frame and all... */
 	drivers_flush();
 
+	/* Remember what was drawn and when it has to be drawn again */
+	shown->screen = s;
+	shown->version = key;
+	shown->next = timer + ((cells != NULL) ? render_next_change(s, timer) : 1);
+	/* The blinking patterns repeat every 16 frames */
+	for (n = 1; (n <= 16) && (timer + n < shown->next); n++) {
+		int b, h;
+
+		render_timed(tmp_state, heartbeat_state, timer + n, &b, &h);
+		if ((b != backlight_state) || (h != heartbeat_phase)) {
+			shown->next = timer + n;
+			break;
+		}
+	}
+	shown->backlight = backlight_state;
+	shown->heartbeat = heartbeat_phase;
+	shown->output = output_state;
+	shown->cursor = s->cursor;
+	shown->cursor_x = s->cursor_x;
+	shown->cursor_y = s->cursor_y;
+	shown->message = message;
+	shown->blank = 0;
+
 	debug(RPT_DEBUG, "==== END RENDERING ====");
 	return 0;
 
 }
 
+
+/**
+ * Blank the current display, as when it has no screens.
+ */
+void
+render_blank(void)
+{
+	DisplayState *shown = &displays[drivers_current_display()];
+
+	if (shown->blank)
+		return;
+	drivers_clear();
+	drivers_flush();
+	memset(shown, 0, sizeof(DisplayState));
+	shown->blank = 1;
+}
+
+
+/**
+ * Forget what was drawn, so that the next frame is drawn in full.
+ * \param s  Forget only the displays showing this screen; NULL for all.
+ */
+void
+render_forget(Screen *s)
+{
+	int d;
+
+	for (d = 0; d < MAX_DISPLAYS; d++) {
+		if ((s == NULL) || (displays[d].screen == s))
+			memset(&displays[d], 0, sizeof(DisplayState));
+	}
+}
+
+
+/**
+ * Tell when a display has to be drawn next, if nothing changes until then.
+ * Displays that were never drawn, or were forgotten, are due at once.
+ * \return  Lowest timer value any display is due at; LONG_MAX if none is.
+ */
+long
+render_next_due(void)
+{
+	long due = LONG_MAX;
+	int d;
+
+	for (d = 0; d < num_displays; d++) {
+		if (!displays[d].blank)
+			due = min(due, displays[d].next);
+	}
+	return due;
+}
+
+
+/**
+ * Work out the backlight and heartbeat states shown at a frame.
+ * If one of the backlight options (FLASH or BLINK) has been set the
+ * backlight is turned on/off based on a timed algorithm. The server core
+ * animates the heartbeat with the timer, see driver_alt_heartbeat();
+ * drivers that animate it themselves need it every frame.
+ * \param backlight_set    Backlight setting in effect.
+ * \param heartbeat_set    Heartbeat setting in effect.
+ * \param timer            A value increased with every frame.
+ * \param backlight_state  Receives the backlight state to set.
+ * \param heartbeat_phase  Receives -1 for no heartbeat, else its phase.
+ */
+static void
+render_timed(int backlight_set, int heartbeat_set, long timer, int *backlight_state, int *heartbeat_phase)
+{
+	/* NOTE: dirty stripping of other options... */
+	/* Backlight flash: check timer and flip backlight as appropriate */
+	if (backlight_set & BACKLIGHT_FLASH) {
+		*backlight_state = (
+				(backlight_set & BACKLIGHT_ON)
+				^ ((timer & 7) == 7)
+			) ? BACKLIGHT_ON : BACKLIGHT_OFF;
+	}
+	/* Backlight blink: check timer and flip backlight as appropriate */
+	else if (backlight_set & BACKLIGHT_BLINK) {
+		*backlight_state = (
+				(backlight_set & BACKLIGHT_ON)
+				^ ((timer & 14) == 14)
+			) ? BACKLIGHT_ON : BACKLIGHT_OFF;
+	}
+	else {
+		/* Simple: Only send lowest bit then... */
+		*backlight_state = backlight_set & BACKLIGHT_ON;
+	}
+
+	if (heartbeat_set == HEARTBEAT_OFF)
+		*heartbeat_phase = -1;
+	else if (drivers_own_heartbeat())
+		*heartbeat_phase = (int) (timer & 0xFFFF) + 2;
+	else
+		*heartbeat_phase = ((timer & 5) != 0);
+}
+
+
+/**
+ * Work out how many frames the screen just drawn stays the same. That is
+ * until the next step of a title or scroller, or the next second if there
+ * is a clock. Anything else that is animated changes every frame. A
+ * screen that does not change is drawn again after RENDER_MAX_IDLE, for
+ * drivers that do things of their own when they are called.
+ * \param s      The screen.
+ * \param timer  A value increased with every call.
+ * \return  Number of frames, at least 1.
+ */
+static long
+render_next_change(Screen *s, long timer)
+{
+	long frames = max(RENDER_MAX_IDLE / frame_interval, 1);
+	Widget *w;
+	LL_iter it;
+
+	/* Server screens change without telling, see render_compose() */
+	if ((s->client == NULL) || (s->raw != NULL) || (s->height > display_props->height)
+	    || (server_msg_expire > 0))
+		return 1;
+	if (!s->cells_animated)
+		return frames;
+
+	LL_ForEach(s->widgetlist, it, w) {
+		long n;
+
+		if (!render_is_animated(w, display_props->width))
+			continue;
+
+		switch (w->type) {
+		case WID_TITLE:
+		case WID_SCROLLER:
+			if ((w->marquee == NULL) || !w->marquee->valid)
+				return 1;
+			n = marquee_next(w->marquee, timer);
+			if (n < 0)
+				continue;	/* stays */
+			break;
+		case WID_CLOCK:
+		case WID_BIGCLOCK:
+			{
+				struct timeval now;
+
+				gettimeofday(&now, NULL);
+				n = (1000000 - now.tv_usec + frame_interval - 1) / frame_interval;
+			}
+			break;
+		default:
+			return 1;
+		}
+		frames = min(frames, max(n, 1));
+	}
+	return frames;
+}
+
+
+/**
+ * Tell whether a widget looks different as time goes by.
+ * \param w          The widget.
+ * \param vis_width  Width of the frame it is in.
+ * \return  1 if it is animated, 0 if it only changes when it is set.
+ */
+static int
+render_is_animated(Widget *w, int vis_width)
+{
+	switch (w->type) {
+	case WID_TITLE:
+		/* Titles scroll if they don't fit, see render_title() */
+		if ((w->text == NULL) || (titlespeed <= TITLESPEED_NO))
+			return 0;
+		if ((w->marquee != NULL) && w->marquee->valid && (w->marquee->text == w->text))
+			return w->marquee->length > vis_width - 6;
+		return (int) strlen(w->text) > vis_width - 6;
+	case WID_SCROLLER:
+	case WID_FRAME:
+	case WID_CLOCK:
+	case WID_BIGCLOCK:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * Tell whether the animated widgets of a screen moved since the last frame.
+ * Only titles and scrollers remember what they showed; any other animated
+ * widget counts as moved.
+ * \param s          The screen.
+ * \param vis_width  Width of the display.
+ * \param timer      A value increased with every call.
+ * \return  1 if a widget moved, 0 if the last frame is still right.
+ */
+static int
+render_moved(Screen *s, int vis_width, long timer)
+{
+	Widget *w;
+	LL_iter it;
+
+	LL_ForEach(s->widgetlist, it, w) {
+		if (!render_is_animated(w, vis_width))
+			continue;
+		if (((w->type != WID_TITLE) && (w->type != WID_SCROLLER))
+		    || (w->marquee == NULL) || !w->marquee->valid
+		    || (w->marquee->drawn != marquee_offset(w->marquee, timer)))
+			return 1;
+	}
+	return 0;
+}
+
+
+/**
+ * Work out the key the compositions of a screen are kept under. It changes
+ * whenever the screen changes (see screen_changed()), and for all screens
+ * at once when a setting they are composed with changes.
+ * \param s  The screen.
+ * \return  The key.
+ */
+static unsigned int
+render_key(Screen *s)
+{
+	if (titlespeed != composed_titlespeed) {
+		composed_titlespeed = titlespeed;
+		render_generation++;
+	}
+	return s->version + render_generation;
+}
+
+
+/**
+ * Compose a screen into a cell buffer. The widgets before the first
+ * animated one are composed into the screen's cached buffer, which is only
+ * done again when the screen changed. If there are animated widgets the
+ * cached buffer is copied to a second one every frame and those widgets
+ * and everything after them are drawn on top.
+ * \param s      The screen.
+ * \param timer  A value increased with every call.
+ * \return  The composed buffer, or NULL on error.
+ */
+static CellBuffer *
+render_compose(Screen *s, long timer)
+{
+	int width = display_props->width;
+	int height = display_props->height;
+	int fspeed = max(s->duration / s->height, 1);
+	int composed = 0;
+	unsigned int key = render_key(s);
+
+	if ((s->cells == NULL) || (s->cells->width != width) || (s->cells->height != height)) {
+		cells_destroy(s->cells);
+		cells_destroy(s->frame_cells);
+		s->frame_cells = NULL;
+		s->cells = cells_create(width, height);
+		if (s->cells == NULL)
+			return NULL;
+		s->cells_version = key - 1;
+	}
+
+	/*
+	 * Only client screens are kept: the server changes the widgets of
+	 * its own screens without telling.
+	 */
+	if ((s->cells_version != key) || (s->client == NULL)) {
+		composed = 1;
+		target = s->cells;
+		cells_clear(target);
+		if (s->height > height)
+			s->cells_animated = 1;	/* the screen scrolls as a whole */
+		else
+			s->cells_animated = render_frame(s->widgetlist, 0, 0, width, height,
+							 s->width, s->height, 'v', fspeed,
+							 timer, RENDER_STATIC);
+		if (s->raw != NULL)
+			s->cells_animated = 1;
+		s->cells_version = key;
+	}
+	if (!s->cells_animated)
+		return s->cells;
+
+	if (s->frame_cells == NULL) {
+		s->frame_cells = cells_create(width, height);
+		if (s->frame_cells == NULL)
+			return NULL;
+	}
+	else if (!composed && (s->height <= height) && (s->raw == NULL)
+		 && !render_moved(s, width, timer)) {
+		/* The last frame still is what the screen looks like */
+		return s->frame_cells;
+	}
+	cells_copy(s->frame_cells, s->cells);
+	target = s->frame_cells;
+	render_frame(s->widgetlist, 0, 0, width, height, s->width, s->height, 'v', fspeed,
+		     timer, (s->height > height) ? RENDER_ALL : RENDER_ANIMATED);
+
+	/* Draw the cells a local client wrote to shared memory */
+	if (s->raw != NULL)
+		render_raw(s);
+
+	return s->frame_cells;
+}
+
+
 /* The following function is positively ghastly (as was mentioned above!) */
 /* Best thing to do is to remove support for frames... but anyway... */
 /* */
-static void
+static int
 render_frame(LinkedList *list,
 		int left,	/* left edge of frame */
 		int top,	/* top edge of frame */
@@ -208,9 +586,13 @@ render_frame(LinkedList *list,
 		int fhgt,	/* frame height? */
 		char fscroll,	/* direction of scrolling */
 		int fspeed,	/* speed of scrolling... */
-		long timer)	/* current timer tick */
+		long timer,	/* current timer tick */
+		int pass)	/* which widgets to draw */
 {
 	int fy = 0;		/* Scrolling offset for the frame... */
+	int animated = 0;	/* An animated widget has been seen */
+	Widget *w;
+	LL_iter it;
 
 	debug(RPT_DEBUG, "%s(list=%p, left=%d, top=%d, "
 			  "right=%d, bottom=%d, fwid=%d, fhgt=%d, "
@@ -220,7 +602,7 @@ render_frame(LinkedList *list,
 
 	/* return on no data or illegal height */
 	if ((list == NULL) || (fhgt <= 0))
-		return;
+		return 0;
 
 	if (fscroll == 'v') {		/* vertical scrolling */
 		// only set offset !=0 when fspeed is != 0 and there is something to scroll
@@ -240,15 +622,15 @@ render_frame(LinkedList *list,
 		/* TODO:  Frames don't scroll horizontally yet! */
 	}
 
-	/* reset widget list */
-	LL_Rewind(list);
-
 	/* loop over all widgets */
-	do {
-		Widget *w = (Widget *) LL_Get(list);
-
-		if (w == NULL)
-			return;
+	LL_ForEach(list, it, w) {
+		if ((pass != RENDER_ALL) && !animated && render_is_animated(w, right - left)) {
+			if (pass == RENDER_STATIC)
+				return 1;
+			animated = 1;
+		}
+		if ((pass == RENDER_ANIMATED) && !animated)
+			continue;
 
 		/* TODO:  Make this cleaner and more flexible! */
 		switch (w->type) {
@@ -265,7 +647,7 @@ render_frame(LinkedList *list,
 			render_pbar(w, left, top - fy, right, bottom);
 			break;
 		case WID_ICON:	  /* FIXME:  Icons don't work in frames! */
-			drivers_icon(w->x, w->y, w->length);
+			cells_icon(target, w->x, w->y, w->length);
 			break;
 		case WID_TITLE:	  /* FIXME:  Doesn't work quite right in frames... */
 			render_title(w, left, top, right, bottom, timer);
@@ -286,21 +668,28 @@ render_frame(LinkedList *list,
 				if ((new_left < right) && (new_top < bottom))	/* Render only if it's visible... */
 					render_frame(w->frame_screen->widgetlist, new_left, new_top,
 							new_right, new_bottom, w->width, w->height,
-							w->length, w->speed, timer);
+							w->length, w->speed, timer, RENDER_ALL);
 			}
 			break;
 		case WID_NUM:	  /* FIXME: doesn't work in frames... */
 			/* NOTE: y=10 means COLON (:) */
 			if ((w->x > 0) && (w->y >= 0) && (w->y <= 10)) {
-				drivers_num(w->x + left, w->y);
+				cells_num(target, w->x + left, w->y);
 			}
 			break;
+		case WID_CLOCK:
+			render_clock(w, left, top - fy, right, bottom, fy);
+			break;
+		case WID_BIGCLOCK: /* FIXME: doesn't work in frames... */
+			render_bigclock(w, left, top, right, bottom);
+			break;
 		case WID_NONE:
 			/* FALLTHROUGH */
 		default:
 			break;
 		}
-	} while (LL_Next(list) == 0);
+	}
+	return 0;
 }
 
 
@@ -319,7 +708,7 @@ render_string(Widget *w, int left, int top, int right, int bottom, int fy)
 		 * strings totally off-screen. Is this on purpose? (M. Dolze)
 		 */
 		w->x = min(w->x, right - left);
-		drivers_string(w->x + left, w->y + top, w->text);
+		cells_string(target, w->x + left, w->y + top, w->text);
 	}
 }
 
@@ -344,7 +733,7 @@ render_hbar(Widget *w, int left, int top, int right, int bottom, int fy)
 				   (display_props->cellwidth * len);
 		}
 
-		drivers_hbar(w->x + left, w->y + top, len, promille, BAR_PATTERN_FILLED);
+		cells_hbar(target, w->x + left, w->y + top, len, promille, BAR_PATTERN_FILLED);
 	}
 	else if (w->length < 0) {
 		/* TODO:  Rearrange stuff to get left-extending
@@ -369,7 +758,7 @@ render_vbar(Widget *w, int left, int top, int right, int bottom)
 		int full_len = display_props->height;
 		int promille = (long) 1000 * w->length / (display_props->cellheight * full_len);
 
-		drivers_vbar(w->x + left, w->y + top, full_len, promille, BAR_PATTERN_FILLED);
+		cells_vbar(target, w->x + left, w->y + top, full_len, promille, BAR_PATTERN_FILLED);
 	}
 	else if (w->length < 0) {
 		/* TODO:  Rearrange stuff to get down-extending
@@ -389,16 +778,16 @@ render_pbar(Widget *w, int left, int top, int right, int bottom)
 	if (!((w->x > 0) && (w->y > 0) && (w->width > 0)))
 		return;
 
-        drivers_pbar(w->x + left, w->y + top, w->width, w->promille,
-       		     w->begin_label, w->end_label);
+	cells_pbar(target, w->x + left, w->y + top, w->width, w->promille,
+		   w->begin_label, w->end_label);
 }
 
 static void
 render_title(Widget *w, int left, int top, int right, int bottom, long timer)
 {
 	int vis_width = right - left;
-	char str[BUFSIZE];
-	int x, width = vis_width - 6, length, delay;
+	int x, width = vis_width - 6, delay;
+	Marquee *m;
 
 	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, timer=%ld)",
 			  __FUNCTION__, w, left, top, right, bottom, timer);
@@ -406,81 +795,51 @@ render_title(Widget *w, int left, int top, int right, int bottom, long timer)
 	if ((w->text == NULL) || (vis_width < 8))
 		return;
 
-	length = strlen(w->text);
-
 	/* calculate delay from titlespeed: <=0 -> 0, [1 - infty] -> [10 - 1] */
 	delay = (titlespeed <= TITLESPEED_NO)
 		? TITLESPEED_NO
 		: max(TITLESPEED_MIN, TITLESPEED_MAX - titlespeed);
 
-	/* display leading fillers */
-	drivers_icon(w->x + left, w->y + top, ICON_BLOCK_FILLED);
-	drivers_icon(w->x + left + 1, w->y + top, ICON_BLOCK_FILLED);
+	m = marquee_update(&w->marquee, w->text, MARQUEE_TITLE, width, 1, delay);
+	if (m == NULL)
+		return;
 
-	length = min(length, sizeof(str)-1);
-	if ((length <= width) || (delay == 0)) {
+	/* display leading fillers */
+	cells_icon(target, w->x + left, w->y + top, ICON_BLOCK_FILLED);
+	cells_icon(target, w->x + left + 1, w->y + top, ICON_BLOCK_FILLED);
 
-		/* copy test starting from the beginning */
-		length = min(length, width);
-		strncpy(str, w->text, length);
-		str[length] = '\0';
+	if ((m->length <= width) || (delay == 0)) {
+		/* display text starting from the beginning */
+		cells_nstring(target, w->x + 3 + left, w->y + top, m->track, width);
 
 		/* set x value for trailing fillers */
-		x = length + 4;
+		x = min(m->length, width) + 4;
 	}
 	else {			/* Scroll the title, if it doesn't fit... */
-		int offset = timer;
-		int reverse;
-
-		/* if the delay is "too large" increase cycle length */
-		if ((delay != 0) && (delay < length / (length - width)))
-			offset /= delay;
-
-		/* reverse direction every length ticks */
-		reverse = (offset / length) & 1;
-
-		/* restrict offset to cycle length */
-		offset %= length;
-		offset = max(offset, 0);
-
-		/* if the delay is "low enough" slow down as requested */
-		if ((delay != 0) && (delay >= length / (length - width)))
-			offset /= delay;
-
-		/* restrict offset to the max. allowed offset: length - width */
-		offset = min(offset, length - width);
-
-		/* scroll backward by mirroring offset at max. offset */
-		if (reverse)
-			offset = (length - width) - offset;
-
-		/* copy test starting from offset */
-		length = min(width, sizeof(str)-1);
-		strncpy(str, w->text + offset, length);
-		str[length] = '\0';
+		m->drawn = marquee_offset(m, timer);
+		cells_nstring(target, w->x + 3 + left, w->y + top, m->track + m->drawn, width);
 
 		/* set x value for trailing fillers */
 		x = vis_width - 2;
 	}
 
-	/* display text */
-	drivers_string(w->x + 3 + left, w->y + top, str);
-
 	/* display trailing fillers */
 	for ( ; x < vis_width; x++) {
-		drivers_icon(w->x + x + left, w->y + top, ICON_BLOCK_FILLED);
+		cells_icon(target, w->x + x + left, w->y + top, ICON_BLOCK_FILLED);
 	}
 }
 
 
+/*
+ * Scrollers show a window of the track their marquee keeps, see marquee.c.
+ * Vertical scrollers show screen_width characters of the track per line,
+ * starting at the line the marquee says.
+ */
 static void
 render_scroller(Widget *w, int left, int top, int right, int bottom, long timer)
 {
-	char str[BUFSIZE];
-	int length;
-	int offset, gap;
-	int screen_width;
-	int necessaryTimeUnits = 0;
+	int screen_width, lines, i;
+	Marquee *m;
 
 	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, timer=%ld)",
 			  __FUNCTION__, w, left, top, right, bottom, timer);
@@ -488,169 +847,26 @@ render_scroller(Widget *w, int left, int top, int right, int bottom, long timer)
 	if ((w->text == NULL) || (w->right < w->left))
 		return;
 
-	screen_width = abs(w->right - w->left + 1);
-	screen_width = min(screen_width, sizeof(str)-1);
+	/* w->length is actually the direction */
+	if ((w->length != MARQUEE_WRAP) && (w->length != MARQUEE_HORIZ)
+	    && (w->length != MARQUEE_VERT))
+		return;
 
-	switch (w->length) {	/* actually, direction... */
-	case 'm': // Marquee
-		length = strlen(w->text);
-		if (length <= screen_width) {
-			/* it fits within the box, just render it */
-			drivers_string(w->left, w->top, w->text);
-			break;
-		}
+	screen_width = w->right - w->left + 1;
+	lines = w->bottom - w->top + 1;
 
-		gap = screen_width / 2;
-		length += gap; /* Allow gap between end and beginning */
+	m = marquee_update(&w->marquee, w->text, w->length, screen_width, lines, w->speed);
+	if (m == NULL)
+		return;
+	m->drawn = marquee_offset(m, timer);
 
-		if (w->speed > 0) {
-			necessaryTimeUnits = length * w->speed;
-			offset = (timer % necessaryTimeUnits) / w->speed;
-		}
-		else if (w->speed < 0) {
-			necessaryTimeUnits = length / (w->speed * -1);
-			offset = (timer % necessaryTimeUnits) * w->speed * -1;
-		}
-		else {
-			offset = 0;
-		}
-		if (offset <= length) {
-			if (gap > offset) {
-				memset(str, ' ', gap - offset);
-				strncpy(&str[gap-offset], w->text, screen_width);
-			}
-			else {
-				int room = screen_width - (length - offset);
-
-				strncpy(str, &w->text[offset-gap], screen_width);
-				if (room > 0) {
-					memset(&str[length-offset], ' ', min(room, gap));
-					room -= gap;
-					if (room > 0)
-						strncpy(&str[length-offset+gap], w->text, room);
-				}
-			}
-			str[screen_width] = '\0';
-			drivers_string(w->left, w->top, str);
-		}
-		break;
-	case 'h':
-		length = strlen(w->text) + 1;
-		if (length <= screen_width) {
-			/* it fits within the box, just render it */
-			drivers_string(w->left, w->top, w->text);
-		}
-		else {
-			int effLength = length - screen_width;
-
-			if (w->speed > 0) {
-				necessaryTimeUnits = effLength * w->speed;
-				if (((timer / necessaryTimeUnits) % 2) == 0) {
-					/* wiggle one way */
-					offset = (timer % (effLength*w->speed))
-						 / w->speed;
-				}
-				else {
-					/* wiggle the other */
-					offset = (((timer % (effLength * w->speed))
-						  - (effLength * w->speed) + 1)
-						 / w->speed) * -1;
-				}
-			}
-			else if (w->speed < 0) {
-				necessaryTimeUnits = effLength / (w->speed * -1);
-				if (((timer / necessaryTimeUnits) % 2) == 0) {
-					offset = (timer % (effLength / (w->speed * -1)))
-						 * w->speed * -1;
-				}
-				else {
-					offset = (((timer % (effLength / (w->speed * -1)))
-						  * w->speed * -1)
-						  - effLength + 1) * -1;
-				}
-			}
-			else {
-				offset = 0;
-			}
-			if (offset <= length) {
-				strncpy(str, &((w->text)[offset]), screen_width);
-				str[screen_width] = '\0';
-				drivers_string(w->left, w->top, str);
-				/*debug(RPT_DEBUG, "scroller %s : %d", str, length-offset); */
-			}
-		}
-		break;
-
-	/* FIXME:  Vert scrollers don't always seem to scroll */
-	/* back up after hitting the bottom.  They jump back to */
-	/* the top instead...  (nevermind?) */
-	case 'v':
-		length = strlen(w->text);
-		if (length <= screen_width) {
-			/* no scrolling required... */
-			drivers_string(w->left, w->top, w->text);
-		}
-		else {
-			int lines_required = (length / screen_width)
-				 + (length % screen_width ? 1 : 0);
-			int available_lines = (w->bottom - w->top + 1);
-
-			if (lines_required <= available_lines) {
-				/* easy... */
-				int i;
-
-				for (i = 0; i < lines_required; i++) {
-					strncpy(str, &((w->text)[i * screen_width]), screen_width);
-					str[screen_width] = '\0';
-					drivers_string(w->left, w->top + i, str);
-				}
-			}
-			else {
-				int effLines = lines_required - available_lines + 1;
-				int begin = 0;
-				int i = 0;
-
-				/*debug(RPT_DEBUG, "length: %d sw: %d lines req: %d  avail lines: %d  effLines: %d ",length,screen_width,lines_required,available_lines,effLines);*/
-				if (w->speed > 0) {
-					necessaryTimeUnits = effLines * w->speed;
-					if (((timer / necessaryTimeUnits) % 2) == 0) {
-						/*debug(RPT_DEBUG, "up ");*/
-						begin = (timer % (necessaryTimeUnits))
-							 / w->speed;
-					}
-					else {
-						/*debug(RPT_DEBUG, "down ");*/
-						begin = (((timer % necessaryTimeUnits)
-							 - necessaryTimeUnits + 1) / w->speed)
-							 * -1;
-					}
-				}
-				else if (w->speed < 0) {
-					necessaryTimeUnits = effLines / (w->speed * -1);
-					if (((timer / necessaryTimeUnits) % 2) == 0) {
-						begin = (timer % necessaryTimeUnits)
-							 * w->speed * -1;
-					}
-					else {
-						begin = (((timer % necessaryTimeUnits)
-							 * w->speed * -1) - effLines + 1)
-							 * -1;
-					}
-				}
-				else {
-					begin = 0;
-				}
-				/*debug(RPT_DEBUG, "rendering begin: %d  timer: %d effLines: %d",begin,timer,effLines); */
-				for (i = begin; i < begin + available_lines; i++) {
-					strncpy(str, &((w->text)[i * (screen_width)]), screen_width);
-					str[screen_width] = '\0';
-					/*debug(RPT_DEBUG, "rendering: '%s' of %s", */
-					/*str,w->text); */
-					drivers_string(w->left, w->top + (i - begin), str);
-				}
-			}
-		}
-		break;
+	if (w->length != MARQUEE_VERT) {
+		cells_nstring(target, w->left, w->top, m->track + m->drawn, screen_width);
+		return;
+	}
+	for (i = 0; (i < lines) && ((m->drawn + i) * screen_width < m->track_len); i++) {
+		cells_nstring(target, w->left, w->top + i,
+			      m->track + (m->drawn + i) * screen_width, screen_width);
 	}
 }
 
@@ -662,11 +878,103 @@ static void render_num(Widget *w, int left, int top, int right, int bottom)
 
 	/* NOTE: y=10 means COLON (:) */
 	if ((w->x > 0) && (w->y >= 0) && (w->y <= 10)) {
-		drivers_num(w->x + left, w->y);
+		cells_num(target, w->x + left, w->y);
 	}
 }
 
 
+/**
+ * Format the current local time for a clock widget.
+ * \param buf     Buffer for the result.
+ * \param size    Size of the buffer.
+ * \param format  strftime() format.
+ */
+static void
+clock_format(char *buf, int size, const char *format)
+{
+	time_t now = time(NULL);
+	struct tm tm;
+
+	localtime_r(&now, &tm);
+	if (strftime(buf, size, format, &tm) == 0)
+		buf[0] = '\0';
+}
+
+
+static void
+render_clock(Widget *w, int left, int top, int right, int bottom, int fy)
+{
+	char str[BUFSIZE];
+
+	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, fy=%d)",
+			  __FUNCTION__, w, left, top, right, bottom, fy);
+
+	if ((w->text != NULL) &&
+	    (w->x > 0) && (w->y > 0) && (w->y > fy) && (w->y <= bottom - top)) {
+		clock_format(str, sizeof(str), w->text);
+		cells_string(target, min(w->x, right - left) + left, w->y + top, str);
+	}
+}
+
+
+/*
+ * Digits are drawn as big numbers 3 columns wide and colons 1 column wide,
+ * the layout the lcdproc client's BigClock screen uses. Any other
+ * character leaves a 1 column gap.
+ */
+static void
+render_bigclock(Widget *w, int left, int top, int right, int bottom)
+{
+	char str[BUFSIZE];
+	const char *c;
+	int x = w->x;
+
+	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d)",
+			  __FUNCTION__, w, left, top, right, bottom);
+
+	if ((w->text == NULL) || (w->x <= 0))
+		return;
+
+	clock_format(str, sizeof(str), w->text);
+	for (c = str; (*c != '\0') && (x <= right - left); c++) {
+		if (isdigit((unsigned char) *c)) {
+			cells_num(target, x + left, *c - '0');
+			x += 3;
+		}
+		else if (*c == ':') {
+			cells_num(target, x + left, 10);
+			x++;
+		}
+		else
+			x++;
+	}
+}
+
+
+/**
+ * Render the shared memory cells of a raw screen. The client's buffer is
+ * only copied when its sequence counter changed; the cursor settings of the
+ * raw screen override those of the screen.
+ * \param s  The screen to render; \c s->raw must not be NULL.
+ */
+static void
+render_raw(Screen *s)
+{
+	RawScreen *r = s->raw;
+	int y, rows;
+
+	rawscreen_update(r);
+
+	rows = min(r->height, display_props->height);
+	for (y = 0; y < rows; y++)
+		cells_string(target, 1, y + 1, rawscreen_row(r, y));
+
+	s->cursor = r->cursor;
+	s->cursor_x = r->cursor_x;
+	s->cursor_y = r->cursor_y;
+}
+
+
 int
 server_msg(const char *text, int expire)
 {
@@ -688,6 +996,7 @@ server_msg(const char *text, int expire)
 	strcat(server_msg_text, text);
 
 	server_msg_expire = expire;
+	server_msg_display = drivers_current_display();
 
 	return 0;
 }
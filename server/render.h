@@ -40,6 +40,15 @@ extern int output_state;
 /* Render the given screen. */
 int render_screen(Screen *s, long timer);
 
+/* Blank the current display */
+void render_blank(void);
+
+/* Draw the next frame in full; s is the screen that changed, or NULL */
+void render_forget(Screen *s);
+
+/* Timer value any display has to be drawn again at */
+long render_next_due(void);
+
 /* Display a short message, which must be shorter than 16 chars, in a corner */
 int server_msg(const char *text, int expire);
 
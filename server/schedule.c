@@ -0,0 +1,232 @@
+/** \file server/schedule.c
+ * Client commands that are executed at a later render tick.
+ *
+ * The commands of the \c after and \c at commands wait in a binary min-heap
+ * ordered by the tick they are due at. The main loop calls schedule_run()
+ * in every rendering stroke, which costs a single comparison as long as
+ * nothing is due. Commands that are due at the same tick run in the order
+ * they were scheduled.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+
+#include "shared/report.h"
+#include "shared/sockets.h"
+
+#include "client.h"
+#include "parse.h"
+#include "main.h"
+#include "schedule.h"
+
+/** A scheduled command */
+typedef struct ScheduleEntry {
+	long tick;		/**< Render tick the command is due at */
+	unsigned long seq;	/**< Order of scheduling, for equal ticks */
+	Client *client;		/**< Client that scheduled it */
+	char *command;		/**< Command line */
+} ScheduleEntry;
+
+static ScheduleEntry *heap = NULL;
+static int heap_len = 0;
+static int heap_size = 0;
+static unsigned long next_seq = 0;
+
+
+static inline int
+entry_before(const ScheduleEntry *a, const ScheduleEntry *b)
+{
+	return (a->tick < b->tick) || ((a->tick == b->tick) && (a->seq < b->seq));
+}
+
+static void
+sift_up(int i)
+{
+	ScheduleEntry e = heap[i];
+
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+
+		if (!entry_before(&e, &heap[parent]))
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = e;
+}
+
+static void
+sift_down(int i)
+{
+	ScheduleEntry e = heap[i];
+
+	while (2 * i + 1 < heap_len) {
+		int child = 2 * i + 1;
+
+		if ((child + 1 < heap_len) && entry_before(&heap[child + 1], &heap[child]))
+			child++;
+		if (!entry_before(&heap[child], &e))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = e;
+}
+
+
+/**
+ * Convert a delay to the render tick it ends at. Delays are rounded up to
+ * whole frames, so a command is never executed early.
+ * \param delay_ms  Delay from now in milliseconds.
+ * \return  Value of the render timer at the end of the delay.
+ */
+long
+schedule_tick(long delay_ms)
+{
+	long frame_ms = frame_interval / 1000;
+
+	if (frame_ms < 1)
+		frame_ms = 1;
+	if (delay_ms < 0)
+		delay_ms = 0;
+	return timer + (delay_ms + frame_ms - 1) / frame_ms;
+}
+
+
+/**
+ * Schedule a command line of a client.
+ * \param c        The client.
+ * \param tick     Render tick the command is due at.
+ * \param command  The command line; it is copied.
+ * \retval 0   Success.
+ * \retval -1  The client has too many commands scheduled, or out of memory.
+ */
+int
+schedule_add(Client *c, long tick, const char *command)
+{
+	char *copy;
+
+	if (c->scheduled >= SCHEDULE_MAX_PER_CLIENT)
+		return -1;
+
+	if (heap_len == heap_size) {
+		int size = (heap_size > 0) ? 2 * heap_size : 16;
+		ScheduleEntry *h = realloc(heap, size * sizeof(ScheduleEntry));
+
+		if (h == NULL) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			return -1;
+		}
+		heap = h;
+		heap_size = size;
+	}
+
+	copy = strdup(command);
+	if (copy == NULL) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		return -1;
+	}
+
+	heap[heap_len].tick = tick;
+	heap[heap_len].seq = next_seq++;
+	heap[heap_len].client = c;
+	heap[heap_len].command = copy;
+	sift_up(heap_len++);
+	c->scheduled++;
+
+	debug(RPT_DEBUG, "%s: [%d] at tick %ld: %s", __FUNCTION__, c->sock, tick, command);
+	return 0;
+}
+
+
+/**
+ * Execute the commands that are due, without sending their replies. A
+ * command that schedules another one for the same tick gets it executed in
+ * the same call.
+ * \param tick  Current value of the render timer.
+ * \return  Number of commands executed.
+ */
+int
+schedule_run(long tick)
+{
+	int n = 0;
+
+	while ((heap_len > 0) && (heap[0].tick <= tick)) {
+		ScheduleEntry e = heap[0];
+
+		heap[0] = heap[--heap_len];
+		if (heap_len > 0)
+			sift_down(0);
+
+		e.client->scheduled--;
+		/* A client that sent bye is destroyed by the next processing stroke.
+		 * The reply is dropped: the client would take it for the reply
+		 * to the command it sent last. */
+		if (e.client->state == ACTIVE) {
+			sock_mute(e.client->sock);
+			parse_message(e.command, e.client);
+			sock_mute(-1);
+		}
+		free(e.command);
+		n++;
+	}
+	return n;
+}
+
+
+/**
+ * Tell when the next command is due.
+ * \return  Render tick of the earliest command, or LONG_MAX if there is none.
+ */
+long
+schedule_next(void)
+{
+	return (heap_len > 0) ? heap[0].tick : LONG_MAX;
+}
+
+
+/**
+ * Forget the commands of a client.
+ * \param c  The client.
+ */
+void
+schedule_drop_client(Client *c)
+{
+	int i, n = 0;
+
+	if (c->scheduled == 0)
+		return;
+
+	for (i = 0; i < heap_len; i++) {
+		if (heap[i].client == c)
+			free(heap[i].command);
+		else
+			heap[n++] = heap[i];
+	}
+	heap_len = n;
+	c->scheduled = 0;
+
+	for (i = heap_len / 2 - 1; i >= 0; i--)
+		sift_down(i);
+}
+
+
+/** Forget all commands and free the heap. */
+void
+schedule_shutdown(void)
+{
+	int i;
+
+	for (i = 0; i < heap_len; i++)
+		free(heap[i].command);
+	free(heap);
+	heap = NULL;
+	heap_len = heap_size = 0;
+}
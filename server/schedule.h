@@ -0,0 +1,39 @@
+/** \file server/schedule.h
+ * Client commands that are executed at a later render tick.
+ */
+
+/* This file is part of LCDd, the lcdproc server.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#define INC_TYPES_ONLY 1
+#include "client.h"
+#undef INC_TYPES_ONLY
+
+/** Maximum number of commands a client can have scheduled at a time */
+#define SCHEDULE_MAX_PER_CLIENT	64
+
+/* Convert a delay in milliseconds to the render tick it ends at */
+long schedule_tick(long delay_ms);
+
+/* Schedule a command line of a client for the given render tick */
+int schedule_add(Client *c, long tick, const char *command);
+
+/* Execute the commands that are due at the given render tick */
+int schedule_run(long tick);
+
+/* Render tick the next command is due at */
+long schedule_next(void);
+
+/* Forget the commands of a client that goes away */
+void schedule_drop_client(Client *c);
+
+/* Forget all commands */
+void schedule_shutdown(void);
+
+#endif
@@ -28,6 +28,8 @@
 #include "menuscreens.h"
 #include "main.h"
 #include "render.h"
+#include "rawscreen.h"
+#include "cells.h"
 
 int  default_duration = 0;
 int  default_timeout  = -1;
@@ -96,6 +98,23 @@ screen_create(char *id, Client *client)
 		return NULL;
 	}
 
+	/* The client is told when the screen is shown and hidden */
+	if (client != NULL) {
+		s->listen_event = malloc(strlen(id) + sizeof("listen \n"));
+		s->ignore_event = malloc(strlen(id) + sizeof("ignore \n"));
+		if ((s->listen_event == NULL) || (s->ignore_event == NULL)) {
+			report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+			free(s->listen_event);
+			free(s->ignore_event);
+			LL_Destroy(s->widgetlist);
+			free(s->id);
+			free(s);
+			return NULL;
+		}
+		sprintf(s->listen_event, "listen %s\n", id);
+		sprintf(s->ignore_event, "ignore %s\n", id);
+	}
+
 	menuscreen_add_screen(s);
 
 	return s;
@@ -115,6 +134,7 @@ screen_destroy(Screen *s)
 	menuscreen_remove_screen(s);
 
 	screenlist_remove(s);
+	render_forget(s);
 
 	for (w = LL_GetFirst(s->widgetlist); w; w = LL_GetNext(s->widgetlist)) {
 		/* Free a widget...*/
@@ -122,6 +142,13 @@ screen_destroy(Screen *s)
 	}
 	LL_Destroy(s->widgetlist);
 
+	rawscreen_destroy(s->raw);
+	cells_destroy(s->cells);
+	cells_destroy(s->frame_cells);
+
+	if (s->handle)
+		client_drop_handle(s->client, s->handle);
+
 	if (s->id != NULL)
 		free(s->id);
 
@@ -131,6 +158,8 @@ screen_destroy(Screen *s)
 	if (s->keys != NULL)
 		free(s->keys);
 
+	free(s->listen_event);
+	free(s->ignore_event);
 	free(s);
 }
 
@@ -147,6 +176,7 @@ screen_add_widget(Screen *s, Widget *w)
 	debug(RPT_DEBUG, "%s(s=[%.40s], widget=[%.40s])", __FUNCTION__, s->id, w->id);
 
 	LL_Push(s->widgetlist, (void *) w);
+	s->version++;
 
 	return 0;
 }
@@ -164,7 +194,44 @@ screen_remove_widget(Screen *s, Widget *w)
 	debug(RPT_DEBUG, "%s(s=[%.40s], widget=[%.40s])", __FUNCTION__, s->id, w->id);
 
 	LL_Remove(s->widgetlist, (void *) w, NEXT);
+	s->version++;
+
+	return 0;
+}
+
+
+/** Note that a screen has changed: its size, its scrolling or one of its
+ * widgets. It is composed and drawn again.
+ * \param s  Screen.
+ */
+void
+screen_changed(Screen *s)
+{
+	if (s != NULL)
+		s->version++;
+}
+
+
+/** Move a screen to another logical display. The screen takes the size
+ * of the new display.
+ * \param s        The screen.
+ * \param display  Number of the display.
+ * \retval <0  Error: there is no such display.
+ * \retval  0  Success.
+ */
+int
+screen_set_display(Screen *s, int display)
+{
+	DisplayProps *props = drivers_display_props(display);
+
+	debug(RPT_DEBUG, "%s(s=[%.40s], display=%d)", __FUNCTION__, s->id, display);
+
+	if ((props == NULL) || (screenlist_set_display(s, display) < 0))
+		return -1;
 
+	s->width = props->width;
+	s->height = props->height;
+	screen_changed(s);
 	return 0;
 }
 
@@ -178,6 +245,7 @@ Widget *
 screen_find_widget(Screen *s, char *id)
 {
 	Widget *w;
+	LL_iter it;
 
 	if (!s)
 		return NULL;
@@ -186,7 +254,7 @@ screen_find_widget(Screen *s, char *id)
 
 	debug(RPT_DEBUG, "%s(s=[%.40s], id=\"%.40s\")", __FUNCTION__, s->id, id);
 
-	for (w = LL_GetFirst(s->widgetlist); w != NULL; w = LL_GetNext(s->widgetlist)) {
+	LL_ForEach(s->widgetlist, it, w) {
 		if (0 == strcmp(w->id, id)) {
 			debug(RPT_DEBUG, "%s: Found %s", __FUNCTION__, id);
 			return w;
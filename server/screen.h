@@ -54,6 +54,16 @@ typedef struct Screen {
 	int keys_size;
 	LinkedList *widgetlist;
 	struct Client *client;
+	struct RawScreen *raw;		/**< Shared memory cells; or NULL */
+	int handle;			/**< Binary protocol handle; or 0 */
+	unsigned int version;		/**< Incremented when widgets change */
+	int display;			/**< Logical display the screen is shown on */
+	struct CellBuffer *cells;	/**< Composed widgets up to the first animated one */
+	struct CellBuffer *frame_cells;	/**< Composed frame, if there are animated widgets */
+	unsigned int cells_version;	/**< Version of the screen \c cells shows */
+	int cells_animated;		/**< The screen has animated widgets */
+	char *listen_event;		/**< "listen <id>\\n" for the client; or NULL */
+	char *ignore_event;		/**< "ignore <id>\\n" for the client; or NULL */
 } Screen;
 
 extern int  default_duration ;
@@ -97,6 +107,12 @@ static inline Widget *screen_getnext_widget(Screen *s)
 }
 
 
+/* Note that a screen or one of its widgets has changed */
+void screen_changed(Screen *s);
+
+/* Move a screen to another display */
+int screen_set_display(Screen *s, int display);
+
 /* Find a widget in a screen */
 Widget *screen_find_widget(Screen *s, char *id);
 
@@ -13,7 +13,9 @@
  */
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "shared/LL.h"
 #include "shared/sockets.h"
@@ -22,27 +24,109 @@
 #include "client.h"
 #include "screen.h"
 #include "screenlist.h"
+#include "drivers.h"
 
 #include "main.h" /* for timer */
 
-/* Local functions */
-int compare_priority(void *one, void *two);
+/** Number of priority classes */
+#define NUM_PRIORITIES	(PRI_INPUT + 1)
 
 int autorotate = UNSET_INT;	/* If on, INFO and FOREGROUND screens will rotate */
-LinkedList *screenlist = NULL;
-Screen *current_screen = NULL;
-long int current_screen_start_time = 0;
+
+/* Every logical display has its own screen list and rotation. The screens
+ * are kept in one queue per priority class, so the screen to show can be
+ * found without sorting. The current screen is always at the head of its
+ * queue; rotating means moving the head to the tail. */
+typedef struct ScreenList {
+	LinkedList *queues[NUM_PRIORITIES];
+	Screen *current;		/**< Screen shown, or NULL */
+	long int start_time;		/**< Timer value when it was switched to */
+	long int processed;		/**< Timer value when it was processed last */
+} ScreenList;
+
+static ScreenList lists[MAX_DISPLAYS];
+
+/** Screen list of the display a screen is shown on */
+#define LIST_OF(s)	(&lists[(s)->display])
+/** Screen list of the selected display */
+#define SELECTED_LIST	(&lists[drivers_current_display()])
+
+
+/** Find the head of the highest non-empty priority class.
+ * \return  The screen, or NULL if there are no screens.
+ */
+static Screen *
+screenlist_top(ScreenList *l)
+{
+	int pri;
+
+	for (pri = NUM_PRIORITIES - 1; pri >= 0; pri--) {
+		Screen *s = LL_Look(l->queues[pri]);
+
+		if (s != NULL)
+			return s;
+	}
+	return NULL;
+}
+
+
+/** Rotate the screen's queue until the screen is at its head.
+ * The order of the screens in the class does not change.
+ */
+static void
+screenlist_bring_to_head(Screen *s)
+{
+	LinkedList *q = LIST_OF(s)->queues[s->priority];
+	int n;
+
+	for (n = LL_Length(q); (n > 0) && (LL_Look(q) != s); n--)
+		LL_Push(q, LL_Shift(q));
+}
+
+
+/** Move on to the next or previous screen of a display. */
+static int
+screenlist_step(ScreenList *l, int forward)
+{
+	LinkedList *q;
+
+	if (!l->current)
+		return -1;
+
+	/* One step forward: the current screen goes to the end of its class.
+	 * One step back: the last screen of the class comes first. */
+	q = l->queues[l->current->priority];
+	if (LL_Look(q) == l->current) {
+		if (forward)
+			LL_Push(q, LL_Shift(q));
+		else
+			LL_Unshift(q, LL_Pop(q));
+	}
+
+	/* Continue in the highest class (normally the current one) */
+	screenlist_switch(screenlist_top(l));
+	return 0;
+}
 
 
 int
 screenlist_init(void)
 {
+	int d, pri;
+
 	report(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	screenlist = LL_new();
-	if (!screenlist) {
-		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
-		return -1;
+	for (d = 0; d < MAX_DISPLAYS; d++) {
+		for (pri = 0; pri < NUM_PRIORITIES; pri++) {
+			lists[d].queues[pri] = LL_new();
+			if (!lists[d].queues[pri]) {
+				report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+				return -1;
+			}
+		}
+		lists[d].current = NULL;
+		lists[d].start_time = 0;
+		lists[d].processed = 0;
 	}
 	return 0;
 }
@@ -51,13 +135,20 @@ screenlist_init(void)
 int
 screenlist_shutdown(void)
 {
+	int d, pri;
+
 	report(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	if (!screenlist) {
+	if (!lists[0].queues[0]) {
 		/* Program shutdown before completed startup */
 		return -1;
 	}
-	LL_Destroy(screenlist);
+	for (d = 0; d < MAX_DISPLAYS; d++) {
+		for (pri = 0; pri < NUM_PRIORITIES; pri++) {
+			LL_Destroy(lists[d].queues[pri]);
+			lists[d].queues[pri] = NULL;
+		}
+	}
 
 	return 0;
 }
@@ -66,58 +157,108 @@ screenlist_shutdown(void)
 int
 screenlist_add(Screen *s)
 {
-	if (!screenlist)
+	if (!lists[0].queues[0] || !s)
 		return -1;
-	return LL_Push(screenlist, s);
+	return LL_Push(LIST_OF(s)->queues[s->priority], s);
 }
 
 
 int
 screenlist_remove(Screen *s)
 {
+	ScreenList *l;
+	void *res;
+
 	debug(RPT_DEBUG, "%s(s=[%.40s])", __FUNCTION__, s->id);
 
-	if (!screenlist)
+	if (!lists[0].queues[0])
 		return -1;
 
+	l = LIST_OF(s);
+
 	/* Are we trying to remove the current screen ? */
-	if (s == current_screen) {
-		screenlist_goto_next();
-		if (s == current_screen) {
+	if (s == l->current) {
+		screenlist_step(l, 1);
+		if (s == l->current) {
 			/* Hmm, no other screen had same priority */
-			void *res = LL_Remove(screenlist, s, NEXT);
+			res = LL_Remove(l->queues[s->priority], s, NEXT);
 			/* And now once more */
-			screenlist_goto_next();
+			screenlist_switch(screenlist_top(l));
+			if (s == l->current)
+				l->current = NULL;
 			return (res == NULL) ? -1 : 0;
 		}
 	}
-	return (LL_Remove(screenlist, s, NEXT) == NULL) ? -1 : 0;
+	return (LL_Remove(l->queues[s->priority], s, NEXT) == NULL) ? -1 : 0;
+}
+
+
+void
+screenlist_set_priority(Screen *s, Priority priority)
+{
+	LinkedList **queues = LIST_OF(s)->queues;
+
+	if (s->priority == priority)
+		return;
+
+	/* Move it to the other queue, if it is in the screenlist at all */
+	if (queues[0] && (LL_Remove(queues[s->priority], s, NEXT) != NULL)) {
+		s->priority = priority;
+		LL_Push(queues[priority], s);
+		if (s == LIST_OF(s)->current)
+			screenlist_bring_to_head(s);
+	}
+	else {
+		s->priority = priority;
+	}
+}
+
+
+int
+screenlist_set_display(Screen *s, int display)
+{
+	int listed;
+
+	if ((display < 0) || (display >= num_displays))
+		return -1;
+	if (s->display == display)
+		return 0;
+
+	/* Take it out of the old display's list, if it is in one at all */
+	listed = (screenlist_remove(s) == 0);
+	s->display = display;
+	if (listed)
+		screenlist_add(s);
+	return 0;
 }
 
 
 void
 screenlist_process(void)
 {
+	ScreenList *l = SELECTED_LIST;
 	Screen *s;
 	Screen *f;
+	long int elapsed;
 
 	report(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	if (!screenlist)
+	if (!l->queues[0])
 		return;
-	/* Sort the list according to priority class */
-	LL_Sort(screenlist, compare_priority);
-	f = LL_GetFirst(screenlist);
+
+	/* The list is not processed on every tick, see screenlist_next_due() */
+	elapsed = timer - l->processed;
+	l->processed = timer;
 
 	/**** First we need to check out the current situation. ****/
 
 	/* Check whether there is an active screen */
-	s = screenlist_current();
+	s = l->current;
 	if (!s) {
 		/* We have no active screen yet.
 		 * Try to switch to the first screen in the list... */
 
-		s = f;
+		s = screenlist_top(l);
 		if (!s) {
 			/* There was no screen in the list */
 			return;
@@ -128,16 +269,18 @@ screenlist_process(void)
 	else {
 		/* There already was an active screen.
 		 * Check to see if it has an expiry time. If so, decrease it
-		 * and then check to see if it has expired. Remove the screen
-		 * if expired. */
+		 * by the time gone by and then check to see if it has expired.
+		 * Remove the screen if expired. */
 		if (s->timeout != -1) {
-			--(s->timeout);
+			s->timeout -= (int) min(elapsed, s->timeout);
 			report(RPT_DEBUG, "Active screen [%.40s] has timeout->%d", s->id, s->timeout);
 			if (s->timeout <= 0) {
-				/* Expired, we can destroy it */
+				/* Expired, we can destroy it; removing it
+				 * already switched to the next screen */
 				report(RPT_DEBUG, "Removing expired screen [%.40s]", s->id);
 				client_remove_screen(s->client, s);
 				screen_destroy(s);
+				return;
 			}
 		}
 	}
@@ -146,7 +289,8 @@ screenlist_process(void)
 
 	/* Is there a screen of a higher priority class than the
 	 * current one ? */
-	if (f->priority > s->priority) {
+	f = screenlist_top(l);
+	if ((f != NULL) && (f->priority > s->priority)) {
 		/* Yes, switch to that screen, job done */
 		report(RPT_DEBUG, "%s: High priority screen [%.40s] selected", __FUNCTION__, f->id);
 		screenlist_switch(f);
@@ -156,35 +300,57 @@ screenlist_process(void)
 	/* Current screen has been visible long enough and is it of 'normal'
 	 * priority ?
 	 */
-	if (autorotate && (timer - current_screen_start_time >= s->duration)
+	if (autorotate && (timer - l->start_time >= s->duration)
 	&& s->priority > PRI_BACKGROUND && s->priority <= PRI_FOREGROUND) {
 		/* Ah, rotate! */
-		screenlist_goto_next();
+		screenlist_step(l, 1);
 	}
 }
 
 
+long
+screenlist_next_due(void)
+{
+	ScreenList *l = SELECTED_LIST;
+	Screen *s = l->current;
+	long int due = LONG_MAX;
+
+	if (!l->queues[0] || !s)
+		return due;
+
+	if (s->timeout != -1)
+		due = l->processed + s->timeout;
+
+	/* Rotating to the same screen again changes nothing */
+	if (autorotate && s->priority > PRI_BACKGROUND && s->priority <= PRI_FOREGROUND
+	    && (LL_Length(l->queues[s->priority]) > 1))
+		due = min(due, l->start_time + s->duration);
+	return due;
+}
+
+
 void
 screenlist_switch(Screen *s)
 {
+	ScreenList *l;
 	Client *c;
-	char str[256];
 
 	if (!s) return;
 
 	report(RPT_DEBUG, "%s(s=[%.40s])", __FUNCTION__, s->id);
 
-	if (s == current_screen) {
+	l = LIST_OF(s);
+	if (s == l->current) {
 		/* Nothing to be done */
 		return;
 	}
 
-	if (current_screen) {
-		c = current_screen->client;
+	if (l->current) {
+		c = l->current->client;
 		if (c) {
 			/* Tell the client we're not listening any more...*/
-			snprintf(str, sizeof(str), "ignore %s\n", current_screen->id);
-			sock_send_string(c->sock, str);
+			client_send_event(c, l->current->ignore_event,
+					  strlen(l->current->ignore_event));
 		} else {
 			/* It's a server screen, no need to inform it. */
 		}
@@ -192,97 +358,37 @@ screenlist_switch(Screen *s)
 	c = s->client;
 	if (c) {
 		/* Tell the client we're paying attention...*/
-		snprintf(str, sizeof(str), "listen %s\n", s->id);
-		sock_send_string(c->sock, str);
+		client_send_event(c, s->listen_event, strlen(s->listen_event));
 	} else {
 		/* It's a server screen, no need to inform it. */
 	}
 	report(RPT_INFO, "%s: switched to screen [%.40s]", __FUNCTION__, s->id);
-	current_screen = s;
-	current_screen_start_time = timer;
+	l->current = s;
+	l->start_time = timer;
+	screenlist_bring_to_head(s);
 }
 
 
 Screen *
 screenlist_current(void)
 {
-	return current_screen;
+	return SELECTED_LIST->current;
 }
 
 
 int
 screenlist_goto_next(void)
 {
-	Screen *s;
-
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	if (!current_screen)
-		return -1;
-
-	/* Find current screen in screenlist */
-	for (s = LL_GetFirst(screenlist); s && s != current_screen; s = LL_GetNext(screenlist))
-		;
-
-	/* One step forward */
-	s = LL_GetNext(screenlist);
-	if (!s || s->priority < current_screen->priority) {
-		/* To far, go back to start of screenlist */
-		s = LL_GetFirst(screenlist);
-	}
-	screenlist_switch(s);
-	return 0;
+	return screenlist_step(SELECTED_LIST, 1);
 }
 
 
 int
 screenlist_goto_prev(void)
 {
-	Screen *s;
-
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	if (!current_screen)
-		return -1;
-
-	/* Find current screen in screenlist */
-	for (s = LL_GetFirst(screenlist); s && s != current_screen; s = LL_GetNext(screenlist));
-
-	/* One step back */
-	s = LL_GetPrev(screenlist);
-	if (!s) {
-		/* We're at the start of the screenlist. We should find the
-		 * last screen with the same priority as the first screen.
-		 */
-		Screen *f = LL_GetFirst(screenlist);
-		Screen *n;
-
-		s = f;
-		while ((n = LL_GetNext(screenlist)) && n->priority == f->priority) {
-			s = n;
-		}
-	}
-	screenlist_switch(s);
-	return 0;
-}
-
-/* Internal function for sorting. */
-int
-compare_priority(void *one, void *two)
-{
-	Screen *a, *b;
-
-	/*debug(RPT_DEBUG, "compare_priority: %8x %8x", one, two);*/
-
-	if (!one)
-		return 0;
-	if (!two)
-		return 0;
-
-	a = (Screen *) one;
-	b = (Screen *) two;
-
-	/*debug(RPT_DEBUG, "compare_priority: done?");*/
-
-	return (b->priority - a->priority);
+	return screenlist_step(SELECTED_LIST, 0);
 }
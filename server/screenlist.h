@@ -35,16 +35,27 @@ int screenlist_add(Screen *s);
 int screenlist_remove(Screen *s);
 	/* Removes a screen from the screenlist. */
 
+void screenlist_set_priority(Screen *s, Priority priority);
+	/* Changes the priority class of a screen. ALWAYS USE THIS FUNCTION
+	 * TO CHANGE THE PRIORITY of a screen that may be in the screenlist. */
+
+int screenlist_set_display(Screen *s, int display);
+	/* Moves a screen to the screenlist of an other display. */
+
 void screenlist_process(void);
-	/* Processes the screenlist. Decides if we need to switch to an other
-	 * screen. */
+	/* Processes the screenlist of the selected display. Decides if we
+	 * need to switch to an other screen. */
+
+long screenlist_next_due(void);
+	/* Returns the timer value screenlist_process() has something to do
+	 * at on the selected display, if nothing changes until then. */
 
 void screenlist_switch(Screen *s);
 	/* Switches to an other screen in the proper way. Informs clients of
 	 * the switch. ALWAYS USE THIS FUNCTION TO SWITCH SCREENS. */
 
 Screen *screenlist_current(void);
-	/* Returns the currently active screen. */
+	/* Returns the currently active screen of the selected display. */
 
 int screenlist_goto_next(void);
 	/* Moves on to the next screen. */
@@ -50,6 +50,7 @@ static int has_hello_msg = 0;
 
 /* file-local function declarations */
 static int reset_server_screen(int rotate, int heartbeat, int title);
+static void set_server_line(char *id, const char *text);
 
 
 /**
@@ -89,7 +90,10 @@ server_screen_init(void)
 		screen_add_widget(server_screen, w);
 		w->x = 1;
 		w->y = i+1;
-		w->text = calloc(LCD_MAX_WIDTH+1, 1);
+		if (widget_set_text(w, "", 0) < 0) {
+			report(RPT_ERR, "server_screen_init: Can't allocate widget text");
+			return -1;
+		}
 	}
 
 	/* set parameters for server_screen and it's widgets */
@@ -105,10 +109,8 @@ server_screen_init(void)
 
 			sprintf(id, "line%d", i+1);
 			w = screen_find_widget(server_screen, id);
-			if ((w != NULL) && (w->text != NULL)) {
-				strncpy(w->text, line, LCD_MAX_WIDTH);
-				w->text[LCD_MAX_WIDTH] = '\0';
-			}
+			if (w != NULL)
+				widget_set_text(w, line, LCD_MAX_WIDTH);
 		}
 	}
 
@@ -143,7 +145,7 @@ update_server_screen(void)
 {
 	static int hello_done = 0;
 	Client *c;
-	Widget *w;
+	LL_iter it;
 	int num_clients = 0;
 	int num_screens = 0;
 
@@ -170,40 +172,48 @@ update_server_screen(void)
 	}
 
 	/* ... and screens */
-	for (c = clients_getfirst(); c != NULL; c = clients_getnext()) {
+	for (c = clients_getfirst(&it); c != NULL; c = clients_getnext(&it)) {
 		num_screens += client_screen_count(c);
 	}
 
 	/* update statistics if we do not only want to show a blank screen */
 	if (rotate_server_screen != SERVERSCREEN_BLANK) {
 		/* format strings for the appropriate display size ... */
+		char line[LCD_MAX_WIDTH+1];
+
 		if (display_props->height >= 3) {	/* >2-line display */
-			w = screen_find_widget(server_screen, "line2");
-			if ((w != NULL) && (w->text != NULL)) {
-				snprintf(w->text, LCD_MAX_WIDTH,
-						"Clients: %i", num_clients);
-			}
-
-			w = screen_find_widget(server_screen, "line3");
-			if ((w != NULL) && (w->text != NULL)) {
-				snprintf(w->text, LCD_MAX_WIDTH,
-						"Screens: %i", num_screens);
-			}
+			snprintf(line, sizeof(line), "Clients: %i", num_clients);
+			set_server_line("line2", line);
+
+			snprintf(line, sizeof(line), "Screens: %i", num_screens);
+			set_server_line("line3", line);
 		} else {				/* 2-line display */
-			w = screen_find_widget(server_screen, "line2");
-			if ((w != NULL) && (w->text != NULL)) {
-				snprintf(w->text, LCD_MAX_WIDTH,
-						((display_props->width >= 16)
-						 ? "Cli: %i  Scr: %i"
-						 : "C: %i  S: %i"),
-						num_clients, num_screens);
-			}
+			snprintf(line, sizeof(line),
+					((display_props->width >= 16)
+					 ? "Cli: %i  Scr: %i"
+					 : "C: %i  S: %i"),
+					num_clients, num_screens);
+			set_server_line("line2", line);
 		}
 	}
 	return 0;
 }
 
 
+/** Set the text of a line of the server screen if it differs.
+ * \param id    Id of the line's widget.
+ * \param text  New text.
+ */
+static void
+set_server_line(char *id, const char *text)
+{
+	Widget *w = screen_find_widget(server_screen, id);
+
+	if ((w != NULL) && (widget_set_text(w, text, LCD_MAX_WIDTH) > 0))
+		widget_changed(w);
+}
+
+
 /**
  * Writes the default or a custom goodbye message defined in the config file
  * to the screen. Default message is centered on the screen while the custom
@@ -272,8 +282,8 @@ reset_server_screen(int rotate, int heartbeat, int title)
 
 	server_screen->heartbeat = (heartbeat && (rotate != SERVERSCREEN_BLANK))
 					? HEARTBEAT_OPEN : HEARTBEAT_OFF;
-	server_screen->priority = (rotate == SERVERSCREEN_ON)
-					? PRI_INFO : PRI_BACKGROUND;
+	screenlist_set_priority(server_screen, (rotate == SERVERSCREEN_ON)
+					       ? PRI_INFO : PRI_BACKGROUND);
 
 	for (i = 0; i < display_props->height; i++) {
 		char id[8];
@@ -287,13 +297,9 @@ reset_server_screen(int rotate, int heartbeat, int title)
 			w->type = ((i == 0) && (title) && (rotate != SERVERSCREEN_BLANK))
 					? WID_TITLE : WID_STRING;
 
-			if (w->text != NULL) {
-				w->text[0] = '\0';
-				if ((i == 0) && (title) && (rotate != SERVERSCREEN_BLANK)) {
-					strncpy(w->text, "LCDproc Server", LCD_MAX_WIDTH);
-					w->text[LCD_MAX_WIDTH] = '\0';
-				}
-			}
+			widget_set_text(w, ((i == 0) && (title) && (rotate != SERVERSCREEN_BLANK))
+					   ? "LCDproc Server" : "", LCD_MAX_WIDTH);
+			widget_changed(w);
 		}
 	}
 	return 0;
@@ -34,20 +34,25 @@
 #include <arpa/inet.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <string.h>
 
 #include "shared/report.h"
 #include "shared/sring.h"
 #include "shared/defines.h"
+#include "shared/configfile.h"
+#include "shared/binproto.h"
 
 #include "clients.h"
 #include "sock.h"
 
 
 /****************************************************************************/
-static fd_set active_fd_set, read_fd_set;
+static fd_set active_fd_set, read_fd_set, write_fd_set;
 static int listening_fd;
+static int unix_listening_fd = -1;
+static char *unix_socket_path = NULL;
 
 /* For efficiency we maintain a list of open sockets. Nodes in this list
  * are obtained from a pre-allocated pool - this removes heap operations
@@ -77,7 +82,8 @@ ClientSocketMap *freeClientSocketPool;
 
 /**** Internal function declarations ****************************************/
 static int sock_read_from_client(ClientSocketMap *clientSocketMap);
-static void sock_destroy_socket(void);
+static int sock_read_binary_from_client(Client *c);
+static void sock_destroy_socket(ClientSocketMap *entry);
 
 
 /** Initialize sockets.
@@ -91,6 +97,7 @@ int
 sock_init(char* bind_addr, int bind_port)
 {
 	int i;
+	const char *path;
 
 	debug(RPT_DEBUG, "%s(bind_addr=\"%s\", port=%d)", __FUNCTION__, bind_addr, bind_port);
 
@@ -102,6 +109,18 @@ sock_init(char* bind_addr, int bind_port)
 		return -1;
 	}
 
+	/* Optionally also listen on a Unix domain socket for local clients */
+	path = config_get_string("server", "UnixSocket", 0, "");
+	if (path[0] != '\0') {
+		unix_listening_fd = sock_create_unix_socket(path);
+		if (unix_listening_fd < 0) {
+			report(RPT_ERR, "%s: error creating Unix socket %s",
+				__FUNCTION__, path);
+			return -1;
+		}
+		unix_socket_path = strdup(path);
+	}
+
 	/* Create the socket -> Client mapping pool */
 	/* How large can FD_SETSIZE be? Even if it is ~2000 this only uses a
 	   few kilobytes of memory. Let's trade size for speed! */
@@ -137,6 +156,13 @@ sock_init(char* bind_addr, int bind_port)
 		entry->socket = listening_fd;
 		entry->client = NULL;
 		LL_AddNode(openSocketList, (void*) entry);
+
+		if (unix_listening_fd >= 0) {
+			entry = (ClientSocketMap*) LL_Pop(freeClientSocketList);
+			entry->socket = unix_listening_fd;
+			entry->client = NULL;
+			LL_Push(openSocketList, (void*) entry);
+		}
 	}
 
 	if ((messageRing = sring_create(MAXMSG)) == NULL) {
@@ -180,6 +206,11 @@ sock_shutdown(void)
                   LL_Destroy(openSocketList);
         */
 	close(listening_fd);
+	if (unix_listening_fd >= 0) {
+		close(unix_listening_fd);
+		unlink(unix_socket_path);
+		free(unix_socket_path);
+	}
 	LL_Destroy(freeClientSocketList);
 	free(freeClientSocketPool);
 	sring_destroy(messageRing);
@@ -247,52 +278,142 @@ sock_create_inet_socket(char *addr, unsigned int port)
 }
 
 
+/** Create a Unix domain socket, bind to it and listen on it.
+ * Clients connected through this socket are local and may use the
+ * features that need descriptor passing (e.g. raw screens).
+ * \param path      File system path of the socket.
+ * \retval  <0      error
+ * \retval >=0      the socket
+ */
+int
+sock_create_unix_socket(const char *path)
+{
+	struct sockaddr_un name;
+	int sock;
+
+	debug(RPT_DEBUG, "%s(path=\"%s\")", __FUNCTION__, path);
+
+	if (strlen(path) >= sizeof(name.sun_path)) {
+		report(RPT_ERR, "%s: socket path too long: %s", __FUNCTION__, path);
+		return -1;
+	}
+
+	sock = socket(PF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		report(RPT_ERR, "%s: cannot create socket - %s",
+			__FUNCTION__, sock_geterror());
+		return -1;
+	}
+
+	memset(&name, 0, sizeof(name));
+	name.sun_family = AF_UNIX;
+	strcpy(name.sun_path, path);
+
+	/* Remove a stale socket left behind by a previous instance */
+	unlink(path);
+
+	if (bind(sock, (struct sockaddr *) &name, sizeof(name)) < 0) {
+		report(RPT_ERR, "%s: cannot bind to %s - %s",
+			__FUNCTION__, path, sock_geterror());
+		close(sock);
+		return -1;
+	}
+	/* Same policy as the TCP port: everybody on this host may connect */
+	chmod(path, 0666);
+
+	if (listen(sock, 1) < 0) {
+		report(RPT_ERR, "%s: error in attempting to listen on %s - %s",
+			__FUNCTION__, path, sock_geterror());
+		close(sock);
+		return -1;
+	}
+
+	report(RPT_NOTICE, "Listening for queries on %s", path);
+
+	FD_SET(sock, &active_fd_set);
+
+	return sock;
+}
+
+
+/** Check whether a client socket is a local (Unix domain) connection.
+ * \param fd  Socket to check.
+ * \return    1 if local, 0 otherwise.
+ */
+int
+sock_is_local(int fd)
+{
+	struct sockaddr_storage addr;
+	socklen_t size = sizeof(addr);
+
+	if (getsockname(fd, (struct sockaddr *) &addr, &size) < 0)
+		return 0;
+	return (addr.ss_family == AF_UNIX) ? 1 : 0;
+}
+
+
 /** Service all clients with pending input.
  * \retval  <0       error
- * \retval   0       success
+ * \retval  >=0      success: the number of clients that connected or went away
  */
 int
 sock_poll_clients(void)
 {
 	struct timeval t;
 	ClientSocketMap* clientSocket;
+	LL_iter it;
+	int n = 0;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
 	t.tv_sec = 0;
 	t.tv_usec = 0;
 
-	/* Block until input arrives on one or more active sockets. */
+	/* Check for input on all sockets, and whether the clients with events
+	 * they could not take before can take more */
 	read_fd_set = active_fd_set;
+	FD_ZERO(&write_fd_set);
+	LL_ForEach(openSocketList, it, clientSocket) {
+		if ((clientSocket->client != NULL) && (clientSocket->client->outbuf_len > 0))
+			FD_SET(clientSocket->socket, &write_fd_set);
+	}
 
-	if (select(FD_SETSIZE, &read_fd_set, NULL, NULL, &t) < 0) {
+	if (select(FD_SETSIZE, &read_fd_set, &write_fd_set, NULL, &t) < 0) {
 		report(RPT_ERR, "%s: Select error - %s",
 			__FUNCTION__, sock_geterror());
 		return -1;
 	}
 
+	/* Send the waiting events; the clients' replies follow once they are out */
+	LL_ForEach(openSocketList, it, clientSocket) {
+		if (FD_ISSET(clientSocket->socket, &write_fd_set))
+			client_flush_events(clientSocket->client);
+	}
+
 	/* Service all the sockets with input pending. */
-	LL_Rewind(openSocketList);
-	for (clientSocket = (ClientSocketMap *) LL_Get(openSocketList);
-	     clientSocket != NULL;
-	     clientSocket = LL_GetNext(openSocketList)) {
+	LL_ForEach(openSocketList, it, clientSocket) {
 
 		if (FD_ISSET(clientSocket->socket, &read_fd_set)) {
-			if (clientSocket->socket == listening_fd) {
+			if ((clientSocket->socket == listening_fd)
+			    || (clientSocket->socket == unix_listening_fd)) {
 				/* Connection request on original socket. */
 				Client *c;
 				int new_sock;
 				struct sockaddr_in clientname;
 				socklen_t size = sizeof(clientname);
 
-				new_sock = accept(listening_fd, (struct sockaddr *) &clientname, &size);
+				new_sock = accept(clientSocket->socket, (struct sockaddr *) &clientname, &size);
 				if (new_sock < 0) {
 					report(RPT_ERR, "%s: Accept error - %s",
 						__FUNCTION__, sock_geterror());
 					return -1;
 				}
-				report(RPT_NOTICE, "Connect from host %s:%hu on socket %i",
-					inet_ntoa(clientname.sin_addr), ntohs(clientname.sin_port), new_sock);
+				if (clientSocket->socket == unix_listening_fd)
+					report(RPT_NOTICE, "Connect from local socket %s on socket %i",
+						unix_socket_path, new_sock);
+				else
+					report(RPT_NOTICE, "Connect from host %s:%hu on socket %i",
+						inet_ntoa(clientname.sin_addr), ntohs(clientname.sin_port), new_sock);
 				FD_SET(new_sock, &active_fd_set);
 
 				fcntl(new_sock, F_SETFL, O_NONBLOCK);
@@ -310,9 +431,8 @@ sock_poll_clients(void)
 					if (newClientSocket != NULL) {
 						newClientSocket->socket = new_sock;
 						newClientSocket->client = c;
-						LL_InsertNode(openSocketList, (void *) newClientSocket);
-						/* advance past the new node - check it on the next pass */
-						LL_Next(openSocketList);
+						/* not in read_fd_set: it is checked on the next pass */
+						LL_Push(openSocketList, (void *) newClientSocket);
 					}
 					else {
 						report(RPT_ERR, "%s: Error - free client socket list exhausted - %d clients.",
@@ -325,18 +445,21 @@ sock_poll_clients(void)
 						 __FUNCTION__, clientSocket->socket);
 					return -1;
 				}
+				n++;
 			}
 			else {	/* Data arriving on an already-connected socket. */
 				int err = 0;
 				debug(RPT_DEBUG, "%s: reading...", __FUNCTION__);
 				err = sock_read_from_client(clientSocket);
 				debug(RPT_DEBUG, "%s: ...done", __FUNCTION__);
-				if (err < 0)
-					sock_destroy_socket();
+				if (err < 0) {
+					sock_destroy_socket(clientSocket);
+					n++;
+				}
 			}
 		}
 	}
-	return 0;
+	return n;
 }
 
 
@@ -352,6 +475,9 @@ sock_read_from_client(ClientSocketMap *clientSocketMap)
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
+	if ((clientSocketMap->client != NULL) && clientSocketMap->client->binary)
+		return sock_read_binary_from_client(clientSocketMap->client);
+
 	errno = 0;
 	nbytes = sock_recv(clientSocketMap->socket, buffer, MAXMSG);
 
@@ -396,6 +522,40 @@ sock_read_from_client(ClientSocketMap *clientSocketMap)
 }
 
 
+/** Read binary frames from a client's socket into the client's own buffer.
+ * Frames are not split into messages here; parse.c consumes them directly
+ * from the buffer.
+ * \retval  <0       error
+ * \retval   0       success
+ */
+static int
+sock_read_binary_from_client(Client *c)
+{
+	int nbytes;
+
+	do {
+		int room = BINPROTO_BUFFER_SIZE - c->inbuf_len;
+
+		/* A full buffer holds at least one complete frame. Leave the
+		 * rest in the socket until that has been parsed. */
+		if (room == 0)
+			return 0;
+
+		errno = 0;
+		nbytes = sock_recv(c->sock, c->inbuf + c->inbuf_len, room);
+		if (nbytes > 0) {
+			debug(RPT_DEBUG, "%s: received %4d bytes", __FUNCTION__, nbytes);
+			c->inbuf_len += nbytes;
+		}
+	} while (nbytes > 0);
+
+	if (nbytes < 0 && errno == EAGAIN)
+		return 0;		/* No data is not an error */
+
+	return -1;			/* EOF */
+}
+
+
 /* comparison function to find a ClientsocketMap entry by client */
 int byClient(void *csm, void *client)
 {
@@ -417,20 +577,19 @@ sock_destroy_client_socket(Client *client)
 	entry = LL_Find(openSocketList, byClient, client);
 
 	if (entry != NULL) {
-		sock_destroy_socket();
+		sock_destroy_socket(entry);
 		return 0;
 	}
 	return -1;
 }
 
 
-/** Close the socket the openSocketList's \c current pointer points to.
+/** Close a client's socket and remove it from the openSocketList.
+ * \param entry  The socket's entry in the openSocketList.
  */
 static void
-sock_destroy_socket(void)
+sock_destroy_socket(ClientSocketMap *entry)
 {
-	ClientSocketMap *entry = LL_Get(openSocketList);
-
 	if (entry != NULL) {
 		if (entry->client != NULL) {
 			report(RPT_NOTICE, "Client on socket %i disconnected",
@@ -448,7 +607,7 @@ sock_destroy_socket(void)
 		close(entry->socket);
 
 		/* re-add socket to the free socket pool */
-		entry = (ClientSocketMap *) LL_DeleteNode(openSocketList, PREV);
+		LL_Remove(openSocketList, entry, NEXT);
 		LL_Push(freeClientSocketList, (void*) entry);
 	}
 }
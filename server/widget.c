@@ -22,10 +22,14 @@
 
 #include "shared/sockets.h"
 #include "shared/report.h"
+#include "shared/str.h"
 
+#include "client.h"
 #include "screen.h"
 #include "widget.h"
 #include "render.h"
+#include "marquee.h"
+#include "drivers.h"
 #include "drivers/lcd.h"
 
 char *typenames[] = {
@@ -39,6 +43,8 @@ char *typenames[] = {
 	"scroller",	/* WID_SCROLLER */
 	"frame",	/* WID_FRAME */
 	"num",		/* WID_NUM */
+	"clock",	/* WID_CLOCK */
+	"bigclock",	/* WID_BIGCLOCK */
 	NULL,		/* WID_NONE */
 };
 
@@ -124,15 +130,176 @@ widget_destroy(Widget *w)
 
 	free(w->id);
 	free(w->text);
+	free(w->begin_label);
+	free(w->end_label);
+	marquee_destroy(w->marquee);
 
 	/* Free subscreen of frame widget too */
 	if (w->type == WID_FRAME)
 		screen_destroy(w->frame_screen);
 
+	if (w->handle)
+		client_drop_handle(w->screen->client, w->handle);
+
 	free(w);
 }
 
 
+/** Tell whether the client owning a widget sends UTF-8 text. */
+static int
+widget_utf8(Widget *w)
+{
+	return ((w->screen != NULL) && (w->screen->client != NULL)
+		&& w->screen->client->utf8);
+}
+
+
+/**
+ * Copy a string into a buffer owned by a widget.
+ * The buffer is reused as long as the string fits. It is allocated large
+ * enough for a display line, so only scrollers with long texts make it grow.
+ * \param buf   Pointer to the buffer; may point to NULL.
+ * \param size  Pointer to the number of bytes allocated for \c *buf.
+ * \param src   String to copy; NULL frees the buffer.
+ * \param len   Maximum number of bytes to copy from \c src.
+ * \param utf8  \c src is UTF-8 and is converted to ISO 8859-1.
+ * \retval <0   Error: out of memory; the buffer is unchanged.
+ * \retval  0   The buffer already contained the string.
+ * \retval  1   The string was copied.
+ */
+static int
+widget_copy_text(char **buf, int *size, const char *src, int len, int utf8)
+{
+	static char *conv = NULL;
+	static int conv_size = 0;
+	int min_size = (display_props != NULL) ? display_props->width + 1 : 1;
+
+	if (src == NULL) {
+		if (*buf == NULL)
+			return 0;
+		free(*buf);
+		*buf = NULL;
+		*size = 0;
+		return 1;
+	}
+
+	len = strnlen(src, len);
+
+	if (utf8) {
+		/* the conversion never makes the text longer */
+		if (len > conv_size) {
+			char *p = realloc(conv, len);
+
+			if (p == NULL)
+				return -1;
+			conv = p;
+			conv_size = len;
+		}
+		len = utf8_to_latin1(conv, src, len);
+		src = conv;
+	}
+
+	/* strncmp() only succeeds if *buf has len non-NUL bytes too */
+	if ((*buf != NULL) && (strncmp(*buf, src, len) == 0) && ((*buf)[len] == '\0'))
+		return 0;
+
+	if (len + 1 > *size) {
+		int new_size = len + 1;
+		char *p;
+
+		if (new_size < min_size)
+			new_size = min_size;
+		if (new_size < 2 * *size)
+			new_size = 2 * *size;
+
+		p = realloc(*buf, new_size);
+		if (p == NULL)
+			return -1;
+		*buf = p;
+		*size = new_size;
+	}
+	memcpy(*buf, src, len);
+	(*buf)[len] = '\0';
+	return 1;
+}
+
+
+/** Set the text of a widget.
+ * Nothing is copied if the widget already shows the text.
+ * \param w     Widget.
+ * \param text  New text.
+ * \param len   Maximum number of bytes to use from \c text.
+ * \retval <0   Error: out of memory.
+ * \retval  0   Text unchanged.
+ * \retval  1   Text changed.
+ */
+int
+widget_set_text(Widget *w, const char *text, int len)
+{
+	int ret = widget_copy_text(&w->text, &w->text_size, text, len, widget_utf8(w));
+
+	if (ret > 0)
+		marquee_invalidate(w->marquee);
+	return ret;
+}
+
+
+/** Set the labels of a pbar widget.
+ * \param w            Widget.
+ * \param begin_label  Label in front of the bar; or NULL for none.
+ * \param end_label    Label at the end of the bar; or NULL for none.
+ * \retval <0          Error: out of memory.
+ * \retval  0          Labels unchanged.
+ * \retval  1          At least one label changed.
+ */
+int
+widget_set_labels(Widget *w, const char *begin_label, const char *end_label)
+{
+	int b, e;
+
+	b = widget_copy_text(&w->begin_label, &w->begin_label_size, begin_label,
+			     (begin_label != NULL) ? strlen(begin_label) : 0, widget_utf8(w));
+	e = widget_copy_text(&w->end_label, &w->end_label_size, end_label,
+			     (end_label != NULL) ? strlen(end_label) : 0, widget_utf8(w));
+	if ((b < 0) || (e < 0))
+		return -1;
+	return b | e;
+}
+
+
+/** Compare the position, size and values of two widgets.
+ * Text and labels are not compared; widget_set_text() and
+ * widget_set_labels() tell whether they changed.
+ * \param a  Widget.
+ * \param b  Widget, usually a copy of \c a taken before changing it.
+ * \return   1 if they are the same, 0 otherwise.
+ */
+int
+widget_same_values(const Widget *a, const Widget *b)
+{
+	return ((a->type == b->type)
+		&& (a->x == b->x) && (a->y == b->y)
+		&& (a->width == b->width) && (a->height == b->height)
+		&& (a->left == b->left) && (a->top == b->top)
+		&& (a->right == b->right) && (a->bottom == b->bottom)
+		&& (a->length == b->length) && (a->speed == b->speed)
+		&& (a->promille == b->promille));
+}
+
+
+/** Note that a widget has changed.
+ * \param w  Widget.
+ */
+void
+widget_changed(Widget *w)
+{
+	if (w == NULL)
+		return;
+	marquee_invalidate(w->marquee);
+	screen_changed(w->screen);
+}
+
+
 /** Convert a widget type name to a widget type.
  * \param typename  Name of the widget type.
  * \return          Widget type.
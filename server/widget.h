@@ -28,7 +28,9 @@ typedef enum WidgetType {
 	WID_TITLE,
 	WID_SCROLLER,
 	WID_FRAME,
-	WID_NUM
+	WID_NUM,
+	WID_CLOCK,
+	WID_BIGCLOCK
 } WidgetType;
 
 
@@ -43,10 +45,15 @@ typedef struct Widget {
 	int length;			/**< size or direction */
 	int speed;			/**< For scroller... */
 	int promille;                   /**< For percentage / pbars */
-	char *text;			/**< text or binary data */
+	char *text;			/**< text, clock format or binary data */
+	int text_size;			/**< bytes allocated for text */
 	char *begin_label;		/**< label in front of pbars; or NULL */
+	int begin_label_size;		/**< bytes allocated for begin_label */
 	char *end_label;		/**< label at end of pbars; or NULL */
+	int end_label_size;		/**< bytes allocated for end_label */
 	struct Screen *frame_screen;	/**< frame widget get an associated screen */
+	int handle;			/**< Binary protocol handle; or 0 */
+	struct Marquee *marquee;	/**< Scrolling of titles and scrollers; or NULL */
 	//LinkedList *kids;		/* Frames can contain more widgets...*/
 } Widget;
 
@@ -58,6 +65,18 @@ Widget *widget_create(char *id, WidgetType type, Screen *screen);
 /* Destroy a widget */
 void widget_destroy(Widget *w);
 
+/* Set the text of a widget, reusing its buffer */
+int widget_set_text(Widget *w, const char *text, int len);
+
+/* Set the labels of a pbar widget, reusing their buffers */
+int widget_set_labels(Widget *w, const char *begin_label, const char *end_label);
+
+/* Compare the position and values of two widgets */
+int widget_same_values(const Widget *a, const Widget *b);
+
+/* Mark the screen of a widget as changed */
+void widget_changed(Widget *w);
+
 /* Convert a widget typename to a widget type */
 WidgetType widget_typename_to_type(char *typename);
 
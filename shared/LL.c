@@ -25,6 +25,64 @@
 
 //TODO: Test everything?
 
+/** Number of nodes in the first block a list allocates */
+#define LL_MIN_BLOCK	8
+/** Maximum number of nodes per block */
+#define LL_MAX_BLOCK	256
+
+
+/** Get an unused node from the list's blocks.
+ * \param list   List object.
+ * \return       Pointer to the node; \c NULL on error.
+ */
+static LL_node *
+LL_AllocNode(LinkedList *list)
+{
+	LL_node *node;
+
+	if (list->free_nodes == NULL) {
+		/* Each block is twice as large as the previous one */
+		int size = (list->blocks != NULL) ? 2 * list->blocks->size : LL_MIN_BLOCK;
+		LL_block *block;
+		int i;
+
+		if (size > LL_MAX_BLOCK)
+			size = LL_MAX_BLOCK;
+		block = malloc(sizeof(LL_block) + size * sizeof(LL_node));
+		if (block == NULL)
+			return NULL;
+		block->size = size;
+		block->next = list->blocks;
+		list->blocks = block;
+
+		for (i = 0; i < size; i++) {
+			block->nodes[i].next = list->free_nodes;
+			list->free_nodes = &block->nodes[i];
+		}
+	}
+
+	node = list->free_nodes;
+	list->free_nodes = node->next;
+	list->length++;
+
+	return node;
+}
+
+
+/** Put a node that has been unlinked back to the list's unused nodes.
+ * \param list   List object.
+ * \param node   Node to recycle.
+ */
+static void
+LL_FreeNode(LinkedList *list, LL_node *node)
+{
+	node->prev = NULL;
+	node->data = NULL;
+	node->next = list->free_nodes;
+	list->free_nodes = node;
+	list->length--;
+}
+
 
 /** Create new linked list.
  * \return  Pointer to freshly created list object; \c NULL on error.
@@ -45,6 +103,9 @@ LL_new(void)
 	list->tail.prev = &list->head;
 	list->tail.next = NULL;
 	list->current = &list->head;
+	list->length = 0;
+	list->free_nodes = NULL;
+	list->blocks = NULL;
 
 	return list;
 }
@@ -62,28 +123,15 @@ LL_new(void)
 int
 LL_Destroy(LinkedList *list)
 {
-	LL_node *prev, *next;
-	LL_node *node;
+	LL_block *block, *next;
 
 	if (!list)
 		return -1;
 
-	node = &list->head;
-
-	for (node = node->next; node && node->next; node = next) {
-		// Avoid accessing "node" after it's freed..  :)
-		next = node->next;
-		prev = node->prev;
-
-		if (next != NULL)
-			next->prev = prev;
-		if (prev != NULL)
-			prev->next = next;
-
-		node->next = NULL;
-		node->prev = NULL;
-
-		free(node);
+	/* All nodes live in the list's blocks */
+	for (block = list->blocks; block != NULL; block = next) {
+		next = block->next;
+		free(block);
 	}
 
 	free(list);
@@ -377,7 +425,7 @@ LL_AddNode(LinkedList *list, void *add)
 	if (!list->current)
 		return -1;
 
-	node = malloc(sizeof(LL_node));
+	node = LL_AllocNode(list);
 	if (node == NULL)
 		return -1;
 
@@ -420,7 +468,7 @@ LL_InsertNode(LinkedList *list, void *add)
 	if (!list->current)
 		return -1;
 
-	node = malloc(sizeof(LL_node));
+	node = LL_AllocNode(list);
 	if (node == NULL)
 		return -1;
 
@@ -473,13 +521,8 @@ LL_DeleteNode(LinkedList *list, Direction whereto)
 	if (next)
 		next->prev = prev;
 
-	list->current->prev = NULL;
-	list->current->next = NULL;
 	// This should not free things; the user should do it explicitly.
-	//if(list->current->data) free(list->current->data);
-	list->current->data = NULL;
-
-	free(list->current);
+	LL_FreeNode(list, list->current);
 
 	switch (whereto) {
 		case HEAD:	list->current = list->head.next;
@@ -722,18 +765,10 @@ LL_SwapNodes(LL_node *one, LL_node *two)
 int
 LL_Length(LinkedList *list)
 {
-	LL_node *node;
-	int num = 0;
-
 	if (!list)
 		return -1;
 
-	node = &list->head;
-
-	for (num = -1; node != &list->tail; num++)
-		node = node->next;
-
-	return num;
+	return list->length;
 }
 
 
@@ -849,8 +884,85 @@ LL_GetByIndex(LinkedList *list, int index)
 }
 
 
+/** Start iterating over a list.
+ * The list's \c current pointer is not changed.
+ * \param list   List object.
+ * \param it     Iterator to initialize.
+ * \return       Pointer to the first node's data; \c NULL at the end or on error.
+ */
+void *
+LL_IterFirst(LinkedList *list, LL_iter *it)
+{
+	if (!it)
+		return NULL;
+
+	it->list = list;
+	it->node = NULL;
+	it->next = (list != NULL) ? list->head.next : NULL;
+
+	return LL_IterNext(it);
+}
+
+
+/** Advance an iterator to the next node.
+ * The successor is looked up before the data is returned, so the node
+ * just returned may be removed from the list, even by other means than
+ * LL_IterRemove().
+ * \param it     Iterator object.
+ * \return       Pointer to the next node's data; \c NULL at the end or on error.
+ */
+void *
+LL_IterNext(LL_iter *it)
+{
+	if (!it || !it->list)
+		return NULL;
+
+	if ((it->next == NULL) || (it->next == &it->list->tail)) {
+		it->node = NULL;
+		return NULL;
+	}
+
+	it->node = it->next;
+	it->next = it->node->next;
+
+	return it->node->data;
+}
+
+
+/** Remove the node returned last by an iterator from the list.
+ * If it is the list's \c current node, \c current moves to the previous one.
+ * \param it     Iterator object.
+ * \return       Pointer to data of deleted node; \c NULL on error.
+ */
+void *
+LL_IterRemove(LL_iter *it)
+{
+	LinkedList *list;
+	LL_node *node;
+	void *data;
+
+	if (!it || !it->list || !it->node)
+		return NULL;
+
+	list = it->list;
+	node = it->node;
+	data = node->data;
+
+	if (list->current == node)
+		list->current = node->prev;
+
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	LL_FreeNode(list, node);
+	it->node = NULL;
+
+	return data;
+}
+
+
 /** Sort list by its contents.
  * The list gets sorted using a comparison function for the data of its nodes.
+ * The sort is a stable merge sort: nodes that compare equal keep their order.
  * After the sorting, the list's current pointer is set to the first node.
  * \param list     List object.
  * \param compare  Pointer to a comparison function, that takes to void pointers
@@ -862,43 +974,71 @@ LL_GetByIndex(LinkedList *list, int index)
 int
 LL_Sort(LinkedList *list, int (*compare)(void *, void *))
 {
-	int i, j;			  // Junk / loop variables
-	int numnodes;			  // number of nodes in list
-	LL_node *best, *last;		  // best match and last node in the list
-	LL_node *current;
+	LL_node *first, *node, *prev;
+	int width;
 
 	if (!list)
 		return -1;
 	if (!compare)
 		return -1;
 
-	numnodes = LL_Length(list); // get the number of nodes...
-	if (0 > LL_End(list))
-		return -1;				  // Find the last node.
-	last = LL_GetNode(list);
-
-	if (numnodes < 2)
+	if (list->length < 2) {
+		LL_Rewind(list);
 		return 0;
+	}
 
-	for (i = numnodes - 1; i > 0; i--) {
-		LL_Rewind(list);			  // get the first node again
-		best = last;				  // reset our "best" node
-
-		for (j = 0; j < i; j++) {
-			current = LL_GetNode(list);
-			// If we found a better match...
-			if (compare(current->data, best->data) > 0) {
-				best = current;	  // keep track of the "best" match
+	/* Work on a NULL terminated chain of the next pointers */
+	first = list->head.next;
+	list->tail.prev->next = NULL;
+
+	/* Bottom-up: merge runs of 1, 2, 4, ... nodes until one is left */
+	for (width = 1; width < list->length; width *= 2) {
+		LL_node *merged = NULL;
+		LL_node **link = &merged;
+		LL_node *left = first;
+
+		while (left != NULL) {
+			LL_node *right = left;
+			int nleft, nright;
+
+			/* Split off up to width nodes on either side */
+			for (nleft = 0; (nleft < width) && (right != NULL); nleft++)
+				right = right->next;
+			nright = width;
+
+			while ((nleft > 0) || ((nright > 0) && (right != NULL))) {
+				LL_node *take;
+
+				/* Prefer the left run on ties to keep the sort stable */
+				if ((nleft > 0) && ((nright == 0) || (right == NULL)
+				    || (compare(left->data, right->data) <= 0))) {
+					take = left;
+					left = left->next;
+					nleft--;
+				}
+				else {
+					take = right;
+					right = right->next;
+					nright--;
+				}
+				*link = take;
+				link = &take->next;
 			}
-			LL_Next(list);		  // Go to the next node.
+			left = right;
 		}
+		*link = NULL;
+		first = merged;
+	}
 
-		LL_SwapNodes(last, best);	// Switch two nodes...
-		if (best)
-			last = best->prev;
-		else
-			return -1;
+	/* Restore the prev pointers and the anchors */
+	prev = &list->head;
+	for (node = first; node != NULL; node = node->next) {
+		node->prev = prev;
+		prev->next = node;
+		prev = node;
 	}
+	prev->next = &list->tail;
+	list->tail.prev = prev;
 
 	LL_Rewind(list);
 
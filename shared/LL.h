@@ -88,6 +88,21 @@
       ... do something to it ...
     } while(LL_Next(list) == 0);
 
+  This moves the list's "current" pointer, so two such loops over the same
+  list cannot be nested.  An iterator keeps its position outside of the
+  list instead:
+
+    LL_iter it;
+
+    LL_ForEach(list, it, my_data) {
+      ... do something to it ...
+      if (done_with_it)
+        LL_IterRemove(&it);	// removing the current item is safe
+    }
+
+  Iterators do not touch "current", and any number of them may be active.
+  While iterating, only the item most recently returned may be removed.
+
   *******************************************************************
 
   You can also treat the list like a stack, or a queue.  Just use the
@@ -104,7 +119,12 @@
     LL_Enqueue()   // Standard queue operations
     LL_Dequeue()
 
-  There are also other goodies, like sorting and searching.
+  There are also other goodies, like sorting (a stable merge sort) and
+  searching.
+
+  Nodes are allocated from blocks owned by the list and are recycled when
+  they are deleted, so adding and removing items normally does not call
+  malloc() or free().
 
   *******************************************************************
   That's about it, for now...  Be sure to free the list when you're done!
@@ -131,14 +151,36 @@ typedef struct LL_node {
 } LL_node;
 
 
+/** Block of nodes allocated at once */
+typedef struct LL_block {
+	struct LL_block *next;	/**< Next block owned by the same list */
+	int size;		/**< Number of nodes in this block */
+	LL_node nodes[];	/**< The nodes */
+} LL_block;
+
+
 /** Structire for a linked list */
 typedef struct LinkedList {
 	LL_node head;		/**< List's head anchor */
 	LL_node tail;		/**< List's tail anchor */
 	LL_node *current;	/**< Pointer to current node */
+	int length;		/**< Number of nodes in the list */
+	LL_node *free_nodes;	/**< Unused nodes, linked by their next pointers */
+	LL_block *blocks;	/**< Blocks the nodes are allocated from */
 } LinkedList;
 
 
+/** External iterator for a linked list.
+ * \c next and \c node are not adjacent, so LL_IterNext() stores them
+ * separately: a merged 16 byte store stalls the next call's load of \c next.
+ */
+typedef struct LL_iter {
+	LL_node *next;		/**< Node to return next */
+	LinkedList *list;	/**< List being iterated */
+	LL_node *node;		/**< Node returned last, or NULL */
+} LL_iter;
+
+
 // Creates a new list...
 LinkedList *LL_new(void);
 // Destroying lists...
@@ -201,6 +243,14 @@ void LL_ForAll(LinkedList *list, void *(*action)(void *, void *), void *value);
 // Array operation...
 void *LL_GetByIndex(LinkedList *list, int index);  // gets the nth node, 0 being the first
 
+// External iterators...
+void *LL_IterFirst(LinkedList *list, LL_iter *it);	// returns first node's data
+void *LL_IterNext(LL_iter *it);			// returns next node's data
+void *LL_IterRemove(LL_iter *it);		// removes node returned last
+
+#define LL_ForEach(list, it, data)	\
+	for ((data) = LL_IterFirst((list), &(it)); (data) != NULL; (data) = LL_IterNext(&(it)))
+
 // Sorts the list...
 int LL_Sort(LinkedList *list, int (*compare)(void *, void *));
 
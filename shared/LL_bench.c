@@ -0,0 +1,344 @@
+/** \file shared/LL_bench.c
+ * Compares the linked list of LL.c with the one it replaced.
+ *
+ * The old list allocated every node with malloc(), counted the nodes for
+ * LL_Length() and sorted with a selection sort swapping nodes. Its code for
+ * these operations is kept here as old_*(), and both lists run the same
+ * work for 10, 100 and 10000 items: filling and emptying the list, walking
+ * it, and sorting it. The sorted orders are compared, so a broken LL_Sort()
+ * fails the run.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "LL.h"
+
+/** Node of the old list */
+typedef struct OldNode {
+	struct OldNode *prev;
+	struct OldNode *next;
+	void *data;
+} OldNode;
+
+/** The old list: anchors and the current pointer, nothing else */
+typedef struct OldList {
+	OldNode head;
+	OldNode tail;
+	OldNode *current;
+} OldList;
+
+static unsigned int seed = 2463534242u;
+
+
+/* xorshift: the same pseudo random keys on every run */
+static unsigned int
+next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static int
+compare_keys(void *one, void *two)
+{
+	unsigned int a = *(unsigned int *) one;
+	unsigned int b = *(unsigned int *) two;
+
+	return (a > b) - (a < b);
+}
+
+
+static OldList *
+old_new(void)
+{
+	OldList *list = malloc(sizeof(OldList));
+
+	if (list == NULL)
+		return NULL;
+	list->head.data = NULL;
+	list->head.prev = NULL;
+	list->head.next = &list->tail;
+	list->tail.data = NULL;
+	list->tail.prev = &list->head;
+	list->tail.next = NULL;
+	list->current = &list->head;
+	return list;
+}
+
+
+/* LL_Push(): LL_End() and LL_AddNode() */
+static int
+old_push(OldList *list, void *add)
+{
+	OldNode *node = malloc(sizeof(OldNode));
+
+	if (node == NULL)
+		return -1;
+	list->current = list->tail.prev;
+	node->next = list->current->next;
+	node->prev = list->current;
+	node->data = add;
+	node->next->prev = node;
+	list->current->next = node;
+	list->current = node;
+	return 0;
+}
+
+
+/* LL_Shift(): LL_Rewind() and LL_DeleteNode(list, NEXT) */
+static void *
+old_shift(OldList *list)
+{
+	OldNode *node = list->head.next;
+	void *data;
+
+	if (node == &list->tail)
+		return NULL;
+	data = node->data;
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	list->current = node->next;
+	free(node);
+	return data;
+}
+
+
+/* LL_Length(): counts the nodes */
+static int
+old_length(OldList *list)
+{
+	OldNode *node = &list->head;
+	int num;
+
+	for (num = -1; node != &list->tail; num++)
+		node = node->next;
+	return num;
+}
+
+
+/* LL_SwapNodes() */
+static void
+old_swap_nodes(OldNode *one, OldNode *two)
+{
+	OldNode *firstprev, *firstnext;
+	OldNode *secondprev, *secondnext;
+
+	if (one == two)
+		return;
+
+	firstprev = one->prev;
+	firstnext = one->next;
+	secondprev = two->prev;
+	secondnext = two->next;
+
+	firstprev->next = two;
+	firstnext->prev = two;
+	secondprev->next = one;
+	secondnext->prev = one;
+
+	one->next = secondnext;
+	one->prev = secondprev;
+	two->next = firstnext;
+	two->prev = firstprev;
+
+	if (firstnext == two)
+		one->prev = two;
+	if (firstprev == two)
+		one->next = two;
+	if (secondprev == one)
+		two->next = one;
+	if (secondnext == one)
+		two->prev = one;
+}
+
+
+/* LL_Sort(): selection sort of the largest item to the end */
+static void
+old_sort(OldList *list, int (*compare)(void *, void *))
+{
+	int numnodes = old_length(list);
+	OldNode *best, *last, *current;
+	int i, j;
+
+	if (numnodes < 2)
+		return;
+	last = list->tail.prev;
+
+	for (i = numnodes - 1; i > 0; i--) {
+		current = list->head.next;
+		best = last;
+		for (j = 0; j < i; j++) {
+			if (compare(current->data, best->data) > 0)
+				best = current;
+			current = current->next;
+		}
+		old_swap_nodes(last, best);
+		last = best->prev;
+	}
+	list->current = list->head.next;
+}
+
+
+static void
+old_destroy(OldList *list)
+{
+	while (old_shift(list) != NULL)
+		;
+	free(list);
+}
+
+
+/* Runs the same work on both lists with n items and prints the times */
+static int
+bench(int n, int rounds, int sort_rounds, unsigned int *keys)
+{
+	LinkedList *list = LL_new();
+	OldList *old = old_new();
+	double t, t_old;
+	unsigned long sum = 0, sum_old = 0;
+	int i, r, errors = 0;
+	unsigned int *key, *sorted;
+	unsigned int prev = 0;
+	OldNode *node;
+	LL_iter it;
+
+	if ((list == NULL) || (old == NULL)) {
+		fprintf(stderr, "LL_bench: out of memory\n");
+		exit(1);
+	}
+
+	/* Fill and empty, as the server does with messages and widgets */
+	t_old = now();
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < n; i++)
+			old_push(old, &keys[i]);
+		while (old_shift(old) != NULL)
+			;
+	}
+	t_old = now() - t_old;
+	t = now();
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < n; i++)
+			LL_Push(list, &keys[i]);
+		while (LL_Shift(list) != NULL)
+			;
+	}
+	t = now() - t;
+	printf("%6d  push+shift  %10.3f %10.3f  %5.1fx\n", n,
+	       t_old * 1e6 / rounds, t * 1e6 / rounds, t_old / t);
+
+	/* Walk, as the per-frame loops over screens and widgets do. The
+	 * cursor functions are unchanged, so they stand in for the old walk. */
+	for (i = 0; i < n; i++) {
+		old_push(old, &keys[i]);
+		LL_Push(list, &keys[i]);
+	}
+	t_old = now();
+	for (r = 0; r < rounds; r++)
+		for (key = LL_GetFirst(list); key != NULL; key = LL_GetNext(list))
+			sum_old += *key;
+	t_old = now() - t_old;
+	t = now();
+	for (r = 0; r < rounds; r++)
+		LL_ForEach(list, it, key)
+			sum += *key;
+	t = now() - t;
+	printf("%6d  walk        %10.3f %10.3f  %5.1fx\n", n,
+	       t_old * 1e6 / rounds, t * 1e6 / rounds, t_old / t);
+	if (sum != sum_old)
+		errors++;
+
+	/* Sort the unsorted items; the sort is timed together with a refill */
+	t_old = now();
+	for (r = 0; r < sort_rounds; r++) {
+		while (old_shift(old) != NULL)
+			;
+		for (i = 0; i < n; i++)
+			old_push(old, &keys[i]);
+		old_sort(old, compare_keys);
+	}
+	t_old = now() - t_old;
+	t = now();
+	for (r = 0; r < sort_rounds; r++) {
+		while (LL_Shift(list) != NULL)
+			;
+		for (i = 0; i < n; i++)
+			LL_Push(list, &keys[i]);
+		LL_Sort(list, compare_keys);
+	}
+	t = now() - t;
+	printf("%6d  fill+sort   %10.3f %10.3f  %5.1fx\n", n,
+	       t_old * 1e6 / sort_rounds, t * 1e6 / sort_rounds, t_old / t);
+
+	/* Both sorts must give the same order of keys */
+	node = old->head.next;
+	i = 0;
+	LL_ForEach(list, it, sorted) {
+		if ((node == &old->tail) || (*(unsigned int *) node->data != *sorted)
+		    || ((i > 0) && (*sorted < prev)))
+			errors++;
+		prev = *sorted;
+		node = node->next;
+		i++;
+	}
+	if ((node != &old->tail) || (i != n) || (LL_Length(list) != n))
+		errors++;
+
+	LL_Destroy(list);
+	old_destroy(old);
+	return errors;
+}
+
+
+int
+main(void)
+{
+	static const struct {
+		int n;
+		int rounds;
+		int sort_rounds;
+	} sizes[] = {
+		{    10, 200000, 100000 },
+		{   100,  20000,   2000 },
+		{ 10000,    200,      5 },
+	};
+	unsigned int *keys;
+	int i, errors = 0;
+
+	keys = malloc(10000 * sizeof(*keys));
+	if (keys == NULL)
+		return 1;
+	for (i = 0; i < 10000; i++)
+		keys[i] = next_random() % 1000;	/* with duplicates */
+
+	printf("     n  operation       old us     new us  speedup\n");
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		errors += bench(sizes[i].n, sizes[i].rounds, sizes[i].sort_rounds, keys);
+
+	free(keys);
+	if (errors > 0) {
+		fprintf(stderr, "LL_bench: the lists differ after sorting\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+/** \file shared/binproto.h
+ * Definitions of the compact binary client protocol.
+ *
+ * A client selects the binary framing by sending \c "hello -binary". After
+ * the (text) \c connect response has been received, everything the client
+ * sends is framed as:
+ *
+ *\verbatim
+ *   uint16  length    number of bytes that follow (command + body)
+ *   uint8   command   one of the BIN_CMD_* values
+ *   ...     body      command specific
+ *\endverbatim
+ *
+ * All integers are in network byte order; x/y values and other numbers in
+ * the body are int16. Strings are not terminated: an id or text that comes
+ * last takes up the rest of the frame.
+ *
+ * Screens and widgets created with BIN_CMD_SCREEN_ADD / BIN_CMD_WIDGET_ADD
+ * are addressed by handles. LCDd answers these commands with the text line
+ * \c "handle <number>". The other native commands send no response unless
+ * they fail, in which case the usual \c "huh? ..." line is sent. Messages
+ * from LCDd (listen, ignore, key, menuevent) stay text lines.
+ */
+
+/*-
+ * This file is part of LCDproc.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef BINPROTO_H
+#define BINPROTO_H
+
+/** Size of the frame header: length and command */
+#define BINPROTO_HEADER_SIZE	3
+
+/** Largest possible frame including the length field */
+#define BINPROTO_MAX_FRAME	(2 + 0xFFFF)
+
+/** Size of LCDd's receive buffer per binary client; holds a frame at least */
+#define BINPROTO_BUFFER_SIZE	(2 * BINPROTO_MAX_FRAME)
+
+/** Maximum number of handles per client (handles fit into a uint16) */
+#define BINPROTO_MAX_HANDLES	0x10000
+
+/** Commands of the binary protocol */
+enum BinCommand {
+	BIN_CMD_TEXT = 0,	/**< body: one text protocol command line */
+	BIN_CMD_SCREEN_ADD,	/**< body: screen id */
+	BIN_CMD_SCREEN_DEL,	/**< body: screen handle */
+	BIN_CMD_WIDGET_ADD,	/**< body: screen handle, frame handle or 0, uint8 type, widget id */
+	BIN_CMD_WIDGET_DEL,	/**< body: widget handle */
+	BIN_CMD_WIDGET_SET,	/**< body: widget handle, type specific values (see below) */
+	BIN_CMD_MAX
+};
+
+/*
+ * Widget types for BIN_CMD_WIDGET_ADD (the same numbers as LCDd's WidgetType)
+ * and the BIN_CMD_WIDGET_SET bodies following the widget handle:
+ */
+#define BIN_WID_STRING		1	/**< x, y, text */
+#define BIN_WID_HBAR		2	/**< x, y, length */
+#define BIN_WID_VBAR		3	/**< x, y, length */
+#define BIN_WID_PBAR		4	/**< x, y, width, promille */
+#define BIN_WID_ICON		5	/**< x, y, icon number (ICON_* in lcd.h) */
+#define BIN_WID_TITLE		6	/**< text */
+#define BIN_WID_SCROLLER	7	/**< left, top, right, bottom, speed, uint8 direction, text */
+#define BIN_WID_FRAME		8	/**< only settable with BIN_CMD_TEXT */
+#define BIN_WID_NUM		9	/**< x, digit */
+#define BIN_WID_CLOCK		10	/**< x, y, strftime() format */
+#define BIN_WID_BIGCLOCK	11	/**< x, strftime() format */
+
+#endif
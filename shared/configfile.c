@@ -18,6 +18,7 @@
 #include <strings.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -41,14 +42,56 @@ typedef struct _config_section {
 } ConfigSection;
 
 
+/** all values of a key in a snapshot */
+typedef struct _config_entry {
+	const char *name;		/**< name of the key; NULL for empty slots */
+	unsigned int hash;		/**< hash of the lower case name */
+	int count;			/**< number of values */
+	const char **values;		/**< values in the order they were read */
+} ConfigEntry;
+
+/** keys of a section in a snapshot */
+typedef struct _config_table {
+	const char *name;		/**< name of the section; NULL for empty slots */
+	unsigned int hash;		/**< hash of the lower case name */
+	int size;			/**< number of slots, a power of 2 */
+	int used;			/**< number of distinct keys */
+	ConfigEntry *entries;		/**< open addressed hash table of keys */
+} ConfigTable;
+
+/**
+ * Read-only, hashed view of the configuration, used for lookups.
+ * It is built on the first lookup after the configuration was changed
+ * and points into the strings of the sections it was built from.
+ */
+typedef struct _config_snapshot {
+	ConfigSection *first_section;	/**< sections the snapshot was built from */
+	int size;			/**< number of slots, a power of 2 */
+	ConfigTable *tables;		/**< open addressed hash table of sections */
+	ConfigEntry *entries;		/**< storage of all key tables */
+	const char **values;		/**< storage of all value arrays */
+} ConfigSnapshot;
+
+
 static ConfigSection *first_section = NULL;
 /* Yes there is a static. It's C after all :)*/
 
+/** snapshot of first_section; NULL if it has to be (re)built */
+static ConfigSnapshot *snapshot = NULL;
+/** snapshot of the configuration before the last config_clear() */
+static ConfigSnapshot *previous = NULL;
+
 
 static ConfigSection *find_section(const char *sectionname);
 static ConfigSection *add_section(const char *sectionname);
 static ConfigKey *find_key(ConfigSection *s, const char *keyname, int skip);
 static ConfigKey *add_key(ConfigSection *s, const char *keyname, const char *value);
+static void free_sections(ConfigSection *first);
+static ConfigSnapshot *get_snapshot(void);
+static void free_snapshot(ConfigSnapshot *snap);
+static const ConfigTable *snapshot_section(const ConfigSnapshot *snap, const char *sectionname);
+static const ConfigEntry *snapshot_key(const ConfigTable *t, const char *keyname);
+static const char *find_value(const char *sectionname, const char *keyname, int skip);
 #if defined(LCDPROC_CONFIG_READ_STRING)
 static char get_next_char_f(FILE *f);
 static int process_config(ConfigSection **current_section, char(*get_next_char)(), const char *source_descr, FILE *f);
@@ -148,12 +191,12 @@ int config_read_string(const char *sectionname, const char *str)
 const char *config_get_string(const char *sectionname, const char *keyname,
 		int skip, const char *default_value)
 {
-	ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+	const char *value = find_value(sectionname, keyname, skip);
 
-	if (k == NULL)
+	if (value == NULL)
 		return default_value;
 
-	return k->value;
+	return value;
 
 /* This is the safer way:*/
 
@@ -185,19 +228,19 @@ const char *config_get_string(const char *sectionname, const char *keyname,
 short config_get_bool(const char *sectionname, const char *keyname,
 		int skip, short default_value)
 {
-	ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+	const char *value = find_value(sectionname, keyname, skip);
 
-	if (k == NULL)
+	if (value == NULL)
 		return default_value;
 
-	if ((strcasecmp(k->value, "0") == 0) || (strcasecmp(k->value, "false") == 0) ||
-	    (strcasecmp(k->value, "n") == 0) || (strcasecmp(k->value, "no") == 0) ||
-	    (strcasecmp(k->value, "off") == 0)) {
+	if ((strcasecmp(value, "0") == 0) || (strcasecmp(value, "false") == 0) ||
+	    (strcasecmp(value, "n") == 0) || (strcasecmp(value, "no") == 0) ||
+	    (strcasecmp(value, "off") == 0)) {
 		return 0;
 	}
-	if ((strcasecmp(k->value, "1") == 0) || (strcasecmp(k->value, "true") == 0) ||
-	    (strcasecmp(k->value, "y") == 0) || (strcasecmp(k->value, "yes") == 0) ||
-	    (strcasecmp(k->value, "on") == 0)) {
+	if ((strcasecmp(value, "1") == 0) || (strcasecmp(value, "true") == 0) ||
+	    (strcasecmp(value, "y") == 0) || (strcasecmp(value, "yes") == 0) ||
+	    (strcasecmp(value, "on") == 0)) {
 		return 1;
 	}
 	return default_value;
@@ -224,23 +267,23 @@ short config_get_bool(const char *sectionname, const char *keyname,
 short config_get_tristate(const char *sectionname, const char *keyname,
 		int skip, const char *name3rd, short default_value)
 {
-	ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+	const char *value = find_value(sectionname, keyname, skip);
 
-	if (k == NULL)
+	if (value == NULL)
 		return default_value;
 
-	if ((strcasecmp(k->value, "0") == 0) || (strcasecmp(k->value, "false") == 0) ||
-	    (strcasecmp(k->value, "n") == 0) || (strcasecmp(k->value, "no") == 0) ||
-	    (strcasecmp(k->value, "off") == 0)) {
+	if ((strcasecmp(value, "0") == 0) || (strcasecmp(value, "false") == 0) ||
+	    (strcasecmp(value, "n") == 0) || (strcasecmp(value, "no") == 0) ||
+	    (strcasecmp(value, "off") == 0)) {
 		return 0;
 	}
-	if ((strcasecmp(k->value, "1") == 0) || (strcasecmp(k->value, "true") == 0) ||
-	    (strcasecmp(k->value, "y") == 0) || (strcasecmp(k->value, "yes") == 0) ||
-	    (strcasecmp(k->value, "on") == 0)) {
+	if ((strcasecmp(value, "1") == 0) || (strcasecmp(value, "true") == 0) ||
+	    (strcasecmp(value, "y") == 0) || (strcasecmp(value, "yes") == 0) ||
+	    (strcasecmp(value, "on") == 0)) {
 		return 1;
 	}
-	if ((strcasecmp(k->value, "2") == 0) ||
-	    ((name3rd != NULL) && (strcasecmp(k->value, name3rd) == 0))) {
+	if ((strcasecmp(value, "2") == 0) ||
+	    ((name3rd != NULL) && (strcasecmp(value, name3rd) == 0))) {
 		return 2;
 	}
 	return default_value;
@@ -260,13 +303,13 @@ short config_get_tristate(const char *sectionname, const char *keyname,
 long int config_get_int(const char *sectionname, const char *keyname,
 		int skip, long int default_value)
 {
-	ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+	const char *value = find_value(sectionname, keyname, skip);
 
-	if (k != NULL) {
+	if (value != NULL) {
 		char *end;
-		long int v = strtol(k->value, &end, 0);
+		long int v = strtol(value, &end, 0);
 
-		if ((end != NULL) && (end != k->value) && (*end == '\0'))
+		if ((end != NULL) && (end != value) && (*end == '\0'))
 			/* Conversion successful */
 			return v;
 	}
@@ -287,13 +330,13 @@ long int config_get_int(const char *sectionname, const char *keyname,
 double config_get_float(const char *sectionname, const char *keyname,
 		int skip, double default_value)
 {
-	ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+	const char *value = find_value(sectionname, keyname, skip);
 
-	if (k != NULL) {
+	if (value != NULL) {
 		char *end;
-		double v = strtod(k->value, &end);
+		double v = strtod(value, &end);
 
-		if ((end != NULL) && (end != k->value) && (*end == '\0'))
+		if ((end != NULL) && (end != value) && (*end == '\0'))
 			/* Conversion successful*/
 			return v;
 	}
@@ -308,7 +351,12 @@ double config_get_float(const char *sectionname, const char *keyname,
  */
 int config_has_section(const char *sectionname)
 {
-	return (find_section(sectionname) != NULL) ? 1 : 0;
+	ConfigSnapshot *snap = get_snapshot();
+
+	if (snap == NULL)
+		return (find_section(sectionname) != NULL) ? 1 : 0;
+
+	return (snapshot_section(snap, sectionname) != NULL) ? 1 : 0;
 }
 
 
@@ -320,29 +368,104 @@ int config_has_section(const char *sectionname)
  */
 int config_has_key(const char *sectionname, const char *keyname)
 {
-	ConfigSection *s = find_section(sectionname);
+	ConfigSnapshot *snap = get_snapshot();
+	const ConfigEntry *e;
 	int count = 0;
 
-	if (s != NULL) {
-		ConfigKey *k;
+	if (snap == NULL) {
+		ConfigSection *s = find_section(sectionname);
 
-		for (k = s->first_key; k != NULL; k = k->next_key) {
-			/* Did we find the right key ?*/
-			if (strcasecmp(k->name, keyname) == 0)
-				count++;
+		if (s != NULL) {
+			ConfigKey *k;
+
+			for (k = s->first_key; k != NULL; k = k->next_key) {
+				/* Did we find the right key ?*/
+				if (strcasecmp(k->name, keyname) == 0)
+					count++;
+			}
 		}
+		return count;
 	}
-	return count;
+
+	e = snapshot_key(snapshot_section(snap, sectionname), keyname);
+	return (e != NULL) ? e->count : 0;
 }
 
 
-/** Clear configuration. */
+/** Test whether a section differs from the configuration that was in
+ * memory before the last call to config_clear(). After re-reading the
+ * configuration this tells which parts of it have changed.
+ * \param sectionname  Name of the section to compare.
+ * \retval 0           section unchanged, or missing in both
+ * \retval 1           section added, removed or changed
+ */
+int config_section_changed(const char *sectionname)
+{
+	ConfigSnapshot *snap = get_snapshot();
+	const ConfigTable *old_t;
+	const ConfigTable *new_t;
+	int i;
+
+	if ((snap == NULL) || (previous == NULL))
+		return 1;
+
+	old_t = snapshot_section(previous, sectionname);
+	new_t = snapshot_section(snap, sectionname);
+	if ((old_t == NULL) || (new_t == NULL))
+		return (old_t != new_t);
+	if (old_t->used != new_t->used)
+		return 1;
+
+	for (i = 0; i < new_t->size; i++) {
+		const ConfigEntry *e = &new_t->entries[i];
+		const ConfigEntry *old_e;
+		int j;
+
+		if (e->name == NULL)
+			continue;
+		old_e = snapshot_key(old_t, e->name);
+		if ((old_e == NULL) || (old_e->count != e->count))
+			return 1;
+		for (j = 0; j < e->count; j++) {
+			if (strcmp(old_e->values[j], e->values[j]) != 0)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+
+/** Clear configuration.
+ * The cleared configuration is kept for config_section_changed() until
+ * the next call.
+ */
 void config_clear(void)
+{
+	ConfigSnapshot *snap = get_snapshot();
+
+	/* Forget the configuration cleared before */
+	if (previous != NULL) {
+		free_sections(previous->first_section);
+		free_snapshot(previous);
+	}
+	previous = snap;
+	if (snap == NULL)
+		free_sections(first_section);
+
+	/* Finally make everything inaccessible */
+	first_section = NULL;
+	snapshot = NULL;
+}
+
+
+/**** INTERNAL FUNCTIONS ****/
+
+static void free_sections(ConfigSection *first)
 {
 	ConfigSection *s;
 	ConfigSection *next_s;
 
-	for (s = first_section; s != NULL; s = next_s) {
+	for (s = first; s != NULL; s = next_s) {
 		ConfigKey *k;
 		ConfigKey *next_k;
 
@@ -361,12 +484,216 @@ void config_clear(void)
 		free(s->name);
 		free(s);
 	}
-	/* Finally make everything inaccessible */
-	first_section = NULL;
 }
 
 
-/**** INTERNAL FUNCTIONS ****/
+/** Case-insensitive hash of a section or key name (FNV-1a). */
+static unsigned int hash_name(const char *name)
+{
+	unsigned int h = 2166136261u;
+
+	while (*name != '\0') {
+		h ^= (unsigned char) tolower((unsigned char) *name++);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+
+/** Size of a hash table for \c n names: a power of 2 that leaves at least
+ * half of the slots free, so probing always ends. */
+static int table_size(int n)
+{
+	int size = 4;
+
+	while (size < 2 * n)
+		size *= 2;
+	return size;
+}
+
+
+static const ConfigTable *snapshot_section(const ConfigSnapshot *snap, const char *sectionname)
+{
+	unsigned int h;
+	int i;
+
+	if ((snap == NULL) || (sectionname == NULL))
+		return NULL;
+
+	h = hash_name(sectionname);
+	for (i = h & (snap->size - 1); snap->tables[i].name != NULL; i = (i + 1) & (snap->size - 1)) {
+		if ((snap->tables[i].hash == h) && (strcasecmp(snap->tables[i].name, sectionname) == 0))
+			return &snap->tables[i];
+	}
+	return NULL;
+}
+
+
+/** Find a key in a section's table, or the free slot where it belongs. */
+static ConfigEntry *table_slot(const ConfigTable *t, const char *keyname, unsigned int h)
+{
+	int i;
+
+	for (i = h & (t->size - 1); t->entries[i].name != NULL; i = (i + 1) & (t->size - 1)) {
+		if ((t->entries[i].hash == h) && (strcasecmp(t->entries[i].name, keyname) == 0))
+			break;
+	}
+	return &t->entries[i];
+}
+
+
+static const ConfigEntry *snapshot_key(const ConfigTable *t, const char *keyname)
+{
+	ConfigEntry *e;
+
+	if ((t == NULL) || (keyname == NULL))
+		return NULL;
+
+	e = table_slot(t, keyname, hash_name(keyname));
+	return (e->name != NULL) ? e : NULL;
+}
+
+
+/** Free a snapshot, but not the sections it was built from. */
+static void free_snapshot(ConfigSnapshot *snap)
+{
+	if (snap == NULL)
+		return;
+
+	free(snap->tables);
+	free(snap->entries);
+	free(snap->values);
+	free(snap);
+}
+
+
+/** Build the snapshot of the current configuration unless it exists.
+ * \return  The snapshot; NULL if memory ran out, lookups then scan the
+ *          lists instead.
+ */
+static ConfigSnapshot *get_snapshot(void)
+{
+	ConfigSnapshot *snap;
+	ConfigSection *s;
+	ConfigKey *k;
+	int sections = 0;
+	int slots = 0;
+	int keys = 0;
+	int i;
+
+	if (snapshot != NULL)
+		return snapshot;
+
+	for (s = first_section; s != NULL; s = s->next_section) {
+		int n = 0;
+
+		for (k = s->first_key; k != NULL; k = k->next_key)
+			n++;
+		sections++;
+		slots += table_size(n);
+		keys += n;
+	}
+
+	snap = calloc(1, sizeof(ConfigSnapshot));
+	if (snap == NULL)
+		return NULL;
+	snap->size = table_size(sections);
+	snap->tables = calloc(snap->size, sizeof(ConfigTable));
+	snap->entries = calloc(slots, sizeof(ConfigEntry));
+	snap->values = malloc((keys + 1) * sizeof(const char *));
+	if ((snap->tables == NULL) || (snap->entries == NULL) || (snap->values == NULL)) {
+		report(RPT_ERR, "%s: Could not allocate memory", __FUNCTION__);
+		free_snapshot(snap);
+		return NULL;
+	}
+
+	/* Hash the sections and their keys, counting the values per key */
+	slots = 0;
+	for (s = first_section; s != NULL; s = s->next_section) {
+		unsigned int h = hash_name(s->name);
+		ConfigTable *t;
+		int n = 0;
+
+		for (i = h & (snap->size - 1); snap->tables[i].name != NULL; i = (i + 1) & (snap->size - 1))
+			;
+		t = &snap->tables[i];
+		for (k = s->first_key; k != NULL; k = k->next_key)
+			n++;
+		t->name = s->name;
+		t->hash = h;
+		t->size = table_size(n);
+		t->entries = snap->entries + slots;
+		slots += t->size;
+
+		for (k = s->first_key; k != NULL; k = k->next_key) {
+			unsigned int kh = hash_name(k->name);
+			ConfigEntry *e = table_slot(t, k->name, kh);
+
+			if (e->name == NULL) {
+				e->name = k->name;
+				e->hash = kh;
+				t->used++;
+			}
+			e->count++;
+		}
+	}
+
+	/* Give each key its share of the value storage ... */
+	keys = 0;
+	for (i = 0; i < slots; i++) {
+		ConfigEntry *e = &snap->entries[i];
+
+		if (e->name != NULL) {
+			e->values = snap->values + keys;
+			keys += e->count;
+			e->count = 0;
+		}
+	}
+
+	/* ... and fill it in the order the values were read */
+	for (s = first_section; s != NULL; s = s->next_section) {
+		const ConfigTable *t = snapshot_section(snap, s->name);
+
+		for (k = s->first_key; k != NULL; k = k->next_key) {
+			ConfigEntry *e = table_slot(t, k->name, hash_name(k->name));
+
+			e->values[e->count++] = k->value;
+		}
+	}
+
+	snap->first_section = first_section;
+	snapshot = snap;
+	return snap;
+}
+
+
+/** Look up a value in the configuration.
+ * \param sectionname  Name of the section where the key is sought.
+ * \param keyname      Name of the key to look for.
+ * \param skip         Number of values to skip; \c -1 for the last one.
+ * \return             The value; NULL if not found.
+ */
+static const char *find_value(const char *sectionname, const char *keyname, int skip)
+{
+	ConfigSnapshot *snap = get_snapshot();
+	const ConfigEntry *e;
+
+	if (snap == NULL) {
+		ConfigKey *k = find_key(find_section(sectionname), keyname, skip);
+
+		return (k != NULL) ? k->value : NULL;
+	}
+
+	e = snapshot_key(snapshot_section(snap, sectionname), keyname);
+	if (e == NULL)
+		return NULL;
+	if (skip == -1)
+		return e->values[e->count - 1];
+	if ((skip < 0) || (skip >= e->count))
+		return NULL;
+	return e->values[skip];
+}
+
 
 static ConfigSection *find_section(const char *sectionname)
 {
@@ -389,6 +716,10 @@ static ConfigSection *add_section(const char *sectionname)
 	for (s = first_section; s != NULL; s = s->next_section)
 		place = &(s->next_section);
 
+	/* The snapshot is rebuilt on the next lookup */
+	free_snapshot(snapshot);
+	snapshot = NULL;
+
 	*place = (ConfigSection *) malloc(sizeof(ConfigSection));
 	if (*place != NULL) {
 		(*place)->name = strdup(sectionname);
@@ -437,6 +768,10 @@ static ConfigKey *add_key(ConfigSection *s, const char *keyname, const char *val
 		for (k = s->first_key; k != NULL; k = k->next_key)
 			place = &(k->next_key);
 
+		/* The snapshot is rebuilt on the next lookup */
+		free_snapshot(snapshot);
+		snapshot = NULL;
+
 		*place = (ConfigKey *) malloc(sizeof(ConfigKey));
 		if (*place != NULL) {
 			(*place)->name = strdup(keyname);
@@ -101,7 +101,13 @@ int config_has_key(const char *sectionname, const char *keyname);
 
 /* Clears all data stored by the config_read_* functions.
  * Should be called if the config should be reread.
+ * The cleared data is kept for config_section_changed().
  */
 void config_clear(void);
 
+/* Checks if a section differs from the config before the last config_clear().
+ * Returns 1 if it was added, removed or changed, 0 otherwise.
+ */
+int config_section_changed(const char *sectionname);
+
 #endif
@@ -0,0 +1,75 @@
+/** \file shared/lcdrec.h
+ * Definitions of the frame recording format.
+ *
+ * The \c record driver writes every frame LCDd renders as the difference to
+ * the previous one; \c lcdreplay reads these files back. A recording
+ * consists of one or more sessions (appending to a file starts a new one):
+ *
+ *\verbatim
+ *   char[6]  magic      "LCDrec"
+ *   uint8    version    LCDREC_VERSION
+ *   uint8    width      display size in characters
+ *   uint8    height
+ *   uint8    cellwidth  size of a custom character in pixels
+ *   uint8    cellheight
+ *   ...      records
+ *\endverbatim
+ *
+ * Widths and heights of 256 are stored as 0. Each record starts with a type
+ * byte. The only record type is LCDREC_FRAME:
+ *
+ *\verbatim
+ *   uint8    type       LCDREC_FRAME
+ *   varint   delay      milliseconds since the previous frame or session start
+ *   uint8    flags      LCDREC_F_* bits, the parts follow in this order
+ *   LCDREC_F_CHARS:     varint runs, then per run:
+ *                         varint skip   unchanged cells since the previous run
+ *                         varint len    number of cells
+ *                         uint8[len]    the characters
+ *   LCDREC_F_CURSOR:    varint x, varint y, uint8 state (1-based, CURSOR_*)
+ *   LCDREC_F_BACKLIGHT: uint8 on
+ *   LCDREC_F_CUSTOM:    uint8 count, then per character:
+ *                         uint8 number, uint8[cellheight] pixel rows
+ *\endverbatim
+ *
+ * Cells are numbered row by row starting with 0 in the upper left corner.
+ * A varint is an unsigned number stored in groups of 7 bits, least
+ * significant first; the high bit is set in all but the last byte. At the
+ * start of a session all cells are blanks, the cursor is off, the backlight
+ * state is unknown and the custom characters are empty.
+ */
+
+/*-
+ * This file is part of LCDproc.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef LCDREC_H
+#define LCDREC_H
+
+/** Start of each session */
+#define LCDREC_MAGIC		"LCDrec"
+/** Length of the magic string */
+#define LCDREC_MAGIC_LEN	6
+/** Version of the format */
+#define LCDREC_VERSION		1
+/** Size of the session header including the magic */
+#define LCDREC_HEADER_SIZE	(LCDREC_MAGIC_LEN + 5)
+
+/** Record type of a frame */
+#define LCDREC_FRAME		'F'
+
+/** \name Parts of a frame record
+ *@{*/
+#define LCDREC_F_CHARS		0x01
+#define LCDREC_F_CURSOR		0x02
+#define LCDREC_F_BACKLIGHT	0x04
+#define LCDREC_F_CUSTOM		0x08
+/**@}*/
+
+/** Number of custom characters in a recording */
+#define LCDREC_NUM_CCS		8
+
+#endif
@@ -0,0 +1,68 @@
+/** \file shared/rawscreen.h
+ * Layout of the shared memory "raw screen" used by local full screen clients.
+ *
+ * A client connected to LCDd's Unix domain socket may request a raw screen
+ * with the \c screen_raw command. LCDd answers with a file descriptor of a
+ * shared memory segment, which starts with a RawScreenHeader followed by
+ * width x height character cells (row by row, no terminators).
+ *
+ * The client writes the cells directly and brackets every update with
+ * rawscreen_begin_update() / rawscreen_end_update(). The sequence counter is
+ * odd while an update is in progress; LCDd only takes over the cells if it
+ * reads the same even counter before and after copying them.
+ */
+
+/*-
+ * This file is part of LCDproc.
+ *
+ * This file is released under the GNU General Public License.
+ * Refer to the COPYING file distributed with this package.
+ */
+
+#ifndef RAWSCREEN_H
+#define RAWSCREEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RAWSCREEN_MAGIC		0x4C434452	/* "LCDR" */
+#define RAWSCREEN_VERSION	1
+
+/** Header of the shared raw screen segment */
+typedef struct RawScreenHeader {
+	uint32_t magic;			/**< RAWSCREEN_MAGIC */
+	uint16_t version;		/**< RAWSCREEN_VERSION */
+	uint16_t header_size;		/**< Offset of the first cell */
+	uint16_t width;			/**< Number of columns */
+	uint16_t height;		/**< Number of rows */
+	volatile uint32_t seq;		/**< Update counter, odd while writing */
+	int16_t cursor;			/**< Cursor state (CURSOR_* in server/render.h) */
+	int16_t cursor_x;		/**< Cursor column, 1-based */
+	int16_t cursor_y;		/**< Cursor row, 1-based */
+	uint16_t reserved;
+} RawScreenHeader;
+
+/** Total size of a raw screen segment of the given dimensions */
+#define RAWSCREEN_SIZE(w, h)	(sizeof(RawScreenHeader) + (size_t) (w) * (h))
+
+/** Pointer to the first character cell */
+static inline char *rawscreen_cells(RawScreenHeader *h)
+{
+	return (char *) h + h->header_size;
+}
+
+/** Mark the start of an update (client side). */
+static inline void rawscreen_begin_update(RawScreenHeader *h)
+{
+	h->seq++;
+	__sync_synchronize();
+}
+
+/** Mark the end of an update (client side). */
+static inline void rawscreen_end_update(RawScreenHeader *h)
+{
+	__sync_synchronize();
+	h->seq++;
+}
+
+#endif
@@ -18,9 +18,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <syslog.h>
+#include <time.h>
 
 #include "report.h"
 
+/* The function is defined here, not the macro that checks the level */
+#undef report
+
 static int report_level = RPT_INFO;
 static int report_dest = RPT_DEST_STORE;
 
@@ -30,44 +34,102 @@ static char *stored_msgs[MAX_STORED_MSGS];
 static int stored_levels[MAX_STORED_MSGS];
 static int num_stored_msgs = 0;
 
+/*
+ * Rate limiting: every place report() is called from gets a token bucket
+ * that holds up to RATE_BURST messages and is refilled with RATE_PER_SEC
+ * messages per second. Messages from a place whose bucket is empty are
+ * counted and reported as suppressed with the next one that gets through.
+ */
+#define RATE_SITES 256
+#define RATE_BURST 10
+#define RATE_PER_SEC 2
+
+typedef struct {
+	const void *site;	/**< Return address of the call to report() */
+	int tokens;
+	time_t last;
+	unsigned int suppressed;
+} RateSite;
+
+static RateSite rate_sites[RATE_SITES];
+
+/** Writes queued messages if set, returns 0 if it took the message. */
+static int (*report_queue)(int level, const char *message) = NULL;
+
 /* local functions */
+#ifdef __GNUC__
+static int rate_allow(const void *site, unsigned int *suppressed);
+#endif
 static void store_report_message(int level, const char *message);
 static void flush_messages();
 
 void
 report(const int level, const char *format,... /* args */ )
 {
+	char buf[1024];
+	unsigned int suppressed = 0;
+	va_list ap;
+
 	/* Check if we should report it */
-	if (level <= report_level || report_dest == RPT_DEST_STORE) {
-		char buf[1024];
+	if (level > report_level && report_dest != RPT_DEST_STORE)
+		return;
+
+#ifdef __GNUC__
+	/* Critical messages and the startup messages are never suppressed */
+	if (level > RPT_CRIT && report_dest != RPT_DEST_STORE
+	    && !rate_allow(__builtin_return_address(0), &suppressed))
+		return;
+#endif
+
+	va_start(ap, format);
+	vsnprintf(buf, sizeof(buf), format, ap);
+	buf[sizeof(buf) - 1] = 0;
+	va_end(ap);
+
+	if (suppressed > 0) {
+		char note[64];
+
+		snprintf(note, sizeof(note), "(%u similar messages suppressed)", suppressed);
+		if (report_queue == NULL || report_queue(level, note) != 0)
+			report_write(level, note);
+	}
+
+	/*
+	 * Critical messages are written right away: the program stops
+	 * right after them, maybe before the queue is written.
+	 */
+	if (level > RPT_CRIT && report_dest != RPT_DEST_STORE
+	    && report_queue != NULL && report_queue(level, buf) == 0)
+		return;
 
-		/*
-		 * Following functions appear to work on RedHat and Debian
-		 * Linux, FreeBSD and Solaris
-		 */
+	report_write(level, buf);
+}
 
-		va_list ap;
-		va_start(ap, format);
 
-		switch (report_dest) {
-		    case RPT_DEST_STDERR:
-			vfprintf(stderr, format, ap);
-			fprintf(stderr, "\n");
-			break;
-		    case RPT_DEST_SYSLOG:
-			vsyslog(LOG_USER | (level + 2), format, ap);
-			break;
-		    case RPT_DEST_STORE:
-			vsnprintf(buf, sizeof(buf), format, ap);
-			buf[sizeof(buf) - 1] = 0;
-			store_report_message(level, buf);
-			break;
-		}
-		va_end(ap);
+void
+report_write(int level, const char *message)
+{
+	switch (report_dest) {
+	    case RPT_DEST_STDERR:
+		fprintf(stderr, "%s\n", message);
+		break;
+	    case RPT_DEST_SYSLOG:
+		syslog(LOG_USER | (level + 2), "%s", message);
+		break;
+	    case RPT_DEST_STORE:
+		store_report_message(level, message);
+		break;
 	}
 }
 
 
+void
+report_set_queue(int (*queue)(int level, const char *message))
+{
+	report_queue = queue;
+}
+
+
 int
 set_reporting(char *application_name, int new_level, int new_dest)
 {
@@ -97,6 +159,68 @@ set_reporting(char *application_name, int new_level, int new_dest)
 }
 
 
+#ifdef __GNUC__
+/**
+ * Takes a token from the bucket of a call site.
+ * \param site        Return address of the call to report().
+ * \param suppressed  Set to the number of messages suppressed since the
+ *                    last one that got through.
+ * \return  1 if the message should be reported, 0 if not.
+ */
+static int
+rate_allow(const void *site, unsigned int *suppressed)
+{
+	unsigned int i = ((unsigned long) site >> 2) % RATE_SITES;
+	unsigned int n;
+	RateSite *r = NULL;
+	time_t now = time(NULL);
+
+	/* Find the slot of this call site or claim an empty one */
+	for (n = 0; n < RATE_SITES; n++, i = (i + 1) % RATE_SITES) {
+		const void *expected = NULL;
+
+		if (rate_sites[i].site == site) {
+			r = &rate_sites[i];
+			break;
+		}
+		if (rate_sites[i].site == NULL
+		    && __atomic_compare_exchange_n(&rate_sites[i].site, &expected, site, 0,
+						   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			r = &rate_sites[i];
+			r->tokens = RATE_BURST;
+			r->last = now;
+			break;
+		}
+		if (expected == site) {
+			r = &rate_sites[i];
+			break;
+		}
+	}
+	if (r == NULL)		/* Table full: don't limit */
+		return 1;
+
+	/* Refill the bucket (the counts are approximate across threads) */
+	if (now < r->last)
+		r->last = now;
+	if (now > r->last) {
+		long tokens = r->tokens + (long) (now - r->last) * RATE_PER_SEC;
+
+		r->tokens = (tokens > RATE_BURST) ? RATE_BURST : tokens;
+		r->last = now;
+	}
+
+	if (r->tokens <= 0) {
+		r->suppressed++;
+		return 0;
+	}
+	r->tokens--;
+	*suppressed = r->suppressed;
+	r->suppressed = 0;
+	return 1;
+}
+#endif
+
+
 /**
  * Puts a message into the message store. If the store is full new messages
  * are silently discarded.
@@ -122,7 +246,8 @@ flush_messages()
 {
 	int i;
 	for (i = 0; i < num_stored_msgs; i++) {
-		report(stored_levels[i], "%s", stored_msgs[i]);
+		if (stored_levels[i] <= report_level)
+			report_write(stored_levels[i], stored_msgs[i]);
 		free(stored_msgs[i]);
 	}
 	num_stored_msgs = 0;
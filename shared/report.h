@@ -15,6 +15,14 @@
  *
  * This way, the global DEBUG macro is off but is locally enabled in
  * certains parts of the software.
+ *
+ * Reports above a level can be left out at compile time, including the
+ * debug() ones, with:
+ * ./configure --with-report-level=N
+ *
+ * Each place report() is called from may write a burst of 10 messages and
+ * then 2 per second; the suppressed messages are counted and the count is
+ * reported with the next message from that place.
  *\endverbatim
  */
 
@@ -80,6 +88,27 @@ int set_reporting( char *application_name, int new_level, int new_dest );
 /** Report the message to the selected destination if important enough */
 void report( const int level, const char *format, .../*args*/ );
 
+/** Write a formatted message to the current destination, unfiltered. */
+void report_write( int level, const char *message );
+
+/**
+ * Have report() pass messages to queue instead of writing them. It returns
+ * 0 if it took the message. NULL writes them directly again.
+ */
+void report_set_queue( int (*queue)(int level, const char *message) );
+
+/**
+ * \def RPT_COMPILE_LEVEL
+ *	Reports above this level are not compiled in.
+ */
+#ifndef RPT_COMPILE_LEVEL
+#  define RPT_COMPILE_LEVEL RPT_DEBUG
+#endif
+
+/* report is still a function when not called, e.g. assigned to a pointer */
+#define report(level, ...) \
+	(((level) <= RPT_COMPILE_LEVEL) ? report((level), __VA_ARGS__) : (void)0)
+
 /**
  * The code that this function generates will not be in the executable when
  * compiled without debugging. This way memory and CPU cycles are saved.
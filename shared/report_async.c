@@ -0,0 +1,211 @@
+/** \file shared/report_async.c
+ * Writing reports from a separate thread.
+ *
+ * report() puts its messages into a ring buffer and a thread writes them
+ * to stderr or syslog, so a slow syslog or console does not hold up the
+ * caller. Putting a message into the ring does not take a lock, so it may
+ * also be done from signal handlers and other threads. When the ring is
+ * full messages are dropped; their number is reported by the thread.
+ *
+ * The ring is a bounded queue with a sequence number per slot (as
+ * described by Dmitry Vyukov): a slot whose number equals the write
+ * position is free, one whose number is one more is filled.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+# include <semaphore.h>
+# include <signal.h>
+#endif
+
+#include "report.h"
+#include "report_async.h"
+
+#ifdef HAVE_PTHREAD
+
+/** Number of slots in the ring, a power of two */
+#define RING_SLOTS 256
+/** Longest message kept, longer ones are truncated */
+#define RING_TEXT 512
+
+typedef struct {
+	unsigned long seq;	/**< Sequence number, see above */
+	int level;
+	char text[RING_TEXT];
+} RingSlot;
+
+static RingSlot ring[RING_SLOTS];
+static unsigned long ring_write;	/**< Next position to fill */
+static unsigned long ring_read;		/**< Next position to write out */
+static unsigned int dropped;		/**< Messages lost since last written */
+
+static sem_t wakeup;
+static pthread_t writer;
+static int running = 0;
+static int stopping = 0;
+static int stop_at_exit = 0;
+
+
+/** Puts a message into the ring, called by report(). */
+static int
+ring_put(int level, const char *message)
+{
+	unsigned long pos = __atomic_load_n(&ring_write, __ATOMIC_RELAXED);
+	RingSlot *slot;
+
+	for (;;) {
+		unsigned long seq;
+		long diff;
+
+		slot = &ring[pos % RING_SLOTS];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		diff = (long) (seq - pos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ring_write, &pos, pos + 1, 1,
+							__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if (diff < 0) {
+			/* Full: the message counts as taken */
+			__atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+			return 0;
+		}
+		else {
+			pos = __atomic_load_n(&ring_write, __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->level = level;
+	strncpy(slot->text, message, RING_TEXT - 1);
+	slot->text[RING_TEXT - 1] = '\0';
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	sem_post(&wakeup);
+	return 0;
+}
+
+
+/** Writes out all filled slots. Only one thread may do this at a time. */
+static void
+ring_drain(void)
+{
+	unsigned int lost;
+
+	for (;;) {
+		RingSlot *slot = &ring[ring_read % RING_SLOTS];
+
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring_read + 1)
+			break;
+		report_write(slot->level, slot->text);
+		__atomic_store_n(&slot->seq, ring_read + RING_SLOTS, __ATOMIC_RELEASE);
+		ring_read++;
+	}
+
+	lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+	if (lost > 0) {
+		char buf[64];
+
+		snprintf(buf, sizeof(buf), "(%u messages dropped, report queue full)", lost);
+		report_write(RPT_WARNING, buf);
+	}
+}
+
+
+static void *
+writer_thread(void *arg)
+{
+	for (;;) {
+		while (sem_wait(&wakeup) != 0)
+			;	/* Interrupted */
+		ring_drain();
+		if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+			break;
+	}
+	return NULL;
+}
+
+#endif /* HAVE_PTHREAD */
+
+
+/**
+ * Starts the thread and has report() pass messages to it. It must be
+ * started after the program forked into the background, as the thread does
+ * not survive fork().
+ * \return  0 on success, -1 if the thread could not be started.
+ */
+int
+report_async_start(void)
+{
+#ifdef HAVE_PTHREAD
+	sigset_t all, old;
+	unsigned long i;
+
+	if (running)
+		return 0;
+
+	for (i = 0; i < RING_SLOTS; i++)
+		ring[i].seq = i;
+	ring_write = ring_read = 0;
+	dropped = 0;
+	stopping = 0;
+	if (sem_init(&wakeup, 0, 0) != 0) {
+		report(RPT_ERR, "Could not start report thread");
+		return -1;
+	}
+
+	/* Signals are handled by the main thread */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	if (pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+		sem_destroy(&wakeup);
+		report(RPT_ERR, "Could not start report thread");
+		return -1;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	running = 1;
+	report_set_queue(ring_put);
+	if (!stop_at_exit)
+		stop_at_exit = (atexit(report_async_stop) == 0);
+	return 0;
+#else
+	report(RPT_WARNING, "Reports can not be written from a separate thread");
+	return -1;
+#endif
+}
+
+
+/**
+ * Writes out the messages in the ring, stops the thread and has report()
+ * write its messages directly again.
+ */
+void
+report_async_stop(void)
+{
+#ifdef HAVE_PTHREAD
+	if (!running)
+		return;
+
+	report_set_queue(NULL);
+	__atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+	sem_post(&wakeup);
+	pthread_join(writer, NULL);
+	ring_drain();		/* Messages put in while stopping */
+	sem_destroy(&wakeup);
+	running = 0;
+#endif
+}
@@ -0,0 +1,16 @@
+/** \file shared/report_async.h
+ * Writing reports from a separate thread.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifndef REPORT_ASYNC_H
+#define REPORT_ASYNC_H
+
+int report_async_start(void);
+void report_async_stop(void);
+
+#endif
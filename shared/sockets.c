@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -35,6 +36,9 @@
 
 typedef struct sockaddr_in sockaddr_in;
 
+/** Socket whose output is discarded, see sock_mute() */
+static int muted_fd = -1;
+
 /**
  * Tries to resolve a resolve a hostname.
  * \param name      Pointer to resolves IP-address
@@ -96,6 +100,43 @@ sock_connect (char *host, unsigned short int port)
 	return sock;
 }
 
+/**
+ * Connect to server on a Unix domain socket.
+ * \param path  File system path of the server's socket
+ * \return  socket file descriptor on success, -1 on error
+ */
+int
+sock_connect_unix (const char *path)
+{
+	struct sockaddr_un servername;
+	int sock;
+
+	if (strlen(path) >= sizeof(servername.sun_path)) {
+		report (RPT_ERR, "sock_connect_unix: socket path too long: %s", path);
+		return -1;
+	}
+
+	sock = socket (PF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		report (RPT_ERR, "sock_connect_unix: Error creating socket");
+		return sock;
+	}
+
+	memset (&servername, '\0', sizeof (servername));
+	servername.sun_family = AF_UNIX;
+	strcpy (servername.sun_path, path);
+
+	if (connect (sock, (struct sockaddr *) &servername, sizeof (servername)) < 0) {
+		report (RPT_ERR, "sock_connect_unix: connect to %s failed", path);
+		close (sock);
+		return -1;
+	}
+
+	fcntl (sock, F_SETFL, O_NONBLOCK);
+
+	return sock;
+}
+
 /**
  * Disconnect from server.
  * \param fd  Socket file descriptor
@@ -211,6 +252,19 @@ sock_recv_string (int fd, char *dest, size_t maxlen)
 	return recvBytes;
 }
 
+/**
+ * Discard what is sent to a socket from now on, as if it was sent. The
+ * server runs the commands a client scheduled this way, as their replies
+ * would be taken for the replies to other commands. One socket can be
+ * muted at a time.
+ * \param fd  Socket file descriptor; -1 to send to all sockets again.
+ */
+void
+sock_mute (int fd)
+{
+	muted_fd = fd;
+}
+
 /**
  * Send raw data.
  * \param fd    Socket file descriptor
@@ -225,6 +279,8 @@ sock_send (int fd, const void *src, size_t size)
 
 	if (!src)
 		return -1;
+	if ((muted_fd >= 0) && (fd == muted_fd))
+		return size;
 
 	while (offset != size) {
 		// write isn't guaranteed to send the entire string at once,
@@ -276,6 +332,143 @@ sock_recv (int fd, void *dest, size_t maxlen)
 	return err;
 }
 
+/**
+ * Send a line of text together with a file descriptor.
+ * The descriptor is passed as SCM_RIGHTS ancillary data attached to the first
+ * byte of \c string, so this only works on Unix domain sockets.
+ * \param fd      Socket file descriptor
+ * \param string  Pointer to the string to send.
+ * \param passfd  File descriptor to hand over to the peer.
+ * \return  Number of bytes sent, -1 on error.
+ */
+int
+sock_send_string_fd (int fd, const char *string, int passfd)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	size_t size = strlen(string);
+	int sent;
+
+	if (size == 0)
+		return -1;
+	if ((muted_fd >= 0) && (fd == muted_fd))
+		return size;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&control, 0, sizeof(control));
+	iov.iov_base = (void *) string;
+	iov.iov_len = size;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &passfd, sizeof(int));
+
+	do {
+		sent = sendmsg(fd, &msg, 0);
+	} while (sent == -1 && errno == EAGAIN);
+
+	if (sent < 0) {
+		report (RPT_ERR, "sock_send_string_fd: socket write error");
+		return -1;
+	}
+
+	/* The descriptor went out with the first chunk, send the rest plainly */
+	if (sent < size) {
+		int rest = sock_send(fd, string + sent, size - sent);
+
+		if (rest < 0)
+			return rest;
+		sent += rest;
+	}
+
+	return sent;
+}
+
+/**
+ * Receive a line of text and a file descriptor that may come along with it.
+ * Works like sock_recv_string(), but uses recvmsg() so that a descriptor
+ * passed by the peer with sock_send_string_fd() is not lost.
+ * \param fd      Socket file descriptor
+ * \param dest    Pointer to buffer to store the received data
+ * \param maxlen  Number of bytes to read at most (size of buffer)
+ * \param passfd  Receives the passed descriptor, or -1 if none came along.
+ * \return  Number of bytes received.
+ */
+int
+sock_recv_string_fd (int fd, char *dest, size_t maxlen, int *passfd)
+{
+	char *ptr = dest;
+	int recvBytes = 0;
+
+	if (!dest || !passfd)
+		return -1;
+	*passfd = -1;
+	if (maxlen <= 0)
+		return 0;
+
+	while (1) {
+		struct msghdr msg;
+		struct iovec iov;
+		struct cmsghdr *cmsg;
+		union {
+			struct cmsghdr align;
+			char buf[CMSG_SPACE(sizeof(int))];
+		} control;
+		int err;
+
+		memset(&msg, 0, sizeof(msg));
+		iov.iov_base = ptr;
+		iov.iov_len = 1;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		err = recvmsg(fd, &msg, 0);
+		if (err == -1) {
+			if (errno == EAGAIN) {
+				if (recvBytes)
+					continue;
+				return 0;
+			}
+			report (RPT_ERR, "sock_recv_string_fd: socket read error");
+			return err;
+		} else if (err == 0) {
+			return recvBytes;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+				memcpy(passfd, CMSG_DATA(cmsg), sizeof(int));
+		}
+
+		recvBytes++;
+
+		// stop at max. bytes allowed, at NUL or at LF
+		if (recvBytes == maxlen || *ptr == '\0' || *ptr == '\n') {
+			*ptr = '\0';
+			break;
+		}
+		ptr++;
+	}
+
+	if (recvBytes < maxlen - 1)
+		dest[recvBytes] = '\0';
+
+	return recvBytes;
+}
+
 /*****************************************************************************/
 
 /**
@@ -19,6 +19,8 @@
 
 /** Connect to server on host, port */
 int sock_connect (char *host, unsigned short int port);
+/** Connect to server on a Unix domain socket */
+int sock_connect_unix (const char *path);
 /** Disconnect from server */
 int sock_close (int fd);
 /** Send printf-like formatted output */
@@ -27,10 +29,16 @@ int sock_printf (int fd, const char *format, .../*args*/);
 int sock_send_string (int fd, const char *string);
 /** Send raw data */
 int sock_send (int fd, const void *src, size_t size);
+/** Discard what is sent to a socket; -1 ends it */
+void sock_mute (int fd);
 /** Receive a line of text */
 int sock_recv_string (int fd, char *dest, size_t maxlen);
 /** Receive raw data */
 int sock_recv (int fd, void *dest, size_t maxlen);
+/** Send a line of text together with a file descriptor (Unix sockets only) */
+int sock_send_string_fd (int fd, const char *string, int passfd);
+/** Receive a line of text and a file descriptor that may come along with it */
+int sock_recv_string_fd (int fd, char *dest, size_t maxlen, int *passfd);
 
 
 /** Return the error message for the last error occured */
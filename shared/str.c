@@ -1,5 +1,6 @@
 /** \file shared/str.c
- * Commmand / argument parsing functions (for use in clients).
+ * Commmand / argument parsing functions (for use in clients) and
+ * character set conversion.
  */
 
 /*-
@@ -12,6 +13,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "report.h"
 #include "str.h"
@@ -52,3 +54,75 @@ get_args (char **argv, char *str, int max_args)
 
 	return i;
 }
+
+
+/** Convert UTF-8 text to ISO 8859-1, the character set the drivers'
+ * character maps translate from. Runs of ASCII are copied eight bytes at a
+ * time. Characters beyond U+00FF become '?'; bytes that are not part of a
+ * valid UTF-8 sequence are copied unchanged, so ISO 8859-1 text passes
+ * through.
+ * \param dst  Output buffer of at least \c len bytes; may be \c src.
+ * \param src  Text to convert; need not be NUL-terminated.
+ * \param len  Number of bytes to convert.
+ * \return     Number of bytes written to \c dst (not NUL-terminated).
+ */
+int
+utf8_to_latin1 (char *dst, const char *src, int len)
+{
+	const unsigned char *s = (const unsigned char *) src;
+	int i = 0, o = 0;
+
+	while (i < len) {
+		unsigned char c = s[i];
+		int n;
+
+		/* ASCII fast path */
+		if (c < 0x80) {
+			uint64_t w;
+
+			while (i + 8 <= len) {
+				memcpy(&w, s + i, 8);
+				if (w & UINT64_C(0x8080808080808080))
+					break;
+				memmove(dst + o, s + i, 8);
+				i += 8;
+				o += 8;
+			}
+			while ((i < len) && (s[i] < 0x80))
+				dst[o++] = s[i++];
+			continue;
+		}
+
+		/* length of the sequence starting with c */
+		if ((c >= 0xC2) && (c <= 0xDF))
+			n = 2;
+		else if ((c >= 0xE0) && (c <= 0xEF))
+			n = 3;
+		else if ((c >= 0xF0) && (c <= 0xF4))
+			n = 4;
+		else
+			n = 0;
+
+		if ((n > 0) && (i + n <= len)) {
+			int k;
+
+			for (k = 1; k < n; k++)
+				if ((s[i + k] & 0xC0) != 0x80)
+					break;
+			if (k == n) {
+				/* only two byte sequences can be below U+0100 */
+				if ((n == 2) && (c <= 0xC3))
+					dst[o++] = ((c & 0x1F) << 6) | (s[i + 1] & 0x3F);
+				else
+					dst[o++] = '?';
+				i += n;
+				continue;
+			}
+		}
+
+		/* not UTF-8: keep the byte */
+		dst[o++] = c;
+		i++;
+	}
+	return o;
+}
@@ -1,10 +1,12 @@
 /** \file shared/str.h
- * Commmand / argument parsing functions (for use in clients).
+ * Commmand / argument parsing functions (for use in clients) and
+ * character set conversion.
  */
 
 #ifndef STR_H
 #define STR_H
 
 int get_args (char **argv, char *str, int max_args);
+int utf8_to_latin1 (char *dst, const char *src, int len);
 
 #endif